@@ -0,0 +1,1307 @@
+/*
+ *  bench.c  --  load generator for twin: runs reproducible libTw scenarios
+ *               over many connections and prints ops/s and latency percentiles
+ *
+ *  This program is placed in the public domain.
+ *
+ */
+
+/* tell <stdlib.h> to declare grantpt(), unlockpt(), ptsname() */
+# define _GNU_SOURCE
+# define _XOPEN_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <Tw/Tw.h>
+#include <Tw/Twerrno.h>
+#include <Tw/Twstat.h>
+#include <Tw/Twstat_defs.h>
+#include <Tw/Twpty.h>
+#include <Tw/Twperf.h>
+#include "version.h"
+
+/*
+ * each connection is a forked child with its own TwOpen().
+ * children connect and set up their scenario, then wait on a shared pipe
+ * so that all of them start hammering the server at the same time.
+ * each op is timed in the child; the raw samples go back to the parent
+ * through a per-child pipe and are merged there.
+ *
+ * output is one line per scenario, made of `key=value' fields separated by spaces.
+ */
+
+typedef struct bench_result {
+    unsigned long n, errors;
+    double start, end;
+    char extra[128];		/* more `key=value' fields from the scenario, if any */
+} bench_result;
+
+typedef struct scenario {
+    TW_CONST char *name, *help;
+    byte (*Init)(void);
+    byte (*Op)(unsigned long i);
+    void (*Quit)(void);
+} scenario;
+
+static byte *argv0, *DisplayName;
+static unsigned long N = 1000, Conns = 1, Seed = 1;
+static dat SizeX = 80, SizeY = 25;
+static uldat SelLen = 256;
+static unsigned long Chatty = 8;
+static char Bench_Extra[128];
+
+static tmsgport Bench_MsgPort;
+static tmenu Bench_Menu;
+static tscreen Bench_Screen;
+static twindow Bench_Win, Bench_MenuWin;
+static tgadget Bench_Gadget;
+static hwattr *Bench_Attr;
+static byte *Bench_Sel, Bench_MIME[TW_MAX_MIMELEN];
+static dat DisplayX, DisplayY;
+
+static twindow Echo_Win;
+static int Echo_Fd = -1;
+static pid_t *Echo_Pid;
+static unsigned long Echo_NPid;
+static uldat Echo_Helper;
+static dat Echo_X, Echo_Y;
+
+#define MAXLRAND48 0x7FFFFFFFl
+
+static double Now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+static int WriteAll(int fd, TW_CONST void *data, size_t len) {
+    TW_CONST char *p = data;
+    ssize_t got;
+
+    while (len) {
+	if ((got = write(fd, p, len)) > 0)
+	    p += got, len -= got;
+	else if (got < 0 && errno == EINTR)
+	    continue;
+	else
+	    return -1;
+    }
+    return 0;
+}
+
+static int ReadAll(int fd, void *data, size_t len) {
+    char *p = data;
+    ssize_t got;
+
+    while (len) {
+	if ((got = read(fd, p, len)) > 0)
+	    p += got, len -= got;
+	else if (got < 0 && errno == EINTR)
+	    continue;
+	else
+	    return -1;
+    }
+    return 0;
+}
+
+static byte NewBenchWindow(twindow *W, dat X, dat Y) {
+    if ((*W = TwCreateWindow
+	 (7, "twbench", NULL, Bench_Menu, COL(HIGH|WHITE,BLUE), TW_NOCURSOR,
+	  TW_WINDOW_DRAG|TW_WINDOW_RESIZE|TW_WINDOW_CLOSE, TW_WINDOWFL_USECONTENTS,
+	  X, Y, 0))) {
+
+	TwConfigureWindow(*W, 0x3, lrand48() / (MAXLRAND48 / DisplayX),
+			  lrand48() / (MAXLRAND48 / DisplayY), 0, 0, 0, 0);
+	TwMapWindow(*W, Bench_Screen);
+	return TRUE;
+    }
+    return FALSE;
+}
+
+
+/*
+ * sync: one request with reply, the floor of every synchronous call.
+ * Tw_Sync() alone would be free here as nothing is queued.
+ */
+static byte SyncOp(unsigned long i) {
+    return TwGetDisplayWidth() == DisplayX;
+}
+
+/* window: create + place + map + delete a random window */
+static byte WindowOp(unsigned long i) {
+    twindow W;
+    if (NewBenchWindow(&W, 10 + lrand48() % 30, 3 + lrand48() % 10)) {
+	TwWriteAsciiWindow(W, 7, "twbench");
+	TwDeleteObj(W);
+	return TwSync();
+    }
+    return FALSE;
+}
+
+/* write: repaint a whole SizeX * SizeY window with TwWriteHWAttrWindow() */
+static byte WriteInit(void) {
+    if ((Bench_Attr = (hwattr *)malloc((size_t)SizeX * SizeY * sizeof(hwattr))))
+	return NewBenchWindow(&Bench_Win, SizeX, SizeY);
+    return FALSE;
+}
+
+static byte WriteOp(unsigned long i) {
+    ldat j, len = (ldat)SizeX * SizeY;
+    hwcol col = (hwcol)(lrand48() & 0x7F);
+    byte c = 'A' + i % 26;
+
+    for (j = 0; j < len; j++)
+	Bench_Attr[j] = HWATTR(col, c + (j & 7));
+    TwWriteHWAttrWindow(Bench_Win, 0, 0, len, Bench_Attr);
+    return TwSync();
+}
+
+/*
+ * alien: the same writes as `write', from a client with our sizes but the
+ * opposite byte order, so the server runs them through its alien decoder
+ * (socketalien.h) and byte-swaps each hwattr. libTw only speaks our own
+ * byte order, so this client is hand-rolled on a second, raw connection,
+ * like a twin client on the other kind of machine would talk to us over
+ * the network. The window itself belongs to the libTw connection,
+ * as object ids are global.
+ */
+#define ALIEN_OK_MAGIC   ((uldat)0x3E4B4F3Cul) /* as in socklist_m4.h */
+#define ALIEN_FIND_MAGIC ((uldat)0x646E6946ul)
+
+static int Alien_Fd = -1;
+static uldat Alien_Serial, Alien_Write, Alien_Sync;
+static byte *Alien_Buf;
+
+/* store and load len bytes in the byte order opposite to ours */
+static byte *AlienPut(byte *t, uldat v, int len) {
+    int k;
+    for (k = 0; k < len; k++)
+	t[TW_IS_LITTLE_ENDIAN ? len - 1 - k : k] = (byte)(v >> 8 * k);
+    return t + len;
+}
+
+static uldat AlienGet(TW_CONST byte *t, int len) {
+    uldat v = 0;
+    int k;
+    for (k = 0; k < len; k++)
+	v |= (uldat)t[TW_IS_LITTLE_ENDIAN ? len - 1 - k : k] << 8 * k;
+    return v;
+}
+
+/* wait for the reply to request Serial, return its code and up to 4 bytes of data */
+static byte AlienReply(uldat Serial, uldat *Code, uldat *Data) {
+    byte buf[3 * sizeof(uldat) + sizeof(uldat)];
+    uldat len;
+
+    do {
+	if (ReadAll(Alien_Fd, buf, 4) < 0 || (len = AlienGet(buf, 4)) < 8 || len > sizeof(buf) - 4 ||
+	    ReadAll(Alien_Fd, buf + 4, len) < 0)
+	    return FALSE;
+    } while (AlienGet(buf + 4, 4) != Serial);
+
+    *Code = AlienGet(buf + 8, 4);
+    *Data = AlienGet(buf + 12, len - 8);
+    return TRUE;
+}
+
+/* the id of a server function, as Tw_FindFunction() would return it */
+static uldat AlienFind(TW_CONST char *Name, byte FormatLen, TW_CONST char *Format) {
+    byte buf[TW_SMALLBUFF], *t = buf + 4, len = strlen(Name);
+    uldat code, id;
+
+    t = AlienPut(t, ++Alien_Serial, 4);
+    t = AlienPut(t, ALIEN_FIND_MAGIC, 4);
+    *t++ = len;
+    memcpy(t, Name, len);
+    t += len;
+    *t++ = FormatLen;
+    memcpy(t, Format, FormatLen);
+    t += FormatLen;
+    AlienPut(buf, t - buf - 4, 4);
+
+    if (WriteAll(Alien_Fd, buf, t - buf) == 0 && AlienReply(Alien_Serial, &code, &id) &&
+	code == ALIEN_OK_MAGIC)
+	return id;
+    return TW_NOID;
+}
+
+static byte AlienInit(void) {
+    TW_DECL_MAGIC(alien_magic);
+    struct sockaddr_un addr;
+    socklen_t addrlen = sizeof(addr);
+    byte buf[TW_MAXBYTE + 1];
+
+    if (!WriteInit() ||
+	!(Alien_Buf = (byte *)malloc(8 * sizeof(uldat) + 2 * sizeof(dat) + (size_t)SizeX * SizeY * sizeof(hwattr))))
+	return FALSE;
+
+    /* connect to the same unix socket as libTw: inet ones also want authentication */
+    if (getpeername(TwConnectionFd(), (struct sockaddr *)&addr, &addrlen) < 0 || addr.sun_family != AF_UNIX) {
+	fprintf(stderr, "%s: alien: needs a unix socket display\n", argv0);
+	return FALSE;
+    }
+    if ((Alien_Fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+	connect(Alien_Fd, (struct sockaddr *)&addr, addrlen) < 0) {
+	fprintf(stderr, "%s: alien: cannot connect: %s\n", argv0, strerror(errno));
+	return FALSE;
+    }
+
+    /* server version, then our magic with TWIN_MAGIC swapped, then server magic and TW_GO_MAGIC */
+    AlienPut(alien_magic + alien_magic[0] - sizeof(uldat), TWIN_MAGIC, sizeof(uldat));
+    if (ReadAll(Alien_Fd, buf, 1) < 0 || ReadAll(Alien_Fd, buf + 1, buf[0] - 1) < 0 ||
+	WriteAll(Alien_Fd, alien_magic, alien_magic[0]) < 0 ||
+	ReadAll(Alien_Fd, buf, 1) < 0 || ReadAll(Alien_Fd, buf + 1, buf[0] - 1) < 0 ||
+	buf[0] != alien_magic[0] || memcmp(buf, alien_magic, alien_magic[0]) ||
+	ReadAll(Alien_Fd, buf, sizeof(uldat)) < 0 || AlienGet(buf, sizeof(uldat)) != TW_GO_MAGIC) {
+	fprintf(stderr, "%s: alien: server refused an opposite-endian client\n", argv0);
+	return FALSE;
+    }
+
+    if ((Alien_Write = AlienFind("WriteHWAttrWindow", 12, "v" TWS_void_STR "x" "\xFF" "_" TWS_dat_STR
+				 "_" TWS_dat_STR "_" TWS_ldat_STR "V" TWS_hwattr_STR)) == TW_NOID ||
+	(Alien_Sync = AlienFind("SyncSocket", 2, "_" TWS_byte_STR)) == TW_NOID) {
+	fprintf(stderr, "%s: alien: server functions not found\n", argv0);
+	return FALSE;
+    }
+    return TRUE;
+}
+
+/* TwWriteHWAttrWindow() + TwSync(), as an opposite-endian libTw would send them */
+static byte AlienOp(unsigned long i) {
+    ldat j, len = (ldat)SizeX * SizeY;
+    hwcol col = (hwcol)(lrand48() & 0x7F);
+    byte c = 'A' + i % 26, *t = Alien_Buf + 4;
+    uldat code, ok;
+
+    t = AlienPut(t, ++Alien_Serial, 4);
+    t = AlienPut(t, Alien_Write, 4);
+    t = AlienPut(t, Bench_Win, 4);
+    t = AlienPut(t, 0, 2);
+    t = AlienPut(t, 0, 2);
+    t = AlienPut(t, len, 4);
+    for (j = 0; j < len; j++)
+	t = AlienPut(t, HWATTR(col, c + (j & 7)), sizeof(hwattr));
+    AlienPut(Alien_Buf, t - Alien_Buf - 4, 4);
+
+    t = AlienPut(t, 8, 4);
+    t = AlienPut(t, ++Alien_Serial, 4);
+    t = AlienPut(t, Alien_Sync, 4);
+
+    return WriteAll(Alien_Fd, Alien_Buf, t - Alien_Buf) == 0 &&
+	AlienReply(Alien_Serial, &code, &ok) && code == ALIEN_OK_MAGIC && ok;
+}
+
+static void AlienQuit(void) {
+    if (Alien_Fd >= 0)
+	close(Alien_Fd);
+}
+
+/*
+ * place: map a window with no position, so that SmartPlace() looks for room
+ * for it among Place_N - 1 windows placed the same way, then delete it.
+ * the WM places windows only after the request that maps them, so the op
+ * polls until the window has a parent: compare with `sync' for the floor.
+ */
+#define PLACE_TIMEOUT 5
+
+static unsigned long Place_N = 100;
+
+static byte PlaceWindow(void) {
+    twindow W;
+    double Deadline = Now() + PLACE_TIMEOUT;
+
+    if (!(W = TwCreateWindow
+	  (7, "twbench", NULL, Bench_Menu, COL(HIGH|WHITE,BLUE), TW_NOCURSOR,
+	   TW_WINDOW_DRAG|TW_WINDOW_RESIZE|TW_WINDOW_CLOSE, TW_WINDOWFL_USECONTENTS,
+	   10 + lrand48() % 30, 3 + lrand48() % 10, 0)))
+	return FALSE;
+    TwMapWindow(W, Bench_Screen);
+    while (!TwStat(W, TWS_widget_Parent)) {
+	if (TwInPanic() || Now() > Deadline)
+	    return FALSE;
+    }
+    Bench_Win = W;
+    return TRUE;
+}
+
+static byte PlaceInit(void) {
+    unsigned long k;
+    for (k = 1; k < Place_N; k++) {
+	if (!PlaceWindow())
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+static byte PlaceOp(unsigned long i) {
+    if (PlaceWindow()) {
+	TwDeleteObj(Bench_Win);
+	return TwSync();
+    }
+    return FALSE;
+}
+
+/* gadget: press a button, read its state back, release it */
+static byte GadgetInit(void) {
+    return NewBenchWindow(&Bench_Win, 20, 5) &&
+	(Bench_Gadget = TwCreateButtonGadget
+	 (Bench_Win, 8, 1, " Bench ", 0, (udat)1,
+	  COL(BLACK,WHITE), COL(HIGH|WHITE,GREEN), COL(HIGH|BLACK,GREEN), 2, 1));
+}
+
+static byte GadgetOp(unsigned long i) {
+    byte pressed;
+    TwSetPressedGadget(Bench_Gadget, TRUE);
+    pressed = TwIsPressedGadget(Bench_Gadget);
+    TwSetPressedGadget(Bench_Gadget, FALSE);
+    return pressed;
+}
+
+/* menu: add a row to a menu window, look it up by code, remove it */
+static byte MenuInit(void) {
+    return (Bench_MenuWin = TwWin4Menu(Bench_Menu)) &&
+	TwItem4Menu(Bench_Menu, Bench_MenuWin, TRUE, 7, " Bench ");
+}
+
+static byte MenuOp(unsigned long i) {
+    udat code = 1 + i % 0x7FFF;
+    trow R;
+
+    if ((R = TwRow4Menu(Bench_MenuWin, code, TW_ROW_ACTIVE, 9, " Bench   "))) {
+	byte ok = TwFindRowByCodeWindow(Bench_MenuWin, code) == R;
+	TwDeleteObj(R);
+	return ok;
+    }
+    return FALSE;
+}
+
+/*
+ * selection: request SelLen bytes from ourselves as owner and wait for them.
+ * big selections arrive in chunks, each sent by the server only after
+ * we read the previous one: its memory must not grow with the chunks.
+ * on unix sockets the op also checks the server peak memory stays below
+ * SEL_PEAK_MAX times SelLen per connection (plus SEL_PEAK_SLACK kB):
+ * the server holds the owner request and a copy of it, but never queues
+ * the chunks, that would be a third copy.
+ */
+#define SEL_PEAK_MAX   2
+#define SEL_PEAK_SLACK 8192
+
+static pid_t Sel_ServerPid;
+static unsigned long Sel_Peak0, Sel_Peak;
+
+/* server peak resident memory in kB, 0 if unknown */
+static unsigned long ServerPeak(void) {
+    char path[64], line[128];
+    unsigned long kb = 0;
+    FILE *f;
+
+    sprintf(path, "/proc/%lu/status", (unsigned long)Sel_ServerPid);
+    if (Sel_ServerPid && (f = fopen(path, "r"))) {
+	while (fgets(line, sizeof(line), f) && sscanf(line, "VmHWM: %lu", &kb) != 1)
+	    ;
+	fclose(f);
+    }
+    return kb;
+}
+
+static byte SelectionInit(void) {
+#ifdef SO_PEERCRED
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    char path[64];
+    int fd;
+#endif
+    uldat j;
+
+    if ((Bench_Sel = (byte *)malloc(SelLen + 1))) {
+	for (j = 0; j < SelLen; j++)
+	    Bench_Sel[j] = 'a' + j % 26;
+	strcpy(Bench_MIME, "text/plain");
+#ifdef SO_PEERCRED
+	if (getsockopt(TwConnectionFd(), SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) {
+	    /* reset the server peak to its current size, if we may */
+	    sprintf(path, "/proc/%lu/clear_refs", (unsigned long)(Sel_ServerPid = cred.pid));
+	    if ((fd = open(path, O_WRONLY)) >= 0) {
+		(void)WriteAll(fd, "5", 1);
+		close(fd);
+	    }
+	    Sel_Peak = Sel_Peak0 = ServerPeak();
+	}
+#endif
+	return TRUE;
+    }
+    return FALSE;
+}
+
+static byte SelectionOp(unsigned long i) {
+    tmsg Msg;
+    uldat got = 0;
+
+    TwRequestSelection(Bench_MsgPort, (uldat)i);
+    while ((Msg = TwReadMsg(TRUE))) {
+	if (Msg->Type == TW_MSG_SELECTIONREQUEST) {
+	    tevent_selectionrequest EventR = &Msg->Event.EventSelectionRequest;
+	    TwNotifySelection(EventR->Requestor, EventR->ReqPrivate, TW_SEL_TEXTMAGIC,
+			      Bench_MIME, SelLen, Bench_Sel);
+	} else if (Msg->Type == TW_MSG_SELECTIONNOTIFY) {
+	    tevent_selectionnotify EventN = &Msg->Event.EventSelectionNotify;
+	    if (EventN->ReqPrivate != (uldat)i)
+		continue;
+	    got += EventN->Len;
+	    if (!(EventN->Code & TW_SEL_NOTIFY_MORE))
+		break;
+	}
+    }
+    if (!Msg || Msg->Event.EventSelectionNotify.Magic != TW_SEL_TEXTMAGIC || got != SelLen)
+	return FALSE;
+    if (Sel_Peak0 && (Sel_Peak = ServerPeak()) > Sel_Peak0 &&
+	Sel_Peak - Sel_Peak0 > Conns * (SEL_PEAK_MAX * (SelLen >> 10) + SEL_PEAK_SLACK))
+	return FALSE;
+    return TRUE;
+}
+
+static void SelectionQuit(void) {
+    if (Sel_Peak0)
+	sprintf(Bench_Extra, "server_peak_kb=+%lu", Sel_Peak > Sel_Peak0 ? Sel_Peak - Sel_Peak0 : 0);
+}
+
+/*
+ * echo: keypress-to-echo latency of a terminal while Chatty other terminals
+ * flood the server with output.
+ *
+ * all terminals are ptys handed to the server with the "pty" extension, so
+ * the server reads them itself next to the client sockets; with more than
+ * REMOTE_MAXTTY of them busy, this shows whether a keypress still gets
+ * through RemoteInputEvent() ahead of the pty output.
+ * keys are injected by attaching ourselves as a display and sending them
+ * to its helper msgport, just like twdisplay does; the op ends when the
+ * echoed character shows up in the DPY_DrawHWAttr messages for that display.
+ */
+#define ECHO_TIMEOUT 5
+
+/* fork a child on the slave side of a new pty, return the master or -1 */
+static int EchoFork(pid_t *pid, byte echo) {
+    int fd, sfd, i, n;
+    char *name, c, buf[4096];
+    struct termios tio;
+
+    if ((fd = open("/dev/ptmx", O_RDWR|O_NOCTTY)) < 0)
+	return -1;
+    if (grantpt(fd) < 0 || unlockpt(fd) < 0 || !(name = ptsname(fd)) ||
+	(*pid = fork()) < 0) {
+	close(fd);
+	return -1;
+    }
+    if (*pid)
+	return fd;
+
+    /* child: close everything we inherited, libTw socket included */
+    setsid();
+    if ((sfd = open(name, O_RDWR)) < 0)
+	_exit(1);
+    dup2(sfd, 0);
+    dup2(sfd, 1);
+    for (i = 2, n = sysconf(_SC_OPEN_MAX); i < n && i < 1024; i++)
+	close(i);
+
+    if (echo) {
+	tcgetattr(0, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(0, TCSANOW, &tio);
+	buf[0] = '\r';
+	while (read(0, &c, 1) == 1) {
+	    buf[1] = c;
+	    if (write(1, buf, 2) != 2)
+		break;
+	}
+    } else {
+	for (i = 0; i < (int)sizeof(buf); i++)
+	    buf[i] = (i + 1) % 72 ? 'a' + i % 26 : '\n';
+	while (write(1, buf, sizeof(buf)) > 0)
+	    ;
+    }
+    _exit(0);
+}
+
+/* hand the master side of a pty to the server, to feed window W with its output */
+static byte PtyAttach(twindow W, int fd) {
+    static textension Pty_Extension;
+
+    if (!Pty_Extension && !(Pty_Extension = TwOpenExtension(3, "pty"))) {
+	fprintf(stderr, "%s: server has no \"pty\" extension\n", argv0);
+	return FALSE;
+    }
+    return TwSendFd(fd) && TwCallLExtension(Pty_Extension, TWPTY_PROTO, 1, (topaque)W);
+}
+
+/* open a terminal window and hand the master side of a new pty to the server */
+static byte EchoTerm(twindow *W, byte echo, dat X, dat Y, int *Fd) {
+    pid_t pid;
+    int fd;
+
+    if (!(*W = TwCreateWindow
+	  (7, "twbench", NULL, Bench_Menu, COL(WHITE,BLACK), TW_NOCURSOR,
+	   TW_WINDOW_WANT_CHANGES|(echo ? TW_WINDOW_WANT_KEYS : 0),
+	   TW_WINDOWFL_USECONTENTS, X, Y, 0)))
+	return FALSE;
+
+    if ((fd = EchoFork(&pid, echo)) < 0) {
+	fprintf(stderr, "%s: echo: cannot open a pty: %s\n", argv0, strerror(errno));
+	return FALSE;
+    }
+    Echo_Pid[Echo_NPid++] = pid;
+
+    if (!PtyAttach(*W, fd)) {
+	close(fd);
+	return FALSE;
+    }
+    if (Fd)
+	*Fd = fd;
+    else
+	close(fd);
+    return TRUE;
+}
+
+/* return the next message, or NULL if none arrives before Deadline */
+static tmsg EchoReadMsg(double Deadline) {
+    struct timeval t;
+    fd_set fds;
+    tmsg Msg;
+    double left;
+    int fd = TwConnectionFd(), n;
+
+    while (!(Msg = TwReadMsg(FALSE)) && !TwInPanic() && (left = Deadline - Now()) > 0.0) {
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+	t.tv_sec = (long)left;
+	t.tv_usec = (long)((left - t.tv_sec) * 1e6);
+	if ((n = select(fd + 1, &fds, NULL, NULL, &t)) == 0 || (n < 0 && errno != EINTR))
+	    break;
+    }
+    return Msg;
+}
+
+static byte EchoAttach(void) {
+    char buf[64];
+    TW_CONST byte *reply;
+    uldat len;
+    tmsg Msg;
+    double Deadline;
+
+    sprintf(buf, "-hw=display@(twbench),x=%d,y=%d", (int)DisplayX, (int)DisplayY);
+    TwAttachHW(strlen(buf), (TW_CONST byte *)buf, 0);
+    TwFlush();
+    while ((reply = TwAttachGetReply(&len)) > (TW_CONST byte *)2) {
+	if (reply == (TW_CONST byte *)-1)
+	    return FALSE;
+    }
+    if (!reply)
+	return FALSE;
+    TwAttachConfirm();
+
+    Deadline = Now() + ECHO_TIMEOUT;
+    while ((Msg = EchoReadMsg(Deadline))) {
+	if (Msg->Type == TW_MSG_DISPLAY && Msg->Event.EventDisplay.Code == TW_DPY_Helper) {
+	    Echo_Helper = *(uldat *)Msg->Event.EventDisplay.Data;
+	    return TRUE;
+	}
+    }
+    return FALSE;
+}
+
+static byte EchoInit(void) {
+    unsigned long k;
+
+    /* keys go to the focused window: a second connection would steal it */
+    if (Conns != 1) {
+	fprintf(stderr, "%s: echo: needs --conns=1\n", argv0);
+	return FALSE;
+    }
+    if (!(Echo_Pid = (pid_t *)malloc((Chatty + 1) * sizeof(pid_t))) || !EchoAttach())
+	return FALSE;
+
+    for (k = 0; k < Chatty; k++) {
+	twindow W;
+	if (!EchoTerm(&W, FALSE, 40, 10, NULL))
+	    return FALSE;
+	TwConfigureWindow(W, 0x3, lrand48() / (MAXLRAND48 / DisplayX),
+			  lrand48() / (MAXLRAND48 / DisplayY), 0, 0, 0, 0);
+	TwMapWindow(W, Bench_Screen);
+    }
+    /* mapped last, so it is on top and focused */
+    if (!EchoTerm(&Echo_Win, TRUE, 12, 3, &Echo_Fd))
+	return FALSE;
+    TwConfigureWindow(Echo_Win, 0x3, 0, 1, 0, 0, 0, 0);
+    TwMapWindow(Echo_Win, Bench_Screen);
+
+    /*
+     * display coordinates of the first cell inside the echo window:
+     * window Left and Up are already reported inside the border
+     * and relative to the screen scrolling, screen Up is its YLimit
+     */
+    Echo_X = (dat)TwStat(Echo_Win, TWS_widget_Left);
+    Echo_Y = (dat)(TwStat(Echo_Win, TWS_widget_Up) + TwStat(Bench_Screen, TWS_widget_Up));
+    return !TwInPanic();
+}
+
+static byte EchoOp(unsigned long i) {
+    tmsg Msg;
+    tevent_keyboard EventK;
+    tevent_display EventD;
+    byte c = 'A' + i % 26;
+    hwattr h;
+    double Deadline = Now() + ECHO_TIMEOUT;
+
+    if (!(Msg = TwCreateMsg(TW_MSG_WIDGET_KEY, 1 + sizeof(struct s_tevent_keyboard))))
+	return FALSE;
+    EventK = &Msg->Event.EventKeyboard;
+    EventK->Code = c;
+    EventK->ShiftFlags = 0;
+    EventK->SeqLen = 1;
+    EventK->AsciiSeq[0] = c;
+    EventK->AsciiSeq[1] = '\0';
+    TwBlindSendMsg(Echo_Helper, Msg);
+    TwFlush();
+
+    while ((Msg = EchoReadMsg(Deadline))) {
+	if (Msg->Type == TW_MSG_WIDGET_KEY && Msg->Event.EventKeyboard.W == Echo_Win) {
+	    EventK = &Msg->Event.EventKeyboard;
+	    if (WriteAll(Echo_Fd, EventK->AsciiSeq, EventK->SeqLen) < 0)
+		return FALSE;
+	} else if (Msg->Type == TW_MSG_DISPLAY && Msg->Event.EventDisplay.Code == TW_DPY_DrawHWAttr) {
+	    EventD = &Msg->Event.EventDisplay;
+	    if (EventD->Y == Echo_Y && EventD->X <= Echo_X &&
+		Echo_X - EventD->X < EventD->Len / (udat)sizeof(hwattr)) {
+		memcpy(&h, EventD->Data + (Echo_X - EventD->X) * sizeof(hwattr), sizeof(hwattr));
+		if (HWFONT(h) == c)
+		    return TRUE;
+	    }
+	}
+    }
+    return FALSE;
+}
+
+static void EchoQuit(void) {
+    while (Echo_NPid)
+	kill(Echo_Pid[--Echo_NPid], SIGKILL);
+    if (Echo_Fd >= 0)
+	close(Echo_Fd);
+}
+
+/*
+ * term, term-direct: throughput and latency of pty output into a terminal
+ * window, forwarded with TwWriteAsciiWindow() as twterm does, or read by the
+ * server itself through the "pty" extension, as `twterm -direct' does.
+ * we play the program on the slave side: each op writes Term_Chunk bytes of
+ * text lines, forwarding them if needed, then a cursor move to a column
+ * other than the one of the previous op. it ends when the server reports
+ * the cursor there, i.e. it has processed the whole chunk.
+ */
+#define TERM_TIMEOUT 5
+
+static unsigned long Term_Chunk = 4096;
+static byte Term_Direct;
+static int Term_Master = -1, Term_Slave = -1;
+static byte *Term_Buf;
+
+static byte TermInit(void) {
+    struct termios tio;
+    char *name;
+    unsigned long j;
+
+    /* room for the cursor move */
+    if (!(Term_Buf = (byte *)malloc(Term_Chunk + 16)))
+	return FALSE;
+    for (j = 0; j < Term_Chunk; j++)
+	Term_Buf[j] = j % 72 == 70 ? '\r' : j % 72 == 71 ? '\n' : 'a' + j % 26;
+
+    if ((Term_Master = open("/dev/ptmx", O_RDWR|O_NOCTTY)) < 0 ||
+	grantpt(Term_Master) < 0 || unlockpt(Term_Master) < 0 || !(name = ptsname(Term_Master)) ||
+	(Term_Slave = open(name, O_RDWR|O_NOCTTY)) < 0) {
+	fprintf(stderr, "%s: term: cannot open a pty: %s\n", argv0, strerror(errno));
+	return FALSE;
+    }
+    /* raw, so that the master reads exactly what we write */
+    tcgetattr(Term_Slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(Term_Slave, TCSANOW, &tio);
+    fcntl(Term_Slave, F_SETFL, O_NONBLOCK);
+
+    if (!(Bench_Win = TwCreateWindow
+	  (7, "twbench", NULL, Bench_Menu, COL(WHITE,BLACK), TW_NOCURSOR,
+	   TW_WINDOW_WANT_CHANGES, TW_WINDOWFL_USECONTENTS, SizeX, SizeY, 0)))
+	return FALSE;
+    TwConfigureWindow(Bench_Win, 0x3, 0, 1, 0, 0, 0, 0);
+    TwMapWindow(Bench_Win, Bench_Screen);
+
+    if (Term_Direct)
+	return PtyAttach(Bench_Win, Term_Master);
+    /* not in direct mode: the server would share the flag */
+    fcntl(Term_Master, F_SETFL, O_NONBLOCK);
+    return TRUE;
+}
+
+static byte TermDirectInit(void) {
+    Term_Direct = TRUE;
+    return TermInit();
+}
+
+/* forward what the master has to read, as twterm does */
+static byte TermForward(unsigned long *Got) {
+    byte buf[4096];
+    ssize_t n;
+
+    while ((n = read(Term_Master, buf, sizeof(buf))) > 0) {
+	*Got += n;
+	TwWriteAsciiWindow(Bench_Win, n, buf);
+	TwFlush();
+    }
+    return n < 0 && (errno == EAGAIN || errno == EINTR);
+}
+
+static byte TermOp(unsigned long i) {
+    struct pollfd p[2];
+    unsigned long len, wrote = 0, got = 0;
+    ssize_t n;
+    dat x = 1 + i % (SizeX - 1);
+    double Deadline = Now() + TERM_TIMEOUT;
+
+    len = Term_Chunk + sprintf((char *)Term_Buf + Term_Chunk, "\033[%d;%dH", (int)SizeY, (int)x);
+
+    p[0].fd = Term_Slave;
+    p[0].events = POLLOUT;
+    p[1].fd = Term_Master;
+    p[1].events = POLLIN;
+
+    while (wrote < len) {
+	if (poll(p, Term_Direct ? 1 : 2, -1) < 0 && errno != EINTR)
+	    return FALSE;
+	if ((p[0].revents & POLLOUT) &&
+	    (n = write(Term_Slave, Term_Buf + wrote, len - wrote)) > 0)
+	    wrote += n;
+	if (!Term_Direct && !TermForward(&got))
+	    return FALSE;
+    }
+    while (!Term_Direct && got < len) {
+	if ((poll(p + 1, 1, -1) < 0 && errno != EINTR) || !TermForward(&got))
+	    return FALSE;
+    }
+    while (TwStat(Bench_Win, TWS_window_CurX) != x - 1) {
+	if (TwInPanic() || Now() > Deadline)
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+static void TermQuit(void) {
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    sprintf(Bench_Extra, "chunk_bytes=%lu client_cpu_ms=%.1f", Term_Chunk,
+	    (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e3 + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e-3);
+    if (Term_Slave >= 0)
+	close(Term_Slave);
+    if (Term_Master >= 0)
+	close(Term_Master);
+}
+
+/*
+ * drag: synthetic mouse drags over the window of a slow client, with the
+ * socket bytes and CPU time it took that client to read them.
+ *
+ * the drags are injected through an attached display, as in `echo'.
+ * the window belongs to a forked receiver on its own connection, that
+ * spends Drag_Work microseconds on each mouse msg, as a client redrawing
+ * on motion would: once it falls behind, the server merges the motion it
+ * did not read yet. `drag-all' sets TW_WINDOW_WANT_ALL_MOTION, to get
+ * every sample as before, for comparison. The op is a whole drag:
+ * a press, Drag_Steps moves, each one synced, and a release.
+ */
+#define DRAG_X 40
+#define DRAG_Y 12
+#define DRAG_IDLE 5
+
+typedef struct drag_report {
+    unsigned long moves, releases, bytes;
+    double cpu;
+} drag_report;
+
+static unsigned long Drag_Work = 50, Drag_Steps = 50;
+static byte Drag_All;
+static int Drag_In = -1;
+static pid_t Drag_Pid;
+static dat Drag_X, Drag_Y;
+
+static void Spin(unsigned long usec) {
+    double end = Now() + usec * 1e-6;
+    while (Now() < end)
+	;
+}
+
+/* bytes the server wrote to the socket of Port, from the "perf" extension */
+static unsigned long DragBytes(tdisplay td, tmsgport Port) {
+    textension eid;
+    topaque i;
+    unsigned long bytes = 0;
+
+    if ((eid = Tw_OpenExtension(td, 4, "perf"))) {
+	for (i = 0; Tw_CallLExtension(td, eid, TWP_PROTO, 3, (topaque)TWP_msgport, i, (topaque)TWP_Exists); i++) {
+	    if ((tmsgport)Tw_CallLExtension(td, eid, TWP_PROTO, 3, (topaque)TWP_msgport, i, (topaque)TWP_Id) == Port) {
+		bytes = Tw_CallLExtension(td, eid, TWP_PROTO, 3, (topaque)TWP_msgport, i, (topaque)TWP_msgport_BytesOut);
+		break;
+	    }
+	}
+	Tw_CloseExtension(td, eid);
+    }
+    return bytes;
+}
+
+/*
+ * body of the receiver: it forks after TwOpen(), so it leaves that
+ * connection alone and opens its own with Tw_Open().
+ * sends the display coordinates of its window, then one drag_report
+ * after N releases, or after DRAG_IDLE seconds without msgs.
+ */
+static int DragRecv(int out) {
+    tdisplay td;
+    tmsgport Port;
+    tmenu Menu;
+    tscreen Screen;
+    twindow W;
+    tmsg Msg;
+    drag_report R;
+    struct rusage ru;
+    struct timeval t;
+    fd_set fds;
+    dat XY[2];
+    int fd;
+
+    close(TwConnectionFd());
+    memset(&R, 0, sizeof(R));
+
+    if (!(td = Tw_Open(DisplayName)) || !(Port = Tw_CreateMsgPort(td, 11, "twbench-rcv")) ||
+	!(Screen = Tw_FirstScreen(td)) ||
+	!(Menu = Tw_CreateMenu
+	  (td, COL(BLACK,WHITE), COL(BLACK,GREEN), COL(HIGH|BLACK,WHITE), COL(HIGH|BLACK,BLACK),
+	   COL(RED,WHITE), COL(RED,GREEN), (byte)0)) ||
+	!(W = Tw_CreateWindow
+	  (td, 11, "twbench-rcv", NULL, Menu, COL(HIGH|WHITE,BLUE), TW_NOCURSOR,
+	   TW_WINDOW_WANT_MOUSE|TW_WINDOW_WANT_MOUSE_MOTION|(Drag_All ? TW_WINDOW_WANT_ALL_MOTION : 0),
+	   TW_WINDOWFL_USECONTENTS, DRAG_X, DRAG_Y, 0)))
+	return 1;
+    Tw_ConfigureWindow(td, W, 0x3, 0, 1, 0, 0, 0, 0);
+    Tw_MapWindow(td, W, Screen);
+
+    /* as in EchoInit() */
+    XY[0] = (dat)Tw_Stat(td, W, TWS_widget_Left);
+    XY[1] = (dat)(Tw_Stat(td, W, TWS_widget_Up) + Tw_Stat(td, Screen, TWS_widget_Up));
+    if (Tw_InPanic(td) || WriteAll(out, XY, sizeof(XY)) < 0)
+	return 1;
+
+    fd = Tw_ConnectionFd(td);
+    while (R.releases < N) {
+	while ((Msg = Tw_ReadMsg(td, FALSE))) {
+	    if (Msg->Type == TW_MSG_WIDGET_MOUSE) {
+		if (isMOVE(Msg->Event.EventMouse.Code))
+		    R.moves++;
+		else if (isRELEASE(Msg->Event.EventMouse.Code))
+		    R.releases++;
+		Spin(Drag_Work);
+	    }
+	}
+	if (R.releases >= N || Tw_InPanic(td))
+	    break;
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+	t.tv_sec = DRAG_IDLE;
+	t.tv_usec = 0;
+	if (select(fd + 1, &fds, NULL, NULL, &t) == 0)
+	    break;
+    }
+    R.bytes = DragBytes(td, Port);
+    getrusage(RUSAGE_SELF, &ru);
+    R.cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+    Tw_Close(td);
+    return WriteAll(out, &R, sizeof(R)) < 0;
+}
+
+static byte DragInit(void) {
+    int p[2];
+    dat XY[2];
+
+    if (Conns != 1) {
+	fprintf(stderr, "%s: drag: needs --conns=1\n", argv0);
+	return FALSE;
+    }
+    if (!EchoAttach() || !TwSync())
+	return FALSE;
+
+    if (pipe(p) < 0 || (Drag_Pid = fork()) < 0)
+	return FALSE;
+    if (Drag_Pid == 0) {
+	close(p[0]);
+	_exit(DragRecv(p[1]));
+    }
+    close(p[1]);
+    Drag_In = p[0];
+    if (ReadAll(Drag_In, XY, sizeof(XY)) < 0) {
+	fprintf(stderr, "%s: drag: receiver failed to start\n", argv0);
+	return FALSE;
+    }
+    Drag_X = XY[0];
+    Drag_Y = XY[1];
+    return TRUE;
+}
+
+static byte DragAllInit(void) {
+    Drag_All = TRUE;
+    return DragInit();
+}
+
+/* move the mouse of the attached display to (X, Y) with the given buttons held */
+static byte DragMouse(udat Code, dat X, dat Y) {
+    tmsg Msg;
+    tevent_mouse EventM;
+
+    if (!(Msg = TwCreateMsg(TW_MSG_WIDGET_MOUSE, sizeof(struct s_tevent_mouse))))
+	return FALSE;
+    EventM = &Msg->Event.EventMouse;
+    EventM->W = TW_NOID;
+    EventM->Code = Code;
+    EventM->ShiftFlags = 0;
+    EventM->X = X;
+    EventM->Y = Y;
+    TwBlindSendMsg(Echo_Helper, Msg);
+    return TwSync();
+}
+
+/* a zigzag across the window, starting from a random cell */
+static byte DragOp(unsigned long i) {
+    unsigned long s, k = lrand48();
+    byte ok = DragMouse(HOLD_LEFT, Drag_X + k % DRAG_X, Drag_Y + k % DRAG_Y);
+
+    for (s = 1; ok && s <= Drag_Steps; s++)
+	ok = DragMouse(HOLD_LEFT, Drag_X + (k + s) % DRAG_X, Drag_Y + (k + s / DRAG_X) % DRAG_Y);
+    return ok && DragMouse(0, Drag_X + (k + s - 1) % DRAG_X, Drag_Y + (k + (s - 1) / DRAG_X) % DRAG_Y);
+}
+
+static void DragQuit(void) {
+    drag_report R;
+    int status;
+
+    if (Drag_In >= 0 && ReadAll(Drag_In, &R, sizeof(R)) == 0)
+	sprintf(Bench_Extra, "recv_moves=%lu recv_releases=%lu recv_bytes=%lu recv_cpu_ms=%.1f",
+		R.moves, R.releases, R.bytes, R.cpu * 1e3);
+    if (Drag_Pid > 0) {
+	kill(Drag_Pid, SIGKILL);
+	waitpid(Drag_Pid, &status, 0);
+    }
+}
+
+static scenario Scenarios[] = {
+    { "sync",      "synchronous request/reply round-trip",		NULL,          SyncOp,      NULL },
+    { "window",    "create, map and delete a random window",		NULL,          WindowOp,    NULL },
+    { "write",     "TwWriteHWAttrWindow() of a whole window",		WriteInit,     WriteOp,     NULL },
+    { "alien",     "`write' from an opposite-endian client",		AlienInit,     AlienOp,     AlienQuit },
+    { "place",     "map a window where SmartPlace() finds room",	PlaceInit,     PlaceOp,     NULL },
+    { "gadget",    "press, query and release a button gadget",		GadgetInit,    GadgetOp,    NULL },
+    { "menu",      "create, find and delete a menu row",		MenuInit,      MenuOp,      NULL },
+    { "selection", "selection request/notify round-trip",		SelectionInit, SelectionOp, SelectionQuit },
+    { "echo",      "keypress-to-echo latency next to chatty ptys",	EchoInit,      EchoOp,      EchoQuit },
+    { "term",      "pty output forwarded to a window, as twterm",	TermInit,      TermOp,      TermQuit },
+    { "term-direct", "pty output read by the server, as twterm -direct", TermDirectInit, TermOp,   TermQuit },
+    { "drag",      "mouse drags over the window of a slow client",	DragInit,      DragOp,      DragQuit },
+    { "drag-all",  "`drag' with TW_WINDOW_WANT_ALL_MOTION",		DragAllInit,   DragOp,      DragQuit },
+    { NULL, NULL, NULL, NULL, NULL }
+};
+
+
+static void LibTwError(void) {
+    uldat err;
+    if ((err = TwErrno))
+	fprintf(stderr, "%s: libTw error: %s%s\n", argv0,
+		TwStrError(err), TwStrErrorDetail(err, TwErrnoDetail));
+}
+
+TW_DECL_MAGIC(bench_magic);
+
+/* body of each child: connect, set up, wait for `go', run, report */
+static int RunConn(scenario *S, unsigned long k, int ready, int go, int out) {
+    bench_result R;
+    unsigned long *lat, i;
+    double t;
+    char c = 0;
+
+    memset(&R, 0, sizeof(R));
+    srand48(Seed + k);
+
+    if (!(lat = (unsigned long *)malloc(N * sizeof(unsigned long))) ||
+	!TwCheckMagic(bench_magic) || !TwOpen(DisplayName) ||
+	!(Bench_MsgPort = TwCreateMsgPort(7, "twbench")) ||
+	!(Bench_Menu = TwCreateMenu
+	  (COL(BLACK,WHITE), COL(BLACK,GREEN), COL(HIGH|BLACK,WHITE), COL(HIGH|BLACK,BLACK),
+	   COL(RED,WHITE), COL(RED,GREEN), (byte)0)) ||
+	!(Bench_Screen = TwFirstScreen()) ||
+	!(DisplayX = TwGetDisplayWidth()) || !(DisplayY = TwGetDisplayHeight()) ||
+	(S->Init && !S->Init()) || !TwSync()) {
+
+	if (S->Quit)
+	    S->Quit();
+	LibTwError();
+	return 1;
+    }
+    TwInfo4Menu(Bench_Menu, TW_ROW_ACTIVE, 9, " twbench ", NULL);
+
+    /* tell the parent we are ready, then block until it closes `go' */
+    if (WriteAll(ready, &c, 1) < 0)
+	return 1;
+    close(ready);
+    if (read(go, &c, 1) < 0)
+	return 1;
+
+    R.start = Now();
+    for (i = 0; i < N; i++) {
+	t = Now();
+	if (!S->Op(i)) {
+	    R.errors++;
+	    if (TwInPanic())
+		break;
+	}
+	lat[i] = (unsigned long)((Now() - t) * 1e6 + 0.5);
+    }
+    R.end = Now();
+    R.n = i;
+
+    if (S->Quit)
+	S->Quit();
+    strcpy(R.extra, Bench_Extra);
+
+    if (WriteAll(out, &R, sizeof(R)) < 0 || WriteAll(out, lat, R.n * sizeof(unsigned long)) < 0)
+	return 1;
+
+    if (TwInPanic()) {
+	LibTwError();
+	return 1;
+    }
+    TwDeleteMsgPort(Bench_MsgPort);
+    TwClose();
+    return 0;
+}
+
+static int CmpULong(TW_CONST void *a, TW_CONST void *b) {
+    unsigned long x = *(TW_CONST unsigned long *)a, y = *(TW_CONST unsigned long *)b;
+    return x < y ? -1 : x > y;
+}
+
+static unsigned long Percentile(unsigned long *lat, unsigned long n, unsigned p) {
+    /* p is in tenths of percent */
+    return lat[(n - 1) * p / 1000];
+}
+
+static int RunScenario(scenario *S) {
+    int ready[2], go[2], *out;
+    pid_t *pid;
+    bench_result R;
+    unsigned long *lat, n = 0, errors = 0, k, alive = 0;
+    char extra[sizeof(R.extra)] = "";
+    double start = 0.0, end = 0.0, sum = 0.0, secs;
+    char c;
+    int status, ret = 0;
+
+    if (!(out = (int *)malloc(Conns * sizeof(int))) ||
+	!(pid = (pid_t *)malloc(Conns * sizeof(pid_t))) ||
+	!(lat = (unsigned long *)malloc(Conns * N * sizeof(unsigned long)))) {
+	fprintf(stderr, "%s: out of memory\n", argv0);
+	return 1;
+    }
+    if (pipe(ready) < 0 || pipe(go) < 0) {
+	fprintf(stderr, "%s: pipe() failed: %s\n", argv0, strerror(errno));
+	return 1;
+    }
+
+    for (k = 0; k < Conns; k++) {
+	int p[2];
+	if (pipe(p) < 0 || (pid[k] = fork()) < 0) {
+	    fprintf(stderr, "%s: fork() failed: %s\n", argv0, strerror(errno));
+	    Conns = k;
+	    ret = 1;
+	    break;
+	}
+	if (pid[k] == 0) {
+	    close(ready[0]);
+	    close(go[1]);
+	    close(p[0]);
+	    _exit(RunConn(S, k, ready[1], go[0], p[1]));
+	}
+	close(p[1]);
+	out[k] = p[0];
+    }
+    close(ready[1]);
+    close(go[0]);
+
+    /* wait for all children to be connected and set up, then start them */
+    for (k = 0; k < Conns && read(ready[0], &c, 1) == 1; k++)
+	;
+    close(ready[0]);
+    close(go[1]);
+
+    for (k = 0; k < Conns; k++) {
+	if (ReadAll(out[k], &R, sizeof(R)) == 0 &&
+	    ReadAll(out[k], lat + n, R.n * sizeof(unsigned long)) == 0) {
+
+	    if (!alive++ || R.start < start)
+		start = R.start;
+	    if (R.end > end)
+		end = R.end;
+	    n += R.n;
+	    errors += R.errors;
+	    if (R.extra[0])
+		strcpy(extra, R.extra);
+	}
+	close(out[k]);
+    }
+    for (k = 0; k < Conns; k++) {
+	if (waitpid(pid[k], &status, 0) == pid[k] && (!WIFEXITED(status) || WEXITSTATUS(status)))
+	    ret = 1;
+    }
+
+    secs = end - start;
+    printf("scenario=%s conns=%lu seed=%lu ops=%lu errors=%lu", S->name, alive, Seed, n, errors);
+    if (n) {
+	qsort(lat, n, sizeof(unsigned long), CmpULong);
+	for (k = 0; k < n; k++)
+	    sum += lat[k];
+	printf(" seconds=%.3f ops_per_sec=%.1f mean_us=%.1f min_us=%lu p50_us=%lu p90_us=%lu"
+	       " p99_us=%lu p999_us=%lu max_us=%lu",
+	       secs, secs > 0.0 ? n / secs : 0.0, sum / n, lat[0],
+	       Percentile(lat, n, 500), Percentile(lat, n, 900),
+	       Percentile(lat, n, 990), Percentile(lat, n, 999), lat[n - 1]);
+    }
+    if (extra[0])
+	printf(" %s", extra);
+    printf("\n");
+    fflush(stdout);
+
+    free(lat);
+    free(pid);
+    free(out);
+    return ret || alive < Conns || errors;
+}
+
+static void Usage(void) {
+    scenario *S;
+
+    fprintf(stderr, "Usage: %s [OPTIONS] [SCENARIO ...]\n"
+	    "Currently known options:\n"
+	    " -h, --help              display this help and exit\n"
+	    " -V, --version           output version information and exit\n"
+	    " --twin@<dpy>            set the server to contact (default is $TWDISPLAY)\n"
+	    " --ops=<N>               ops per connection (default 1000)\n"
+	    " --conns=<N>             concurrent connections (default 1)\n"
+	    " --seed=<N>              random seed, connection k uses seed+k (default 1)\n"
+	    " --size=<X>x<Y>          window size for `write' and `alien' (default 80x25)\n"
+	    " --sel-len=<N>           selection size for `selection' (default 256)\n"
+	    " --chatty=<N>            busy terminals next to `echo' (default 8)\n"
+	    " --chunk=<N>             pty bytes per op for `term' (default 4096)\n"
+	    " --windows=<N>           windows on screen for `place' (default 100)\n"
+	    " --drag-steps=<N>        moves per drag for `drag' (default 50)\n"
+	    " --drag-work=<N>         usec the `drag' receiver spends per msg (default 50)\n"
+	    "Currently known scenarios (default is all of them):\n",
+	    argv0);
+    for (S = Scenarios; S->name; S++)
+	fprintf(stderr, " %-23s %s\n", S->name, S->help);
+}
+
+static void ShowVersion(void) {
+    fputs("twbench " TWIN_VERSION_STR "\n", stdout);
+}
+
+int main(int argc, char *argv[]) {
+    scenario *S;
+    char **names;
+    int i, ret = 0;
+    long x, y;
+
+    TwMergeHyphensArgv(argc, argv);
+
+    argv0 = argv[0];
+    names = argv + 1;
+
+    if (argc == 2) {
+	if (!strcmp(argv[1], "-h") || !strcmp(argv[1], "-help")) {
+	    Usage();
+	    return 0;
+	} else if (!strcmp(argv[1], "-V") || !strcmp(argv[1], "-version")) {
+	    ShowVersion();
+	    return 0;
+	}
+    }
+
+    /* scenario names are compacted at the start of argv[1...] */
+    for (i = 1; i < argc; i++) {
+	if (!strncmp(argv[i], "-twin@", 6))
+	    DisplayName = argv[i] + 6;
+	else if (!strncmp(argv[i], "-ops=", 5))
+	    N = strtoul(argv[i] + 5, NULL, 0);
+	else if (!strncmp(argv[i], "-conns=", 7))
+	    Conns = strtoul(argv[i] + 7, NULL, 0);
+	else if (!strncmp(argv[i], "-seed=", 6))
+	    Seed = strtoul(argv[i] + 6, NULL, 0);
+	else if (!strncmp(argv[i], "-size=", 6) &&
+		 sscanf(argv[i] + 6, "%ldx%ld", &x, &y) == 2 &&
+		 x > 0 && y > 0 && x <= TW_MAXDAT && y <= TW_MAXDAT)
+	    SizeX = (dat)x, SizeY = (dat)y;
+	else if (!strncmp(argv[i], "-sel-len=", 9))
+	    SelLen = strtoul(argv[i] + 9, NULL, 0);
+	else if (!strncmp(argv[i], "-chatty=", 8))
+	    Chatty = strtoul(argv[i] + 8, NULL, 0);
+	else if (!strncmp(argv[i], "-chunk=", 7) && strtoul(argv[i] + 7, NULL, 0))
+	    Term_Chunk = strtoul(argv[i] + 7, NULL, 0);
+	else if (!strncmp(argv[i], "-windows=", 9))
+	    Place_N = strtoul(argv[i] + 9, NULL, 0);
+	else if (!strncmp(argv[i], "-drag-steps=", 12))
+	    Drag_Steps = strtoul(argv[i] + 12, NULL, 0);
+	else if (!strncmp(argv[i], "-drag-work=", 11))
+	    Drag_Work = strtoul(argv[i] + 11, NULL, 0);
+	else if (argv[i][0] != '-') {
+	    for (S = Scenarios; S->name && strcmp(S->name, argv[i]); S++)
+		;
+	    if (!S->name)
+		break;
+	    *names++ = argv[i];
+	} else
+	    break;
+    }
+    if (i < argc || !N || !Conns) {
+	fprintf(stderr, "%s: argument `%s' not recognized\n"
+		"\ttry `%s --help' for usage summary.\n", argv0, i < argc ? argv[i] : argv[argc - 1], argv0);
+	return 1;
+    }
+    *names = NULL;
+
+    /* a child may die while we write to its pipe */
+    signal(SIGPIPE, SIG_IGN);
+
+    for (S = Scenarios; S->name; S++) {
+	for (names = argv + 1; *names && strcmp(*names, S->name); names++)
+	    ;
+	if (*names || !argv[1])
+	    ret |= RunScenario(S);
+    }
+    return ret;
+}
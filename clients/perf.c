@@ -0,0 +1,139 @@
+/*
+ *  perf.c  --  print twin server performance counters
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <Tw/Tw.h>
+#include <Tw/Twerrno.h>
+#include <Tw/Twstat.h>
+#include <Tw/Twstat_defs.h>
+#include <Tw/Twperf.h>
+
+static tdisplay td;
+static textension eid;
+
+static int errmsg(void) {
+    int err;
+    if ((err = Tw_Errno(td))) {
+	fprintf(stderr, "twperf: libTw error: %s%s\n",
+		Tw_StrError(td, err), Tw_StrErrorDetail(td, err, Tw_ErrnoDetail(td)));
+    }
+    return !!err;
+}
+
+static unsigned long get(tany scope, tany index, tany counter) {
+    return (unsigned long)Tw_CallLExtension(td, eid, TWP_PROTO, 3, scope, index, counter);
+}
+
+static void printhist(TW_CONST char *name, tany base) {
+    unsigned long n;
+    int i;
+    
+    printf("  %s histogram (usec):\n", name);
+    for (i = 0; i < TWP_HIST_N; i++) {
+	if ((n = get(TWP_global, 0, base + i)))
+	    printf("    [%lu, %lu)\t%lu\n", i ? 1ul << i : 0ul, 2ul << i, n);
+    }
+}
+
+static void printname(tobj id) {
+    tslist reply;
+    tsfield f;
+    
+    if ((reply = Tw_StatL(td, id, 1, TWS_msgport_Name))) {
+	if (reply->N >= 1 && (f = reply->TSF) &&
+	    f->type == (TWS_vec|TWS_byte) && f->hash == TWS_msgport_Name)
+	    
+	    printf("%.*s", (int)f->TWS_field_vecL, (TW_CONST byte *)f->TWS_field_vecV);
+	Tw_DeleteStat(td, reply);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    tany i;
+    int err;
+    
+    if (!(td = Tw_Open(NULL)) || !(eid = Tw_OpenExtension(td, 4, "perf"))) {
+	if (!errmsg())
+	    fprintf(stderr, "twperf: server has no `perf' extension\n");
+	if (td)
+	    Tw_Close(td);
+	return 1;
+    }
+    /* draws are timed only while the extension is open: give them some time */
+    if (argc > 1 && (i = atoi(argv[1])) > 0) {
+	Tw_Flush(td);
+	sleep(i);
+    }
+
+    printf("startup usec:\n"
+	   "  core %lu, display %lu, wm %lu, first frame %lu, other displays %lu\n"
+	   "  live upgrade pause %lu\n",
+	   get(TWP_global, 0, TWP_global_StartCore), get(TWP_global, 0, TWP_global_StartHW),
+	   get(TWP_global, 0, TWP_global_StartWM), get(TWP_global, 0, TWP_global_StartFrame),
+	   get(TWP_global, 0, TWP_global_StartMoreHW), get(TWP_global, 0, TWP_global_UpgradeUsec));
+    
+    printf("global:\n"
+	   "  msgport runs %lu, msgs %lu\n"
+	   "  draw calls %lu, usec %lu\n"
+	   "  flush calls %lu, usec %lu\n"
+	   "  printk lines dropped %lu\n"
+	   "  memory quota soft %lu, hard %lu kbytes: throttled %lu, disconnected %lu clients\n",
+	   get(TWP_global, 0, TWP_global_MsgPortRuns), get(TWP_global, 0, TWP_global_Msgs),
+	   get(TWP_global, 0, TWP_global_DrawCalls), get(TWP_global, 0, TWP_global_DrawUsec),
+	   get(TWP_global, 0, TWP_global_FlushCalls), get(TWP_global, 0, TWP_global_FlushUsec),
+	   get(TWP_global, 0, TWP_global_PrintkDropped),
+	   get(TWP_global, 0, TWP_global_MemSoft) >> 10, get(TWP_global, 0, TWP_global_MemHard) >> 10,
+	   get(TWP_global, 0, TWP_global_MemThrottles), get(TWP_global, 0, TWP_global_MemKills));
+    printhist("draw", TWP_global_DrawHist);
+    printhist("flush", TWP_global_FlushHist);
+    
+    printf("displays:\n");
+    for (i = 0; get(TWP_display, i, TWP_Exists); i++) {
+	printf("  0x%lx:\tflushes %lu, cells %lu, usec %lu\n",
+	       get(TWP_display, i, TWP_Id),
+	       get(TWP_display, i, TWP_display_FlushCalls),
+	       get(TWP_display, i, TWP_display_FlushCells),
+	       get(TWP_display, i, TWP_display_FlushUsec));
+    }
+    
+    printf("msgports:\n");
+    for (i = 0; get(TWP_msgport, i, TWP_Exists); i++) {
+	printf("  0x%lx:\truns %lu, msgs %lu, bytes in %lu, out %lu, mem %lu kbytes (peak %lu)%s\t",
+	       get(TWP_msgport, i, TWP_Id),
+	       get(TWP_msgport, i, TWP_msgport_Runs),
+	       get(TWP_msgport, i, TWP_msgport_Msgs),
+	       get(TWP_msgport, i, TWP_msgport_BytesIn),
+	       get(TWP_msgport, i, TWP_msgport_BytesOut),
+	       get(TWP_msgport, i, TWP_msgport_MemUsed) >> 10,
+	       get(TWP_msgport, i, TWP_msgport_MemPeak) >> 10,
+	       get(TWP_msgport, i, TWP_msgport_MemThrottled) ? " throttled" : "");
+	printname((tobj)get(TWP_msgport, i, TWP_Id));
+	putchar('\n');
+    }
+    
+    printf("slots:\n");
+    for (i = 0; get(TWP_slot, i, TWP_Exists); i++) {
+	printf("  %lu:\tfired %lu, bytes in %lu, out %lu\n",
+	       get(TWP_slot, i, TWP_Id),
+	       get(TWP_slot, i, TWP_slot_Fired),
+	       get(TWP_slot, i, TWP_slot_BytesIn),
+	       get(TWP_slot, i, TWP_slot_BytesOut));
+    }
+    fflush(stdout);
+    
+    err = errmsg();
+    
+    Tw_CloseExtension(td, eid);
+    Tw_Close(td);
+    
+    return err;
+}
@@ -50,6 +50,7 @@
 #include <Tw/Tw.h>
 
 #include "term.h"
+#include "pty.h"
 
 /* pseudo-teletype connections handling functions */
 
@@ -222,13 +223,13 @@ static byte switchto_tty(void)
 }
 
 /* 5. fork() a program in a pseudo-teletype */
-uldat Spawn(twindow Window, pid_t *ppid, dat X, dat Y, TW_CONST byte *arg0, byte * TW_CONST *argv) {
+int Spawn(twindow Window, pid_t *ppid, dat X, dat Y, TW_CONST byte *arg0, byte * TW_CONST *argv) {
 
     TwGetPrivileges();
     
     if (!get_pty()) {
 	TwDropPrivileges();
-	return FALSE;
+	return TW_NOFD;
     }
     (void)fixup_pty(X, Y);
     
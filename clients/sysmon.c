@@ -30,9 +30,101 @@ tmenu SysMon_Menu;
 twindow SysMon_Win;
 
 byte numeric = 1;
+uldat interval = 1000; /* milliseconds between samples */
 
 char buf[TW_BIGBUFF];
 
+/*
+ * each sample is drawn into CanvasText[] and CanvasCol[] first, then only the cells
+ * that differ from what the server already shows (ShownText[], ShownCol[])
+ * are sent, all in the single TwFlush() that follows.
+ */
+#define ROWS 5
+#define COLS 29
+#define COL_LABEL COL(HIGH|YELLOW,BLUE)
+
+static byte CanvasText[ROWS][COLS], ShownText[ROWS][COLS];
+static hwcol CanvasCol[ROWS][COLS], ShownCol[ROWS][COLS];
+static dat CanvasX, CanvasY, CanvasW;
+
+static void CanvasGotoXY(dat x, dat y) {
+    CanvasX = x;
+    CanvasY = y;
+}
+
+static void CanvasWrite(hwcol col, uldat len, TW_CONST char *s) {
+    while (len-- && CanvasX < CanvasW) {
+	CanvasText[CanvasY][CanvasX] = *s++;
+	CanvasCol[CanvasY][CanvasX++] = col;
+    }
+}
+
+/* reset the canvas to the labels InitSysMon() wrote */
+static void CanvasClear(void) {
+    static TW_CONST char *labels[ROWS] = { "CPU", "DISK", "MEM", "SWAP", "UPTIME" };
+    dat y;
+    
+    TwWriteMem(CanvasText, ' ', sizeof(CanvasText));
+    TwWriteMem(CanvasCol, COL_LABEL, sizeof(CanvasCol));
+    for (y = 0; y < ROWS; y++)
+	TwCopyMem(labels[y], CanvasText[y], strlen(labels[y]));
+}
+
+static void CanvasSend(void) {
+    dat x, y, start, end;
+    hwcol col;
+    
+    for (y = 0; y < ROWS; y++) {
+	for (start = 0; start < CanvasW && CanvasText[y][start] == ShownText[y][start] &&
+	     CanvasCol[y][start] == ShownCol[y][start]; start++)
+	    ;
+	if (start == CanvasW)
+	    continue;
+	for (end = CanvasW; CanvasText[y][end-1] == ShownText[y][end-1] &&
+	     CanvasCol[y][end-1] == ShownCol[y][end-1]; end--)
+	    ;
+	
+	TwGotoXYWindow(SysMon_Win, start, y);
+	for (x = start; x < end; x = start) {
+	    col = CanvasCol[y][x];
+	    while (++start < end && CanvasCol[y][start] == col)
+		;
+	    TwSetColTextWindow(SysMon_Win, col);
+	    TwWriteAsciiWindow(SysMon_Win, start - x, CanvasText[y] + x);
+	}
+	TwCopyMem(CanvasText[y], ShownText[y], CanvasW);
+	TwCopyMem(CanvasCol[y], ShownCol[y], CanvasW * sizeof(hwcol));
+    }
+}
+
+/* /proc files are opened once, then re-read from the start with pread() */
+typedef struct {
+    TW_CONST char *name;
+    int Fd;
+} procfile;
+
+static procfile ProcStat = { "/proc/stat", TW_NOFD }, ProcDiskStats = { "/proc/diskstats", TW_NOFD },
+    ProcMemInfo = { "/proc/meminfo", TW_NOFD }, ProcUptime = { "/proc/uptime", TW_NOFD };
+
+/* read the whole file into buf[]; return FALSE if it cannot be read */
+static byte ReadProc(procfile *P) {
+    uldat len = 0;
+    int got = 0;
+    
+    if (P->Fd == TW_NOFD && (P->Fd = open(P->name, O_RDONLY)) == TW_NOFD)
+	return FALSE;
+    
+    while (len < TW_BIGBUFF - 1 && (got = pread(P->Fd, buf + len, TW_BIGBUFF - 1 - len, len)) > 0)
+	len += got;
+    if (got < 0 && !len) {
+	close(P->Fd);
+	P->Fd = TW_NOFD;
+	return FALSE;
+    }
+    buf[len] = '\0';
+    return TRUE;
+}
+
 TW_DECL_MAGIC(sysmon_magic);
 
 byte InitSysMon(int argc, char ** argv) {
@@ -65,7 +157,17 @@ byte InitSysMon(int argc, char ** argv) {
 	    border = 1;
 	else if (!strcmp(*argv, "-border"))
 	    border = 0;
+	else if (argc > 1 && !strcmp(*argv, "-interval")) {
+	    /* milliseconds; sampling faster than 10 times a second makes little sense */
+	    if ((interval = strtoul(*++argv, NULL, 0)) < 100)
+		interval = 100;
+	    argc--;
+	}
     }
+    CanvasW = numeric ? COLS : COLS - 5;
+    CanvasClear();
+    TwCopyMem(CanvasText, ShownText, sizeof(CanvasText));
+    TwCopyMem(CanvasCol, ShownCol, sizeof(CanvasCol));
     
     return
 	TwCheckMagic(sysmon_magic) && TwOpen(NULL) &&
@@ -79,7 +181,7 @@ byte InitSysMon(int argc, char ** argv) {
 	(SysMon_Win = TwCreateWindow
 	 (len, name, NULL, SysMon_Menu, COL(HIGH|YELLOW,BLUE),
 	  TW_NOCURSOR, TW_WINDOW_DRAG|TW_WINDOW_CLOSE, (border ? 0 : TW_WINDOWFL_BORDERLESS),
-	  numeric ? 29 : 24, 5, 0)) &&
+	  CanvasW, ROWS, 0)) &&
 
 	(TwSetColorsWindow(SysMon_Win, 0x1FF,
 			   (hwcol)0x3F, (hwcol)0, (hwcol)0, (hwcol)0, (hwcol)0x9F,
@@ -98,8 +200,6 @@ uldat HBar(hwcol Col, uldat len, uldat scale, uldat frac) {
     byte *s = buf;
     
     if (len) {
-	TwSetColTextWindow(SysMon_Win, Col|half);
-	
 	len *= WIDTH;
 	len += frac;
 	
@@ -109,7 +209,7 @@ uldat HBar(hwcol Col, uldat len, uldat scale, uldat frac) {
 	    frac = 0;
 	TwWriteMem(s, '\xDB', len/scale/2);
 	
-	TwWriteAsciiWindow(SysMon_Win, len/scale/2 + !!frac, buf);
+	CanvasWrite(Col|half, len/scale/2 + !!frac, buf);
 	
 	half = COL(0, COLFG(Col));
 	frac = len % (scale*2);
@@ -123,8 +223,7 @@ void PrintPercent(hwcol Col, uldat percent) {
 	percent = 100;
     sprintf(buf, " %3d%%", percent);
     
-    TwSetColTextWindow(SysMon_Win, Col);
-    TwWriteAsciiWindow(SysMon_Win, 5, buf);
+    CanvasWrite(Col, 5, buf);
 }
 
 void PrintAbsoluteK(hwcol Col, unsigned long nK) { 
@@ -149,27 +248,22 @@ void PrintAbsoluteK(hwcol Col, unsigned long nK) {
     else
 	sprintf(buf, "    0");
 	
-    TwSetColTextWindow(SysMon_Win, Col);
-    TwWriteAsciiWindow(SysMon_Win, 5, buf);
+    CanvasWrite(Col, 5, buf);
 }
 
 void Update(void) {
-    static int Fd;
     static unsigned long CpuUser[2], CpuNice[2], CpuSystem[2], CpuIdle[2],
 	CpuWait[2], CpuHardInt[2], CpuSoftInt[2], CpuTotal;
     static unsigned long DiskR[2], DiskW[2], DiskMax;
     static unsigned long MemUsed, MemShared, MemBuff, MemCache, MemFree, MemTotal;
     static unsigned long SwapUsed, SwapFree, SwapTotal;
     static byte i;
-    uldat len, tmp;
+    uldat tmp;
     char *s, *e, *e2;
     
-    if ((Fd = open("/proc/stat", O_RDONLY)) != TW_NOFD) {
-	s = buf;
-	len = 0;
-	while ((tmp = read(Fd, s, TW_BIGBUFF - len)) > 0)
-	    len += tmp, s += tmp;
-	buf[len] = '\0';
+    CanvasClear();
+    
+    if (ReadProc(&ProcStat)) {
 	if ((s = strstr(buf, "cpu "))) {
 	    CpuUser[i] = strtoul(s+4, &e, 0) - CpuUser[!i];
 	    CpuNice[i] = strtoul(e, &s, 0) - CpuNice[!i];
@@ -210,18 +304,11 @@ void Update(void) {
 	    DiskR[i] -= DiskR[!i];
 	    DiskW[i] -= DiskW[!i];
 	}
-
-	close(Fd);
     }
 
-    if ((Fd = open("/proc/diskstats", O_RDONLY)) != TW_NOFD) {
+    if (ReadProc(&ProcDiskStats)) {
 	/* linux kernel 2.6 disk stats: */
 
-	s = buf;
-	len = 0;
-	while ((tmp = read(Fd, s, TW_BIGBUFF - len)) > 0)
-	    len += tmp, s += tmp;
-	buf[len] = '\0';
 	s = buf;
 
 	DiskR[i] = DiskW[i] = 0;
@@ -246,8 +333,6 @@ void Update(void) {
 
 	DiskR[i] -= DiskR[!i];
 	DiskW[i] -= DiskW[!i];
-	
-	close(Fd);
     }
 
     if (DiskMax) {
@@ -261,12 +346,7 @@ void Update(void) {
 	DiskMax = 1;
     }
 
-    if ((Fd = open("/proc/meminfo", O_RDONLY)) != TW_NOFD) {
-	s = buf;
-	len = 0;
-	while ((tmp = read(Fd, s, TW_BIGBUFF - len)) > 0)
-	    len += tmp, s += tmp;
-	buf[len] = '\0';
+    if (ReadProc(&ProcMemInfo)) {
 	if ((s = strstr(buf, "MemTotal:")))
 	    MemTotal = strtoul(s+9, &e, 0), s = e;
 	if ((s = strstr(buf, "MemFree:")))
@@ -294,12 +374,10 @@ void Update(void) {
 	if ((s = strstr(buf, "SwapFree:")))
 	    SwapFree = strtoul(s+9, &e, 0), s = e;
 	SwapUsed = SwapTotal - SwapFree;
-
-	close(Fd);
     }
 
     if (CpuTotal) {
-	TwGotoXYWindow(SysMon_Win, 4, 0);
+	CanvasGotoXY(4, 0);
 	if (numeric)
 	    PrintPercent(COL(HIGH|YELLOW,BLUE), 100 * (CpuTotal - CpuIdle[i] - CpuWait[i]) / CpuTotal);
 	tmp = HBar(COL(HIGH|GREEN,0), CpuUser[i],   CpuTotal, 0);
@@ -311,7 +389,7 @@ void Update(void) {
 	(void)HBar(COL(BLUE,0),       CpuIdle[i],   CpuTotal, tmp);
     }
     if (DiskMax) {
-	TwGotoXYWindow(SysMon_Win, 4, 1);
+	CanvasGotoXY(4, 1);
 	if (numeric)
 	    PrintAbsoluteK(COL(HIGH|YELLOW,BLUE), (DiskR[i]+DiskW[i])>>1);
 	tmp = HBar(COL(HIGH|GREEN,0), DiskR[i], DiskMax, 0);
@@ -319,7 +397,7 @@ void Update(void) {
 	(void)HBar(COL(BLUE,0),       DiskMax - DiskR[i] - DiskW[i], DiskMax, tmp);
     }
     if (MemTotal) {
-	TwGotoXYWindow(SysMon_Win, 4, 2);
+	CanvasGotoXY(4, 2);
 	if (numeric)
 	    PrintAbsoluteK(COL(HIGH|YELLOW,BLUE), (MemTotal-MemFree));
 	tmp = HBar(COL(HIGH|GREEN,0), MemUsed,   MemTotal, 0);
@@ -329,31 +407,23 @@ void Update(void) {
 	(void)HBar(COL(BLUE,0),       MemFree,   MemTotal, tmp);
     }
     if (SwapTotal) {
-	TwGotoXYWindow(SysMon_Win, 4, 3);
+	CanvasGotoXY(4, 3);
 	if (numeric)
 	    PrintAbsoluteK(COL(HIGH|YELLOW,BLUE), SwapUsed);
 	tmp = HBar(COL(HIGH|GREEN,0), SwapUsed,  SwapTotal, 0);
 	(void)HBar(COL(BLUE,0),       SwapFree,  SwapTotal, tmp);
     }
 
-    TwSetColTextWindow(SysMon_Win, COL(WHITE,BLUE));
-
     /*
      * --- Uptime ---
      * Print to SysMon Window
      * added by Mohammad Bahathir Hashim <bakhtiar@softhome.net>
      */
-    if ((Fd = open("/proc/uptime", O_RDONLY)) != TW_NOFD) {
+    if (ReadProc(&ProcUptime)) {
 
 	unsigned long updays;
 	int uphours, upminutes;
 
-	s = buf;
-	len = 0;
-	while ((tmp = read(Fd, s, TW_BIGBUFF - len)) > 0)
-	    len += tmp, s += tmp;
-	buf[len] = '\0';
-
 	updays = strtoul(buf, NULL, 0);
 	/*upseconds = updays % 60;*/
 	upminutes = (updays /= 60) % 60;
@@ -362,11 +432,11 @@ void Update(void) {
 	
 	sprintf(buf, "%d days %2d:%02d", (int)updays, uphours, upminutes);
 
-	TwGotoXYWindow(SysMon_Win, 8, 4);
-	TwWriteAsciiWindow(SysMon_Win, strlen(buf), buf);
-
-	close(Fd);
+	CanvasGotoXY(8, 4);
+	CanvasWrite(COL(WHITE,BLUE), strlen(buf), buf);
     }
+    
+    CanvasSend();
 
     CpuUser[i] += CpuUser[!i];
     CpuNice[i] += CpuNice[!i];
@@ -412,8 +482,8 @@ int main(int argc, char *argv[]) {
 	    Update();
 	    TwFlush();
 	    
-	    p.tv_sec = 1;
-	    p.tv_usec = 0;
+	    p.tv_sec = interval / 1000;
+	    p.tv_usec = interval % 1000 * 1000;
 	}
 
 	while ((Msg = TwReadMsg(FALSE))) {
@@ -35,6 +35,8 @@
 
 #include <Tw/Tw.h>
 #include <Tw/Twerrno.h>
+#include <Tw/Twstat.h>
+#include <Tw/Twpty.h>
 #include <Tutf/Tutf.h>
 
 #include "version.h"
@@ -50,6 +52,10 @@ static tmsgport Term_MsgPort;
 static tmenu Term_Menu;
 static uldat WinN;
 
+/* with -direct, the server reads our ptys itself, see <Tw/Twpty.h> */
+static byte flag_direct;
+static textension Pty_Extension;
+
 fd_set save_rfds;
 uldat max_fds;
 int twin_fd;
@@ -247,6 +253,19 @@ static twindow newTermWindow(byte *title) {
     return Window;
 }
 
+/*
+ * hand a copy of the pty master to the server: it will parse the output,
+ * while we keep the child, the keyboard and the resizes.
+ * on failure we just keep forwarding the output ourselves.
+ */
+static void DirectTerm(uldat Slot) {
+    if (Pty_Extension && TwSendFd(LS.Fd) &&
+	TwCallLExtension(Pty_Extension, TWPTY_PROTO, 1, (topaque)LS.Window)) {
+	
+	FD_CLR(LS.Fd, &save_rfds);
+    }
+}
+
 static byte OpenTerm(TW_CONST byte *arg0, byte * TW_CONST *argv) {
     twindow Window;
     int Fd;
@@ -270,6 +289,8 @@ static byte OpenTerm(TW_CONST byte *arg0, byte * TW_CONST *argv) {
     if ((Window = newTermWindow(title))) {
 	if ((Fd = Spawn(Window, &Pid, 80, 25, arg0, argv)) != TW_NOFD) {
 	    if ((Slot = RegisterRemote(Fd, Window, Pid)) != TW_NOSLOT) {
+		if (flag_direct)
+		    DirectTerm(Slot);
 		TwMapWindow(Window, Term_Screen);
 		WinN++;
 		return !TwInPanic();
@@ -314,12 +335,15 @@ static void RemotePidIsDead(pid_t pid) {
 
 static void HandleSignalChild(void) {
     pid_t pid;
-    int status;
+    int status, save_errno = errno;
+    
     while ((pid = wait3(&status, WNOHANG, (struct rusage *)0)) != 0 && pid != (pid_t)-1) {
 	if (WIFEXITED(status) || WIFSIGNALED(status))
 	    RemotePidIsDead(pid);
     }
     ReceivedSignalChild = FALSE;
+    /* wait3() fails with ECHILD at the end: don't confuse select() callers */
+    errno = save_errno;
 }
 
 static byte Add_Spawn_Row4Menu(twindow Window) {
@@ -366,6 +390,7 @@ static byte InitTerm(void) {
 	TwItem4Menu(Term_Menu, Window, TRUE, 6, " File ") &&
 	TwItem4MenuCommon(Term_Menu) &&
 	(Term_Screen = TwFirstScreen()) &&
+	(!flag_direct || (Pty_Extension = TwOpenExtension(3, "pty")), TRUE) &&
 	(OpenTerm(NULL, NULL)))
 	 
 	return TRUE;
@@ -485,6 +510,7 @@ static void Usage(char *name) {
 	    " -h, --help              display this help and exit\n"
 	    " -V, --version           output version information and exit\n"
 	    " -t <title>              set window title\n"
+	    " -direct                 let the server read terminal output directly\n"
 	    " -e <command>            run <command> instead of user's shell\n"
 	    "                         (must be last option)\n", name);
 }
@@ -513,6 +539,8 @@ int main(int argc, char *argv[]) {
 	} else if (!strcmp(*argv, "-V") || !strcmp(*argv, "-version")) {
 	    ShowVersion();
 	    return 0;
+	} else if (!strcmp(*argv, "-direct")) {
+	    flag_direct = TRUE;
 	} else if (argc > 1 && !strcmp(*argv, "-t")) {
 	    default_title = *++argv;
 	    argc--;
@@ -569,7 +597,11 @@ int main(int argc, char *argv[]) {
 	    
 	    if (ReceivedSignalChild)
 		HandleSignalChild();
-	} while (num_fds < 0 && errno == EINTR);
+	    /*
+	     * with -direct, SIGCHLD is the only way we learn our terminals died:
+	     * stop waiting if it was the last one.
+	     */
+	} while (num_fds < 0 && errno == EINTR && WinN);
 
 	if (num_fds < 0 && errno != EINTR) {
 	    /* panic! */
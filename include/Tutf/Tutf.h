@@ -679,6 +679,7 @@
 
 typedef hwfont *Tutf_array;
 typedef hwfont (*Tutf_function)(hwfont);
+typedef void (*Tutf_function_n)(TUTF_CONST hwfont *src, hwfont *dst, uldat n);
 
 
 
@@ -701,6 +702,14 @@ Tutf_function Tutf_UTF_16_to_charset_function(uldat id);
 /* return the array to translate from given charset to UTF-16 */
 Tutf_array Tutf_charset_to_UTF_16_array(uldat id);
 
+/*
+ * return a function capable to translate n chars at once from UTF-16
+ * to the same charset as `f', which must come from Tutf_UTF_16_to_charset_function()
+ * or be one of the specific translation functions below.
+ * returns NULL if `f' is unknown.
+ */
+Tutf_function_n Tutf_UTF_16_to_charset_function_n(Tutf_function f);
+
 
 /* specific translation functions */
 
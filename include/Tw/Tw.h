@@ -154,6 +154,7 @@ struct s_tevent_display {
 #define TW_DPY_Helper		((udat)14)
 #define TW_DPY_RedrawVideo	((udat)15)
 #define TW_DPY_Quit		((udat)16)
+#define TW_DPY_RowHash		((udat)17)
 
 typedef struct s_tevent_keyboard *tevent_keyboard;
 /** type for keypress events */
@@ -217,7 +218,7 @@ typedef struct s_tevent_selectionnotify *tevent_selectionnotify;
 /** type for selection notification event (selection owner sends clipboard to who asks for it) */
 struct s_tevent_selectionnotify {
     twidget W;
-    udat Code, pad; /* unused */
+    udat Code, pad; /* Code is 0 or TW_SEL_NOTIFY_MORE */
     uldat ReqPrivate;
     uldat Magic;
     byte MIME[TW_MAX_MIMELEN];
@@ -233,6 +234,9 @@ struct s_tevent_selectionnotify {
 #define TW_SEL_DATAMAGIC	((uldat)0xDA1AA1AD) /* check MIME if you get this */
 #define TW_SEL_IDMAGIC		((uldat)0x49644964)
 
+/*SelectionNotify Code: big selections arrive in several chunks, all but the last have this set */
+#define TW_SEL_NOTIFY_MORE	((udat)0x0001)
+
 typedef struct s_tevent_selectionrequest *tevent_selectionrequest;
 /** type to request selection to owner */
 struct s_tevent_selectionrequest {
@@ -124,6 +124,11 @@
 #define TW_WIDGET_WANT_MOUSE	0x0004
 #define TW_WIDGET_WANT_CHANGES	0x0008
 #define TW_WIDGET_AUTO_FOCUS	0x0010
+/*
+ * mouse motion not yet read by the client is merged with newer motion
+ * for the same widget and buttons. this asks to get every sample instead.
+ */
+#define TW_WIDGET_WANT_ALL_MOTION	0x0020
 
 /* Widget->Flags */
 #define TW_WIDGETFL_USEEXPOSE	0x02
@@ -142,6 +147,7 @@
 #define TW_GADGET_WANT_MOUSE	TW_WIDGET_WANT_MOUSE	/* 0x0004 */
 #define TW_GADGET_WANT_CHANGES	TW_WIDGET_WANT_CHANGES	/* 0x0008 */
 #define TW_GADGET_AUTO_FOCUS	TW_WIDGET_AUTO_FOCUS	/* 0x0010 */
+#define TW_GADGET_WANT_ALL_MOTION	TW_WIDGET_WANT_ALL_MOTION /* 0x0020 */
 
 
 /* Gadget->Flags */
@@ -168,6 +174,7 @@
 #define TW_WINDOW_WANT_MOUSE	TW_WIDGET_WANT_MOUSE	/* 0x0004 */
 #define TW_WINDOW_WANT_CHANGES	TW_WIDGET_WANT_CHANGES	/* 0x0008 */
 #define TW_WINDOW_AUTO_FOCUS	TW_WIDGET_AUTO_FOCUS	/* 0x0010 */
+#define TW_WINDOW_WANT_ALL_MOTION	TW_WIDGET_WANT_ALL_MOTION /* 0x0020 */
 #define TW_WINDOW_DRAG		0x0100
 #define TW_WINDOW_RESIZE	0x0200
 #define TW_WINDOW_CLOSE		0x0400
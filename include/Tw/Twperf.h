@@ -0,0 +1,77 @@
+/*
+ *  Twperf.h  --  performance counters exported by twin server
+ *                through the "perf" extension.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef _TW_PERF_H
+#define _TW_PERF_H
+
+/*
+ * usage: eid = Tw_OpenExtension(td, 4, "perf");
+ *        value = Tw_CallLExtension(td, eid, TWP_PROTO, 3, scope, index, counter);
+ *
+ * index is 0 for TWP_global, otherwise it selects the n-th display,
+ * msgport or fd slot in the server. Reading TWP_Exists of an index past the end
+ * returns 0, so clients can enumerate them. All other counters are cumulative
+ * since the object was created, except memory usage and quotas which are current values.
+ */
+#define TWP_PROTO "_"TWS_tany_STR "_"TWS_topaque_STR "_"TWS_topaque_STR "_"TWS_topaque_STR
+
+/* scopes */
+#define TWP_global		0
+#define TWP_display		1
+#define TWP_msgport		2
+#define TWP_slot		3
+
+/* histograms count durations in buckets of powers of two microseconds: [0,2) [2,4) [4,8) ... */
+#define TWP_HIST_N		16
+
+/* counters valid in all scopes */
+#define TWP_Exists		0x00 /* 1 if the object exists, 0 otherwise */
+#define TWP_Id			0x01 /* object id usable with Tw_Stat(), or slot number for TWP_slot */
+
+#define TWP_global_MsgPortRuns	0x02 /* msgport handlers invoked by main loop */
+#define TWP_global_Msgs		0x03 /* msgs they found in their queues */
+#define TWP_global_DrawCalls	0x04 /* calls to DrawAreaCtx(), only while some client has this extension open */
+#define TWP_global_DrawUsec	0x05 /* total time spent in them */
+#define TWP_global_FlushCalls	0x06 /* display flushes, all displays */
+#define TWP_global_FlushUsec	0x07 /* total time spent in them */
+#define TWP_global_StartCore	0x08 /* startup phases, in usec: core data structures */
+#define TWP_global_StartHW	0x09 /* first display */
+#define TWP_global_StartWM	0x0A /* drawing and window manager */
+#define TWP_global_StartFrame	0x0B /* main loop until first frame */
+#define TWP_global_StartMoreHW	0x0C /* other `--hw=' displays, attached after first frame */
+#define TWP_global_PrintkDropped 0x0D /* log lines dropped by printk() rate limit or full buffer */
+#define TWP_global_UpgradeUsec	0x0E /* pause of the live upgrade this server started from, or 0 */
+#define TWP_global_DrawHist	0x10 /* ... + TWP_HIST_N - 1 */
+#define TWP_global_FlushHist	0x20 /* ... + TWP_HIST_N - 1 */
+#define TWP_global_MemSoft	0x30 /* per-client soft memory quota in bytes (--memsoft), or 0 */
+#define TWP_global_MemHard	0x31 /* per-client hard memory quota in bytes (--memhard), or 0 */
+#define TWP_global_MemThrottles	0x32 /* times a client went over the soft quota */
+#define TWP_global_MemKills	0x33 /* clients disconnected for going over the hard quota */
+
+#define TWP_display_FlushCalls	0x02 /* FlushVideo() + FlushHW() on this display */
+#define TWP_display_FlushCells	0x03 /* dirty cells they pushed */
+#define TWP_display_FlushUsec	0x04 /* total time spent in them */
+
+#define TWP_msgport_Runs	0x02 /* handler invocations */
+#define TWP_msgport_Msgs	0x03 /* msgs found in queue at each invocation */
+#define TWP_msgport_Slot	0x04 /* fd slot of the client, or (topaque)-1 */
+#define TWP_msgport_BytesIn	0x05 /* bytes read from client socket */
+#define TWP_msgport_BytesOut	0x06 /* bytes written to client socket */
+#define TWP_msgport_MemUsed	0x07 /* bytes used by owned windows and data queued on the socket */
+#define TWP_msgport_MemPeak	0x08 /* highest MemUsed seen */
+#define TWP_msgport_MemThrottled 0x09 /* 1 if over the soft quota and throttled */
+
+#define TWP_slot_Fired		0x02 /* times the fd was found ready and dispatched */
+#define TWP_slot_BytesIn	0x03 /* bytes read, only for client sockets */
+#define TWP_slot_BytesOut	0x04 /* bytes written from the slot write queue */
+
+#endif /* _TW_PERF_H */
+
@@ -0,0 +1,32 @@
+/*
+ *  Twpty.h  --  let twin server read a client's pty directly
+ *               through the "pty" extension.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ */
+
+#ifndef _TW_TWPTY_H
+#define _TW_TWPTY_H
+
+/*
+ * usage: eid = Tw_OpenExtension(td, 3, "pty");
+ *        Tw_SendFd(td, pty_master_fd);
+ *        ok = Tw_CallLExtension(td, eid, TWPTY_PROTO, 1, (topaque)Window);
+ *
+ * Window must be a TW_WINDOWFL_USECONTENTS window owned by the caller
+ * and must have TW_WINDOW_WANT_CHANGES: the server only reads the pty and feeds
+ * the output to the window terminal emulator, while keyboard input, resizes
+ * and the child process itself stay with the client, exactly as before.
+ * When the pty hangs up, the server closes its copy and stops reading it;
+ * the client learns about the child exiting from SIGCHLD as usual.
+ *
+ * ok is 1 on success; on 0 the client should keep forwarding the output itself.
+ */
+#define TWPTY_PROTO "_"TWS_tany_STR "_"TWS_topaque_STR
+
+#endif /* _TW_TWPTY_H */
+
@@ -171,6 +171,9 @@
 #define TWS_window_MaxYWidth		0x0325
 #define TWS_window_WLogic		0x0326
 #define TWS_window_HLogic		0x0327
+#define TWS_window_ReadCalls		0x0328
+#define TWS_window_ReadBytes		0x0329
+#define TWS_window_ReadRate		0x032A
 #define TWS_window_USE_C_Contents	0x0330
 #define TWS_window_USE_C_HSplit		0x0331
 #define TWS_window_USE_R_FirstRow	0x0332
@@ -410,6 +413,9 @@
 	EL(window_MaxYWidth) \
 	EL(window_WLogic) \
 	EL(window_HLogic) \
+	EL(window_ReadCalls) \
+	EL(window_ReadBytes) \
+	EL(window_ReadRate) \
 	EL(window_USE_C_Contents) \
 	EL(window_USE_C_HSplit) \
 	EL(window_USE_R_FirstRow) \
@@ -118,6 +118,8 @@
 
 #define TwConnectionFd()	Tw_ConnectionFd(Tw_DefaultD)
 
+#define TwSendFd(a1)	Tw_SendFd(Tw_DefaultD, a1)
+
 #define TwLibraryVersion()	Tw_LibraryVersion(Tw_DefaultD)
 #define TwServerVersion()	Tw_ServerVersion(Tw_DefaultD)
 
@@ -119,6 +119,8 @@ byte Tw_SendMsg(tdisplay TwD, tmsgport MsgPort,tmsg Msg);
 void Tw_BlindSendMsg(tdisplay TwD, tmsgport MsgPort,tmsg Msg);
 
 int Tw_ConnectionFd(tdisplay TwD);
+/** pass a file descriptor to the server (unix sockets only), see <Tw/Twpty.h> */
+byte Tw_SendFd(tdisplay TwD, int fd);
 
 uldat Tw_LibraryVersion(tdisplay TwD);
 uldat Tw_ServerVersion(tdisplay TwD);
@@ -140,6 +140,7 @@
 #define TwSetOwnerSelection(a1, a2)		Tw_SetOwnerSelection(Tw_DefaultD, a1, a2)
 #define TwRequestSelection(a1, a2)		Tw_RequestSelection(Tw_DefaultD, a1, a2)
 #define TwNotifySelection(a1, a2, a3, a4, a5, a6)		Tw_NotifySelection(Tw_DefaultD, a1, a2, a3, a4, a5, a6)
+#define TwAckSelection(a1)		Tw_AckSelection(Tw_DefaultD, a1)
 
 #define TwSetServerUid(a1, a2)		Tw_SetServerUid(Tw_DefaultD, a1, a2)
 
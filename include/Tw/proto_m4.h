@@ -168,6 +168,7 @@ tobj  Tw_GetOwnerSelection(tdisplay TwD);
 void  Tw_SetOwnerSelection(tdisplay TwD, tany secnow, tany fracnow);
 void  Tw_RequestSelection(tdisplay TwD, tobj owner, uldat reqprivate);
 void  Tw_NotifySelection(tdisplay TwD, tobj requestor, uldat reqprivate, uldat magic, TW_CONST byte *mine, uldat len, TW_CONST byte *data);
+void  Tw_AckSelection(tdisplay TwD, uldat reqprivate);
 
 byte  Tw_SetServerUid(tdisplay TwD, uldat uid, byte privileges);
 
@@ -139,6 +139,8 @@ DECL(byte,SendMsg,        tmsgport MsgPort, tmsg Msg)
 DECL(void,BlindSendMsg,   tmsgport MsgPort, tmsg Msg)
 
 DECL(int,ConnectionFd)
+c_doxygen(/** pass a file descriptor to the server (unix sockets only), see <Tw/Twpty.h> */)
+DECL(byte,SendFd, int fd)
 
 DECL(uldat,LibraryVersion)
 DECL(uldat,ServerVersion)
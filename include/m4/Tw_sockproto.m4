@@ -198,6 +198,7 @@ PROTO(void,v, SetOwner,Selection,0, tany,_,secnow, tany,_,fracnow)
 PROTO(void,v,  Request,Selection,0, obj,x,owner, uldat,_,reqprivate)
 PROTO(void,v,   Notify,Selection,0, obj,x,requestor, uldat,_,reqprivate, uldat,_,magic,
       byte,V(TW_MAX_MIMELEN),mine, uldat,_,len, byte,V(A(5)),data)
+PROTO(void,v,      Ack,Selection,0, uldat,_,reqprivate)
 
 PROTO(byte,_, SetServer,Uid,0, uldat,_,uid, byte,_,privileges)
 
@@ -24,8 +24,14 @@
 # define th_mutex_init(__mx)     pthread_mutex_init(&(__mx), NULL)
 # define th_mutex_destroy(__mx)  pthread_mutex_destroy(&(__mx))
 # define th_mutex_lock(__mx)     pthread_mutex_lock(&(__mx))
+# define th_mutex_trylock(__mx)  (pthread_mutex_trylock(&(__mx)) == 0)
 # define th_mutex_unlock(__mx)   pthread_mutex_unlock(&(__mx))
 
+# define th_key                  pthread_key_t
+# define th_key_create(__k, __fn) pthread_key_create(&(__k), (__fn))
+# define th_key_get(__k)         pthread_getspecific(__k)
+# define th_key_set(__k, __v)    pthread_setspecific((__k), (__v))
+
 
 /* implementation of recursive mutexes. use native ones if available, else emulate. */
 
@@ -36,6 +42,7 @@
 #  define th_r_mutex_init(__mx)     th_mutex_init(__mx)
 #  define th_r_mutex_destroy(__mx)  th_mutex_destroy(__mx)
 #  define th_r_mutex_lock(__mx)     th_mutex_lock(__mx)
+#  define th_r_mutex_trylock(__mx)  th_mutex_trylock(__mx)
 #  define th_r_mutex_unlock(__mx)   th_mutex_unlock(__mx)
 #  define TH_R_MUTEX_HELPER_DEFS(attr) typedef th_r_mutex _th_r_mutex
 
@@ -47,49 +54,55 @@
 typedef struct {
     unsigned __c;
     th_self __s;
-    th_mutex __m1, __m2;
+    th_mutex __m;
 } th_r_mutex;
-#  define TH_R_MUTEX_INITIALIZER    { 0, th_self_none, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER }
+#  define TH_R_MUTEX_INITIALIZER    { 0, th_self_none, PTHREAD_MUTEX_INITIALIZER }
 #  define th_r_mutex_init(__mx)    do { \
     (__mx).__c = 0; \
     (__mx).__s = th_self_none; \
-    th_mutex_init((__mx).__m1); \
-    th_mutex_init((__mx).__m2); \
+    th_mutex_init((__mx).__m); \
 } while (0)
 #  define th_r_mutex_destroy(__mx) do { \
-    th_mutex_destroy((__mx).__m2); \
-    th_mutex_destroy((__mx).__m1); \
+    th_mutex_destroy((__mx).__m); \
 } while (0)
 #  define th_r_mutex_lock(__mx)    _th_r_mutex_lock(&(__mx))
+#  define th_r_mutex_trylock(__mx) _th_r_mutex_trylock(&(__mx))
 #  define th_r_mutex_unlock(__mx)  _th_r_mutex_unlock(&(__mx))
 
+/*
+ * the owner holds __mx->__m until its last unlock.
+ * __mx->__s can be compared with th_self_get() without locking:
+ * only the owner sets it to its own thread identifier.
+ */
 #  define TH_R_MUTEX_HELPER_DEFS(attr) \
     attr void _th_r_mutex_lock(th_r_mutex * __mx) { \
 	th_self __self = th_self_get(); \
 	\
-	th_mutex_lock(__mx->__m1); \
-	if (__mx->__s == th_self_none || __mx->__s == __self) { \
-	    __mx->__s = __self; \
-	    __mx->__c++; \
-	} else { \
-	    th_mutex_unlock(__mx->__m1); \
-	    /* some other thread might steal us __mx->__m2 here, but that's semantically ok */ \
-	    th_mutex_lock(__mx->__m2); \
-	    th_mutex_lock(__mx->__m1); \
-	    __mx->__s = __self; \
+	if (__mx->__s == __self) { \
 	    __mx->__c++; \
+	    return; \
 	} \
-	th_mutex_unlock(__mx->__m1); \
+	th_mutex_lock(__mx->__m); \
+	__mx->__s = __self; \
+	__mx->__c = 1; \
+    } \
+    attr int _th_r_mutex_trylock(th_r_mutex * __mx) { \
+	th_self __self = th_self_get(); \
+	\
+	if (__mx->__s == __self) \
+	    __mx->__c++; \
+	else if (th_mutex_trylock(__mx->__m)) { \
+	    __mx->__s = __self; \
+	    __mx->__c = 1; \
+	} else \
+	    return 0; \
+	return 1; \
     } \
     attr void _th_r_mutex_unlock(th_r_mutex * __mx) { \
-	unsigned __c = 1; \
-	th_mutex_lock(__mx->__m1); \
-	if (__mx->__s == th_self_get()) \
-	    if (!(__c = --__mx->__c)) \
-		__mx->__s = th_self_none; \
-	th_mutex_unlock(__mx->__m1); \
-	if (!__c) \
-	    th_mutex_unlock(__mx->__m2); \
+	if (__mx->__s == th_self_get() && !--__mx->__c) { \
+	    __mx->__s = th_self_none; \
+	    th_mutex_unlock(__mx->__m); \
+	} \
     } \
     typedef th_r_mutex _th_r_mutex
 
@@ -106,6 +119,7 @@ typedef struct {
 # define TH_MUTEX_INITIALIZER    {}
 # define th_mutex_init(__mx)    do { } while (0)
 # define th_mutex_lock(__mx)    do { } while (0)
+# define th_mutex_trylock(__mx) 1
 # define th_mutex_unlock(__mx)  do { } while (0)
 # define th_mutex_destroy(__mx) do { } while (0)
 
@@ -113,6 +127,7 @@ typedef struct {
 # define TH_R_MUTEX_INITIALIZER    {}
 # define th_r_mutex_init(__mx)    do { } while (0)
 # define th_r_mutex_lock(__mx)    do { } while (0)
+# define th_r_mutex_trylock(__mx) 1
 # define th_r_mutex_unlock(__mx)  do { } while (0)
 # define th_r_mutex_destroy(__mx) do { } while (0)
 # define TH_R_MUTEX_HELPER_DEFS(attr) typedef int _th_r_mutex
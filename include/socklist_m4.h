@@ -160,6 +160,7 @@ EL(GetOwnerSelection)
 EL(SetOwnerSelection)
 EL(RequestSelection)
 EL(NotifySelection)
+EL(AckSelection)
 
 EL(SetServerUid)
 
@@ -74,6 +74,7 @@ typedef struct s_mouse_state {
 } mouse_state;
 
 typedef struct s_ttydata ttydata;
+typedef struct s_reflow reflow;
 typedef struct s_remotedata remotedata;
 typedef struct s_draw_ctx draw_ctx;
 
@@ -189,6 +190,11 @@ struct s_remotedata {
     int Fd;
     pid_t ChildPid;
     uldat FdSlot; /* index in the FdList array (remote.c) */
+    byte *RBuf;   /* input buffer, sized from observed throughput (tterm.c) */
+    uldat RBufSize, RBufIdle;
+    uldat ReadCalls, ReadBytes; /* statistics: read() calls and bytes read */
+    uldat ReadRate, RateBytes;  /* bytes/s measured over the last second */
+    tany RateTime;
 };
 
 struct s_draw_ctx {
@@ -307,6 +313,11 @@ struct s_fn_widget {
 #define WIDGET_WANT_MOUSE	0x0004
 #define WIDGET_WANT_CHANGES	0x0008
 #define WIDGET_AUTO_FOCUS	0x0010
+/*
+ * mouse motion not yet read by the owner is merged with newer motion
+ * for the same widget and buttons. this asks to get every sample instead.
+ */
+#define WIDGET_WANT_ALL_MOTION	0x0020
 
 
 /* Widget->Flags */
@@ -403,6 +414,7 @@ struct s_fn_gadget {
 #define GADGET_WANT_MOUSE	WIDGET_WANT_MOUSE	/* 0x0004 */
 #define GADGET_WANT_CHANGES	WIDGET_WANT_CHANGES	/* 0x0008 */
 #define GADGET_AUTO_FOCUS	WIDGET_AUTO_FOCUS	/* 0x0010 */
+#define GADGET_WANT_ALL_MOTION	WIDGET_WANT_ALL_MOTION	/* 0x0020 */
 
 
 /* Gadget->Flags */
@@ -452,10 +464,24 @@ struct s_WR {		/* for WINDOWFL_USEROWS windows */
     /*and NumRowSplit forcing twin to recalculate them */
 };
 
+/*
+ * after a width change, only the rows from the visible top down are rewrapped at once:
+ * the older ones are rewrapped from the old Contents when needed, see ReflowRows()
+ */
+struct s_reflow {
+    hwattr *Contents;	/* old Contents, Wrapped, WLogic, HLogic and HSplit */
+    byte *Wrapped;
+    ldat WLogic, HLogic, HSplit;
+    ldat Lines;		/* old rows [0, Lines) (from the oldest one) are still to be rewrapped */
+    ldat Rows;		/* into rows [0, Rows) of the current Contents */
+};
+
 struct s_WC {		/* for WINDOWFL_USECONTENTS windows */
     hwattr *Contents;
     ttydata *TtyData;
     ldat HSplit;
+    byte *Wrapped;	/* one per Contents row: TRUE if the line continues on next row */
+    reflow *Reflow;	/* rows not rewrapped yet after a width change, or NULL */
 };
 
 struct s_window {
@@ -499,6 +525,7 @@ struct s_window {
     dat MaxXWidth, MaxYWidth;
     ldat WLogic, HLogic;	/* window interior logic size */
     hwfont CONST * Charset;	/* the byte -> hwfont translation to use */
+    tany MemUsed;		/* bytes of Contents or rows, charged to Owner. see ChargeMem() */
 };
 
 struct s_fn_window {
@@ -563,6 +590,7 @@ struct s_fn_window {
 #define WINDOW_WANT_MOUSE	WIDGET_WANT_MOUSE	/* 0x0004 */
 #define WINDOW_WANT_CHANGES	WIDGET_WANT_CHANGES	/* 0x0008 */
 #define WINDOW_AUTO_FOCUS	WIDGET_AUTO_FOCUS	/* 0x0010 */
+#define WINDOW_WANT_ALL_MOTION	WIDGET_WANT_ALL_MOTION	/* 0x0020 */
 #define WINDOW_DRAG		0x0100
 #define WINDOW_RESIZE		0x0200
 #define WINDOW_CLOSE		0x0400
@@ -771,6 +799,9 @@ struct s_row {
     hwcol *ColText;
 };
 
+/* bytes charged to a window for a row: ColText is counted even if not allocated */
+#define ROWMEM(MaxLen) ((tany)(MaxLen) * (sizeof(hwfont) + sizeof(hwcol)))
+
 struct s_fn_row {
     uldat Magic, Size, Used;
     row (*Create)(fn_row, udat Code, byte Flags);
@@ -1001,6 +1032,7 @@ struct s_event_display {
 #define DPY_Helper		((udat)14)
 #define DPY_RedrawVideo		((udat)15)
 #define DPY_Quit		((udat)16)
+#define DPY_RowHash		((udat)17)
 
 typedef struct s_event_widget event_widget;
 struct s_event_widget {
@@ -1043,7 +1075,7 @@ struct s_event_selection {
 typedef struct s_event_selectionnotify event_selectionnotify;
 struct s_event_selectionnotify {
     widget W;
-    udat Code, pad; /* unused */
+    udat Code, pad; /* Code is 0 or SEL_NOTIFY_MORE */
     uldat ReqPrivate;
     uldat Magic;
     byte MIME[MAX_MIMELEN];
@@ -1059,6 +1091,15 @@ struct s_event_selectionnotify {
 #define SEL_DATAMAGIC	0xDA1AA1AD /* check MIME if you get this */
 #define SEL_IDMAGIC	0x49644964
 
+/*
+ * big selections are notified to msgports in several MSG_SELECTIONNOTIFY
+ * of at most SEL_NOTIFY_CHUNK bytes each: all but the last one
+ * have SEL_NOTIFY_MORE set in Code, and each one is sent only after
+ * the requestor acked the previous one, see TwinSelectionAck().
+ */
+#define SEL_NOTIFY_MORE		0x0001
+#define SEL_NOTIFY_CHUNK	0x8000
+
 typedef struct s_event_selectionrequest event_selectionrequest;
 struct s_event_selectionrequest {
     widget W;
@@ -1120,6 +1161,7 @@ struct s_msgport {
     timevalue CallTime, PauseDuration;
     remotedata RemoteData;
     msg FirstMsg, LastMsg;
+    uldat CountMsg;		/* number of msgs in the FirstMsg list */
     menu FirstMenu, LastMenu;	/* menus created by this MsgPort */
     widget FirstW, LastW;	/* widgets owned by this MsgPort */
     group FirstGroup, LastGroup; /* groups done by this MsgPort */
@@ -1127,6 +1169,10 @@ struct s_msgport {
     uldat CountE, SizeE;        /* number of extensions used by this MsgPort */
     extension *Es;              /* extensions used by this MsgPort */
     display_hw AttachHW;	/* that was attached as told by MsgPort */
+    uldat PerfRuns, PerfMsgs;	/* performance counters, see <Tw/Twperf.h> */
+    tany MemUsed, MemPeak;	/* bytes of windows owned by this MsgPort, see ChargeMem() */
+    timevalue MemThrottle;	/* if MemThrottled, client input is paused until then */
+    byte MemThrottled;
 };
 struct s_fn_msgport {
     uldat Magic, Size, Used;
@@ -1375,9 +1421,45 @@ struct s_display_hw {
      * 
      * Otherwise, set this to zero.
      */
-    
+
+    timevalue FlushTime;
+    uldat FlushKeys;
+    /*
+     * when FlushVideo() last drew something on this display,
+     * and how many keyboard events had arrived by then
+     */
+
+    tany FlushCost, FrameDelay;
+    /*
+     * used by the frame scheduler in hw_multi.c:
+     * FlushCost is the smoothed time spent in FlushVideo() + FlushHW(),
+     * FrameDelay is the minimum interval between two flushes this display
+     * currently gets. Both in timevalue->Fraction units.
+     */
+
+    udat MaxFPS, MaxLatency;
+    /*
+     * frame rate cap and latency budget (milliseconds) for this display,
+     * set with the ",fps=<n>" and ",latency=<msec>" options. zero means default.
+     */
+
+    dat (*DeferVideo)[2][2];
+    dat DeferHeight;
+    byte DeferFlag;
+    /*
+     * dirty areas this display skipped while its frame was not yet due,
+     * in the same format as ChangedVideo[]. DeferFlag is TRUE if non-empty.
+     */
+
     uldat AttachSlot; /* slot of client that told us to attach to this display */
     
+    uldat PerfFlushes;
+    tany PerfCells, PerfUsec;
+    /*
+     * performance counters, see <Tw/Twperf.h>:
+     * number of flushes, dirty cells they pushed and time they took
+     */
+    
     dat XY[2];  /* hw-dependent cursor position */
     uldat TT;   /* hw-dependent cursor type */
 };
@@ -1700,6 +1782,8 @@ void *ReAllocMem0(void *Mem, size_t ElementSize, size_t OldCount, size_t NewCoun
 
 # define FreeMem(Mem)       free(Mem)
 
+void ChargeMem(window W, tany Alloc, tany Freed); /* account memory of W to its owner */
+
 
 
 /* INLINE/define stuff: */
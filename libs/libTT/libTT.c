@@ -1056,6 +1056,50 @@ TT_INLINE void DelAllCallbacks_ttcomponent(ttcomponent o) {
     }
 }
 
+/*
+ * small direct-mapped caches in front of the ttlistener and ttdata AVL trees:
+ * FireOneEvent() and the ttdata getters look up the same few keys over and over.
+ * Any change to any of those trees invalidates both caches by incrementing cache_gen,
+ * so entries never point to removed or deleted objects.
+ */
+#define CACHE_SIZE	256 /* must be a power of two */
+
+typedef struct s_listener_cache {
+    ttuint gen;
+    ttlistener base;
+    ttcomponent component;
+    ttuint evtype, evcode, evflags;
+    ttlistener found;
+} listener_cache;
+
+typedef struct s_data_cache {
+    ttuint gen;
+    ttdata base;
+    ttuint key_hash;
+    ttdata found;
+} data_cache;
+
+static listener_cache listener_cache_v[CACHE_SIZE];
+static data_cache data_cache_v[CACHE_SIZE];
+static ttuint cache_gen = 1;
+
+static void InvalidateCaches(void) {
+    if (!++cache_gen) {
+	/* wrapped around: really clear the caches */
+	TTWriteMem(listener_cache_v, '\0', sizeof(listener_cache_v));
+	TTWriteMem(data_cache_v, '\0', sizeof(data_cache_v));
+	cache_gen = 1;
+    }
+}
+
+TT_INLINE ttuint CacheIndex(TT_CONST void *base, ttuint key) {
+    ttuint h = (ttuint)(ttopaque)base ^ key;
+    h ^= h >> 8;
+    h ^= h >> 16;
+    return h & (CACHE_SIZE - 1);
+}
+
+
 /* ttlistener AVL management */
 
 #define ttavl2ttlistener(avl) ( (avl) ? (ttlistener) ((ttbyte *)(avl) - TT_OFFSETOF(ttlistener,AVL)) : (ttlistener)0 )
@@ -1091,7 +1135,19 @@ static int CompareListenerAVLs(ttavl_c a1, ttavl_c a2) {
 
 static ttlistener FindListener4Event(ttlistener base, ttevent ev) {
     s_ttlistener evc;
+    listener_cache *C;
     ttavl key;
+    ttuint evflags;
+    
+    /* evflags are compared only for key and mouse events, see CompareEvents() */
+    evflags = ev->evtype == ttevent_evtype_key || ev->evtype == ttevent_evtype_mouse ? ev->evflags : 0;
+    evc.AVL.AVLkey = AVLEventKey(ev);
+    
+    C = &listener_cache_v[CacheIndex(base, evc.AVL.AVLkey)];
+    if (C->gen == cache_gen && C->base == base && C->component == ev->component &&
+	C->evtype == ev->evtype && C->evcode == ev->evcode && C->evflags == evflags)
+	
+	return C->found;
     
     /*
      * no need to fully initialize evc here...
@@ -1100,7 +1156,6 @@ static ttlistener FindListener4Event(ttlistener base, ttevent ev) {
      * if (!TNEW2(ttlistener, &evc))
      *     return (ttlistener)0;
      */
-    evc.AVL.AVLkey = AVLEventKey(ev);
     evc.event = ev;
     
     key = AVLFind(ttlistener2ttavl(&evc), ttlistener2ttavl(base), CompareListenerAVLs);
@@ -1110,7 +1165,13 @@ static ttlistener FindListener4Event(ttlistener base, ttevent ev) {
      * 
      * TDEL(&evc);
      */
-    return key ? ttavl2ttlistener(key) : (ttlistener)0;
+    C->gen = cache_gen;
+    C->base = base;
+    C->component = ev->component;
+    C->evtype = ev->evtype;
+    C->evcode = ev->evcode;
+    C->evflags = evflags;
+    return C->found = key ? ttavl2ttlistener(key) : (ttlistener)0;
 }
 
 static void CallFunctionPlain(ttlistener_fn function, ttopaque args_n, ttany *args) {
@@ -1466,6 +1527,8 @@ static void AddTo_ttlistener(ttlistener c, ttcomponent o) {
 	    AVLInsert(ttlistener2ttavl(c), node, CompareListenerAVLs, &node);
 	    o->listeners = ttavl2ttlistener(node);
 	}
+	c->component = o;
+	InvalidateCaches();
 	return /* c */ ;
     } else
 	SetErrno(TT_EBAD_ARG, c && c->event ? 2 : 1);
@@ -1506,6 +1569,7 @@ static void Remove_ttlistener(ttlistener c) {
 		    o->listeners = ttavl2ttlistener(node);
 		}
 	    }
+	    InvalidateCaches();
 	}
     }
 }
@@ -1549,6 +1613,7 @@ TT_INLINE void DelAllListeners_ttcomponent(ttcomponent o) {
 	if (o->listeners)
 	    DelAll_ttlistener(o->listeners);
 	o->listeners = (ttlistener)0;
+	InvalidateCaches();
     }
 }
 
@@ -1677,6 +1742,18 @@ TT_INLINE ttdata Find_ttdata(ttdata key, TT_CONST ttdata base) {
 }
 static ttdata FindByKey_ttdata(ttdata base, TT_CONST ttbyte *key, ttopaque len) {
     s_ttdata d;
+    data_cache *C;
+    ttdata found;
+    
+    d.AVL.AVLkey = AVLStringKey(key, len);
+    
+    /* only hits are cached: they can be checked against the key stored in found */
+    C = &data_cache_v[CacheIndex(base, d.AVL.AVLkey)];
+    if (C->gen == cache_gen && C->base == base && C->key_hash == d.AVL.AVLkey &&
+	(found = C->found)->key_len == len && !TTCmpMem(found->key, key, len))
+	
+	return found;
+    
     /*
      * no need to fully initialize d here...
      * just d.AVL, d.key and d.key_len are used
@@ -1684,10 +1761,15 @@ static ttdata FindByKey_ttdata(ttdata base, TT_CONST ttbyte *key, ttopaque len)
      * if (!TNEW2(ttdata, &d))
      *     return (ttdata)0;
      */
-    d.AVL.AVLkey = AVLStringKey(key, len);
     d.key = (ttbyte *)key;
     d.key_len = len;
-    return Find_ttdata(&d, base);
+    if ((found = Find_ttdata(&d, base))) {
+	C->gen = cache_gen;
+	C->base = base;
+	C->key_hash = d.AVL.AVLkey;
+	C->found = found;
+    }
+    return found;
     /*
      * so no need to cleanup d too
      * 
@@ -1704,7 +1786,7 @@ static void AddTo_ttdata(ttdata d, ttcomponent o, ttbyte quickndirty) {
 
 	d->AVL.AVLkey = AVLStringKey(d->key, d->key_len);
 
-	if (!quickndirty && (base = Find_ttdata(o->datas, d))) {
+	if (!quickndirty && (base = Find_ttdata(d, o->datas))) {
 	    /* already exists, replace: */
 	    base->data = d->data;
 	    TDEL(d);
@@ -1714,6 +1796,7 @@ static void AddTo_ttdata(ttdata d, ttcomponent o, ttbyte quickndirty) {
 	    root = ttdata2ttavl(o->datas);
 	    AVLInsert(ttdata2ttavl(d), root, CompareDataAVLs, &root);
 	    o->datas = ttavl2ttdata(root);
+	    InvalidateCaches();
 	}
 	return /* d */ ;
     } else
@@ -1735,6 +1818,7 @@ static void Remove_ttdata(ttdata d) {
 	root = ttdata2ttavl(o->datas);
 	AVLRemove(ttdata2ttavl(d), CompareDataAVLs, &root);
 	o->datas = ttavl2ttdata(root);
+	InvalidateCaches();
     }
 }
 
@@ -1803,6 +1887,7 @@ TT_INLINE void DelAllDatas_ttcomponent(ttcomponent o) {
 	if (o->datas)
 	    DelAll_ttdata(o->datas);
 	o->datas = (ttdata)0;
+	InvalidateCaches();
     }
 }
 
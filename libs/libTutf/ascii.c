@@ -45,3 +45,12 @@ hwfont T_CAT(Tutf_UTF_16_to_,T_MAP(ASCII))(hwfont c) {
     return c;
 }
 
+static void T_CAT3(Tutf_UTF_16_to_,T_MAP(ASCII),_n)(TUTF_CONST hwfont * src, hwfont * dst, uldat n) {
+    hwfont c;
+    
+    while (n--) {
+	c = *src++;
+	*dst++ = c >= 0x20 && c <= 0x7E ? c : T_CAT(Tutf_UTF_16_to_,T_MAP(ASCII))(c);
+    }
+}
+
@@ -15,7 +15,7 @@ hwfont Tutf_CP865_to_UTF_16[0x100] = {
 #undef EL
 };
 
-hwfont Tutf_UTF_16_to_CP865(hwfont c)
+static utf16_hash_table * utf16_table_CP865(void)
 {
 # define EL(x) +1
     enum {
@@ -33,5 +33,15 @@ hwfont Tutf_UTF_16_to_CP865(hwfont c)
         /* manually map T_UTF_16_CHECK_MARK -> T_CP865_SQUARE_ROOT */
         utf16_hash_insert_at(table, n - 1, T_UTF_16_CHECK_MARK, T_CP865_SQUARE_ROOT);
     }
-    return utf16_hash_search(table, c, TRUE);
+    return table;
+}
+
+hwfont Tutf_UTF_16_to_CP865(hwfont c)
+{
+    return utf16_hash_search(utf16_table_CP865(), c, TRUE);
+}
+
+static void Tutf_UTF_16_to_CP865_n(TUTF_CONST hwfont * src, hwfont * dst, uldat n)
+{
+    utf16_hash_search_n(utf16_table_CP865(), src, dst, n, TRUE);
 }
@@ -36,3 +36,13 @@ hwfont Tutf_UTF_16_to_ISO8859_1(hwfont utf16)
     return cache_ch = Tutf_UTF_16_to_ASCII(utf16);
 }
 
+static void Tutf_UTF_16_to_ISO8859_1_n(TUTF_CONST hwfont * src, hwfont * dst, uldat n)
+{
+    hwfont utf16;
+    
+    while (n--) {
+        utf16 = *src++;
+        *dst++ = utf16 < 0x100 ? utf16 : Tutf_UTF_16_to_ISO8859_1(utf16);
+    }
+}
+
@@ -335,12 +335,13 @@ typedef struct {
     byte * TUTF_CONST * names;
     Tutf_array array;
     Tutf_function function;
+    Tutf_function_n function_n;
 } Tutf_struct;
 
-#define DECL_CH(ch) { T_CAT(names_,ch), T_CAT3(Tutf_,ch,_to_UTF_16), T_CAT(Tutf_UTF_16_to_,ch) },
+#define DECL_CH(ch) { T_CAT(names_,ch), T_CAT3(Tutf_,ch,_to_UTF_16), T_CAT(Tutf_UTF_16_to_,ch), T_CAT3(Tutf_UTF_16_to_,ch,_n) },
 
 static Tutf_struct Tutf_structs[] = {
-    { T_CAT(names_,UTF_16), NULL, NULL },
+    { T_CAT(names_,UTF_16), NULL, NULL, NULL },
     _NLIST(DECL_CH)
     { NULL }
 };
@@ -400,3 +401,13 @@ Tutf_array Tutf_charset_to_UTF_16_array(uldat id) {
     return id < sizeof(Tutf_structs)/sizeof(Tutf_structs[0]) ? Tutf_structs[id].array : NULL;
 }
 
+/* return the function to translate n chars at once from UTF_16 to the same charset as f */
+Tutf_function_n Tutf_UTF_16_to_charset_function_n(Tutf_function f) {
+    Tutf_struct *CH;
+    if (f) for (CH = Tutf_structs + 1; CH->names; CH++) {
+	if (CH->function == f)
+	    return CH->function_n;
+    }
+    return NULL;
+}
+
@@ -18,7 +18,7 @@ hwfont T_CAT3(Tutf_,T_TEMPLATE,_to_UTF_16)[0x100] = {
 #undef EL
 };
 
-hwfont T_CAT(Tutf_UTF_16_to_,T_TEMPLATE) (hwfont c)
+static utf16_hash_table * T_CAT(utf16_table_,T_TEMPLATE) (void)
 {
 #define EL(x) +1
     enum {
@@ -32,12 +32,25 @@ hwfont T_CAT(Tutf_UTF_16_to_,T_TEMPLATE) (hwfont c)
     /* a single 8-bit charset obviously cannot contain all unicode chars. this is just a best effort. */
     if (!table)
 	table = utf16_hash_create(T_CAT3(Tutf_,T_TEMPLATE,_to_UTF_16), n, n_power_of_2);
+    return table;
+}
 
 #ifdef TEMPLATE_REDEFINES_ASCII
-    return utf16_hash_search(table, c, FALSE);
+# define T_ASCII_IS_PRESERVED FALSE
 #else
-    return utf16_hash_search(table, c, TRUE);
+# define T_ASCII_IS_PRESERVED TRUE
 #endif
+
+hwfont T_CAT(Tutf_UTF_16_to_,T_TEMPLATE) (hwfont c)
+{
+    return utf16_hash_search(T_CAT(utf16_table_,T_TEMPLATE)(), c, T_ASCII_IS_PRESERVED);
 }
 
+static void T_CAT3(Tutf_UTF_16_to_,T_TEMPLATE,_n) (TUTF_CONST hwfont * src, hwfont * dst, uldat n)
+{
+    utf16_hash_search_n(T_CAT(utf16_table_,T_TEMPLATE)(), src, dst, n, T_ASCII_IS_PRESERVED);
+}
+
+#undef T_ASCII_IS_PRESERVED
+
 #undef T_TEMPLATE
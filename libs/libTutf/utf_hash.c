@@ -11,6 +11,7 @@ typedef struct {
     udat   n_power_of_2;
     hwfont cache_utf16;
     byte   cache_ch;
+    byte * page[0x100]; /* direct utf16 -> ch maps, one per 256-chars block. filled on demand */
     byte   index[3 /* actually n_power_of_2 */ ];
 } utf16_hash_table;
 
@@ -42,14 +43,22 @@ TUTF_INLINE void * align_address(void * address)
 
 static utf16_hash_table * utf16_hash_create(TUTF_CONST hwfont charset[0x100], udat n, udat n_power_of_2)
 {
-    utf16_hash_table * table = calloc(1, (sizeof(utf16_hash_table)
-                                          + (n ? n : 1) * sizeof(utf16_hash_entry) /* ensure at least one utf16_hash_entry */
-                                          + (n_power_of_2 - 3) + alignment_mask)
-                                      & ~(size_t)alignment_mask);
+    utf16_hash_table * table;
+    udat i, m;
+
+    /* T_NLIST() does not count undefined positions, which may still differ from UTF-16 */
+    for (i = m = 0; i < 0x100; i++)
+        m += charset[i] != i;
+    if (n < m)
+        n = m, n_power_of_2 = NEXT_POWER_OF_2(n);
+
+    table = calloc(1, (sizeof(utf16_hash_table)
+                       + (n ? n : 1) * sizeof(utf16_hash_entry) /* ensure at least one utf16_hash_entry */
+                       + (n_power_of_2 - 3) + alignment_mask)
+                   & ~(size_t)alignment_mask);
     if (table != NULL)
     {
         hwfont utf16;
-        dat i;
         byte offset = 0;
 
         table->base = (utf16_hash_entry *)align_address(table->index + n_power_of_2);
@@ -74,10 +83,13 @@ static hwfont utf16_hash_search(utf16_hash_table * table, hwfont utf16, byte asc
     if (table != NULL)
     {
         TUTF_CONST utf16_hash_entry *base, *e;
-        byte ch, key0_visited;
+        byte *ch_page, ch, key0_visited;
 
         if (utf16 == table->cache_utf16)
             return table->cache_ch;
+        
+        if ((ch_page = table->page[utf16 >> 8]))
+            return ch_page[utf16 & 0xff];
     
         if ((ascii_is_preserved && utf16 >= ' ' && utf16 <= '~') ||
             (utf16 & ~0x00ff) == 0xf000 || /* direct-to-font area */
@@ -117,3 +129,48 @@ static hwfont utf16_hash_search(utf16_hash_table * table, hwfont utf16, byte asc
     return '?';
 }
 
+/* fill the direct map of 256-chars block 'hi' */
+static byte * utf16_hash_fill_page(utf16_hash_table * table, byte hi, byte ascii_is_preserved)
+{
+    byte * ch_page = malloc(0x100);
+    udat lo;
+
+    if (ch_page != NULL)
+    {
+        for (lo = 0; lo < 0x100; lo++)
+            ch_page[lo] = utf16_hash_search(table, (hwfont)(hi << 8 | lo), ascii_is_preserved);
+        table->page[hi] = ch_page;
+    }
+    return ch_page;
+}
+
+/* convert n chars at once. in-place conversion (dst == src) is allowed */
+static void utf16_hash_search_n(utf16_hash_table * table, TUTF_CONST hwfont * src, hwfont * dst, uldat n, byte ascii_is_preserved)
+{
+    TUTF_CONST byte *ch_page;
+    hwfont utf16;
+
+    if (table == NULL)
+    {
+        while (n--)
+            *dst++ = '?';
+        return;
+    }
+    while (n)
+    {
+        if (ascii_is_preserved)
+        {
+            /* plain ASCII runs are copied as they are */
+            while (n && (utf16 = *src) >= ' ' && utf16 <= '~')
+                *dst++ = utf16, src++, n--;
+            if (!n)
+                break;
+        }
+        utf16 = *src++, n--;
+
+        if ((ch_page = table->page[utf16 >> 8]) || (ch_page = utf16_hash_fill_page(table, utf16 >> 8, ascii_is_preserved)))
+            *dst++ = ch_page[utf16 & 0xff];
+        else
+            *dst++ = utf16_hash_search(table, utf16, ascii_is_preserved);
+    }
+}
@@ -176,10 +176,8 @@ void AVLInsert(tavl L /*key*/, tavl P /*base*/, tavl_compare cmp, tavl *root) {
 	*root = L;
 }
 
-/* FIXME: this is not completely tested */
 void AVLRemove(tavl P /*node*/, tavl_compare cmp, tavl *root) {
     tavl L, R, LC, RC, Y;
-    byte HL, HR;
     
     L = LC = P->AVLLeft;
     R = RC = P->AVLRight;
@@ -208,14 +206,18 @@ void AVLRemove(tavl P /*node*/, tavl_compare cmp, tavl *root) {
 	    AVL_Insert(L, P->AVLParent, P, root);
 	    if ((L->AVLRight = P->AVLRight)) L->AVLRight->AVLParent = L;
 	    if ((L->AVLLeft = P->AVLLeft)) L->AVLLeft->AVLParent = L;
-	    HL = AVLHeightOf(L->AVLLeft);
-	    HR = AVLHeightOf(L->AVLRight);
-	    L->AVLHeight = 1 + (HL > HR ? HL : HR);
+	    /*
+	     * L takes the place of P, height included: the ancestors of P were
+	     * balanced with it. AVLRebalance() below fixes it from Y upwards,
+	     * and Y must not be P, which is no longer in the tree.
+	     */
+	    L->AVLHeight = P->AVLHeight;
+	    if (Y == P)
+		Y = L;
 	} else {
 	    /* similar to the above, just swap Left <--> Right sides */
 	    RC = R->AVLRight;
-	    Y = R->AVLParent;
-	    if ((Y = L->AVLParent) == P)
+	    if ((Y = R->AVLParent) == P)
 		Y->AVLRight = RC;
 	    else
 		Y->AVLLeft = RC;
@@ -223,9 +225,9 @@ void AVLRemove(tavl P /*node*/, tavl_compare cmp, tavl *root) {
 	    AVL_Insert(R, P->AVLParent, P, root);
 	    if ((R->AVLLeft = P->AVLLeft)) R->AVLLeft->AVLParent = R;
 	    if ((R->AVLRight = P->AVLRight)) R->AVLRight->AVLParent = R;
-	    HR = AVLHeightOf(R->AVLRight);
-	    HL = AVLHeightOf(R->AVLLeft);
-	    R->AVLHeight = 1 + (HR > HL ? HR : HL);
+	    R->AVLHeight = P->AVLHeight;
+	    if (Y == P)
+		Y = R;
 	}
     } else
 	AVL_Insert(R ? R : L, Y = P->AVLParent, P, root);
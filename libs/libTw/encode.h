@@ -229,7 +229,6 @@ static udat ExtensionEncodeArgs(TW_CONST byte *Format, uldat *Space, va_list va,
 	    if (t < TWS_highest) {
 		space += Tw_MagicData[t];
 		a->TWS_field_scalar = va_arg(va, tany);
-		break;
 	    } else if (t == TWS_array) {
 		/* here TWS_array is used to specify W()-style arrays */
 		a->type = TWS_vec | TWS_vecW | TWS_byte;
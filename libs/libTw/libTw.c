@@ -234,6 +234,56 @@ static s_tw_errno rCommonErrno;
 static uldat OpenCount;
 #ifdef th_mutex
 static th_mutex OpenCountMutex = TH_MUTEX_INITIALIZER;
+
+#ifdef CONF_SOCKET_PTHREADS
+
+/*
+ * per-thread buffer where calls are serialized while another thread holds the LOCK.
+ * It uses libc malloc() as it can outlive the functions set by Tw_ConfigMalloc().
+ */
+typedef struct s_thread_buf {
+    byte *buf;
+    uldat max;
+} s_thread_buf;
+
+static th_key ThreadBufKey;
+static byte ThreadBufKeyOk;
+
+static void FreeThreadBuf(void *T) {
+    free(((s_thread_buf *)T)->buf);
+    free(T);
+}
+
+/* return a buffer of at least len bytes private to the calling thread, or NULL */
+static byte *GetThreadBuf(uldat len) {
+    s_thread_buf *T;
+    byte *buf;
+    
+    if (!ThreadBufKeyOk)
+	return NULL;
+    if (!(T = (s_thread_buf *)th_key_get(ThreadBufKey))) {
+	if (!(T = (s_thread_buf *)calloc(1, sizeof(s_thread_buf))))
+	    return NULL;
+	if (th_key_set(ThreadBufKey, T) != 0) {
+	    free(T);
+	    return NULL;
+	}
+    }
+    if (T->max < len) {
+	if (!(buf = (byte *)realloc(T->buf, len)))
+	    return NULL;
+	T->buf = buf;
+	T->max = len;
+    }
+    return T->buf;
+}
+
+#endif /* CONF_SOCKET_PTHREADS */
+#endif
+
+#ifndef CONF_SOCKET_PTHREADS
+/* without threads the LOCK is never contended: calls are always serialized into QWRITE */
+# define GetThreadBuf(len)	((byte *)0)
 #endif
 
 /* and this is the 'default' display */
@@ -428,6 +478,8 @@ TW_INLINE uldat ParanoidAddQueueQMSG(tw_d TwD, uldat len, void *data) {
     uldat mtype, minlen, xlen;
     tmsg M;
     tevent_any E;
+    byte *q;
+    uldat qlen;
     
     /* we already checked (len >= 3 * sizeof(uldat)) */
     Pop(t,uldat,mtype);
@@ -477,8 +529,10 @@ TW_INLINE uldat ParanoidAddQueueQMSG(tw_d TwD, uldat len, void *data) {
 	    Qlen[QMSG] -= len;
 	    return 0;
 	}
-	/* check variable-length messages: */
-	M = (tmsg)GetQueue(TwD, QMSG, NULL);
+	/* check variable-length messages: the one just added, not the first in queue */
+	len = (len + 7) & ~7;
+	q = GetQueue(TwD, QMSG, &qlen);
+	M = (tmsg)(q + qlen - len);
 	E = &M->Event;
 	
 	switch (mtype &= TW_MAXUDAT) {
@@ -501,7 +555,6 @@ TW_INLINE uldat ParanoidAddQueueQMSG(tw_d TwD, uldat len, void *data) {
 	    xlen = 0;
 	    break;
 	}
-	len = (len + 7) & ~7;
 	if (M->Len >= xlen + minlen)
 	    return len;
 	Qlen[QMSG] -= len;
@@ -1257,6 +1310,10 @@ tw_d Tw_Open(TW_CONST byte *TwDisplay) {
     
     th_mutex_lock(OpenCountMutex);
     OpenCount++;
+#ifdef CONF_SOCKET_PTHREADS
+    if (!ThreadBufKeyOk)
+	ThreadBufKeyOk = th_key_create(ThreadBufKey, FreeThreadBuf) == 0;
+#endif
     th_mutex_unlock(OpenCountMutex);
 
     LOCK;
@@ -1512,6 +1569,70 @@ int Tw_ConnectionFd(tw_d TwD) {
     return f;
 }
 
+/* this requires LOCK not to be held */
+/**
+ * passes the file descriptor `fd' to the server with SCM_RIGHTS;
+ * the server keeps it until an extension claims it (see <Tw/Twpty.h>).
+ * Works only on unix sockets without compression.
+ * Returns FALSE on failure.
+ */
+byte Tw_SendFd(tw_d TwD, int fd) {
+#ifdef SCM_RIGHTS
+    union {
+	struct cmsghdr h;
+	byte buf[CMSG_SPACE(sizeof(int))];
+    } cbuf;
+    struct cmsghdr *c;
+    struct msghdr mh;
+    struct iovec iov;
+    fd_set fset;
+    uldat zero = 0;
+    int sfd;
+    byte ok;
+    
+    LOCK;
+    ok = Fd != TW_NOFD && Flush(TwD, TRUE);
+# ifdef CONF_SOCKET_GZ
+    ok = ok && !GzipFlag;
+# endif
+    if (ok) {
+	/*
+	 * the fd needs at least one byte to travel with:
+	 * send a zero request length, which the server skips.
+	 */
+	iov.iov_base = (void *)&zero;
+	iov.iov_len = sizeof(uldat);
+	Tw_WriteMem(&mh, 0, sizeof(mh));
+	mh.msg_iov = &iov;
+	mh.msg_iovlen = 1;
+	mh.msg_control = cbuf.buf;
+	mh.msg_controllen = sizeof(cbuf.buf);
+	c = CMSG_FIRSTHDR(&mh);
+	c->cmsg_level = SOL_SOCKET;
+	c->cmsg_type = SCM_RIGHTS;
+	c->cmsg_len = CMSG_LEN(sizeof(int));
+	Tw_CopyMem(&fd, CMSG_DATA(c), sizeof(int));
+	
+	FD_ZERO(&fset);
+	sfd = Fd;
+	while (sendmsg(sfd, &mh, 0) != (int)sizeof(uldat)) {
+	    if (errno == EWOULDBLOCK) {
+		FD_SET(sfd, &fset);
+		select(sfd+1, NULL, &fset, NULL, NULL);
+		FD_CLR(sfd, &fset);
+	    } else if (errno != EINTR) {
+		ok = FALSE;
+		break;
+	    }
+	}
+    }
+    UNLK;
+    return ok;
+#else
+    return FALSE;
+#endif
+}
+
 /* hack:
  * TwReadMsg() returns an already DeQueued tmsg.
  * TwPeekMsg() returns a tmsg without DeQueueing it.
@@ -1559,6 +1680,16 @@ static tmsg ReadMsg(tw_d TwD, byte Wait, byte deQueue) {
 	    } while (Wait && Fd != TW_NOFD && !len);
 	}
     
+	if (Fd != TW_NOFD && len && deQueue && Msg->Type == TW_MSG_SELECTIONNOTIFY &&
+	    (Msg->Event.EventSelectionNotify.Code & TW_SEL_NOTIFY_MORE)) {
+	    /*
+	     * a chunk of a big selection: the server sends the next one
+	     * only after we ack this one. Acking may parse replies, moving Msg.
+	     */
+	    Tw_AckSelection(TwD, Msg->Event.EventSelectionNotify.ReqPrivate);
+	    Flush(TwD, FALSE);
+	    Msg = (tmsg)GetQueue(TwD, QMSG, &len);
+	}
 	if (Fd != TW_NOFD && len) {
 	    if (deQueue)
 		DeQueueAligned(TwD, QMSG, Msg->Len);
@@ -2113,28 +2244,45 @@ static tany _Tw_EncodeCall(byte flags, uldat o, tw_d TwD, ...)
     tsfield b;
     va_list va;
     DECL_MyReply
+    byte *buf = NULL, *t;
     uldat space, My;
-    udat N;
+    udat N, n;
 
     a->TWS_field_scalar = TW_NOID;
     
     flags ^= (ENCODE_FL_NOLOCK|ENCODE_FL_VOID);
 
-    if (flags & ENCODE_FL_LOCK)
+    va_start(va, (void *)TwD);
+    N = EncodeArgs(o, &space, va, a);
+    va_end(va);
+
+    /*
+     * if the LOCK is free (always, without threads) arguments are serialized
+     * directly into QWRITE. Else serialize calls without return value
+     * while waiting for it: threads sending many requests concurrently
+     * then contend only for the final copy into QWRITE.
+     */
+    if ((flags & ENCODE_FL_LOCK) && !th_r_mutex_trylock(mutex)) {
+	if (N != (udat)-1 && !(flags & ENCODE_FL_RETURN) && (buf = GetThreadBuf(space))) {
+	    /* skip over a[0], that will hold return value */
+	    for (t = buf, b = a+1, n = N; n; b++, n--)
+		t = PushArg(t, b);
+	}
 	LOCK;
+    }
     if (Fd != TW_NOFD && (My = id_Tw[o]) != TW_NOID &&
        	(My != TW_BADID || (My = FindFunctionId(TwD, o)) != TW_NOID)) {
 
-	va_start(va, (void *)TwD);
-	N = EncodeArgs(o, &space, va, a);
-	va_end(va);
-
 	if (N != (udat)-1) {
 	    if (InitRS(TwD) && WQLeft(space)) {
-		/* skip over a[0], that will hold return value */
-		for (b = a+1; N; b++, N--)
-		    s = PushArg(s, b);
-		
+		if (buf) {
+		    Tw_CopyMem(buf, s, space);
+		    s += space;
+		} else {
+		    /* skip over a[0], that will hold return value */
+		    for (b = a+1; N; b++, N--)
+			s = PushArg(s, b);
+		}
 		Send(TwD, (My = NextSerial(TwD)), id_Tw[o]);
 		if (flags & ENCODE_FL_RETURN) {
 		    if ((MyReply = (void *)Wait4Reply(TwD, My)) && (INIT_MyReply MyCode == OK_MAGIC)) {
@@ -238,6 +238,8 @@
 6, (byte *)"Tw_RequestSelection", (byte *)"0""v"TWS_void_STR"x"magic_id_STR(obj)"_"TWS_uldat_STR },
 { Tw_NotifySelection, 15,
 14, (byte *)"Tw_NotifySelection", (byte *)"0""v"TWS_void_STR"x"magic_id_STR(obj)"_"TWS_uldat_STR"_"TWS_uldat_STR"V"TWS_byte_STR"_"TWS_uldat_STR"V"TWS_byte_STR },
+{ Tw_AckSelection, 12,
+4, (byte *)"Tw_AckSelection", (byte *)"0""v"TWS_void_STR"_"TWS_uldat_STR },
 
 { Tw_SetServerUid, 12,
 6, (byte *)"Tw_SetServerUid", (byte *)"0""_"TWS_byte_STR"_"TWS_uldat_STR"_"TWS_byte_STR },
@@ -914,12 +914,22 @@ Tw_NotifySelection:
 	.size	 Tw_NotifySelection,.L_NotifySelection-Tw_NotifySelection
 
 
+	.align 4
+.globl Tw_AckSelection
+	.type	 Tw_AckSelection,@function
+Tw_AckSelection:
+	pushl $80
+	jmp _Tw_i386_call_2
+.L_AckSelection:
+	.size	 Tw_AckSelection,.L_AckSelection-Tw_AckSelection
+
+
 
 	.align 4
 .globl Tw_SetServerUid
 	.type	 Tw_SetServerUid,@function
 Tw_SetServerUid:
-	pushl $80
+	pushl $81
 	jmp _Tw_i386_call_0
 .L_SetServerUid:
 	.size	 Tw_SetServerUid,.L_SetServerUid-Tw_SetServerUid
@@ -930,7 +940,7 @@ Tw_SetServerUid:
 .globl Tw_OpenExtension
 	.type	 Tw_OpenExtension,@function
 Tw_OpenExtension:
-	pushl $81
+	pushl $82
 	jmp _Tw_i386_call_0
 .L_OpenExtension:
 	.size	 Tw_OpenExtension,.L_OpenExtension-Tw_OpenExtension
@@ -940,7 +950,7 @@ Tw_OpenExtension:
 .globl Tw_CallBExtension
 	.type	 Tw_CallBExtension,@function
 Tw_CallBExtension:
-	pushl $82
+	pushl $83
 	jmp _Tw_i386_call_0
 .L_CallBExtension:
 	.size	 Tw_CallBExtension,.L_CallBExtension-Tw_CallBExtension
@@ -950,7 +960,7 @@ Tw_CallBExtension:
 .globl Tw_CloseExtension
 	.type	 Tw_CloseExtension,@function
 Tw_CloseExtension:
-	pushl $83
+	pushl $84
 	jmp _Tw_i386_call_2
 .L_CloseExtension:
 	.size	 Tw_CloseExtension,.L_CloseExtension-Tw_CloseExtension
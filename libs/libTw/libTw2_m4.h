@@ -614,6 +614,11 @@ void Tw_NotifySelection(tw_d TwD, tobj a1, uldat a2, uldat a3, TW_CONST byte *a4
     , n((a5) * sizeof(byte)), N(a6));
 }
 
+void Tw_AckSelection(tw_d TwD, uldat a1) {
+    _Tw_EncodeCall(ENCODE_FL_VOID, order_AckSelection, TwD 
+    , n(a1));
+}
+
 
 byte Tw_SetServerUid(tw_d TwD, uldat a1, byte a2) {
     return (byte)_Tw_EncodeCall(0, order_SetServerUid, TwD 
@@ -286,6 +286,7 @@
 
 
 
+
   case order_OpenExtension:
     switch (n) {
       case 2: L = (a[1]._) * sizeof(byte); break;
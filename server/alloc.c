@@ -76,6 +76,23 @@ void *ReAllocMem0(void *Mem, size_t ElementSize, size_t OldCount, size_t NewCoun
 }
 
 
+/*
+ * account the bytes allocated and freed for the Contents or rows of W
+ * to W itself and to the MsgPort owning it. OwnWidget() and DisOwnWidget()
+ * move W->MemUsed between owners, so the totals stay exact.
+ */
+void ChargeMem(window W, tany Alloc, tany Freed) {
+    msgport Owner;
+    
+    W->MemUsed += Alloc - Freed;
+    if ((Owner = W->Owner)) {
+	Owner->MemUsed += Alloc - Freed;
+	if (Owner->MemPeak < Owner->MemUsed)
+	    Owner->MemPeak = Owner->MemUsed;
+    }
+}
+
+
 void *CloneMem(CONST void *From, uldat Size) {
     void *temp;
     if (From && Size && (temp = AllocMem(Size)))
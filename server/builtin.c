@@ -26,6 +26,7 @@
 #include "resize.h"
 #include "printk.h"
 #include "util.h"
+#include "upgrade.h"
 #include "version.h"
 
 #include <Tw/Twkeys.h>
@@ -45,6 +46,7 @@
 #define COD_SUSPEND	(udat)10
 #define COD_DETACH	(udat)11
 #define COD_RELOAD_RC	(udat)12
+#define COD_UPGRADE	(udat)13
 
 #define COD_CLOCK_WIN   (udat)20
 #define COD_OPTION_WIN	(udat)21
@@ -566,6 +568,10 @@ static void BuiltinH(msgport MsgPort) {
 		    SendControlMsg(Ext(WM,MsgPort), MSG_CONTROL_RESTART, 0, NULL);
 		    break;
 
+		  case COD_UPGRADE:
+		    Upgrade();
+		    break;
+
 		  case COD_TERM_ON:
 		    if (!DlLoad(TermSo))
 			break;
@@ -678,6 +684,8 @@ static void BuiltinH(msgport MsgPort) {
 		    break;
 		}
 	    }
+	    if (Msg->Event.EventSelectionNotify.Code & SEL_NOTIFY_MORE)
+		TwinSelectionAck((obj)Builtin_MsgPort, Msg->Event.EventSelectionNotify.ReqPrivate);
 	    break;
 	    
 	  case MSG_USER_CONTROL:
@@ -816,6 +824,7 @@ byte InitBuiltin(void) {
 	Row4Menu(Window, COD_SPAWN,  ROW_ACTIVE,10, " New Term ") &&
 	Row4Menu(Window, COD_EXECUTE,ROW_ACTIVE,10, " Execute  ") &&
 	Row4Menu(Window, COD_RELOAD_RC,ROW_ACTIVE,11," Reload RC ") &&
+	Row4Menu(Window, COD_UPGRADE,ROW_ACTIVE,10, " Upgrade  ") &&
 	Row4Menu(Window, (udat)0,    ROW_IGNORE,11, "\xC4\xC4\xC4\xC4\xC4\xC4\xC4\xC4\xC4\xC4\xC4") &&
 	Row4Menu(Window, COD_DETACH, ROW_ACTIVE,10, " Detach   ") &&
 	Row4Menu(Window, COD_SUSPEND,ROW_ACTIVE,10, " Suspend  ") &&
@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
+#include <ctype.h>
 #include <signal.h>
 
 #include "twin.h"
@@ -88,6 +89,11 @@ static int max_fds;
 static tmsgport TMsgPort = NOID, THelper = NOID;
 static byte MouseMotionN; /* non-zero to report also mouse motion events */
 
+static byte *CacheFile; /* `-cache': last frame is saved here at exit */
+static dat CacheRows;   /* rows of Video[] restored from CacheFile */
+
+static selchunks SelChunks; /* chunked selection notify being reassembled */
+
 int (*OverrideSelect)(int n, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout) = select;
 
 /*
@@ -624,6 +630,7 @@ static byte ReAllocVideo(dat Width, dat Height) {
 	ValidVideo = FALSE;
 	WriteMem(ChangedVideo, 0xff, (ldat)DisplayHeight*sizeof(dat)*4);
     
+	CacheRows = 0;
     }
     return change;
 }
@@ -658,6 +665,92 @@ static byte ResizeDisplay(void) {
     return change;
 }
 
+/*
+ * screen cache: when reattaching, show the last frame immediately
+ * and let twin send only the rows that changed in the meantime.
+ * 
+ * the file is a struct cache_header followed by Video[],
+ * and it is specific to the machine that wrote it.
+ */
+struct cache_header {
+    byte Magic[4];
+    udat Sizeof;
+    dat Width, Height;
+};
+
+static CONST byte CacheMagic[4] = { 'T', 'W', 'D', 'C' };
+
+/* CacheFile is $HOME/.twdisplay-cache<TWDisplay> */
+static void InitCache(void) {
+    CONST byte *d = TWDisplay ? TWDisplay : (CONST byte *)"";
+    byte *s;
+    
+    if (HOME && (CacheFile = AllocMem(strlen(HOME) + strlen(d) + 18))) {
+	sprintf(CacheFile, "%s/.twdisplay-cache%s", HOME, d);
+	for (s = CacheFile + strlen(HOME) + 17; *s; s++) {
+	    if (!isalnum(*s) && *s != '.' && *s != '-')
+		*s = '_';
+	}
+    }
+}
+
+static byte LoadCache(void) {
+    struct cache_header h;
+    uldat len = (uldat)DisplayWidth * DisplayHeight * sizeof(hwattr);
+    byte ok = FALSE;
+    int fd;
+    
+    if (CacheFile && (fd = open(CacheFile, O_RDONLY)) >= 0) {
+	ok = read(fd, &h, sizeof(h)) == sizeof(h) && !CmpMem(h.Magic, CacheMagic, sizeof(CacheMagic)) &&
+	    h.Sizeof == sizeof(hwattr) && h.Width == DisplayWidth && h.Height == DisplayHeight &&
+	    read(fd, Video, len) == (int)len;
+	close(fd);
+    }
+    return ok;
+}
+
+/* called also by signal handlers via Quit(): only use async-signal-safe functions */
+static void SaveCache(void) {
+    struct cache_header h;
+    uldat len = (uldat)DisplayWidth * DisplayHeight * sizeof(hwattr);
+    int fd;
+    
+    if (!CacheFile || !ValidVideo || !Video)
+	return;
+    
+    CopyMem(CacheMagic, h.Magic, sizeof(CacheMagic));
+    h.Sizeof = sizeof(hwattr);
+    h.Width = DisplayWidth;
+    h.Height = DisplayHeight;
+    
+    /* the cache holds whatever was on screen: keep it private */
+    if ((fd = open(CacheFile, O_WRONLY|O_CREAT|O_TRUNC, 0600)) >= 0) {
+	if (write(fd, &h, sizeof(h)) != sizeof(h) || write(fd, Video, len) != (int)len)
+	    unlink(CacheFile);
+	close(fd);
+    }
+}
+
+/* tell twin the hash of each row restored from cache, it will not resend the ones still valid */
+static void SendRowHash(void) {
+    tmsg Tmsg;
+    uldat h;
+    dat y;
+    
+    if ((Tmsg = TwCreateMsg(TW_MSG_DISPLAY, TW_SIZEOF_TEVENT_DISPLAY + CacheRows * sizeof(uldat)))) {
+	Tmsg->Event.EventDisplay.Code = TW_DPY_RowHash;
+	Tmsg->Event.EventDisplay.Len  = CacheRows * sizeof(uldat);
+	Tmsg->Event.EventDisplay.X    = DisplayWidth;
+	Tmsg->Event.EventDisplay.Y    = CacheRows;
+	for (y = 0; y < CacheRows; y++) {
+	    h = HashVideoRow(Video + y * (ldat)DisplayWidth, DisplayWidth);
+	    CopyMem(&h, Tmsg->Event.EventDisplay.Data + y * sizeof(uldat), sizeof(uldat));
+	}
+	TwBlindSendMsg(THelper, Tmsg);
+    }
+    CacheRows = 0;
+}
+
 byte AllHWCanDragAreaNow(dat Left, dat Up, dat Rgt, dat Dwn, dat DstLeft, dat DstUp) {
     return (CanDragArea && HW->CanDragArea &&
 	    HW->CanDragArea(Left, Up, Rgt, Dwn, DstLeft, DstUp));
@@ -687,6 +780,9 @@ void ResetPaletteHW(void) {
 
 static void HandleMsg(tmsg Msg) {
     tevent_display EventD;
+    tevent_selectionnotify EventN;
+    CONST byte *Data;
+    uldat Len;
     
     switch (Msg->Type) {
       case TW_MSG_SELECTION:
@@ -712,12 +808,14 @@ static void HandleMsg(tmsg Msg) {
 #if 0
 	printk("twdisplay: Selection Notify to underlying HW\n");
 #endif
-	/* notify selection to underlying HW */
-	HW->HWSelectionNotify(Msg->Event.EventSelectionNotify.ReqPrivate,
-			      Msg->Event.EventSelectionNotify.Magic,
-			      Msg->Event.EventSelectionNotify.MIME,
-			      Msg->Event.EventSelectionNotify.Len,
-			      Msg->Event.EventSelectionNotify.Data);
+	EventN = &Msg->Event.EventSelectionNotify;
+	Len = EventN->Len;
+	Data = EventN->Data;
+	/* big selections arrive in chunks: notify them to underlying HW only when complete */
+	if (SelectionChunk(&SelChunks, EventN->ReqPrivate, EventN->Code, &Len, &Data)) {
+	    HW->HWSelectionNotify(EventN->ReqPrivate, EventN->Magic, EventN->MIME, Len, Data);
+	    SelectionChunkFree(&SelChunks);
+	}
 	break;
       case TW_MSG_DISPLAY:
 	EventD = &Msg->Event.EventDisplay;
@@ -790,6 +888,8 @@ static void HandleMsg(tmsg Msg) {
 	    break;
 	  case TW_DPY_Helper:
 	    THelper = *(uldat *)EventD->Data;
+	    if (CacheFile)
+		SendRowHash();
 	    break;
 	  case TW_DPY_Quit:
 	    Quit(0);
@@ -1026,6 +1126,8 @@ static void MainLoop(int Fd) {
     if (TwInPanic()) {
 	err = TwErrno;
 	detail = TwErrnoDetail;
+	/* connection lost: still worth caching what we show */
+	SaveCache();
     	QuitDisplayHW(HW);
 	printk("%."STR(TW_SMALLBUFF)"s: libTw error: %."STR(TW_SMALLBUFF)"s%."STR(TW_SMALLBUFF)"s\n", MYname,
 		TwStrError(err), TwStrErrorDetail(err, detail));
@@ -1060,6 +1162,8 @@ static void Usage(void) {
 	  " -v, --verbose            verbose output (default)\n"
 	  " -q, --quiet              quiet - don't report messages from twin server\n"
 	  " -f, --force              force running even with wrong protocol version\n"
+	  " -cache                   keep last frame in $HOME/.twdisplay-cache*\n"
+	  "                          to redraw only what changed when reattaching\n"
 	  " --twin@<TWDISPLAY>       specify server to contact instead of $TWDISPLAY\n"
 	  " --hw=<display>[,options] start the given display (only one --hw=... allowed)\n"
 	  "                          (default: autoprobe all displays until one succeeds)\n"
@@ -1111,7 +1215,7 @@ TW_DECL_MAGIC(display_magic);
 int main(int argc, char *argv[]) {
     byte flags = TW_ATTACH_HW_REDIRECT, force = 0;
     byte *dpy = NULL, *arg = NULL, *tty = ttyname(0);
-    byte ret = 0, ourtty = 0;
+    byte ret = 0, ourtty = 0, cache = 0;
     byte *s;
     TW_CONST byte *buff;
     uldat chunk;
@@ -1138,6 +1242,8 @@ int main(int argc, char *argv[]) {
 	    flags &= ~TW_ATTACH_HW_REDIRECT;
 	else if (!strcmp(*argv, "-f") || !strcmp(*argv, "-force"))
 	    force = 1;
+	else if (!strcmp(*argv, "-cache"))
+	    cache = 1;
 	else if (!strncmp(*argv, "-twin@", 6))
 	    dpy = *argv + 6;
 	else if (!strncmp(*argv, "-hw=", 4)) {
@@ -1216,6 +1322,9 @@ int main(int argc, char *argv[]) {
     origTERM = CloneStr(getenv("TERM"));
     HOME = CloneStr(getenv("HOME"));
     
+    if (cache)
+	InitCache();
+    
     InitSignals();
     InitTtysave();
     
@@ -1257,9 +1366,10 @@ int main(int argc, char *argv[]) {
 	    return 1;
 	}
 	
-	sprintf(buf, "-hw=display@(%.*s),x=%d,y=%d%s%s%s", (int)HW->NameLen, HW->Name,
+	sprintf(buf, "-hw=display@(%.*s),x=%d,y=%d%s%s%s%s", (int)HW->NameLen, HW->Name,
 		(int)HW->X, (int)HW->Y, HW->CanResize ? ",resize" : "",
-		/* CanDragArea */ TRUE ? ",drag" : "", ExpensiveFlushVideo ? ",slow" : "");
+		/* CanDragArea */ TRUE ? ",drag" : "", ExpensiveFlushVideo ? ",slow" : "",
+		CacheFile ? ",cache" : "");
 	
 	TwAttachHW(strlen(buf), buf, flags);
 	TwFlush();
@@ -1300,6 +1410,14 @@ int main(int argc, char *argv[]) {
 
 	ResizeDisplay();
 	
+	if (LoadCache()) {
+	    /* show the cached frame now, twin will send only what changed since */
+	    CacheRows = DisplayHeight;
+	    ValidVideo = TRUE;
+	    DirtyVideo(0, 0, DisplayWidth - 1, DisplayHeight - 1);
+	    FlushHW();
+	}
+	
 	if (flags && !ourtty) {
 	    if (ret)
 		printk("... ok, twin successfully attached.\n");
@@ -1325,8 +1443,10 @@ int main(int argc, char *argv[]) {
 }
 
 void Quit(int status) {
+    SaveCache();
     QuitDisplayHW(HW);
     if (status < 0)
 	return; /* give control back to signal handler */
+    SelectionChunkFree(&SelChunks);
     exit(status);
 }
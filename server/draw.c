@@ -19,6 +19,7 @@
 #include "printk.h"
 #include "util.h"
 #include "draw.h"
+#include "resize.h"
 
 #include <Tutf/Tutf.h>
 #include <Tutf/Tutf_defs.h>
@@ -750,6 +751,8 @@ void DrawSelfWindow(draw_ctx *D) {
 		X2 = Xnew - 1;
 	    }
 	    if (X1 <= X2 && Y1 <= Y2) {
+		if (W->USE.C.Reflow)
+		    ReflowRows(W, Y1 - Up);
 		Row = Y1 - Up + W->USE.C.HSplit; /* row number in Contents */
 		if (Row >= W->HLogic)
 		    Row -= W->HLogic;
@@ -1187,7 +1190,23 @@ byte ContainsCursor(widget W) {
     return FALSE;
 }
 
+static void doDrawAreaCtx(draw_ctx *D);
+
+/* time doDrawAreaCtx() for the performance counters, if someone reads them */
 static void DrawAreaCtx(draw_ctx *D) {
+    timevalue Start, End;
+    
+    if (!PerfDrawTiming) {
+	doDrawAreaCtx(D);
+	return;
+    }
+    InstantNow(&Start);
+    doDrawAreaCtx(D);
+    InstantNow(&End);
+    PerfHistAdd(&PerfDraw, &Start, &End);
+}
+
+static void doDrawAreaCtx(draw_ctx *D) {
     draw_ctx *FirstD = D;
     ldat DWidth, DHeight, YLimit;
     screen FirstScreen, Screen;
@@ -0,0 +1,179 @@
+/*
+ * ext_perf.c -- built-in extension exporting server performance counters
+ *
+ * the counters themselves are updated by main.c, draw.c, hw_multi.c,
+ * remote.c and socket.c; this file only reads them.
+ * see <Tw/Twperf.h> for the protocol.
+ */
+
+#include "twin.h"
+
+#ifdef CONF_EXT
+
+#include "data.h"
+#include "extreg.h"
+#include "fdlist.h"
+#include "main.h"
+#include "printk.h"
+#include "remote.h"
+#include "upgrade.h"
+#include "util.h"
+
+#include <Tw/Tw.h>
+#include <Tw/Twstat.h>
+#include <Tw/Twperf.h>
+
+#include "ext_perf.h"
+
+extern fdlist *FdList;
+extern uldat FdTop;
+
+static tany perf_Hist(perf_hist *H, topaque counter, topaque base) {
+    if (counter >= base && counter < base + TWP_HIST_N)
+	return H->Hist[counter - base];
+    return (tany)0;
+}
+
+static tany perf_Global(topaque index, topaque counter) {
+    if (index)
+	return (tany)0;
+    
+    switch (counter) {
+      case TWP_Exists:			return (tany)1;
+      case TWP_Id:			return (tany)0;
+      case TWP_global_MsgPortRuns:	return PerfMsgPortRuns;
+      case TWP_global_Msgs:		return PerfMsgs;
+      case TWP_global_DrawCalls:	return PerfDraw.Calls;
+      case TWP_global_DrawUsec:		return PerfDraw.Usec;
+      case TWP_global_FlushCalls:	return PerfFlush.Calls;
+      case TWP_global_FlushUsec:	return PerfFlush.Usec;
+      case TWP_global_StartCore:	return PerfStartup[PERF_STARTUP_CORE];
+      case TWP_global_StartHW:		return PerfStartup[PERF_STARTUP_HW];
+      case TWP_global_StartWM:		return PerfStartup[PERF_STARTUP_WM];
+      case TWP_global_StartFrame:	return PerfStartup[PERF_STARTUP_FRAME];
+      case TWP_global_StartMoreHW:	return PerfStartup[PERF_STARTUP_MOREHW];
+      case TWP_global_PrintkDropped:	return PrintkDropped;
+      case TWP_global_UpgradeUsec:	return PerfUpgrade;
+      case TWP_global_MemSoft:		return flag_memsoft;
+      case TWP_global_MemHard:		return flag_memhard;
+      case TWP_global_MemThrottles:	return PerfMemThrottles;
+      case TWP_global_MemKills:		return PerfMemKills;
+      default:
+	if (counter >= TWP_global_DrawHist && counter < TWP_global_DrawHist + TWP_HIST_N)
+	    return perf_Hist(&PerfDraw, counter, TWP_global_DrawHist);
+	return perf_Hist(&PerfFlush, counter, TWP_global_FlushHist);
+    }
+}
+
+static tany perf_Display(topaque index, topaque counter) {
+    display_hw D;
+    
+    for (D = All->FirstDisplayHW; D && index; D = D->Next, index--)
+	;
+    if (!D)
+	return (tany)0;
+    
+    switch (counter) {
+      case TWP_Exists:			return (tany)1;
+      case TWP_Id:			return D->Id;
+      case TWP_display_FlushCalls:	return D->PerfFlushes;
+      case TWP_display_FlushCells:	return D->PerfCells;
+      case TWP_display_FlushUsec:	return D->PerfUsec;
+      default:				return (tany)0;
+    }
+}
+
+/* sum a byte counter over a slot and its compressed/uncompressed pair */
+static tany perf_SlotBytes(uldat Slot, byte out) {
+    tany n = 0;
+    uldat pair;
+    
+    if (Slot < FdTop && FdList[Slot].Fd != NOFD) {
+	n = out ? FdList[Slot].PerfBytesOut : FdList[Slot].PerfBytesIn;
+	if ((pair = FdList[Slot].pairSlot) < FdTop && FdList[pair].Fd != NOFD)
+	    n += out ? FdList[pair].PerfBytesOut : FdList[pair].PerfBytesIn;
+    }
+    return n;
+}
+
+static tany perf_MsgPort(topaque index, topaque counter) {
+    msgport M;
+    
+    for (M = All->FirstMsgPort; M && index; M = M->Next, index--)
+	;
+    if (!M)
+	return (tany)0;
+    
+    switch (counter) {
+      case TWP_Exists:			return (tany)1;
+      case TWP_Id:			return M->Id;
+      case TWP_msgport_Runs:		return M->PerfRuns;
+      case TWP_msgport_Msgs:		return M->PerfMsgs;
+      case TWP_msgport_Slot:		return M->RemoteData.FdSlot;
+      case TWP_msgport_BytesIn:		return perf_SlotBytes(M->RemoteData.FdSlot, FALSE);
+      case TWP_msgport_BytesOut:	return perf_SlotBytes(M->RemoteData.FdSlot, TRUE);
+      case TWP_msgport_MemUsed:		return RemoteGetMemUsed(M);
+      case TWP_msgport_MemPeak:
+	(void)RemoteGetMemUsed(M);	/* updates MemPeak */
+	return M->MemPeak;
+      case TWP_msgport_MemThrottled:	return M->MemThrottled;
+      default:				return (tany)0;
+    }
+}
+
+static tany perf_Slot(topaque index, topaque counter) {
+    uldat Slot;
+    
+    for (Slot = 0; Slot < FdTop; Slot++) {
+	if (FdList[Slot].Fd != NOFD && !index--)
+	    break;
+    }
+    if (Slot >= FdTop)
+	return (tany)0;
+    
+    switch (counter) {
+      case TWP_Exists:			return (tany)1;
+      case TWP_Id:			return Slot;
+      case TWP_slot_Fired:		return FdList[Slot].PerfFired;
+      case TWP_slot_BytesIn:		return FdList[Slot].PerfBytesIn;
+      case TWP_slot_BytesOut:		return FdList[Slot].PerfBytesOut;
+      default:				return (tany)0;
+    }
+}
+
+static tany ext_perf_CallBExtension(extension Extension, topaque len, CONST byte *data, void *return_type) {
+    struct s_tsfield tws[3];
+    topaque args_n = 3;
+    
+    /* actually, we receive a (tsfield) in return_type. we always return a (tany) */
+    ((tsfield)return_type)->type = TWS_tany;
+    
+    tws[0].type = tws[1].type = tws[2].type = TWS_topaque;
+
+    if (Ext(Socket,DecodeExtension)(&len, &data, &args_n, tws) && args_n == 3 && len == 0) {
+	
+	topaque index = (topaque)tws[1].TWS_field_scalar;
+	topaque counter = (topaque)tws[2].TWS_field_scalar;
+	
+	switch ((topaque)tws[0].TWS_field_scalar) {
+	  case TWP_global:	return perf_Global(index, counter);
+	  case TWP_display:	return perf_Display(index, counter);
+	  case TWP_msgport:	return perf_MsgPort(index, counter);
+	  case TWP_slot:	return perf_Slot(index, counter);
+	  default:		break;
+	}
+    }
+    return (tany)0;
+}
+
+byte ext_perf_Init(extension E) {
+    E->CallB = ext_perf_CallBExtension;
+    PerfDrawTiming = TRUE;
+    return TRUE;
+}
+
+void ext_perf_Quit(extension E) {
+    PerfDrawTiming = FALSE;
+}
+
+#endif /* CONF_EXT */
@@ -0,0 +1,11 @@
+#ifndef _TWIN_EXT_PERF_H
+#define _TWIN_EXT_PERF_H
+
+
+byte ext_perf_Init(extension E);
+
+void ext_perf_Quit(extension E);
+
+
+#endif /* _TWIN_EXT_PERF_H */
+
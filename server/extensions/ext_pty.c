@@ -0,0 +1,106 @@
+/*
+ * ext_pty.c -- built-in extension reading a client's pty directly
+ *
+ * the client passes the pty master with Tw_SendFd(), then names
+ * the window showing it: from then on the server feeds the pty output
+ * straight to the window terminal emulator, as tterm.c does for its own
+ * terminals, instead of the client forwarding it with Tw_WriteAsciiWindow().
+ * see <Tw/Twpty.h> for the protocol.
+ */
+
+#include "twin.h"
+
+#ifdef CONF_EXT
+
+#include "data.h"
+#include "extreg.h"
+#include "methods.h"
+#include "remote.h"
+#include "util.h"
+
+#include <Tw/Tw.h>
+#include <Tw/Twstat.h>
+#include <Tw/Twpty.h>
+
+#include "ext_pty.h"
+
+/* stop reading the pty; the window itself belongs to the client */
+static void pty_Release(window Window) {
+    UnRegisterWindowFdIO(Window);
+    if (Window->RemoteData.Fd != NOFD) {
+	close(Window->RemoteData.Fd);
+	Window->RemoteData.Fd = NOFD;
+    }
+    Window->ShutDownHook = (fn_hook)0;
+}
+
+static void pty_ShutDown(widget W) {
+    pty_Release((window)W);
+}
+
+static void pty_IO(int Fd, window Window) {
+    static byte buf[TW_BIGBUFF * 16]; /* as TTY_MAXBUFF in tterm.c */
+    ssize_t got;
+    
+    if ((got = read(Fd, buf, sizeof(buf))) > 0) {
+	Window->RemoteData.ReadCalls++;
+	Window->RemoteData.ReadBytes += got;
+	Act(TtyWriteAscii,Window)(Window, got, buf);
+    } else if (got == 0 || (errno != EINTR && errno != EWOULDBLOCK))
+	/* the child exited: the client reaps it and deletes Window */
+	pty_Release(Window);
+}
+
+static byte pty_Attach(topaque id) {
+    window Window;
+    msgport Owner;
+    int fd;
+    
+    if (!Ext(Socket,TakeFd)(&fd, &Owner))
+	return FALSE;
+    
+    /*
+     * resizes must reach the client, which owns the child:
+     * resize.c would otherwise signal RemoteData.ChildPid
+     */
+    if ((Window = (window)Id2Obj(window_magic_id, id)) && IS_WINDOW(Window) &&
+	Window->Owner == Owner && W_USE(Window, USECONTENTS) &&
+	(Window->Attrib & WINDOW_WANT_CHANGES) &&
+	Window->RemoteData.FdSlot == NOSLOT && Window->RemoteData.Fd == NOFD) {
+	
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	Window->RemoteData.Fd = fd;
+	if (RegisterWindowFdIO(Window, pty_IO)) {
+	    Window->ShutDownHook = pty_ShutDown;
+	    return TRUE;
+	}
+	Window->RemoteData.Fd = NOFD;
+    }
+    close(fd);
+    return FALSE;
+}
+
+static tany ext_pty_CallBExtension(extension Extension, topaque len, CONST byte *data, void *return_type) {
+    struct s_tsfield tws[1];
+    topaque args_n = 1;
+    
+    /* actually, we receive a (tsfield) in return_type. we always return a (tany) */
+    ((tsfield)return_type)->type = TWS_tany;
+    
+    tws[0].type = TWS_topaque;
+
+    if (Ext(Socket,DecodeExtension)(&len, &data, &args_n, tws) && args_n == 1 && len == 0)
+	return (tany)pty_Attach((topaque)tws[0].TWS_field_scalar);
+    
+    return (tany)0;
+}
+
+byte ext_pty_Init(extension E) {
+    E->CallB = ext_pty_CallBExtension;
+    return TRUE;
+}
+
+void ext_pty_Quit(extension E) {
+}
+
+#endif /* CONF_EXT */
@@ -0,0 +1,10 @@
+#ifndef _TWIN_EXT_PTY_H
+#define _TWIN_EXT_PTY_H
+
+
+byte ext_pty_Init(extension E);
+
+void ext_pty_Quit(extension E);
+
+
+#endif /* _TWIN_EXT_PTY_H */
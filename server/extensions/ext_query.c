@@ -7,6 +7,8 @@
 #include "methods.h"
 #include "printk.h"
 #include "ext_query.h"
+#include "ext_perf.h"
+#include "ext_pty.h"
 
 
 static void warn_NoExtension(topaque len, CONST byte *name, uldat tried) {
@@ -42,12 +44,16 @@ static extension LoadExtension(topaque namelen, CONST byte *name) {
 	E->CallB = NULL;
 	E->Quit = NULL;
 	
+#define check4(s, len, name) (sizeof(s) - 1 == (len) && !CmpMem(s, name, len))
 #define TRY4(e) (check4(STR(e), namelen, name) && (tried++, E->Quit = CAT3(ext_,e,_Quit), CAT3(ext_,e,_Init)(E)))
 	success =
+	    TRY4(perf) ||
+	    TRY4(pty) ||
 	    (E->Quit = NULL, Act(DlOpen,E)(E)) ||
 	    (warn_NoExtension(namelen, name, tried), FALSE);
 
 #undef TRY4
+#undef check4
 
 	if (!success) {
 	    Delete(E);
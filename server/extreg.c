@@ -20,14 +20,16 @@
 exts Exts = {
     { NULL },
     { remoteKillSlot },
-    { (void *)NoOp, AlwaysTrue, (void *)AlwaysFalse, (void *)AlwaysNull, (void *)AlwaysNull },
-    { FakeOpenTerm }
+    { (void *)NoOp, AlwaysTrue, (void *)AlwaysFalse, (void *)AlwaysNull, (void *)AlwaysNull, (void *)AlwaysFalse,
+      AlwaysFalse, (void *)NoOp, (void *)AlwaysFalse },
+    { FakeOpenTerm, AlwaysFalse, (void *)AlwaysFalse }
 };
 static exts OrigExts = {
     { NULL },
     { remoteKillSlot },
-    { (void *)NoOp, AlwaysTrue, (void *)AlwaysFalse, (void *)AlwaysNull, (void *)AlwaysNull },
-    { FakeOpenTerm }
+    { (void *)NoOp, AlwaysTrue, (void *)AlwaysFalse, (void *)AlwaysNull, (void *)AlwaysNull, (void *)AlwaysFalse,
+      AlwaysFalse, (void *)NoOp, (void *)AlwaysFalse },
+    { FakeOpenTerm, AlwaysFalse, (void *)AlwaysFalse }
 };
 
 #define OrigExt(where) ((void **)( (byte *)&OrigExts + ( (byte *)where - (byte *)&Exts)))
@@ -25,9 +25,15 @@ struct exts {
 	byte (*DecodeExtension)(topaque *len, CONST byte **data, topaque *args_n, tsfield args);
 	void (*MultiplexS)(uldat order, topaque args_n, tsfield args);
 	tany (*MultiplexL)(uldat order, ...);
+	byte (*TakeFd)(int *fd, msgport *Owner);
+	byte  (*Save)(void);	/* see upgrade.c */
+	void  (*HandOver)(void);
+	uldat (*Restore)(uldat *Lost);
     } Socket;
     struct {
 	window (*Open)(CONST byte *arg0, byte * CONST * argv);
+	byte  (*Save)(void);	/* see upgrade.c */
+	uldat (*Restore)(void);
     } Term;
 };
 
@@ -47,6 +47,12 @@ struct fdlist {			/* the uncompressed one has                       */
     byte AlienMagic[9 /*TWS_highest*/];/* sizes and endianity used by slot
 					* instead of native sizes and endianity */
     byte extern_couldntwrite;
+    uldat WQMotion, WQMotionEnd;/* last mouse motion msg in WQueue, valid while */
+    uldat WQMotionW;		/* it ends at WQlen and WQueue was not flushed: */
+    udat WQMotionCode;		/* see sockSendMotion() in socket.c */
+    uldat PerfFired;		/* performance counters, see <Tw/Twperf.h> */
+    tany PerfBytesIn, PerfBytesOut;
+    int PassedFd;		/* fd received with SCM_RIGHTS, see sockRead() in socket.c */
 };
 
 enum Alien_magics {
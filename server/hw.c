@@ -65,7 +65,7 @@ byte NeedOldVideo, CanDragArea;
 byte ExpensiveFlushVideo, ValidOldVideo, NeedHW;
 
 dat (*ChangedVideo)[2][2];
-byte ChangedVideoFlag, ChangedVideoFlagAgain;
+byte ChangedVideoFlag;
 byte QueuedDrawArea2FullScreen;
 
 dat DisplayWidth, DisplayHeight;
@@ -282,6 +282,66 @@ void NeedRedrawVideo(dat Left, dat Up, dat Right, dat Down) {
  */
 
 
+/*
+ * hash a row of Video[], for twdisplay screen cache.
+ * both twin and twdisplay compute it, so it must not depend on byte order:
+ * it is FNV-1a over each hwattr, low byte first.
+ */
+uldat HashVideoRow(CONST hwattr *V, dat len) {
+    uldat h = 2166136261U;
+    hwattr a;
+    byte i;
+    
+    while (len-- > 0) {
+	a = *V++;
+	for (i = 0; i < sizeof(hwattr); i++, a >>= 8)
+	    h = (h ^ (byte)a) * 16777619U;
+    }
+    return h;
+}
+
+/*
+ * feed a selection notify to S, to reassemble big selections arriving
+ * in several chunks. Return TRUE if the selection is complete: *Len and *Data
+ * then are the whole selection, valid until SelectionChunkFree(S).
+ * A notify for another ReqPrivate, or one that is not a chunk, discards
+ * a pending partial selection; data we have no memory for is dropped.
+ */
+byte SelectionChunk(selchunks *S, uldat ReqPrivate, udat Code, uldat *Len, CONST byte **Data) {
+    uldat Max;
+    byte *Buf;
+    
+    if (S->Len && ReqPrivate != S->ReqPrivate)
+	S->Len = 0;
+    if (!S->Len && !(Code & SEL_NOTIFY_MORE))
+	return TRUE;
+    S->ReqPrivate = ReqPrivate;
+    
+    if (S->Len + *Len > S->Max) {
+	Max = Max2(S->Len + *Len, S->Max << 1);
+	if ((Buf = ReAllocMem(S->Buf, Max))) {
+	    S->Buf = Buf;
+	    S->Max = Max;
+	} else
+	    *Len = S->Max - S->Len;
+    }
+    if (*Len) {
+	CopyMem(*Data, S->Buf + S->Len, *Len);
+	S->Len += *Len;
+    }
+    if (Code & SEL_NOTIFY_MORE)
+	return FALSE;
+    *Len = S->Len;
+    *Data = S->Buf;
+    return TRUE;
+}
+
+void SelectionChunkFree(selchunks *S) {
+    if (S->Buf)
+	FreeMem(S->Buf);
+    S->Buf = NULL;
+    S->Len = S->Max = 0;
+}
 
 /*
  * for better cleannes, DirtyVideo()
@@ -301,7 +361,7 @@ void DirtyVideo(dat Xstart, dat Ystart, dat Xend, dat Yend) {
     Xend = Min2(Xend, DisplayWidth-1);
     Yend = Min2(Yend, DisplayHeight-1);
 
-    ChangedVideoFlag = ChangedVideoFlagAgain = TRUE;
+    ChangedVideoFlag = TRUE;
     
     for (; Ystart <= Yend; Ystart++) {
 	s0 = ChangedVideo[Ystart][0][0];
@@ -25,7 +25,7 @@ extern display_hw DisplayHWCTTY;
 extern hwattr *Video, *OldVideo;
 extern byte NeedOldVideo, ValidOldVideo;
 extern byte ExpensiveFlushVideo, NeedHW;
-extern byte CanDragArea, ChangedVideoFlagAgain;
+extern byte CanDragArea;
 extern byte QueuedDrawArea2FullScreen;
 
 extern VOLATILE byte GotSignals;
@@ -36,8 +36,18 @@ byte InitTtysave(void);
 
 
 void DirtyVideo(dat Xstart, dat Ystart, dat Xend, dat Yend);
+uldat HashVideoRow(CONST hwattr *V, dat len);
 void DragArea(dat Xstart, dat Ystart, dat Xend, dat Yend, dat DstXstart, dat DstYstart);
 
+/* a big selection notify being reassembled from its chunks, see SelectionChunk() */
+typedef struct s_selchunks selchunks;
+struct s_selchunks {
+    byte *Buf;
+    uldat Len, Max, ReqPrivate;
+};
+byte SelectionChunk(selchunks *S, uldat ReqPrivate, udat Code, uldat *Len, CONST byte **Data);
+void SelectionChunkFree(selchunks *S);
+
 void MoveToXY(dat x, dat y);
 void SetCursorType(uldat type);
 
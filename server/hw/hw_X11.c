@@ -49,6 +49,7 @@ struct x11_data {
     dat xhw_view, xhw_startx, xhw_starty, xhw_endx, xhw_endy;
     
     Tutf_function xUTF_16_to_charset;
+    Tutf_function_n xUTF_16_to_charset_n;
     Display     *xdisplay;
     Window       xwindow;
     GC           xgc;
@@ -83,6 +84,7 @@ struct x11_data {
 #define xhw_endy	(xdata->xhw_endy)
 
 #define xUTF_16_to_charset	(xdata->xUTF_16_to_charset)
+#define xUTF_16_to_charset_n	(xdata->xUTF_16_to_charset_n)
 #define xdisplay	(xdata->xdisplay)
 #define xwindow		(xdata->xwindow)
 #define xgc		(xdata->xgc)
@@ -123,11 +125,25 @@ static hwcol _col;
 #define XDRAW_ANY(buf, buflen, col, gfx) XDRAW(col, buf, buflen)
 
 
+/* translate a run of chars at once to the font charset. clobbers fbuf */
+INLINE void X11_Translate(hwfont *fbuf, XChar2b *buf, udat buflen) {
+    hwfont f;
+    udat i;
+    
+    if (xUTF_16_to_charset_n)
+	xUTF_16_to_charset_n(fbuf, fbuf, buflen);
+    for (i = 0; i < buflen; i++) {
+	f = xUTF_16_to_charset_n ? fbuf[i] : xUTF_16_to_charset(fbuf[i]);
+	buf[i].byte1 = f >> 8;
+	buf[i].byte2 = f & 0xFF;
+    }
+}
+
 INLINE void X11_Mogrify(dat x, dat y, uldat len) {
     hwattr *V, *oV;
     hwcol col;
     udat buflen = 0;
-    hwfont f;
+    hwfont fbuf[TW_SMALLBUFF];
     XChar2b buf[TW_SMALLBUFF];
     int xbegin, ybegin;
     
@@ -154,6 +170,7 @@ INLINE void X11_Mogrify(dat x, dat y, uldat len) {
     for (_col = ~HWCOL(*V); len; x++, V++, oV++, len--) {
 	col = HWCOL(*V);
 	if (buflen && (col != _col || (ValidOldVideo && *V == *oV) || buflen == TW_SMALLBUFF)) {
+	    X11_Translate(fbuf, buf, buflen);
 	    XDRAW(_col, buf, buflen);
 	    buflen = 0;
 	}
@@ -162,12 +179,11 @@ INLINE void X11_Mogrify(dat x, dat y, uldat len) {
 		xbegin = (x - xhw_startx) * (ldat)xwfont;
 		_col = col;
 	    }
-	    f = xUTF_16_to_charset(HWFONT(*V));
-	    buf[buflen  ].byte1 = f >> 8;
-	    buf[buflen++].byte2 = f & 0xFF;
+	    fbuf[buflen++] = HWFONT(*V);
 	}
     }
     if (buflen) {
+	X11_Translate(fbuf, buf, buflen);
 	XDRAW(_col, buf, buflen);
 	buflen = 0;
     }
@@ -498,6 +514,7 @@ static byte X11_InitHW(void) {
 
 	    if (!(xUTF_16_to_charset = X11_UTF_16_to_charset_function(charset)))
 		xUTF_16_to_charset = X11_UTF_16_to_UTF_16;
+	    xUTF_16_to_charset_n = Tutf_UTF_16_to_charset_function_n(xUTF_16_to_charset);
 	    /*
 	     * ask ICCCM-compliant window manager to tell us when close window
 	     * has been chosen, rather than just killing us
@@ -24,11 +24,18 @@
 
 struct display_data {
     msgport display, Helper;
+    uldat *RowHash;	/* hashes of the rows twdisplay restored from its screen cache */
+    dat RowHashW, RowHashN;
+    byte WaitRowHash;	/* TRUE until twdisplay sends DPY_RowHash */
 };
 
 #define displaydata	((struct display_data *)HW->Private)
 #define display		(displaydata->display)
 #define Helper		(displaydata->Helper)
+#define RowHash		(displaydata->RowHash)
+#define RowHashW	(displaydata->RowHashW)
+#define RowHashN	(displaydata->RowHashN)
+#define WaitRowHash	(displaydata->WaitRowHash)
 
 static msg Msg;
 static event_display *ev;
@@ -141,6 +148,22 @@ static void display_HandleEvent(display_hw hw) {
 				    ((udat *)Event->EventDisplay.Data)[1]);
 		break;
 #endif
+	      case DPY_RowHash:
+		/*
+		 * twdisplay tells us which rows it already shows:
+		 * redraw everything, display_FlushVideo() will skip them.
+		 */
+		if (WaitRowHash) {
+		    WaitRowHash = FALSE;
+		    RowHashN = Min2(Event->EventDisplay.Y, Event->EventDisplay.Len / sizeof(uldat));
+		    if (RowHashN > 0) {
+			RowHash = (uldat *)Event->EventDisplay.Data;
+			RowHashW = Event->EventDisplay.X;
+			Event->EventDisplay.Data = NULL;
+		    }
+		    NeedRedrawVideo(0, 0, HW->X - 1, HW->Y - 1);
+		}
+		break;
 	      case DPY_Resize:
 		if (HW->X != Event->EventDisplay.X ||
 		    HW->Y != Event->EventDisplay.Y) {
@@ -214,9 +237,20 @@ INLINE void display_SetCursorType(uldat type) {
     Ext(Socket,SendMsg)(display, Msg);
 }
 
+/* TRUE if row y is one twdisplay restored from its screen cache, and is still current */
+static byte display_RowCached(dat y) {
+    return y < RowHashN && RowHashW == DisplayWidth &&
+	RowHash[y] == HashVideoRow(Video + y * (ldat)DisplayWidth, DisplayWidth);
+}
+
 static void display_FlushVideo(void) {
     dat start, end;
     udat i;
+    byte cached = FALSE;
+    
+    if (WaitRowHash)
+	/* anything we draw now would be drawn again after DPY_RowHash */
+	return;
     
     /* first burst all changes */
     if (ChangedVideoFlag) {
@@ -224,11 +258,20 @@ static void display_FlushVideo(void) {
 	    start = ChangedVideo[i>>1][i&1][0];
 	    end   = ChangedVideo[i>>1][i&1][1];
 	    
-	    if (start != -1)
+	    if (RowHash && !(i&1))
+		cached = display_RowCached(i>>1);
+	    
+	    if (start != -1 && !cached)
 		display_Mogrify(start, i>>1, end-start+1);
 	}
 	setFlush();
     }
+    if (RowHash) {
+	/* this was the full redraw requested by DPY_RowHash */
+	FreeMem(RowHash);
+	RowHash = NULL;
+	RowHashN = 0;
+    }
     
     /* update the cursor */
     if (!ValidOldVideo || (CursorType != NOCURSOR && (CursorX != HW->XY[0] || CursorY != HW->XY[1]))) {
@@ -373,7 +416,7 @@ static void display_SelectionNotify_display(uldat ReqPrivate, uldat Magic, CONST
 
 static void display_QuitHW(void) {
     /* tell twdisplay to cleanly quit */
-    display_CreateMsg(DPY_Quit, 4*sizeof(dat));
+    display_CreateMsg(DPY_Quit, 0);
     Ext(Socket,SendMsg)(display, Msg);
     RemoteFlush(HW->AttachSlot);
 
@@ -381,6 +424,9 @@ static void display_QuitHW(void) {
     
     Helper->AttachHW = (display_hw)0; /* to avoid infinite loop */
     Delete(Helper);
+    
+    if (RowHash)
+	FreeMem(RowHash), RowHash = NULL;
 
     if (!--Used && Msg)
 	Delete(Msg), Msg = (msg)0;
@@ -461,6 +507,11 @@ static byte display_InitHW(void) {
     ev = &Msg->Event.EventDisplay;
     display = Port;
     Helper->AttachHW = HW;
+    
+    RowHash = NULL;
+    RowHashW = RowHashN = 0;
+    /* twdisplay `-cache': wait for its DPY_RowHash before drawing */
+    WaitRowHash = arg && strstr(arg, ",cache");
 	
     HW->mouse_slot = NOSLOT;
     HW->keyboard_slot = NOSLOT;
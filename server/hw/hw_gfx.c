@@ -72,6 +72,7 @@ struct x11_data {
     Display     *xdisplay;
     Window       xwindow;
     Pixmap       xtheme, xroot, xbg;
+    Pixmap       xtile[256]; /* single theme cells, cut from xtheme on first use */
     GC           xgc, xthemegc, xrootgc, xbggc;
     XFontStruct *xsfont;
 #ifdef TW_FEATURE_X11_XIM_XIC /* autodetected by hw_x/features.h */
@@ -108,6 +109,7 @@ struct x11_data {
 #define xdisplay	(xdata->xdisplay)
 #define xwindow		(xdata->xwindow)
 #define xtheme		(xdata->xtheme)
+#define xtile		(xdata->xtile)
 #define xroot		(xdata->xroot)
 #define xbg		(xdata->xbg)
 #define xgc		(xdata->xgc)
@@ -200,6 +202,8 @@ INLINE void gfx_Draw1Mono(myXChar *f, hwcol col, hwattr gfx, int xbegin, int ybe
 	xthemesgc.foreground = xcol[COLFG(col)], mask |= GCForeground;
     if (xthemesgc.background != xcol[COLBG(col)])
 	xthemesgc.background = xcol[COLBG(col)], mask |= GCBackground;    
+    if (xthemesgc.stipple != xtheme)
+	xthemesgc.stipple = xtheme, mask |= GCStipple;
     if (xthemesgc.ts_x_origin != xbegin - i)
 	xthemesgc.ts_x_origin = xbegin - i, mask |= GCTileStipXOrigin;
     if (xthemesgc.ts_y_origin != ybegin - j)
@@ -213,7 +217,65 @@ INLINE void gfx_Draw1Mono(myXChar *f, hwcol col, hwattr gfx, int xbegin, int ybe
     }
 }
 
+/* return a pixmap holding only theme cell `gfx', cutting it from xtheme on first use */
+static Pixmap gfx_Tile(hwattr gfx) {
+    Pixmap *tile = &xtile[gfx & 0xFF];
+    GC gc;
+    
+    if (*tile == None &&
+	(*tile = XCreatePixmap(xdisplay, xwindow, xwfont, xhfont,
+			       xmonochrome ? 1 : DefaultDepth(xdisplay, DefaultScreen(xdisplay)))) != None) {
+	
+	if ((gc = XCreateGC(xdisplay, *tile, 0, NULL))) {
+	    XCopyArea(xdisplay, xtheme, *tile, gc, (gfx % pitch) * (ldat)xwfont, (gfx / pitch) * (ldat)xhfont,
+		      xwfont, xhfont, 0, 0);
+	    XFreeGC(xdisplay, gc);
+	} else {
+	    XFreePixmap(xdisplay, *tile);
+	    *tile = None;
+	}
+    }
+    return *tile;
+}
+
+/*
+ * draw a run of identical theme cells with a single tiled (or stippled) fill
+ * and their text with a single string. fall back to one cell at time
+ * if the tile cannot be created.
+ */
+static byte gfx_DrawRun(myXChar *buf, udat buflen, hwcol col, hwattr gfx, int xbegin, int ybegin) {
+    Pixmap tile;
+    unsigned long mask = 0;
+    
+    if ((tile = gfx_Tile(gfx)) == None)
+	return FALSE;
+    
+    if (xmonochrome) {
+	if (xthemesgc.foreground != xcol[COLFG(col)])
+	    xthemesgc.foreground = xcol[COLFG(col)], mask |= GCForeground;
+	if (xthemesgc.background != xcol[COLBG(col)])
+	    xthemesgc.background = xcol[COLBG(col)], mask |= GCBackground;
+	if (xthemesgc.stipple != tile)
+	    xthemesgc.stipple = tile, mask |= GCStipple;
+    } else if (xthemesgc.tile != tile)
+	xthemesgc.tile = tile, mask |= GCTile;
+    if (xthemesgc.ts_x_origin != xbegin)
+	xthemesgc.ts_x_origin = xbegin, mask |= GCTileStipXOrigin;
+    if (xthemesgc.ts_y_origin != ybegin)
+	xthemesgc.ts_y_origin = ybegin, mask |= GCTileStipYOrigin;
+    if (mask)
+	XChangeGC(xdisplay, xthemegc, mask, &xthemesgc);
+    XFillRectangle(xdisplay, xwindow, xthemegc, xbegin, ybegin, xwfont * (uldat)buflen, xhfont);
+    
+    if (IS_GFX_TITLE(gfx) || IS_GFX_INSIDE(gfx) || IS_GFX_MENU(gfx) || IS_GFX_ROOT(gfx)) {
+	XDRAW_S(buf, buflen, col);
+    }
+    return TRUE;
+}
+
 static void gfx_DrawMono(myXChar *buf, udat buflen, hwcol col, hwattr gfx, int xbegin, int ybegin) {
+    if (buflen > 1 && gfx_DrawRun(buf, buflen, col, gfx, xbegin, ybegin))
+	return;
     for (; buflen; buf++, buflen--, xbegin += xwfont) {
 	gfx_Draw1Mono(buf, col, gfx, xbegin, ybegin);
     }
@@ -242,6 +304,8 @@ INLINE void gfx_Draw1Color(myXChar *f, hwcol col, hwattr gfx, int xbegin, int yb
 }
 
 static void gfx_DrawColor(myXChar *buf, udat buflen, hwcol col, hwattr gfx, int xbegin, int ybegin) {
+    if (buflen > 1 && gfx_DrawRun(buf, buflen, col, gfx, xbegin, ybegin))
+	return;
     for (; buflen; buf++, buflen--, xbegin += xwfont) {
 	gfx_Draw1Color(buf, col, gfx, xbegin, ybegin);
     }
@@ -705,7 +769,13 @@ static byte gfx_InitHW(void) {
 	      xthemesgc.fill_style = FillOpaqueStippled,
 	      !!(xthemegc = XCreateGC(xdisplay, xwindow, GCStipple|GCFillStyle|
 				      GCForeground|GCBackground|GCGraphicsExposures, &xthemesgc)))
-	     : TRUE) &&
+	     :
+	     /* used by gfx_DrawRun() to fill runs of identical cells */
+	     (xthemesgc.graphics_exposures = False,
+	      xthemesgc.tile = xtheme,
+	      xthemesgc.fill_style = FillTiled,
+	      !!(xthemegc = XCreateGC(xdisplay, xwindow, GCTile|GCFillStyle|GCGraphicsExposures, &xthemesgc)))
+	     ) &&
 	    
 	    (opt.file_root ?
 	     (xs_gc.foreground = xs_gc.background = xcol[0],
@@ -876,6 +946,7 @@ fail:
 }
 
 static void gfx_QuitHW(void) {
+    int i;
 
 #ifdef TW_FEATURE_X11_XIM_XIC
     if (xic)              XDestroyIC(xic);
@@ -884,6 +955,10 @@ static void gfx_QuitHW(void) {
     if (xsfont)           XFreeFont(xdisplay, xsfont);
     if (xgc      != None) XFreeGC(xdisplay, xgc);
     if (xthemegc != None) XFreeGC(xdisplay, xthemegc);
+    for (i = 0; i < 256; i++) {
+	if (xtile[i] != None) XFreePixmap(xdisplay, xtile[i]);
+    }
+    if (xtheme   != None) XFreePixmap(xdisplay, xtheme);
     if (xroot    != None) XFreePixmap(xdisplay, xroot);
     if (xbg      != None) XFreePixmap(xdisplay, xbg);
     if (xwindow  != None) {
@@ -57,6 +57,7 @@ struct tty_data {
     byte *tty_name, *tty_TERM;
     uldat tty_charset;
     Tutf_function tty_UTF_16_to_charset;
+    Tutf_function_n tty_UTF_16_to_charset_n;
     Tutf_array tty_charset_to_UTF_16;
     byte tty_use_utf8, tty_is_xterm;
     dat ttypar[3];
@@ -92,6 +93,7 @@ struct tty_data {
 #define tty_TERM	(ttydata->tty_TERM)
 #define tty_charset	(ttydata->tty_charset)
 #define tty_UTF_16_to_charset	(ttydata->tty_UTF_16_to_charset)
+#define tty_UTF_16_to_charset_n	(ttydata->tty_UTF_16_to_charset_n)
 #define tty_charset_to_UTF_16	(ttydata->tty_charset_to_UTF_16)
 #define tty_use_utf8		(ttydata->tty_use_utf8)
 #define tty_is_xterm		(ttydata->tty_is_xterm)
@@ -551,6 +553,7 @@ static byte tty_InitHW(void) {
                     tty_UTF_16_to_charset = Tutf_UTF_16_to_charset_function(tty_charset);
                     tty_charset_to_UTF_16 = Tutf_charset_to_UTF_16_array(tty_charset);
                 }
+                tty_UTF_16_to_charset_n = Tutf_UTF_16_to_charset_function_n(tty_UTF_16_to_charset);
 
 		/*
 		 * must be deferred until now, as HW-specific functions
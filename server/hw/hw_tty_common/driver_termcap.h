@@ -332,18 +332,28 @@ INLINE void termcap_SetColor(hwcol col) {
 
 INLINE void termcap_Mogrify(dat x, dat y, uldat len) {
     uldat delta = x + y * (uldat)DisplayWidth;
-    hwattr *V, *oV;
+    hwattr *V, *oV, *cV;
     hwcol col;
     hwfont c, _c;
-    byte sending = FALSE;
+    hwfont cbuf[TW_SMALLBUFF];
+    uldat i, chunk = 0;
+    byte sending = FALSE, bulk = !tty_use_utf8 && tty_UTF_16_to_charset_n;
     
     if (!wrapglitch && delta + len >= (uldat)DisplayWidth * DisplayHeight)
 	len = (uldat)DisplayWidth * DisplayHeight - delta - 1;
     
-    V = Video + delta;
+    cV = V = Video + delta;
     oV = OldVideo + delta;
     
     for (; len; V++, oV++, x++, len--) {
+	if (bulk && (uldat)(V - cV) >= chunk) {
+	    /* translate the next chunk of chars at once */
+	    cV = V;
+	    chunk = Min2(len, TW_SMALLBUFF);
+	    for (i = 0; i < chunk; i++)
+		cbuf[i] = HWFONT(V[i]);
+	    tty_UTF_16_to_charset_n(cbuf, cbuf, chunk);
+	}
 	if (!ValidOldVideo || *V != *oV) {
 	    if (!sending)
 		sending = TRUE, termcap_MoveToXY(x,y);
@@ -359,7 +369,9 @@ INLINE void termcap_Mogrify(dat x, dat y, uldat len) {
                     /* use utf-8 to output this non-ASCII char */
                     tty_MogrifyUTF8(_c);
                     continue;
-                } else if (tty_charset_to_UTF_16[c] != c) {
+                } else if (bulk) {
+                    c = cbuf[V - cV];
+                } else if (c >= 256 || tty_charset_to_UTF_16[c] != c) {
                     c = tty_UTF_16_to_charset(_c);
                 }
             }
@@ -393,7 +405,7 @@ INLINE void termcap_SingleMogrify(dat x, dat y, hwattr V) {
             /* use utf-8 to output this non-ASCII char */
             tty_MogrifyUTF8(_c);
             return;
-        } else if (tty_charset_to_UTF_16[c] != c) {
+        } else if (c >= 256 || tty_charset_to_UTF_16[c] != c) {
             c = tty_UTF_16_to_charset(_c);
         }
     }
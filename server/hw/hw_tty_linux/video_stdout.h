@@ -174,7 +174,7 @@ INLINE void linux_Mogrify(dat x, dat y, uldat len) {
                     /* use utf-8 to output this non-ASCII char. */
                     tty_MogrifyUTF8(c);
                     continue;
-                } else if (tty_charset_to_UTF_16[c] != c) {
+                } else if (c >= 256 || tty_charset_to_UTF_16[c] != c) {
                     c = tty_UTF_16_to_charset(_c);
                 }
             }
@@ -207,7 +207,7 @@ INLINE void linux_SingleMogrify(dat x, dat y, hwattr V) {
             /* use utf-8 to output this non-ASCII char. */
             tty_MogrifyUTF8(c);
             return;
-        } else if (tty_charset_to_UTF_16[c] != c) {
+        } else if (c >= 256 || tty_charset_to_UTF_16[c] != c) {
             c = tty_UTF_16_to_charset(_c);
         }
     }
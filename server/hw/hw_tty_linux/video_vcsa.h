@@ -101,17 +101,30 @@ static void vcsa_QuitVideo(void) {
 #else /* TW_SIZEOF_HWATTR != 2 || !TW_IS_LITTLE_ENDIAN */
 
 static byte vcsa_buff[TW_BIGBUFF*2];
+static hwfont vcsa_font[TW_BIGBUFF];
 
 INLINE void vcsa_write(int fd, hwattr *buf, uldat count, uldat pos) {
     byte *buf8;
+    hwfont *font;
     uldat chunk;
     
     lseek(fd, pos*2+4, SEEK_SET);
     while (count) {
+	chunk = Min2(count, TW_BIGBUFF);
+	if (tty_UTF_16_to_charset_n) {
+	    /* translate the whole chunk at once */
+	    for (pos = 0; pos < chunk; pos++)
+		vcsa_font[pos] = HWFONT(buf[pos]);
+	    tty_UTF_16_to_charset_n(vcsa_font, vcsa_font, chunk);
+	} else {
+	    for (pos = 0; pos < chunk; pos++)
+		vcsa_font[pos] = tty_UTF_16_to_charset(HWFONT(buf[pos]));
+	}
 	buf8 = vcsa_buff;
-	pos = chunk = Min2(count, TW_BIGBUFF);
+	font = vcsa_font;
+	pos = chunk;
 	while (pos--) {
-	    *buf8++ = tty_UTF_16_to_charset(HWFONT(*buf));
+	    *buf8++ = *font++;
 	    *buf8++ = HWCOL(*buf);
 	    buf++;
 	}
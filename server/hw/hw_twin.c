@@ -42,6 +42,7 @@ typedef struct {
     byte TSelCount;
     sel_req SelReq[TSELMAX]; /* buffers to hold selection request data while waiting from twin */
     sel_req TSelReq[TSELMAX]; /* buffers to hold selection request data while waiting from libTw */
+    selchunks TSelChunks; /* chunked selection notify being reassembled */
 } tw_data;
 
 #define twdata		((tw_data *)HW->Private)
@@ -52,6 +53,7 @@ typedef struct {
 #define TSelCount	(twdata->TSelCount)
 #define SelReq		(twdata->SelReq)
 #define TSelReq		(twdata->TSelReq)
+#define TSelChunks	(twdata->TSelChunks)
 
 static void TW_SelectionRequest_up(uldat Requestor, uldat ReqPrivate);
 static void TW_SelectionNotify_up(uldat ReqPrivate, uldat Magic, CONST byte MIME[MAX_MIMELEN],
@@ -106,6 +108,8 @@ static void TW_Configure(udat resource, byte todefault, udat value) {
 
 static void TW_HandleMsg(tmsg Msg) {
     tevent_any Event;
+    CONST byte *Data;
+    uldat Len;
     dat x, y, dx, dy;
     udat keys;
     
@@ -120,9 +124,15 @@ static void TW_HandleMsg(tmsg Msg) {
 	TW_SelectionRequest_up(Event->EventSelectionRequest.Requestor, Event->EventSelectionRequest.ReqPrivate);
 	return;
       case TW_MSG_SELECTIONNOTIFY:
-	TW_SelectionNotify_up(Event->EventSelectionNotify.ReqPrivate, Event->EventSelectionNotify.Magic,
-			      Event->EventSelectionNotify.MIME, Event->EventSelectionNotify.Len,
-			      Event->EventSelectionNotify.Data);
+	Len = Event->EventSelectionNotify.Len;
+	Data = Event->EventSelectionNotify.Data;
+	/* big selections arrive in chunks: pass them up only when complete */
+	if (SelectionChunk(&TSelChunks, Event->EventSelectionNotify.ReqPrivate,
+			   Event->EventSelectionNotify.Code, &Len, &Data)) {
+	    TW_SelectionNotify_up(Event->EventSelectionNotify.ReqPrivate, Event->EventSelectionNotify.Magic,
+				  Event->EventSelectionNotify.MIME, Len, Data);
+	    SelectionChunkFree(&TSelChunks);
+	}
 	return;
       default:
 	break;
@@ -405,6 +415,8 @@ static void TW_QuitHW(void) {
      */
     Tw_Close(Td);
     
+    SelectionChunkFree(&TSelChunks);
+    
     UnRegisterRemote(HW->keyboard_slot);
     HW->keyboard_slot = NOSLOT;
     
@@ -466,6 +478,7 @@ static byte TW_InitHW(void) {
 #endif
 	
     Td = NULL;
+    WriteMem(&TSelChunks, '\0', sizeof(selchunks));
     
     if (Tw_CheckMagic(hw_twin_magic) && (Td = Tw_Open(arg)) &&
 	
@@ -0,0 +1,364 @@
+/*
+ *  test_gfx_runs.c  --  check that hw_gfx draws runs of identical theme cells
+ *                       with the same pixels as one cell at time
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *
+ * Built and run by `make check' in the server/hw directory when hw_gfx is
+ * enabled. It includes hw_gfx.c and replaces the handful of Xlib calls the
+ * drawing functions use with a small software rasterizer, so it needs the
+ * X11 and Xpm headers but no X server. The rest of hw_gfx.c and of the
+ * server stay unresolved. To build it by hand, from the build directory:
+ *
+ *   cc -DHAVE_CONFIG_H -I include -I $srcdir/include -I $srcdir/server \
+ *      -o test_gfx_runs $srcdir/server/hw/test_gfx_runs.c \
+ *      -no-pie -Wl,--unresolved-symbols=ignore-all
+ *   ./test_gfx_runs [rounds] [seed]
+ *
+ * Each round draws the same random run (theme cell, colors, text, length
+ * and starting pixel) twice on a noisy window: with gfx_Draw1Color() or
+ * gfx_Draw1Mono() cell by cell, and with gfx_DrawColor() or gfx_DrawMono(),
+ * which use gfx_DrawRun(). The two windows must match pixel by pixel.
+ * Runs start at any pixel, not only on the cell grid as X11_Mogrify() puts
+ * them: there a wrong ts_x_origin or ts_y_origin would be hidden by the
+ * tile being exactly one cell wide and high.
+ * The order of the two passes is random, so the GC state cached in
+ * xthemesgc is exercised across both paths; XCreatePixmap() also fails on
+ * demand to exercise the fallback. The rasterizer reports BadMatch for
+ * tiles and stipples of the wrong depth, as a real server would.
+ */
+
+#include "hw_gfx.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+display_hw HW;
+
+#define W      6	/* font width and height: odd sizes catch modulo errors */
+#define H      9
+#define UP     7
+#define COLS   80
+#define ROWS   4
+#define THEME_ROWS 18	/* enough for gfx up to 255 */
+
+/* ---- rasterizer ---- */
+
+typedef struct {
+    unsigned w, h, depth;
+    unsigned long *pix;
+} mdraw;
+
+typedef struct {
+    XGCValues v;
+} mgc;
+
+#define MAX_DRAW 300
+#define MAX_GC   300
+
+static mdraw Draws[MAX_DRAW];	/* Drawable n is Draws[n], 0 is None */
+static uldat NDraws = 1;
+static mgc Gcs[MAX_GC];
+static uldat NGcs;
+static byte FailPixmap;
+static uldat Requests, BadMatches;
+
+static unsigned long Mod(long a, unsigned long m) {
+    return (unsigned long)(((a % (long)m) + (long)m) % (long)m);
+}
+
+static mdraw *Draw(Drawable d) {
+    if (d == None || d >= NDraws || !Draws[d].pix) {
+	fprintf(stderr, "test_gfx_runs: bad drawable %lu\n", (unsigned long)d);
+	exit(1);
+    }
+    return &Draws[d];
+}
+
+static Drawable NewDraw(unsigned w, unsigned h, unsigned depth) {
+    if (NDraws >= MAX_DRAW)
+	return None;
+    Draws[NDraws].w = w;
+    Draws[NDraws].h = h;
+    Draws[NDraws].depth = depth;
+    Draws[NDraws].pix = (unsigned long *)calloc((size_t)w * h, sizeof(unsigned long));
+    return NDraws++;
+}
+
+Pixmap XCreatePixmap(Display *dpy, Drawable d, unsigned int w, unsigned int h, unsigned int depth) {
+    Requests++;
+    if (FailPixmap)
+	return None;
+    return NewDraw(w, h, depth);
+}
+
+int XFreePixmap(Display *dpy, Pixmap p) {
+    Requests++;
+    free(Draw(p)->pix);
+    Draws[p].pix = NULL;
+    return 1;
+}
+
+static void SetGC(mgc *g, unsigned long mask, XGCValues *v) {
+    if (mask & GCForeground)      g->v.foreground = v->foreground;
+    if (mask & GCBackground)      g->v.background = v->background;
+    if (mask & GCFillStyle)       g->v.fill_style = v->fill_style;
+    if (mask & GCTile)            g->v.tile = v->tile;
+    if (mask & GCStipple)         g->v.stipple = v->stipple;
+    if (mask & GCTileStipXOrigin) g->v.ts_x_origin = v->ts_x_origin;
+    if (mask & GCTileStipYOrigin) g->v.ts_y_origin = v->ts_y_origin;
+}
+
+GC XCreateGC(Display *dpy, Drawable d, unsigned long mask, XGCValues *v) {
+    mgc *g;
+    Requests++;
+    if (NGcs >= MAX_GC)
+	return NULL;
+    g = &Gcs[NGcs++];
+    memset(g, 0, sizeof(*g));
+    g->v.background = 1;
+    g->v.fill_style = FillSolid;
+    SetGC(g, mask, v);
+    return (GC)g;
+}
+
+int XFreeGC(Display *dpy, GC gc) {
+    Requests++;
+    return 1;
+}
+
+int XChangeGC(Display *dpy, GC gc, unsigned long mask, XGCValues *v) {
+    Requests++;
+    SetGC((mgc *)gc, mask, v);
+    return 1;
+}
+
+int XCopyArea(Display *dpy, Drawable src, Drawable dst, GC gc, int sx, int sy,
+	      unsigned int w, unsigned int h, int dx, int dy) {
+    mdraw *s = Draw(src), *d = Draw(dst);
+    unsigned x, y;
+
+    Requests++;
+    if (s->depth != d->depth) {
+	BadMatches++;
+	return 1;
+    }
+    for (y = 0; y < h; y++)
+	for (x = 0; x < w; x++) {
+	    if (sx + x < s->w && sy + y < s->h && dx + x < d->w && dy + y < d->h)
+		d->pix[(dy + y) * d->w + dx + x] = s->pix[(sy + y) * s->w + sx + x];
+	}
+    return 1;
+}
+
+int XFillRectangle(Display *dpy, Drawable dst, GC gc, int x0, int y0, unsigned int w, unsigned int h) {
+    XGCValues *v = &((mgc *)gc)->v;
+    mdraw *d = Draw(dst), *t = NULL;
+    unsigned long p;
+    int x, y;
+
+    Requests++;
+    if (v->fill_style == FillTiled) {
+	t = Draw(v->tile);
+	if (t->depth != d->depth) {
+	    BadMatches++;
+	    return 1;
+	}
+    } else if (v->fill_style == FillOpaqueStippled) {
+	t = Draw(v->stipple);
+	if (t->depth != 1) {
+	    BadMatches++;
+	    return 1;
+	}
+    }
+    for (y = y0; y < y0 + (int)h; y++)
+	for (x = x0; x < x0 + (int)w; x++) {
+	    if (x < 0 || y < 0 || x >= (int)d->w || y >= (int)d->h)
+		continue;
+	    if (!t)
+		p = v->foreground;
+	    else {
+		p = t->pix[Mod(y - v->ts_y_origin, t->h) * t->w + Mod(x - v->ts_x_origin, t->w)];
+		if (v->fill_style == FillOpaqueStippled)
+		    p = p ? v->foreground : v->background;
+	    }
+	    d->pix[y * d->w + x] = p;
+	}
+    return 1;
+}
+
+/* one pixel per glyph, at a position depending on the character */
+int XDrawString16(Display *dpy, Drawable dst, GC gc, int x, int y, _Xconst XChar2b *s, int n) {
+    mdraw *d = Draw(dst);
+    unsigned c;
+    int k;
+
+    Requests++;
+    y -= UP;
+    for (k = 0; k < n; k++) {
+	c = (unsigned)s[k].byte1 << 8 | s[k].byte2;
+	d->pix[(y + (c / W) % H) * d->w + x + k * W + c % W] = ((mgc *)gc)->v.foreground;
+    }
+    return 1;
+}
+
+/* ---- setup ---- */
+
+static struct s_display_hw TheHW;
+static struct x11_data TheData;
+static Screen TheScreen;
+
+static void Setup(int mono) {
+    static _XPrivDisplay dpy;
+    unsigned long *p;
+    uldat i;
+
+    if (!dpy) {
+	dpy = (_XPrivDisplay)calloc(1, sizeof(*dpy));
+	TheScreen.root_depth = 24;
+	dpy->screens = &TheScreen;
+	dpy->nscreens = 1;
+    }
+    for (i = 1; i < NDraws; i++)
+	free(Draws[i].pix);
+    memset(Draws, 0, sizeof(Draws));
+    NDraws = 1;
+    NGcs = 0;
+
+    memset(&TheData, 0, sizeof(TheData));
+    HW = &TheHW;
+    HW->Private = &TheData;
+    xdisplay = (Display *)dpy;
+    xmonochrome = mono;
+    xwfont = W;
+    xhfont = H;
+    xupfont = UP;
+    for (i = 0; i <= MAXCOL; i++)
+	xcol[i] = mono ? i & 1 : (unsigned long)rand() & 0xFFFFFF;
+
+    xwindow = NewDraw((COLS + 1) * W, (ROWS + 1) * H, mono ? 1 : 24);
+    xtheme = NewDraw(pitch * W, THEME_ROWS * H, mono ? 1 : 24);
+    for (p = Draws[xtheme].pix, i = 0; i < pitch * W * THEME_ROWS * H; i++)
+	p[i] = mono ? rand() & 1 : (unsigned long)rand() & 0xFFFFFF;
+
+    /* same GCs as gfx_InitHW() */
+    xsgc.foreground = xsgc.background = xcol[0];
+    xgc = XCreateGC(xdisplay, xwindow, GCForeground|GCBackground, &xsgc);
+    if (mono) {
+	xthemesgc.foreground = xthemesgc.background = xcol[0];
+	xthemesgc.stipple = xtheme;
+	xthemesgc.fill_style = FillOpaqueStippled;
+	xthemegc = XCreateGC(xdisplay, xwindow, GCStipple|GCFillStyle|GCForeground|GCBackground, &xthemesgc);
+    } else {
+	xthemesgc.tile = xtheme;
+	xthemesgc.fill_style = FillTiled;
+	xthemegc = XCreateGC(xdisplay, xwindow, GCTile|GCFillStyle, &xthemesgc);
+    }
+}
+
+static void Noise(void) {
+    mdraw *d = Draw(xwindow);
+    uldat i;
+    for (i = 0; i < d->w * d->h; i++)
+	d->pix[i] = xmonochrome ? (i * 7 / 3) & 1 : i * 2654435761UL & 0xFFFFFF;
+}
+
+/* ---- the two paths ---- */
+
+static uldat DrawCells(myXChar *buf, udat len, hwcol col, hwattr gfx, int xbegin, int ybegin) {
+    uldat r = Requests;
+    for (; len; buf++, len--, xbegin += xwfont) {
+	if (xmonochrome)
+	    gfx_Draw1Mono(buf, col, gfx, xbegin, ybegin);
+	else
+	    gfx_Draw1Color(buf, col, gfx, xbegin, ybegin);
+    }
+    return Requests - r;
+}
+
+static uldat DrawRun(myXChar *buf, udat len, hwcol col, hwattr gfx, int xbegin, int ybegin) {
+    uldat r = Requests;
+    if (xmonochrome)
+	gfx_DrawMono(buf, len, col, gfx, xbegin, ybegin);
+    else
+	gfx_DrawColor(buf, len, col, gfx, xbegin, ybegin);
+    return Requests - r;
+}
+
+static uldat CellRequests, RunRequests;
+
+static byte Round(void) {
+    static unsigned long ref[(COLS + 1) * W * (ROWS + 1) * H];
+    myXChar buf[COLS];
+    udat len = 1 + rand() % COLS, i;
+    int x = rand() % (COLS - len + 1) * W + rand() % W, y = rand() % ROWS * H + rand() % H;
+    hwattr gfx = rand() & 0xFF;
+    hwcol col = rand() & 0xFF;
+    byte runfirst = rand() & 1;
+    uldat n;
+
+    for (i = 0; i < len; i++) {
+	buf[i].byte1 = rand() & 1;
+	buf[i].byte2 = rand() & 0xFF;
+    }
+    /* gfx_DrawRun() caches tiles: make the first attempt fail now and then */
+    FailPixmap = xtile[gfx] == None && rand() % 8 == 0;
+
+    for (n = 0; n < 2; n++) {
+	Noise();
+	if (n == runfirst)
+	    RunRequests += DrawRun(buf, len, col, gfx, x, y);
+	else
+	    CellRequests += DrawCells(buf, len, col, gfx, x, y);
+	if (n == 0)
+	    memcpy(ref, Draws[xwindow].pix, sizeof(ref));
+    }
+    FailPixmap = FALSE;
+
+    if (memcmp(ref, Draws[xwindow].pix, sizeof(ref))) {
+	fprintf(stderr, "MISMATCH: %s gfx=%u col=0x%02X x=%d y=%d len=%u run drawn %s\n",
+		xmonochrome ? "mono" : "color", (unsigned)gfx, (unsigned)col, x, y, (unsigned)len,
+		runfirst ? "first" : "second");
+	return FALSE;
+    }
+    return TRUE;
+}
+
+/* requests to draw one full row of a single theme cell, tile already cached */
+static void RowRequests(void) {
+    myXChar buf[COLS];
+    uldat cells, run;
+
+    memset(buf, 0, sizeof(buf));
+    DrawRun(buf, COLS, 0x70, GFX_MENU, 0, 0);
+    cells = DrawCells(buf, COLS, 0x07, GFX_MENU, 0, 0);
+    run = DrawRun(buf, COLS, 0x70, GFX_MENU, 0, 0);
+    printf("%s: a %d-cell row takes %lu requests cell by cell, %lu as a run\n",
+	   xmonochrome ? "mono" : "color", COLS, (unsigned long)cells, (unsigned long)run);
+}
+
+int main(int argc, char *argv[]) {
+    uldat rounds = argc > 1 ? strtoul(argv[1], NULL, 0) : 5000;
+    unsigned seed = argc > 2 ? strtoul(argv[2], NULL, 0) : 1;
+    uldat i, failed, total = 0;
+    int mono;
+
+    srand(seed);
+    for (mono = 0; mono < 2; mono++) {
+	Setup(mono);
+	CellRequests = RunRequests = 0;
+	for (failed = i = 0; i < rounds; i++)
+	    failed += !Round();
+	total += failed;
+	printf("%s: %lu rounds, %lu failed, %lu BadMatch; requests %lu cell by cell, %lu as runs\n",
+	       mono ? "mono" : "color", (unsigned long)rounds, (unsigned long)failed,
+	       (unsigned long)BadMatches, (unsigned long)CellRequests, (unsigned long)RunRequests);
+	RowRequests();
+    }
+    return total || BadMatches;
+}
@@ -57,11 +57,16 @@ static dat TryDisplayWidth, TryDisplayHeight;
 
 static dat AccelVideo[4] = { TW_MAXDAT, TW_MAXDAT, TW_MINDAT, TW_MINDAT };
 byte   StrategyFlag;
-tany   StrategyDelay = (tany)0;
+
+static timevalue KeyTime; /* when the last keyboard event arrived */
+static uldat KeyCount;    /* how many keyboard events arrived */
 
 static udat ConfigureHWValue[HW_CONFIGURE_MAX];
 static byte ConfigureHWDefault[HW_CONFIGURE_MAX];
 
+static byte **DeferredHW; /* `--hw=' options left for AttachDeferredHW() */
+static byte DeferredFlags;
+
 
 
 /* common functions */
@@ -217,6 +222,19 @@ static void warn_NoHW(TW_CONST byte *arg, uldat len) {
 }
 
 
+/* parse the frame scheduler options common to all displays */
+static void frame_Options(display_hw D_HW) {
+    byte *s, *arg = D_HW->Name;
+    int n;
+    
+    D_HW->MaxFPS = D_HW->MaxLatency = 0;
+    
+    if (arg && (s = strstr(arg, ",fps=")) && (n = atoi(s+5)) > 0)
+	D_HW->MaxFPS = Min2(n, TW_MAXUDAT);
+    if (arg && (s = strstr(arg, ",latency=")) && (n = atoi(s+9)) > 0)
+	D_HW->MaxLatency = Min2(n, TW_MAXUDAT);
+}
+
 /*
  * InitDisplayHW runs HW specific InitXXX() functions, starting from best setup
  * and falling back in case some of them fails.
@@ -251,6 +269,12 @@ byte InitDisplayHW(display_hw D_HW) {
         
 	D_HW->Quitted = FALSE;
 	
+	frame_Options(D_HW);
+	D_HW->FlushTime.Seconds = D_HW->FlushTime.Fraction = (tany)0;
+	D_HW->FlushKeys = KeyCount;
+	D_HW->FlushCost = D_HW->FrameDelay = (tany)0;
+	D_HW->DeferFlag = FALSE;
+	
 	/* configure correctly the new HW */
 	for (tried = 0; tried < HW_CONFIGURE_MAX; tried++) {
 	    if (!(ConfigureHWDefault[tried]))
@@ -388,11 +412,30 @@ byte DetachDisplayHW(uldat len, CONST byte *arg, byte flags) {
     return done;
 }
 
+/*
+ * parse the non-negative number after `--option=' in arg.
+ * return FALSE, after complaining, if it is missing, negative or too big.
+ */
+static byte ParseCountOption(byte *arg, uldat skip, tany *n) {
+    char *end;
+    long l;
+
+    errno = 0;
+    l = strtol(arg + skip, &end, 0);
+    if (end == (char *)arg + skip || *end || errno || l < 0) {
+	printk("twin: ignoring `%."STR(TW_SMALLBUFF)"s': expected a non-negative number\n", arg);
+	return FALSE;
+    }
+    *n = (tany)l;
+    return TRUE;
+}
+
 /* initialize all required HW displays. Since we are at it, also parse command line */
 byte InitHW(void) {
     byte **arglist = orig_argv;
     byte *arg;
     udat hwcount = 0;
+    tany n;
     
     byte ret = FALSE, flags = 0, nohw = FALSE;
     
@@ -409,7 +452,16 @@ byte InitHW(void) {
 	    flag_secure = TRUE;
 	else if (!strcmp(arg, "-envrc"))
 	    flag_envrc = TRUE;
-	else if (!strncmp(arg, "-hw=", 4))
+	else if (!strncmp(arg, "-ttyquantum=", 12)) {
+	    if (ParseCountOption(arg, 12, &n))
+		flag_ttyquantum = (uldat)Min2(n, (tany)TW_MAXULDAT);
+	} else if (!strncmp(arg, "-memsoft=", 9)) {
+	    if (ParseCountOption(arg, 9, &n))
+		flag_memsoft = n << 10;
+	} else if (!strncmp(arg, "-memhard=", 9)) {
+	    if (ParseCountOption(arg, 9, &n))
+		flag_memhard = n << 10;
+	} else if (!strncmp(arg, "-hw=", 4))
 	    hwcount++;
 	else
 	    printk("twin: ignoring unknown option `%."STR(TW_SMALLBUFF)"s'\n", arg);
@@ -438,6 +490,12 @@ byte InitHW(void) {
     else if (hwcount) {
         for (arglist = orig_argv; (arg = *arglist); arglist++) {
             if (!strncmp(arg, "-hw=", 4)) {
+		if (ret) {
+		    /* one display is enough to start: attach the others from main loop */
+		    DeferredHW = arglist;
+		    DeferredFlags = flags;
+		    break;
+		}
                 ret |= !!AttachDisplayHW(strlen(arg), arg, NOSLOT, flags);
             }
         }
@@ -452,6 +510,22 @@ byte InitHW(void) {
     return ret;
 }
 
+/* attach the displays InitHW() did not wait for. return TRUE if it attached some */
+byte AttachDeferredHW(void) {
+    byte **arglist, *arg;
+    byte ret = FALSE;
+    
+    if (!(arglist = DeferredHW))
+	return ret;
+    DeferredHW = NULL;
+    
+    for (; (arg = *arglist); arglist++) {
+	if (!strncmp(arg, "-hw=", 4))
+	    ret |= !!AttachDisplayHW(strlen(arg), arg, NOSLOT, DeferredFlags);
+    }
+    return ret;
+}
+
 void QuitHW(void) {
     DeleteList(All->FirstDisplayHW);
 }
@@ -688,10 +762,142 @@ void TwinSelectionSetOwner(obj Owner, tany Time, tany Frac) {
     }
 }
 
-void TwinSelectionNotify(obj Requestor, uldat ReqPrivate, uldat Magic, CONST byte MIME[MAX_MIMELEN],
-			    uldat Len, CONST byte *Data) {
+/*
+ * msg length is an udat: big selections are notified to msgports
+ * in SEL_NOTIFY_CHUNK pieces, and the requestor knows more are coming
+ * from SEL_NOTIFY_MORE. Like X11 INCR transfers, the next piece is sent
+ * only when the requestor acks the previous one with TwinSelectionAck(),
+ * so each transfer keeps a single piece queued, whatever the size.
+ */
+typedef struct s_seltransfer *seltransfer;
+struct s_seltransfer {
+    seltransfer Next;
+    msgport Requestor;
+    uldat ReqPrivate, Magic;
+    byte MIME[MAX_MIMELEN];
+    uldat Len, Sent;
+    byte *Data;		/* our copy: the owner may change or delete its own */
+};
+
+static seltransfer SelTransfers;
+
+/* send the first Len bytes of Data in a single notify: return FALSE if out of memory */
+static byte SelectionNotifyMsg(msgport Requestor, uldat ReqPrivate, uldat Magic, CONST byte MIME[MAX_MIMELEN],
+			       uldat Len, CONST byte *Data, udat Code) {
     msg NewMsg;
     event_any *Event;
+    
+    if (!(NewMsg = Do(Create,Msg)(FnMsg, MSG_SELECTIONNOTIFY, Len)))
+	return FALSE;
+    Event = &NewMsg->Event;
+    Event->EventSelectionNotify.W = NULL;
+    Event->EventSelectionNotify.Code = Code;
+    Event->EventSelectionNotify.pad = 0;
+    Event->EventSelectionNotify.ReqPrivate = ReqPrivate;
+    Event->EventSelectionNotify.Magic = Magic;
+    if (MIME)
+	CopyMem(MIME, Event->EventSelectionNotify.MIME, MAX_MIMELEN);
+    else
+	WriteMem(Event->EventSelectionNotify.MIME, '\0', MAX_MIMELEN);
+    Event->EventSelectionNotify.Len = Len;
+    if (Len)
+	CopyMem(Data, Event->EventSelectionNotify.Data, Len);
+    SendMsg(Requestor, NewMsg);
+    return TRUE;
+}
+
+static seltransfer *SelectionTransferFind(msgport Requestor, uldat ReqPrivate) {
+    seltransfer *T;
+    
+    for (T = &SelTransfers; *T; T = &(*T)->Next) {
+	if ((*T)->Requestor == Requestor && (*T)->ReqPrivate == ReqPrivate)
+	    break;
+    }
+    return T;
+}
+
+static void SelectionTransferDelete(seltransfer *T) {
+    seltransfer Del = *T;
+    
+    *T = Del->Next;
+    FreeMem(Del->Data);
+    FreeMem(Del);
+}
+
+/* send the next piece of *T, and forget it after the last one */
+static void SelectionTransferNext(seltransfer *T) {
+    seltransfer S = *T;
+    uldat Chunk = Min2(S->Len - S->Sent, SEL_NOTIFY_CHUNK);
+    byte More = S->Sent + Chunk < S->Len;
+    
+    if (SelectionNotifyMsg(S->Requestor, S->ReqPrivate, S->Magic, S->MIME,
+			   Chunk, S->Data + S->Sent, More ? SEL_NOTIFY_MORE : 0) && More)
+	S->Sent += Chunk;
+    else
+	/* done, or out of memory: the requestor gets what was sent so far */
+	SelectionTransferDelete(T);
+}
+
+/* the requestor consumed the previous piece of a big selection: send the next */
+void TwinSelectionAck(obj Requestor, uldat ReqPrivate) {
+    seltransfer *T;
+    
+    if (Requestor && Requestor->Id >> magic_shift == msgport_magic >> magic_shift &&
+	*(T = SelectionTransferFind((msgport)Requestor, ReqPrivate)))
+	SelectionTransferNext(T);
+}
+
+/* Requestor is being deleted: drop the transfers it will never ack */
+void SelectionTransferCancel(msgport Requestor) {
+    seltransfer *T = &SelTransfers;
+    
+    while (*T) {
+	if ((*T)->Requestor == Requestor)
+	    SelectionTransferDelete(T);
+	else
+	    T = &(*T)->Next;
+    }
+}
+
+static void SelectionNotifyMsgPort(msgport Requestor, uldat ReqPrivate, uldat Magic, CONST byte MIME[MAX_MIMELEN],
+				   uldat Len, CONST byte *Data) {
+    seltransfer *T = SelectionTransferFind(Requestor, ReqPrivate), S;
+    
+    if (*T) {
+	/* a new selection for the same request: end the old one where it is */
+	(void)SelectionNotifyMsg(Requestor, ReqPrivate, (*T)->Magic, (*T)->MIME, 0, NULL, 0);
+	SelectionTransferDelete(T);
+    }
+    if (Len <= SEL_NOTIFY_CHUNK) {
+	(void)SelectionNotifyMsg(Requestor, ReqPrivate, Magic, MIME, Len, Data, 0);
+	return;
+    }
+    if ((S = (seltransfer)AllocMem(sizeof(struct s_seltransfer))) &&
+	(S->Data = (byte *)AllocMem(Len))) {
+	
+	CopyMem(Data, S->Data, Len);
+	S->Requestor = Requestor;
+	S->ReqPrivate = ReqPrivate;
+	S->Magic = Magic;
+	if (MIME)
+	    CopyMem(MIME, S->MIME, MAX_MIMELEN);
+	else
+	    WriteMem(S->MIME, '\0', MAX_MIMELEN);
+	S->Len = Len;
+	S->Sent = 0;
+	S->Next = SelTransfers;
+	SelTransfers = S;
+	SelectionTransferNext(&SelTransfers);
+	return;
+    }
+    if (S)
+	FreeMem(S);
+    /* no memory for a copy: send the first piece only */
+    (void)SelectionNotifyMsg(Requestor, ReqPrivate, Magic, MIME, SEL_NOTIFY_CHUNK, Data, 0);
+}
+
+void TwinSelectionNotify(obj Requestor, uldat ReqPrivate, uldat Magic, CONST byte MIME[MAX_MIMELEN],
+			    uldat Len, CONST byte *Data) {
 #if 0    
     printk("twin: Selection Notify to 0x%08x\n", Requestor ? Requestor->Id : NOID);
 #endif
@@ -700,22 +906,7 @@ void TwinSelectionNotify(obj Requestor, uldat ReqPrivate, uldat Magic, CONST byt
     } else if (Requestor->Id >> magic_shift == msgport_magic >> magic_shift) {
 	if (!Data)
 	    Len = 0;
-
-	if ((NewMsg = Do(Create,Msg)(FnMsg, MSG_SELECTIONNOTIFY, Len))) {
-	    Event = &NewMsg->Event;
-	    Event->EventSelectionNotify.W = NULL;
-	    Event->EventSelectionNotify.Code = 0;
-	    Event->EventSelectionNotify.pad = 0;
-	    Event->EventSelectionNotify.ReqPrivate = ReqPrivate;
-	    Event->EventSelectionNotify.Magic = Magic;
-	    if (MIME)
-		CopyMem(MIME, Event->EventSelectionNotify.MIME, MAX_MIMELEN);
-	    else
-		WriteMem(Event->EventSelectionNotify.MIME, '\0', MAX_MIMELEN);
-	    Event->EventSelectionNotify.Len = Len;
-	    CopyMem(Data, Event->EventSelectionNotify.Data, Len);
-	    SendMsg((msgport)Requestor, NewMsg);
-	}
+	SelectionNotifyMsgPort((msgport)Requestor, ReqPrivate, Magic, MIME, Len, Data);
     } else if (Requestor->Id >> magic_shift == display_hw_magic >> magic_shift) {
 	SaveHW;
 	SetHW((display_hw)Requestor);
@@ -856,16 +1047,206 @@ INLINE void SyncOldVideo(void) {
 
 #define MaxRecentBeepHW ((byte)30)
 
-void FlushHW(void) {
+/*
+ * frame scheduler.
+ * 
+ * each display gets its own coalescing interval (HW->FrameDelay),
+ * computed from what its last flushes cost and whether it still has
+ * unsent output queued: cheap displays are flushed immediately,
+ * expensive or backlogged ones let dirty areas accumulate in HW->DeferVideo[]
+ * until their next frame is due. This replaces the old global HW_DELAY strategy.
+ */
+#define FRAME_MINDELAY	(10 MilliSECs)
+#define FRAME_MAXDELAY	(50 MilliSECs) /* default latency budget */
+
+/* how much output is still queued for HW from previous flushes */
+static uldat BacklogHW(void) {
+    uldat len = 0;
+    
+    if (HW->NeedHW & NEEDFromPreviousFlushHW)
+	/* display told RemoteCouldntWrite() */
+	len++;
+    if (HW->AttachSlot != NOSLOT)
+	/* display attached through a socket client (twdisplay, twattach) */
+	len += RemoteGetWQlen(HW->AttachSlot);
+    return len;
+}
+
+static tany FrameDelayHW(void) {
+    timevalue T, Budget = {(tany)0, (tany)0};
+    tany delay = (tany)0, budget;
+    
+    budget = HW->MaxLatency ? (tany)HW->MaxLatency MilliSECs : FRAME_MAXDELAY;
+    
+    /*
+     * keystroke echo bypasses any delay, but only for the first frame
+     * after the key: output following it is throttled as usual
+     */
+    if (HW->FlushKeys != KeyCount) {
+	Budget.Fraction = budget;
+	SumTime(&T, &KeyTime, &Budget);
+	if (CmpTime(&All->Now, &T) < 0)
+	    return delay;
+    }
+    
+    if (BacklogHW())
+	/* no point in drawing more frames until the display drains its queue */
+	delay = budget;
+    else if (HW->FlagsHW & FlHWExpensiveFlushVideo)
+	/* spend at most half of the time flushing */
+	delay = Min2(Max2(HW->FlushCost * 2, FRAME_MINDELAY), budget);
+    
+    if (HW->MaxFPS)
+	delay = Max2(delay, (tany)(1 FullSECs) / HW->MaxFPS);
+    
+    return delay;
+}
+
+/* return TRUE if HW has something to draw */
+INLINE byte DirtyHW(void) {
+    return ChangedVideoFlag || HW->RedrawVideo || HW->DeferFlag ||
+	((HW->FlagsHW & FlHWSoftMouse) && (HW->FlagsHW & FlHWChangedMouseFlag));
+}
+
+/*
+ * return TRUE if it's time to flush HW, otherwise
+ * lower *Next to the time remaining until HW frame is due
+ */
+static byte FrameDueHW(timevalue *Next) {
+    timevalue Due, Left, Delay = {(tany)0, (tany)0};
+    
+    Delay.Fraction = HW->FrameDelay = FrameDelayHW();
+    SumTime(&Due, &HW->FlushTime, &Delay);
+    
+    if (CmpTime(&Due, &All->Now) <= 0)
+	return TRUE;
+    
+    SubTime(&Left, &Due, &All->Now);
+    if (Next->Seconds < 0 || CmpTime(&Left, Next) < 0)
+	CopyMem(&Left, Next, sizeof(timevalue));
+    return FALSE;
+}
+
+/* remember the dirty areas of ChangedVideo[] in HW->DeferVideo[] */
+static void DeferVideoHW(void) {
+    dat (*saveVideo)[2][2] = ChangedVideo, (*newVideo)[2][2];
+    dat y, j;
+    
+    if (!ChangedVideoFlag)
+	return;
+    
+    if (HW->DeferHeight != DisplayHeight || !HW->DeferVideo) {
+	if (!(newVideo = (dat (*)[2][2])ReAllocMem(HW->DeferVideo, (ldat)DisplayHeight*sizeof(dat)*4))) {
+	    /* draw everything later, it's better than losing the dirty areas */
+	    HW->DeferHeight = 0;
+	    HW->DeferFlag = FALSE;
+	    NeedRedrawVideo(0, 0, DisplayWidth - 1, DisplayHeight - 1);
+	    return;
+	}
+	HW->DeferVideo = newVideo;
+	if (HW->DeferFlag)
+	    /* display was resized while deferring: redraw everything */
+	    NeedRedrawVideo(0, 0, DisplayWidth - 1, DisplayHeight - 1);
+	HW->DeferHeight = DisplayHeight;
+	HW->DeferFlag = FALSE;
+    }
+    if (!HW->DeferFlag)
+	WriteMem(HW->DeferVideo, 0xff, (ldat)DisplayHeight*sizeof(dat)*4);
+    
+    /* let DirtyVideo() merge the areas into HW->DeferVideo[] */
+    ChangedVideo = HW->DeferVideo;
+    for (y = 0; y < DisplayHeight; y++) {
+	for (j = 0; j < 2; j++) {
+	    if (saveVideo[y][j][0] != -1)
+		DirtyVideo(saveVideo[y][j][0], y, saveVideo[y][j][1], y);
+	}
+    }
+    ChangedVideo = saveVideo;
+    HW->DeferFlag = TRUE;
+}
+
+/* add back HW->DeferVideo[] to ChangedVideo[] */
+static void UndeferVideoHW(void) {
+    dat y, j;
+    
+    if (HW->DeferHeight == DisplayHeight) {
+	for (y = 0; y < DisplayHeight; y++) {
+	    for (j = 0; j < 2; j++) {
+		if (HW->DeferVideo[y][j][0] != -1)
+		    DirtyVideo(HW->DeferVideo[y][j][0], y, HW->DeferVideo[y][j][1], y);
+	    }
+	}
+    } else
+	DirtyVideo(0, 0, DisplayWidth - 1, DisplayHeight - 1);
+    HW->DeferFlag = FALSE;
+}
+
+/* number of cells in ChangedVideo[], i.e. what FlushVideo() is about to push */
+static tany DirtyCellsHW(void) {
+    tany n = 0;
+    dat y, j;
+    
+    if (ChangedVideoFlag) {
+	for (y = 0; y < DisplayHeight; y++) {
+	    for (j = 0; j < 2; j++) {
+		if (ChangedVideo[y][j][0] != -1)
+		    n += ChangedVideo[y][j][1] - ChangedVideo[y][j][0] + 1;
+	    }
+	}
+    }
+    return n;
+}
+
+/* run HW->FlushVideo() and HW->FlushHW(), and keep track of their cost */
+static void FlushVideoHW(byte dirty) {
+    timevalue Start, End, Cost;
+    
+    if (dirty) {
+	InstantNow(&Start);
+	HW->PerfCells += DirtyCellsHW();
+    }
+    
+    HW->FlushVideo();
+    
+    HW->RedrawVideo = FALSE;
+	
+    if (HW->NeedHW & NEEDFlushHW)
+	/* this also accounts for blocking writes to ttys */
+	HW->FlushHW();
+    
+    if (dirty) {
+	InstantNow(&End);
+	SubTime(&Cost, &End, &Start);
+	if (Cost.Seconds || Cost.Fraction > (1 FullSECs) / 2)
+	    Cost.Fraction = (1 FullSECs) / 2;
+	HW->FlushCost = (HW->FlushCost * 3 + Cost.Fraction) / 4;
+	CopyMem(&All->Now, &HW->FlushTime, sizeof(timevalue));
+	HW->FlushKeys = KeyCount;
+	
+	HW->PerfFlushes++;
+	HW->PerfUsec += PerfHistAdd(&PerfFlush, &Start, &End);
+    }
+}
+
+/*
+ * flush all displays. if Next is not NULL, displays whose frame
+ * is not yet due are skipped and Next is set to the time remaining
+ * until the first of them must be flushed.
+ * return TRUE if some display was skipped.
+ */
+static byte doFlushHW(timevalue *Next) {
     static timevalue LastBeep = {(tany)0, (tany)0};
     timevalue tmp = {(tany)0, 100 MilliSECs};
-    byte doBeep = FALSE, saved = FALSE, mangled = FALSE;
+    byte doBeep = FALSE, saved = FALSE, mangled = FALSE, deferred = FALSE, dirty;
     byte saveChangedVideoFlag, saveValidOldVideo;
     /*
      * we can NEVER get (saved == FALSE && mangled == TRUE)
      * as it would mean we have irreversibly lost ChangedVideo[]
      */
 
+    if (Next)
+	Next->Seconds = -1;
+    
     /*
      * displaying on ourselves can cause infine beeping loops...
      * avoid it
@@ -899,10 +1280,7 @@ void FlushHW(void) {
 	/*
 	 * adjust ChangedVideoFlag and ChangedVideo[]
 	 * to include HW supplied area HW->Redraw*
-	 * 
-	 * we do not save/restore ChangedVideoFlagAgain since it's used
-	 * to decide buffering strategies, so must reflect whether
-	 * some display had to draw something or not.
+	 * and the areas HW skipped in previous flushes.
 	 */
 	if (mangled) {
 	    ValidOldVideo = saveValidOldVideo;
@@ -910,8 +1288,21 @@ void FlushHW(void) {
 	    CopyMem(saveChangedVideo, ChangedVideo, (ldat)DisplayHeight*sizeof(dat)*4);
 	    mangled = FALSE;
 	}
-	if (HW->RedrawVideo || ((HW->FlagsHW & FlHWSoftMouse) &&
-				(HW->FlagsHW & FlHWChangedMouseFlag))) {
+	if (doBeep)
+	    HW->Beep();
+
+	dirty = DirtyHW();
+	
+	if (Next && dirty && !FrameDueHW(Next)) {
+	    DeferVideoHW();
+	    if (HW->NeedHW & NEEDFlushHW)
+		HW->FlushHW();
+	    deferred = TRUE;
+	    continue;
+	}
+	
+	if (HW->RedrawVideo || HW->DeferFlag ||
+	    ((HW->FlagsHW & FlHWSoftMouse) && (HW->FlagsHW & FlHWChangedMouseFlag))) {
 	    if (!saved) {
 		saveValidOldVideo = ValidOldVideo;
 		saveChangedVideoFlag = ChangedVideoFlag;
@@ -923,17 +1314,15 @@ void FlushHW(void) {
 		ValidOldVideo = FALSE;
 		/* the OldVideo[] caching would make all this stuff useless otherwise */
 	    }
+	    if (HW->DeferFlag) {
+		UndeferVideoHW();
+		ValidOldVideo = FALSE;
+		/* OldVideo[] is not what this display is showing */
+	    }
 	    mangled = TRUE;
 	}
-	if (doBeep)
-	    HW->Beep();
 
-	HW->FlushVideo();
-
-	HW->RedrawVideo = FALSE;
-	
-	if (HW->NeedHW & NEEDFlushHW)
-	    HW->FlushHW();
+	FlushVideoHW(dirty);
     }
     if (NeedHW & NEEDFlushStdout)
 	fflush(stdout), NeedHW &= ~NEEDFlushStdout;
@@ -943,6 +1332,21 @@ void FlushHW(void) {
 
     ChangedVideoFlag = FALSE;
     ValidOldVideo = TRUE;
+    
+    return deferred;
+}
+
+void FlushHW(void) {
+    (void)doFlushHW(NULL);
+}
+
+/*
+ * flush only the displays whose frame is due.
+ * return TRUE if some display was skipped: in that case
+ * *Next is the time remaining until its frame is due.
+ */
+byte FrameFlushHW(timevalue *Next) {
+    return doFlushHW(Next);
 }
 
 
@@ -1085,7 +1489,8 @@ byte AllHWCanDragAreaNow(dat Left, dat Up, dat Rgt, dat Dwn, dat DstLeft, dat Ds
     if (CanDragArea && Strategy4Video(DstLeft, DstUp, DstRgt, DstDwn) == HW_ACCEL) {
 	Accel = TRUE;
 	forHW {
-	    if (HW->CanDragArea && HW->CanDragArea(Left, Up, Rgt, Dwn, DstLeft, DstUp))
+	    /* a display with deferred dirty areas would drag stale contents */
+	    if (!HW->DeferFlag && HW->CanDragArea && HW->CanDragArea(Left, Up, Rgt, Dwn, DstLeft, DstUp))
 		;
 	    else {
 		Accel = FALSE;
@@ -1193,6 +1598,10 @@ byte KeyboardEventCommon(udat Code, udat ShiftFlags, udat Len, CONST byte *Seq)
     if (HW->FlagsHW & FlHWNoInput)
 	return TRUE;
 
+    /* let the frame scheduler flush the echo immediately */
+    CopyMem(&All->Now, &KeyTime, sizeof(timevalue));
+    KeyCount++;
+    
     if ((Msg=Do(Create,Msg)(FnMsg, MSG_KEY, Len))) {
 	Event = &Msg->Event.EventKeyboard;
 	    
@@ -15,20 +15,21 @@
  */
 
 extern byte StrategyFlag;
-extern tany StrategyDelay;
 /* strategy */
 #define HW_UNSET  0
 #define HW_ACCEL  1
 #define HW_BUFFER 2
-#define HW_DELAY  3
 
 void StrategyReset(void);
 byte Strategy4Video(dat Xstart, dat Ystart, dat Xend, dat Yend);
 
+byte FrameFlushHW(timevalue *Next);
+
 byte InitDisplayHW(display_hw);
 void QuitDisplayHW(display_hw);
 
 byte InitHW(void);
+byte AttachDeferredHW(void);
 void QuitHW(void);
 
 byte RestartHW(byte verbose);
@@ -46,6 +47,9 @@ void UpdateFlagsHW(void);
 
 void EnableMouseMotionEvents(byte enable);
 
+void TwinSelectionAck(obj Requestor, uldat ReqPrivate);
+void SelectionTransferCancel(msgport Requestor);
+
 byte StdAddMouseEvent(udat Code, dat MouseX, dat MouseY);
 void SyntheticKey(widget W, udat Code, udat ShiftFlags, byte Len, byte *Seq);
 
@@ -34,6 +34,8 @@
 #include "scroller.h"
 #include "util.h"
 #include "remote.h"
+#include "printk.h"
+#include "upgrade.h"
 #include "version.h"
 
 
@@ -46,11 +48,19 @@ byte **main_argv, **orig_argv;
 uldat main_argv_usable_len;
 byte flag_secure, flag_envrc;
 byte *flag_secure_msg = "twin: cannot exec() external programs in secure mode.\n";
+uldat flag_ttyquantum; /* max bytes read from each terminal per main loop. 0 = no limit */
+tany flag_memsoft, flag_memhard; /* per-client memory quotas in bytes. 0 = no limit */
 
 int (*OverrideSelect)(int n, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
 
 static timevalue *Now;
 
+static timevalue StartupTime; /* when the current startup phase began */
+static byte StartupPending = TRUE;
+
+/* attach the other displays anyway if the first frame is deferred this long */
+#define STARTUP_MAXWAIT (500 MilliSECs)
+
 INLINE struct timeval *CalcSleepTime(struct timeval *sleeptime, msgport Port, timevalue *now) {
     byte got = 0;
     timevalue *call = &Port->CallTime;
@@ -96,6 +106,11 @@ static msgport RunMsgPort(msgport CurrPort) {
     All->RunMsgPort = CurrPort;
     
     if (CurrPort->Handler) {
+	CurrPort->PerfRuns++;
+	CurrPort->PerfMsgs += CurrPort->CountMsg;
+	PerfMsgPortRuns++;
+	PerfMsgs += CurrPort->CountMsg;
+	
 	CurrPort->Handler(CurrPort);
 	
 	if (All->RunMsgPort == CurrPort) {
@@ -125,8 +140,14 @@ static void Usage(void) {
 	  " -s, --share              start display as shared (default)\n"
 	  " -x, --excl               start display as exclusive\n"
 	  " --nohw                   start in background without display\n"
+	  " --ttyquantum=<bytes>     read at most <bytes> from each terminal at once\n"
+	  " --memsoft=<kbytes>       slow down clients using more than <kbytes> of memory\n"
+	  " --memhard=<kbytes>       disconnect clients using more than <kbytes> of memory\n"
 	  " --hw=<display>[,options] start with the given display (multiple --hw=... allowed)\n"
 	  "                          (default: autoprobe all displays until one succeeds)\n"
+	  "Options known by all display drivers: \n"
+	  "\t,fps=<n>                 draw at most <n> frames per second\n"
+	  "\t,latency=<msec>          delay drawing at most <msec> to merge updates\n"
 	  "Currently known display drivers: \n"
 	  "\tgfx[@<XDISPLAY>]\n"
 	  "\tX[@<XDISPLAY>]\n"
@@ -159,7 +180,51 @@ static byte DieWMSo(void) {
     return FALSE;
 }
 
+/* account the startup phase just finished and begin the next one */
+static byte StartupPhase(udat phase) {
+    timevalue T;
+    
+    InstantNow(&T);
+    PerfStartup[phase] = PerfUsec(&StartupTime, &T);
+    CopyMem(&T, &StartupTime, sizeof(timevalue));
+    return TRUE;
+}
+
+/*
+ * return TRUE if the first frame took more than STARTUP_MAXWAIT:
+ * a display that always has output pending (a chatty pty) keeps
+ * deferring it and must not hold back the other displays forever.
+ */
+static byte StartupLate(void) {
+    timevalue T = {(tany)0, STARTUP_MAXWAIT};
+    
+    IncrTime(&T, &StartupTime);
+    return CmpTime(Now, &T) >= 0;
+}
+
+/*
+ * called once the first frame is on screen: attach the displays
+ * InitHW() did not wait for, then report how long each phase took.
+ * return TRUE if some display was attached.
+ */
+static byte StartupDone(void) {
+    byte attached;
+    
+    StartupPhase(PERF_STARTUP_FRAME);
+    attached = AttachDeferredHW();
+    StartupPhase(PERF_STARTUP_MOREHW);
+    
+    printk("twin: startup times (usec): core %lu, display %lu, wm %lu, first frame %lu, other displays %lu\n",
+	   (unsigned long)PerfStartup[PERF_STARTUP_CORE], (unsigned long)PerfStartup[PERF_STARTUP_HW],
+	   (unsigned long)PerfStartup[PERF_STARTUP_WM], (unsigned long)PerfStartup[PERF_STARTUP_FRAME],
+	   (unsigned long)PerfStartup[PERF_STARTUP_MOREHW]);
+    UpgradeReport();
+    return attached;
+}
+
 static byte Init(void) {
+    InstantNow(&StartupTime);
+    
     FD_ZERO(&save_rfds);
     FD_ZERO(&save_wfds);
 
@@ -182,13 +247,16 @@ static byte Init(void) {
     
     return (   InitData()
 	    && InitSignals()
+	    && InitUpgrade()
 	    && InitTWDisplay()
 	    && (All->AtQuit = QuitTWDisplay)
 	    && InitTransUser()
 	    && InitTtysave()
 	    && InitScroller()
 	    && InitBuiltin()
+	    && StartupPhase(PERF_STARTUP_CORE)
 	    && InitHW()
+	    && StartupPhase(PERF_STARTUP_HW)
 	    /*
 	     * We need care here: DrawArea2(), DrawMenu(), etc. all need All->BuiltinMenu and
 	     * also Video[]. The former is initialized by InitBuiltin(), the latter by InitHW().
@@ -196,6 +264,7 @@ static byte Init(void) {
 	     */
 	    && InitDraw()   
 	    && (DlLoad(WMSo) || DieWMSo())
+	    && StartupPhase(PERF_STARTUP_WM)
 	   );
 }
     
@@ -208,6 +277,8 @@ void Quit(int status) {
     SuspendHW(FALSE);
     /* not QuitHW() as it would fire up socket.so and maybe fork() in bg */
     
+    flushk();
+    
     if (status < 0)
 	return; /* give control back to signal handler */
     exit(status);
@@ -237,12 +308,10 @@ static void MergeHyphensArgv(int argc, char **argv) {
     }
 }
 
-#define MAXDELAY 50 MilliSECs
-#define MINDELAY 10000
-
 int main(int argc, char *argv[]) {
     msgport CurrPort;
-    timevalue Old, Cut;
+    timevalue Frame;
+    byte deferred;
     fd_set read_fds, write_fds, *pwrite_fds;
     struct timeval sel_timeout, *this_timeout;
     int num_fds;
@@ -273,6 +342,8 @@ int main(int argc, char *argv[]) {
 
     if (!Init())
 	Quit(0);
+    
+    UpgradeResume();
 
     /* not needed... done by InitHW() */
     /* QueuedDrawArea2FullScreen = TRUE; */
@@ -294,28 +365,15 @@ int main(int argc, char *argv[]) {
 	 */
 	this_timeout = CalcSleepTime(&sel_timeout, All->FirstMsgPort, Now);
 
-	if (ExpensiveFlushVideo) {
-	    /* decide what to do... sleep a little if we can (HW_DELAY),
-	     * otherwise revert to one of the other strategies */
-	    if (!ChangedVideoFlagAgain || StrategyDelay >= MAXDELAY) {
-		StrategyDelay = (tany)0;
-		if (StrategyFlag == HW_DELAY)
-		    StrategyFlag = HW_BUFFER;
-	    } else {
-		if ((!this_timeout && (this_timeout = &sel_timeout))
-		    || this_timeout->tv_sec || this_timeout->tv_usec > MINDELAY) {
-		    this_timeout->tv_sec = (tany)0;
-		    this_timeout->tv_usec = MINDELAY;
-		}
-		StrategyFlag = HW_DELAY;
-		ChangedVideoFlagAgain = FALSE;
-	    }
-	}
-	
 	do {
 	    /* synchronously handle signals */
-	    if (GotSignals)
+	    if (GotSignals) {
 		HandleSignals();
+		if (GotSignalUpgrade) {
+		    GotSignalUpgrade = FALSE;
+		    Upgrade();
+		}
+	    }
 	    
 	    if (NeedHW & NEEDResizeDisplay) {
 		ResizeDisplay();
@@ -338,8 +396,36 @@ int main(int argc, char *argv[]) {
 	    if (NeedHW & NEEDPanicHW)
 		PanicHW();
 
-	    if (StrategyFlag != HW_DELAY)
-		FlushHW();
+	    /* messages printk()ed since last time */
+	    DrainPrintk();
+	    
+	    if ((deferred = FrameFlushHW(&Frame))) {
+		/*
+		 * some display is coalescing its output:
+		 * wake up when its next frame is due
+		 */
+		if (!this_timeout || this_timeout->tv_sec > Frame.Seconds ||
+		    (this_timeout->tv_sec == Frame.Seconds &&
+		     this_timeout->tv_usec > Frame.Fraction / (1 MicroSECs))) {
+		    
+		    sel_timeout.tv_sec = Frame.Seconds;
+		    sel_timeout.tv_usec = Frame.Fraction / (1 MicroSECs);
+		    this_timeout = &sel_timeout;
+		}
+	    }
+	    
+	    if (StartupPending && (!deferred || StartupLate())) {
+		/*
+		 * first frame is out: finish what startup did not wait for.
+		 * if it was deferred instead, wait for the flush it is due at
+		 * (but not more than STARTUP_MAXWAIT).
+		 */
+		StartupPending = FALSE;
+		if (StartupDone()) {
+		    sel_timeout.tv_sec = sel_timeout.tv_usec = 0;
+		    this_timeout = &sel_timeout;
+		}
+	    }
 	    
 	    if (NeedHW & NEEDPanicHW || All->FirstMsgPort->FirstMsg) {
 		/*
@@ -368,22 +454,21 @@ int main(int argc, char *argv[]) {
 	    /* ach, problem. */
 	    num_fds = 0, RemoteParanoia();
 	
-	if (StrategyFlag == HW_DELAY) {
-	    /* keep track of how much we are delaying the flush */
-	    CopyMem(Now, &Old, sizeof(timevalue));
-	    InstantNow(Now);
-	    SubTime(&Cut, Now, &Old);
-	    if (Cut.Seconds || Cut.Fraction >= MAXDELAY)
-		StrategyDelay = MAXDELAY;
-	    else
-		StrategyDelay += Cut.Fraction;
-	} else {
-	    InstantNow(Now);
-	    StrategyReset();
-	}
+	InstantNow(Now);
+	StrategyReset();
 
 	/*
-	 * handle mouse, keyboard and connections to other programs
+	 * handle mouse and keyboard first, and let WM_MsgPort dispatch them
+	 * before any terminal output is parsed: keystrokes must never wait
+	 * behind a chatty pty.
+	 */
+	if (num_fds)
+	    num_fds = RemoteInputEvent(num_fds, &read_fds);
+	
+	(void)RunMsgPort(Ext(WM,MsgPort));
+	
+	/*
+	 * then handle connections to other programs
 	 * (both in tty:s and Twin native connections)
 	 */
 	if (num_fds)
@@ -15,6 +15,8 @@ extern byte lenTWDisplay, *TWDisplay, *origTWDisplay, *origTERM, *origHW, *HOME;
 extern byte **main_argv, **orig_argv;
 extern uldat main_argv_usable_len;
 extern byte flag_envrc, flag_secure, *flag_secure_msg;
+extern uldat flag_ttyquantum;
+extern tany flag_memsoft, flag_memhard;
 
 extern int (*OverrideSelect)(int n, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
 
@@ -345,14 +345,15 @@ static void MapWidget(widget W, widget Parent) {
 static void MapTopRealWidget(widget W, screen Screen) {
     widget OldW;
     
+    /*
+     * the upper layer deletes the map msg, even if W is not mapped below
+     * (windows without a menu): forget it in any case, or UnMapWidget()
+     * would delete it again. let the upper layer do this:
+     * Delete(W->MapQueueMsg);
+     */
+    W->MapQueueMsg = (msg)0;
+    
     if (Screen && !W->Parent && (!IS_WINDOW(W) || ((window)W)->Menu)) {
-	if (W->MapQueueMsg)
-	    /*
-	     * let the upper layer do this:
-	     * Delete(W->MapQueueMsg);
-	     */
-	    W->MapQueueMsg = (msg)0;
-	
 	if (W->Up == TW_MAXDAT) {
 	    W->Left = Screen->XLogic;
 	    W->Up = Max2(Screen->YLimit+1, 0) + Screen->YLogic;
@@ -524,12 +525,21 @@ static void OwnWidget(widget Widget, msgport Owner) {
 	Widget->O_Prev = (widget)0;
 	Owner->FirstW = Widget;
 	Widget->Owner = Owner;
+	
+	if (IS_WINDOW(Widget)) {
+	    Owner->MemUsed += ((window)Widget)->MemUsed;
+	    if (Owner->MemPeak < Owner->MemUsed)
+		Owner->MemPeak = Owner->MemUsed;
+	}
     }
 }
 
 static void DisOwnWidget(widget W) {
     msgport Owner;
     if ((Owner = W->Owner)) {
+	if (IS_WINDOW(W))
+	    Owner->MemUsed -= ((window)W)->MemUsed;
+	
 	if (W->O_Prev)
 	    W->O_Prev->O_Next = W->O_Next;
 	else if (Owner->FirstW == W)
@@ -855,8 +865,17 @@ static byte InitTtyData(window Window, dat ScrollBackLines) {
     if (!Data && !(Window->USE.C.TtyData = Data = AllocMem(sizeof(ttydata))))
 	return FALSE;
 
-    if (!p && !(Window->USE.C.Contents = p = AllocMem(count * sizeof(hwattr))))
-	return FALSE;
+    if (!p) {
+	if (!(Window->USE.C.Contents = p = AllocMem(count * sizeof(hwattr))))
+	    return FALSE;
+	ChargeMem(Window, count * sizeof(hwattr), (tany)0);
+    }
+    if (!Window->USE.C.Wrapped) {
+	if (!(Window->USE.C.Wrapped = AllocMem(Window->HLogic)))
+	    return FALSE;
+	ChargeMem(Window, Window->HLogic, (tany)0);
+    }
+    WriteMem(Window->USE.C.Wrapped, '\0', Window->HLogic);
     
     h = HWATTR( COL(WHITE,BLACK), ' ') | extra_POS_INSIDE;
     while (count--)
@@ -939,6 +958,11 @@ static window CreateWindow(fn_window Fn_Window, msgport Owner,
 	Window->RemoteData.Fd = NOFD;
 	Window->RemoteData.ChildPid = NOPID;
 	Window->RemoteData.FdSlot = NOSLOT;
+	Window->RemoteData.RBuf = NULL;
+	Window->RemoteData.RBufSize = Window->RemoteData.RBufIdle = 0;
+	Window->RemoteData.ReadCalls = Window->RemoteData.ReadBytes = 0;
+	Window->RemoteData.ReadRate = Window->RemoteData.RateBytes = 0;
+	Window->RemoteData.RateTime = 0;
 	Window->CurX = Window->CurY = 0;
 	Window->XstSel = Window->YstSel = Window->XendSel = Window->YendSel = 0;
         Window->ColGadgets = DEFAULT_ColGadgets;
@@ -1005,13 +1029,19 @@ static void DeleteWindow(window W) {
 	FreeMem(W->Name);
     if (W->ColName)
 	FreeMem(W->ColName);
+    if (W->RemoteData.RBuf)
+	FreeMem(W->RemoteData.RBuf);
     if (W_USE(W, USECONTENTS)) {
 	if (W->USE.C.TtyData)
 	    FreeMem(W->USE.C.TtyData);
+	FreeReflow(W);
 	if (W->USE.C.Contents)
 	    FreeMem(W->USE.C.Contents);
+	if (W->USE.C.Wrapped)
+	    FreeMem(W->USE.C.Wrapped);
     } else if (W_USE(W, USEROWS))
 	DeleteList(W->USE.R.FirstRow);
+    ChargeMem(W, (tany)0, W->MemUsed);
 	
     (Fn_Widget->Delete)((widget)W);
     if (!--Fn_Widget->Used)
@@ -1756,6 +1786,7 @@ static void InsertRow(row Row, window Parent, row Prev, row Next) {
 	InsertGeneric((obj)Row, (obj_parent)&Parent->USE.R.FirstRow, (obj)Prev, (obj)Next, &Parent->HLogic);
 	Row->Window = Parent;
 	Parent->USE.R.NumRowOne = Parent->USE.R.NumRowSplit = (ldat)0;
+	ChargeMem(Parent, ROWMEM(Row->MaxLen), (tany)0);
     }
 }
 
@@ -1763,6 +1794,7 @@ static void RemoveRow(row Row) {
     if (Row->Window && W_USE(Row->Window, USEROWS)) {
 	Row->Window->USE.R.NumRowOne = Row->Window->USE.R.NumRowSplit = (ldat)0;
 	RemoveGeneric((obj)Row, (obj_parent)&Row->Window->USE.R.FirstRow, &Row->Window->HLogic);
+	ChargeMem(Row->Window, (tany)0, ROWMEM(Row->MaxLen));
 	Row->Window = (window)0;
     }
 }
@@ -2295,12 +2327,14 @@ static void InsertMsg(msg Msg, msgport Parent, msg Prev, msg Next) {
 	
 	InsertGeneric((obj)Msg, (obj_parent)&Parent->FirstMsg, (obj)Prev, (obj)Next, (ldat *)0);
 	Msg->MsgPort = Parent;
+	Parent->CountMsg++;
     }
 }
 
 static void RemoveMsg(msg Msg) {
     if (Msg->MsgPort) {
 	RemoveGeneric((obj)Msg, (obj_parent)&Msg->MsgPort->FirstMsg, (ldat *)0);
+	Msg->MsgPort->CountMsg--;
 	Msg->MsgPort = (msgport)0;
     }
 }
@@ -2352,6 +2386,7 @@ static msgport CreateMsgPort(fn_msgport Fn_MsgPort, byte NameLen, CONST byte *Na
 	MsgPort->RemoteData.ChildPid = NOPID;
 	MsgPort->RemoteData.FdSlot = NOSLOT;
 	MsgPort->FirstMsg=MsgPort->LastMsg = (msg)0;
+	MsgPort->CountMsg = (uldat)0;
 	MsgPort->FirstMenu=MsgPort->LastMenu = (menu)0;
 	MsgPort->FirstW=MsgPort->LastW = (widget)0;
 	MsgPort->FirstGroup=MsgPort->LastGroup = (group)0;
@@ -2359,6 +2394,9 @@ static msgport CreateMsgPort(fn_msgport Fn_MsgPort, byte NameLen, CONST byte *Na
 	MsgPort->CountE=MsgPort->SizeE = (uldat)0;
 	MsgPort->Es=(extension *)0;
 	MsgPort->AttachHW = (display_hw)0;
+	MsgPort->PerfRuns = MsgPort->PerfMsgs = (uldat)0;
+	MsgPort->MemUsed = MsgPort->MemPeak = (tany)0;
+	MsgPort->MemThrottled = FALSE;
 	InsertMiddle(MsgPort, MsgPort, All,
 		     WakeUp ? (msgport)0 : All->LastMsgPort,
 		     WakeUp ? All->FirstMsgPort : (msgport)0);
@@ -2388,10 +2426,22 @@ static void DeleteMsgPort(msgport MsgPort) {
     uldat count = 30;
     widget W;
     extension *Es;
+    display_hw D_HW;
     
     if (MsgPort) {
 	fn_obj Fn_Obj = MsgPort->Fn->Fn_Obj;
 	
+	if ((D_HW = MsgPort->AttachHW)) {
+	    /*
+	     * a client attached as display deleted its own MsgPort:
+	     * shut the display down while its MsgPort is still valid,
+	     * but leave the client connected.
+	     */
+	    MsgPort->AttachHW = (display_hw)0;
+	    D_HW->AttachSlot = NOSLOT;
+	    Delete(D_HW);
+	}
+	
 	/*
 	 * optimization: if we are going to UnMap() a lot of windows,
 	 * we set QueuedDrawArea2FullScreen = TRUE, so that the UnMap()
@@ -2408,6 +2458,8 @@ static void DeleteMsgPort(msgport MsgPort) {
 	if (MsgPort->ShutDownHook)
 	    MsgPort->ShutDownHook(MsgPort);
 
+	SelectionTransferCancel(MsgPort);
+
 	/*
 	 * must delete the Menus first, as among widgets there are also
 	 * menuitem windows, which cannot be deleted before deleting
@@ -2742,6 +2794,8 @@ static display_hw CreateDisplayHW(fn_display_hw Fn_DisplayHW, uldat NameLen, CON
 	    DisplayHW->Module = NULL;
 	    DisplayHW->Quitted = TRUE;
 	    DisplayHW->AttachSlot = NOSLOT;
+	    DisplayHW->PerfFlushes = (uldat)0;
+	    DisplayHW->PerfCells = DisplayHW->PerfUsec = (tany)0;
 	    /*
 	     * ->Quitted will be set to FALSE only
 	     * after DisplayHW->InitHW() has succeeded
@@ -2796,6 +2850,8 @@ static void DeleteDisplayHW(display_hw DisplayHW) {
     Remove(DisplayHW);
     if (DisplayHW->NameLen && DisplayHW->Name)
 	FreeMem(DisplayHW->Name);
+    if (DisplayHW->DeferVideo)
+	FreeMem(DisplayHW->DeferVideo);
     
     (Fn_Obj->Delete)((obj)DisplayHW);
     if (!--Fn_Obj->Used)
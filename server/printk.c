@@ -11,10 +11,12 @@
  */
 
 #include "twin.h"
+#include "data.h"
 #include "remote.h"
 #include "methods.h"
 #include "builtin.h"
 #include "draw.h"
+#include "printk.h"
 
 #ifdef TW_HAVE_STDARG_H
 # include <stdarg.h>
@@ -23,42 +25,159 @@
 static byte buf[TW_BIGBUFF]; /* hope it's enough */
 static int printk_fd = NOFD;
 
+/*
+ * printk_str() only appends to this ring: DrainPrintk() copies it
+ * to the Messages window and to printk_fd (or stderr) from the main loop,
+ * so a burst of messages never waits for a slow fd or for redraws.
+ * 
+ * the positions are free-running byte counts, taken modulo PRINTK_RING
+ * (a power of two) when indexing.
+ */
+#define PRINTK_RING	(TW_BIGBUFF * 16)
+#define PRINTK_RATE	256	/* lines per second, the rest are dropped */
+
+static byte ring[PRINTK_RING];
+static uldat ring_end, ring_fd, ring_win;
 
+static byte printk_bol = TRUE, printk_keep;
+static uldat printk_lines;
+static tany printk_second;
+tany PrintkDropped;		/* total, exported by extensions/ext_perf.c */
+static uldat printk_dropped;	/* since last notice */
+
+static byte printk_Append(uldat len, CONST byte *s) {
+    uldat used = Max2(ring_end - ring_fd, ring_end - ring_win), off, chunk;
+    
+    if (len > PRINTK_RING - used)
+	return FALSE;
+    
+    off = ring_end & (PRINTK_RING - 1);
+    chunk = Min2(len, PRINTK_RING - off);
+    CopyMem(s, ring + off, chunk);
+    CopyMem(s + chunk, ring, len - chunk);
+    ring_end += len;
+    return TRUE;
+}
+
+/* a new line starts: decide whether it fits the rate limit */
+static byte printk_Admit(void) {
+    byte notice[TW_SMALLBUFF];
+    
+    if (printk_second != (tany)All->Now.Seconds) {
+	printk_second = (tany)All->Now.Seconds;
+	printk_lines = 0;
+    }
+    if (printk_lines >= PRINTK_RATE)
+	return FALSE;
+    
+    if (printk_dropped) {
+	sprintf(notice, "twin: printk: %u lines dropped\n", (unsigned)printk_dropped);
+	if (!printk_Append(LenStr(notice), notice))
+	    return FALSE;
+	printk_dropped = 0;
+	printk_lines++;
+    }
+    printk_lines++;
+    return TRUE;
+}
 
 void printk_str(int len, CONST byte *s) {
+    CONST byte *nl;
     int chunk;
 
-    if (len > 0) {
+    while (len > 0) {
+	nl = memchr(s, '\n', len);
+	chunk = nl ? nl - s + 1 : len;
+	
+	if (printk_bol)
+	    printk_keep = printk_Admit();
+	if (printk_keep && !printk_Append(chunk, s))
+	    printk_keep = FALSE;
+	if (!printk_keep && nl)
+	    printk_dropped++, PrintkDropped++;
+	
+	printk_bol = nl != NULL;
+	s += chunk;
+	len -= chunk;
+    }
+}
 
-#ifdef CONF_PRINTK
-	if (MessagesWin) {
-	    if (MessagesWin->HLogic > TW_SMALLBUFF) {
-		while (MessagesWin->HLogic > TW_SMALLBUFF) {
-		    Delete(MessagesWin->USE.R.FirstRow);
-		    MessagesWin->CurY--;
-		}
-		if (MessagesWin->Parent)
-		    DrawFullWindow2(MessagesWin);
-	    }
-	    Act(RowWriteAscii,MessagesWin)(MessagesWin, len, s);
+/*
+ * write pending messages to printk_fd or stderr.
+ * if wait is FALSE, stop as soon as printk_fd would block;
+ * otherwise wait for it up to one second each time.
+ */
+static void DrainPrintkFd(byte wait) {
+    struct timeval t;
+    fd_set set;
+    uldat off, len;
+    int chunk;
+    
+    while ((len = ring_end - ring_fd)) {
+	off = ring_fd & (PRINTK_RING - 1);
+	len = Min2(len, PRINTK_RING - off);
+	
+	if (printk_fd == NOFD) {
+	    fwrite(ring + off, len, 1, stderr);
+	    ring_fd += len;
+	    continue;
 	}
-#endif /* CONF_PRINTK */
+	do {
+	    chunk = write(printk_fd, ring + off, len);
+	} while (chunk < 0 && errno == EINTR);
 	
-	if (printk_fd == NOFD)
-	    fwrite(s, len, 1, stderr);
-	else {
-	    do {
-		do {
-		    chunk = write(printk_fd, s, len);
-		} while (chunk < 0 && errno == EINTR);
-		if (chunk > 0) {
-		    s += chunk;
-		    len -= chunk;
-		}
-	    } while (len > 0 && chunk > 0);
+	if (chunk > 0)
+	    ring_fd += chunk;
+	else if (chunk < 0 && errno == EWOULDBLOCK) {
+	    if (!wait)
+		return; /* retry next time */
+	    FD_ZERO(&set);
+	    FD_SET(printk_fd, &set);
+	    t.tv_sec = 1;
+	    t.tv_usec = 0;
+	    if (select(printk_fd+1, NULL, &set, NULL, &t) <= 0)
+		break;
+	} else
+	    break;
+    }
+    /* printk_fd is stuck or broken: forget what it could not take */
+    ring_fd = ring_end;
+}
+
+#ifdef CONF_PRINTK
+static void DrainPrintkWin(void) {
+    window W = MessagesWin;
+    uldat off, len;
+    
+    while ((len = ring_end - ring_win)) {
+	off = ring_win & (PRINTK_RING - 1);
+	len = Min2(len, PRINTK_RING - off);
+	if (W)
+	    Act(RowWriteAscii,W)(W, len, ring + off);
+	ring_win += len;
+    }
+    if (W && W->HLogic > TW_SMALLBUFF) {
+	while (W->HLogic > TW_SMALLBUFF) {
+	    Delete(W->USE.R.FirstRow);
+	    W->CurY--;
 	}
+	if (W->Parent)
+	    DrawFullWindow2(W);
     }
 }
+#endif
+
+/* called by the main loop: copy the messages printk() collected to their destinations */
+void DrainPrintk(void) {
+    if (ring_end != ring_fd)
+	DrainPrintkFd(FALSE);
+#ifdef CONF_PRINTK
+    if (ring_end != ring_win)
+	DrainPrintkWin();
+#else
+    ring_win = ring_end;
+#endif
+}
 
 
 
@@ -87,7 +206,9 @@ int printk(CONST byte *format, ...) {
 }
 
     
+/* write pending messages to printk_fd or stderr now; the Messages window can wait */
 int flushk(void) {
+    DrainPrintkFd(TRUE);
     return printk_fd == NOFD ? fflush(stderr) : TRUE;
 }
 
@@ -111,6 +232,7 @@ int printk_receive_fd(int fd) {
 
 byte RegisterPrintk(int fd) {
     if (printk_fd == NOFD) {
+	flushk();
 	printk_fd = fd;
 	return TRUE;
     }
@@ -118,6 +240,7 @@ byte RegisterPrintk(int fd) {
 }
 
 void UnRegisterPrintk(void) {
+    flushk();
     printk_fd = NOFD;
 }
 
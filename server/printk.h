@@ -13,6 +13,9 @@ int printk(CONST byte *format, ...);
 void printk_str(int len, CONST byte *s);
 int printk_receive_fd(int fd);
 int flushk(void);
+void DrainPrintk(void);
+
+extern tany PrintkDropped;
 
 byte RegisterPrintk(int fd);
 void UnRegisterPrintk(void);
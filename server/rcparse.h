@@ -1253,6 +1253,8 @@ static byte ReadGlobals(void) {
     CopyMem(M, GlobalShadows, sizeof(GlobalShadows));
     M = (void **) ((str )M + sizeof(GlobalShadows));
 
+    RCIndexBinds();
+
 #ifdef DEBUG_RC
     DumpGlobals();
 #endif
@@ -1273,15 +1275,218 @@ static byte ReadGlobals(void) {
 
 static byte rcparse(str path);
 
+
+/*
+ * ~/.twinrc.cache : the parsed pool of the last successful rcload(),
+ * reused as long as all the files it was parsed from are unchanged.
+ * It is mapped, copied into a new pool and relocated, without parsing
+ * anything and without fork()ing.
+ */
+#define RCCACHE_MAGIC	"twin rc cache 1"
+
+#define MAX_RCDEPS 64
+static str RcDeps[MAX_RCDEPS];
+static uldat RcDepsN;
+static byte RcDepsOverflow;
+
+typedef struct rccache_hdr {
+    byte magic[16];
+    byte version[16];
+    uldat sizeof_node, ndeps;
+} rccache_hdr;
+
+typedef struct rccache_dep {
+    off_t size;
+    time_t mtime;
+    uldat hash, pathlen;
+} rccache_dep;
+
+/* remember that path is being parsed: the cache must depend on it */
+static str RcDepend(str path) {
+    if (path) {
+	if (RcDepsN < MAX_RCDEPS)
+	    RcDeps[RcDepsN++] = CloneStr(path);
+	else
+	    RcDepsOverflow = TRUE;
+    }
+    return path;
+}
+
+/* FNV-1a hash of a file contents */
+static byte RcHashFile(CONST byte *path, uldat *hash) {
+    struct stat st;
+    CONST byte *t, *end;
+    byte *data;
+    uldat h = 2166136261u;
+    int fd;
+    byte ok = FALSE;
+    
+    if ((fd = open(path, O_RDONLY)) < 0)
+	return ok;
+    if (fstat(fd, &st) == 0) {
+	if (st.st_size == 0)
+	    ok = TRUE;
+	else if ((data = shm_map_file(fd, (size_t)st.st_size))) {
+	    for (t = data, end = data + st.st_size; t < end; t++)
+		h = (h ^ *t) * 16777619u;
+	    shm_unmap_file(data, (size_t)st.st_size);
+	    ok = TRUE;
+	}
+    }
+    close(fd);
+    *hash = h;
+    return ok;
+}
+
+/* a crafted cache could corrupt the server: only trust our own HOME */
+static byte RcCacheAllowed(void) {
+    return !flag_secure && HOME && *HOME && getuid() == geteuid();
+}
+
+static str RcCachePath(void) {
+    str path;
+    
+    if (!RcCacheAllowed())
+	return NULL;
+    if ((path = AllocMem(LenStr(HOME) + 16)))
+	sprintf(path, "%s/.twinrc.cache", HOME);
+    return path;
+}
+
+static void RcCacheHdr(rccache_hdr *h, uldat ndeps) {
+    WriteMem(h, '\0', sizeof(*h));
+    CopyMem(RCCACHE_MAGIC, h->magic, sizeof(RCCACHE_MAGIC));
+    strncpy(h->version, TWIN_VERSION_STR, sizeof(h->version) - 1);
+    h->sizeof_node = sizeof(struct node);
+    h->ndeps = ndeps;
+}
+
+/*
+ * check that the len bytes at data are an up-to-date cache of rcpath,
+ * return the offset of the image in them, or 0.
+ * rcpath must be its first dependency: if a ~/.twinrc appeared
+ * since the cache was built from the system one, it is stale.
+ */
+static size_t RcCacheCheck(CONST byte *data, size_t len, CONST byte *rcpath) {
+    rccache_hdr h, ref;
+    rccache_dep d;
+    struct stat st;
+    byte path[TW_BIGBUFF];
+    size_t off = sizeof(h);
+    uldat i, hash;
+    
+    if (len < off)
+	return 0;
+    CopyMem(data, &h, sizeof(h));
+    RcCacheHdr(&ref, h.ndeps);
+    if (CmpMem(&h, &ref, sizeof(h)) || !h.ndeps || h.ndeps > MAX_RCDEPS)
+	return 0;
+    
+    for (i = 0; i < h.ndeps; i++) {
+	if (len - off < sizeof(d))
+	    return 0;
+	CopyMem(data + off, &d, sizeof(d));
+	off += sizeof(d);
+	if (d.pathlen >= sizeof(path) || len - off < d.pathlen)
+	    return 0;
+	CopyMem(data + off, path, d.pathlen);
+	off += d.pathlen;
+	path[d.pathlen] = '\0';
+
+	if ((i == 0 && CmpStr(path, rcpath)) || stat(path, &st) != 0 || st.st_size != d.size)
+	    return 0;
+	/* a touched but unmodified file is still ok */
+	if (st.st_mtime != d.mtime && (!RcHashFile(path, &hash) || hash != d.hash))
+	    return 0;
+    }
+    return off < len ? off : 0;
+}
+
+static byte RcCacheLoad(void) {
+    str path, rcpath;
+    struct stat st;
+    byte *data;
+    size_t off;
+    int fd;
+    byte c = FALSE;
+    
+    if (!(path = RcCachePath()))
+	return c;
+    
+    if ((rcpath = FindFile(".twinrc", NULL)) && (fd = open(path, O_RDONLY)) >= 0) {
+	if (fstat(fd, &st) == 0 && st.st_uid == getuid() &&
+	    !(st.st_mode & (S_IWGRP|S_IWOTH)) && st.st_size > 0 &&
+	    (data = shm_map_file(fd, (size_t)st.st_size))) {
+	    
+	    if ((off = RcCacheCheck(data, (size_t)st.st_size, rcpath)) &&
+		shm_load_image(data + off, (size_t)st.st_size - off) &&
+		!(c = ReadGlobals()))
+		shm_abort();
+	    shm_unmap_file(data, (size_t)st.st_size);
+	}
+	close(fd);
+    }
+    if (rcpath)
+	FreeMem(rcpath);
+    FreeMem(path);
+    return c;
+}
+
+/* called by the rcload() child after a successful parse */
+static void RcCacheSave(CONST byte *reloc) {
+    rccache_hdr h;
+    rccache_dep d;
+    struct stat st;
+    str path, tmp;
+    uldat i;
+    int fd;
+    byte ok;
+    
+    if (RcDepsOverflow || !RcDepsN || !(path = RcCachePath()))
+	return;
+    
+    if ((tmp = AllocMem(LenStr(path) + 5))) {
+	sprintf(tmp, "%s.new", path);
+	unlink(tmp);
+	if ((fd = open(tmp, O_WRONLY|O_CREAT|O_EXCL, 0600)) >= 0) {
+	    
+	    RcCacheHdr(&h, RcDepsN);
+	    ok = write(fd, &h, sizeof(h)) == sizeof(h);
+	    
+	    for (i = 0; ok && i < RcDepsN; i++) {
+		WriteMem(&d, '\0', sizeof(d));
+		d.pathlen = LenStr(RcDeps[i]);
+		ok = stat(RcDeps[i], &st) == 0 && RcHashFile(RcDeps[i], &d.hash);
+		d.size = st.st_size;
+		d.mtime = st.st_mtime;
+		ok = ok && write(fd, &d, sizeof(d)) == sizeof(d) &&
+		    write(fd, RcDeps[i], d.pathlen) == d.pathlen;
+	    }
+	    ok = ok && shm_write_image(fd, reloc);
+	    
+	    if (close(fd) == 0 && ok && rename(tmp, path) == 0)
+		;
+	    else
+		unlink(tmp);
+	}
+	FreeMem(tmp);
+    }
+    FreeMem(path);
+}
+
 static byte rcload(void) {
     str path;
     uldat len;
 #ifndef DEBUG_FORK
     int fdm[2];
     int fdl[2];
+    byte *reloc;
 #endif
     byte c = FALSE;
 
+    if (RcCacheLoad())
+	return TRUE;
+    
     if (!(path = FindFile(".twinrc", &len)))
 	return c;
 
@@ -1289,8 +1494,8 @@ static byte rcload(void) {
      * try to guess a reasonable size:
      * assume a failsafe avg of a node every 4 bytes
      */
-    len = Min2(len, TW_MAXULDAT / sizeof(node));
-    len = Max2(len, TW_BIGBUFF) * sizeof(node) / 4;
+    len = Min2(len, TW_MAXULDAT / sizeof(struct node));
+    len = Max2(len, TW_BIGBUFF) * sizeof(struct node) / 4;
     
     if (!shm_init(len)) {
 	FreeMem(path);
@@ -1340,8 +1545,11 @@ static byte rcload(void) {
 		    close(fdl[1]);
 		}
 		ClearGlobals();
-		if (rcparse(path)) {
+		if (rcparse(RcDepend(path))) {
 		    WriteGlobals();
+		    /* save the cache *before* our parent uses the pool */
+		    if ((reloc = shm_reloc_map()))
+			RcCacheSave(reloc);
 		    shm_send(fdm[1]);
 		}
 		exit(0);
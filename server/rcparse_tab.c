@@ -1528,7 +1528,7 @@ yyreduce:
 
   case 7:
 
-    { set_yy_file(FindFile((yyvsp[-1]._string), NULL)); (yyval._node) = NULL; }
+    { set_yy_file(RcDepend(FindFile((yyvsp[-1]._string), NULL))); (yyval._node) = NULL; }
 
     break;
 
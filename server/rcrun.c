@@ -25,6 +25,7 @@
 #include "hw.h"
 #include "common.h"
 #include "hw_multi.h"
+#include "upgrade.h"
 
 #include "rctypes.h"
 #include "rcparse_tab.h"
@@ -212,11 +213,175 @@ static ldat Pos2Ctx(udat Pos) {
     return 0;
 }
 
+/*
+ * KeyList and MouseList are indexed by RCIndexBinds() for constant-time lookup.
+ * The index keeps the first bind of the list that matches,
+ * so lookups give exactly the same result as scanning the lists.
+ */
+typedef struct keybind_slot {
+    ldat label, shiftflags;
+    node body;
+    byte used;
+} keybind_slot;
+
+static keybind_slot *KeyIndex;
+static uldat KeyIndexMask; /* KeyIndex has KeyIndexMask+1 slots, a power of two */
+
+/* MouseIndex[button][press/release][context bit] */
+static node MouseIndex[BUTTON_N_MAX][2][CTX_BITS];
+
+#define KEYHASH(label, shiftflags) \
+    (((uldat)(label) * 0x9E3779B1ul ^ (uldat)(shiftflags)) & KeyIndexMask)
+
+static keybind_slot *KeyIndexSlot(ldat label, ldat shiftflags) {
+    uldat i = KEYHASH(label, shiftflags);
+    keybind_slot *k;
+    
+    /* linear probing. the table is never full */
+    while ((k = KeyIndex + i)->used && (k->label != label || k->shiftflags != shiftflags))
+	i = (i + 1) & KeyIndexMask;
+    return k;
+}
+
+static void IndexKeyBinds(void) {
+    keybind_slot *k;
+    uldat n = 0;
+    node l;
+    
+    if (KeyIndex)
+	FreeMem(KeyIndex);
+    KeyIndex = NULL;
+    
+    for (l = KeyList; l; l = l->next)
+	n++;
+    /* keep load factor below 1/2 */
+    for (KeyIndexMask = 7; KeyIndexMask < 2 * n; KeyIndexMask = KeyIndexMask * 2 + 1)
+	;
+    if (!(KeyIndex = AllocMem0(sizeof(keybind_slot), KeyIndexMask + 1)))
+	return;
+    
+    for (l = KeyList; l; l = l->next) {
+	if (!(k = KeyIndexSlot(l->id, l->x.ctx))->used) {
+	    k->label = l->id;
+	    k->shiftflags = l->x.ctx;
+	    k->body = l->body;
+	    k->used = TRUE;
+	}
+    }
+}
+
+static void IndexMouseBinds(void) {
+    node l, *slot;
+    ldat b, hc, c;
+    
+    WriteMem(MouseIndex, '\0', sizeof(MouseIndex));
+    
+    for (l = MouseList; l; l = l->next) {
+	for (b = 0; b < BUTTON_N_MAX; b++) {
+	    if (!(l->id & HOLD_CODE(b)))
+		continue;
+	    for (hc = 0; hc < 2; hc++) {
+		if (!(l->id & (hc ? RELEASE_ : PRESS_)))
+		    continue;
+		for (c = 0; c < CTX_BITS; c++) {
+		    if ((l->x.ctx & ((ldat)1 << c)) && !*(slot = &MouseIndex[b][hc][c]))
+			*slot = l;
+		}
+	    }
+	}
+    }
+}
+
+/*
+ * BorderList is indexed by the first character of the window title:
+ * bucket [Border][c] lists, in BorderList order, the patterns that can match
+ * a title starting with c. The literal prefix of each pattern is compared
+ * with CmpMem() and only the rest goes through wildcard_match().
+ */
+typedef struct border_pat {
+    str rest;		/* pattern after its literal prefix */
+    uldat prelen;	/* length of literal prefix */
+    hwfont *data;
+} border_pat;
+
+static border_pat *BorderPats;
+static border_pat **BorderPool;
+static uldat BorderStart[2*256+1]; /* bucket i is BorderPool[BorderStart[i] ... BorderStart[i+1]-1] */
+
+static uldat BorderPrefix(str p) {
+    uldat n = 0;
+    while (p[n] && p[n] != '\\' && p[n] != '?' && p[n] != '*' && p[n] != '[')
+	n++;
+    return n;
+}
+
+static void IndexBorders(void) {
+    uldat Next[2*256+1];
+    uldat n = 0, i, c, lo, hi;
+    border_pat *b;
+    node l;
+    
+    if (BorderPats)
+	FreeMem(BorderPats);
+    if (BorderPool)
+	FreeMem(BorderPool);
+    BorderPats = NULL;
+    BorderPool = NULL;
+    WriteMem(BorderStart, '\0', sizeof(BorderStart));
+    
+    for (l = BorderList; l; l = l->next)
+	n++;
+    if (!n || !(BorderPats = AllocMem(n * sizeof(border_pat))))
+	return;
+    
+    /* count bucket sizes */
+    for (l = BorderList, b = BorderPats; l; l = l->next, b++) {
+	b->prelen = BorderPrefix(l->name);
+	b->rest = l->name + b->prelen;
+	b->data = (hwfont *)l->data;
+	i = (l->x.f.flag == FL_INACTIVE) * 256;
+	if (b->prelen || !l->name[0])
+	    BorderStart[i + l->name[0] + 1]++;
+	else for (c = 0; c < 256; c++)
+	    BorderStart[i + c + 1]++;
+    }
+    for (i = 1; i <= 2*256; i++)
+	BorderStart[i] += BorderStart[i-1];
+    
+    if (!(BorderPool = AllocMem(BorderStart[2*256] * sizeof(border_pat *)))) {
+	FreeMem(BorderPats);
+	BorderPats = NULL;
+	return;
+    }
+    /* fill buckets, keeping BorderList order */
+    CopyMem(BorderStart, Next, sizeof(Next));
+    for (l = BorderList, b = BorderPats; l; l = l->next, b++) {
+	i = (l->x.f.flag == FL_INACTIVE) * 256;
+	if (b->prelen || !l->name[0])
+	    lo = hi = l->name[0];
+	else
+	    lo = 0, hi = 255;
+	for (c = lo; c <= hi; c++)
+	    BorderPool[Next[i + c]++] = b;
+    }
+}
+
+/* must be called whenever KeyList, MouseList or BorderList change */
+void RCIndexBinds(void) {
+    IndexKeyBinds();
+    IndexMouseBinds();
+    IndexBorders();
+}
+
 static node RCFindKeyBind(ldat label, ldat shiftflags) {
     node l = KeyList;
+    keybind_slot *k;
     
     shiftflags &= ~(KBD_CAPS_LOCK|KBD_NUM_LOCK); /* ignore CapsLock and NumLock when looking for a keybind! */
     
+    if (KeyIndex)
+	return (k = KeyIndexSlot(label, shiftflags))->used ? k->body : NULL;
+    
     for (; l; l = l->next) {
 	if (label == l->id && shiftflags == l->x.ctx)
 	    return l->body;
@@ -227,8 +392,22 @@ static node RCFindKeyBind(ldat label, ldat shiftflags) {
 static node RCFindMouseBind(ldat code, ldat ctx) {
     node l = MouseList;
     ldat hc = code & (PRESS_|RELEASE_);
+    ldat b, c;
     code &= HOLD_ANY;
     
+    if (!code || !hc || !ctx)
+	return NULL;
+    
+    /* the usual case: one button, either press or release, one context */
+    if ((code & (code - 1)) == 0 && (hc == PRESS_ || hc == RELEASE_) && (ctx & (ctx - 1)) == 0) {
+	for (b = 0; HOLD_CODE(b) != code; b++)
+	    ;
+	for (c = 0; c < CTX_BITS && ((ldat)1 << c) != ctx; c++)
+	    ;
+	if (c < CTX_BITS)
+	    return MouseIndex[b][hc == RELEASE_][c];
+    }
+    
     for (; l; l = l->next) {
 	/* triple-inclusive match here:
 	 * (l->id & code)   : match buttons
@@ -247,6 +426,19 @@ hwfont *RCFindBorderPattern(window W, byte Border) {
     if (!W)
 	return NULL;
     
+    if (BorderPats) {
+	border_pat **b, **end;
+	str q = W->Name ? W->Name : (str)"";
+	uldat i = (uldat)Border * 256 + q[0], len = W->Name ? W->NameLen : 0;
+	
+	for (b = BorderPool + BorderStart[i], end = BorderPool + BorderStart[i+1]; b < end; b++) {
+	    if ((*b)->prelen <= len && !CmpMem(q, (*b)->rest - (*b)->prelen, (*b)->prelen) &&
+		wildcard_match((*b)->rest, q + (*b)->prelen))
+		return W->BorderPattern[Border] = (*b)->data;
+	}
+	return W->BorderPattern[Border] = NULL;
+    }
+    
     for (l = BorderList; l; l=l->next) {
 	if ((l->x.f.flag == FL_INACTIVE) == Border && wildcard_match(l->name, W->Name))
 	    break;
@@ -819,7 +1011,8 @@ static void RCReload(void) {
 	
 	ResetBorderPattern();
 	RCKillAll();
-	if (CallList)
+	/* after a live upgrade, the windows they would open are already there */
+	if (CallList && !UpgradeSkipStartup())
 	    RCNew(CallList);
 
 	FillButtonWin();
@@ -976,6 +1169,16 @@ byte RC_VM(timevalue *t) {
 }
 
 void QuitRC(void) {
+    if (KeyIndex)
+	FreeMem(KeyIndex);
+    KeyIndex = NULL;
+    WriteMem(MouseIndex, '\0', sizeof(MouseIndex));
+    if (BorderPats)
+	FreeMem(BorderPats);
+    if (BorderPool)
+	FreeMem(BorderPool);
+    BorderPats = NULL;
+    BorderPool = NULL;
     ResetBorderPattern();
     RCKillAll();
     shm_quit();
@@ -1141,6 +1344,7 @@ byte InitRC(void) {
     FuncList  = F;
     KeyList   = K;
     MouseList = M;
+    RCIndexBinds();
     
     MenuBinds = pN;
     MenuBindsMax = COD_COMMON_LAST - COD_COMMON_FIRST + 1;
@@ -29,6 +29,7 @@ extern udat MenuBindsMax;
 
 byte InitRC(void);
 void QuitRC(void);
+void RCIndexBinds(void);
 
 node LookupNodeName(str name, node head);
 
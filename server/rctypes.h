@@ -84,6 +84,11 @@ void shm_abort(void);
 void shm_quit(void);
 byte shm_send(int fd);
 byte shm_receive(int fd);
+byte *shm_map_file(int fd, size_t len);
+void shm_unmap_file(byte *data, size_t len);
+byte *shm_reloc_map(void);
+byte shm_write_image(int fd, CONST byte *reloc);
+byte shm_load_image(CONST byte *data, size_t size);
 void *shm_getbase(void);
 #ifdef DEBUG_MALLOC
 void *shm_getend(void);
@@ -85,6 +85,7 @@ byte RemoteFlush(uldat Slot) {
 	/* a (gzipped) paired slot:
 	 * PrivateFlush() does everything:
 	 * first gzip the data, then flush it */
+	LS.WQMotionEnd = (uldat)0;
 	chunk = LS.PrivateFlush(Slot);
 
 	if (LS.PrivateAfterFlush)
@@ -106,6 +107,9 @@ byte RemoteFlush(uldat Slot) {
 	offset += chunk;
 	LS.WQlen -= chunk;
     }
+    LS.PerfBytesOut += offset;
+    if (offset)
+	LS.WQMotionEnd = (uldat)0;
     
     if (LS.WQlen) {
 	FD_SET(LS.Fd, &save_wfds);
@@ -155,6 +159,55 @@ msgport RemoteGetMsgPort(uldat Slot) {
     return (msgport)0;
 }
 
+/* return how many bytes are queued for writing to Slot (and its compressed pair) */
+uldat RemoteGetWQlen(uldat Slot) {
+    uldat len = 0;
+    if (Slot < FdTop && LS.Fd != NOFD) {
+	len = LS.WQlen;
+	if (LS.pairSlot < FdTop && FdList[LS.pairSlot].Fd != NOFD)
+	    len += FdList[LS.pairSlot].WQlen;
+    }
+    return len;
+}
+
+/*
+ * return the bytes used by MsgPort: its windows, plus the data waiting
+ * in the queues of its socket. Queue capacity is not counted: queues never
+ * shrink, and a single big request must not count against the quota forever.
+ */
+tany RemoteGetMemUsed(msgport MsgPort) {
+    uldat Slot = MsgPort->RemoteData.FdSlot;
+    tany len = MsgPort->MemUsed;
+    
+    if (Slot < FdTop && LS.Fd != NOFD) {
+	len += LS.WQlen + LS.RQlen;
+	if ((Slot = LS.pairSlot) < FdTop && LS.Fd != NOFD)
+	    len += LS.WQlen + LS.RQlen;
+    }
+    if (MsgPort->MemPeak < len)
+	MsgPort->MemPeak = len;
+    return len;
+}
+
+/*
+ * stop or resume watching Slot for input, e.g. to throttle a client.
+ * for compressed sockets, the real fd is in the other slot of the pair.
+ */
+void RemotePauseRead(uldat Slot, byte pause) {
+    if (Slot < FdTop && LS.Fd < 0 && LS.pairSlot < FdTop)
+	Slot = LS.pairSlot;
+    if (Slot < FdTop && LS.Fd >= 0) {
+	if (pause)
+	    FD_CLR(LS.Fd, &save_rfds);
+	else {
+	    FD_SET(LS.Fd, &save_rfds);
+	    /* UnRegisterRemote() may have lowered max_fds while we were paused */
+	    if (max_fds < LS.Fd)
+		max_fds = LS.Fd;
+	}
+    }
+}
+
 /* Register a Fd, its HandlerIO and eventually its HandlerData arg */
 /*
  * On success, return the slot number.
@@ -190,6 +243,10 @@ uldat RegisterRemote(int Fd, obj HandlerData, void *HandlerIO) {
     LS.WQlen = LS.WQmax = LS.RQlen = LS.RQmax = (uldat)0;
     LS.PrivateAfterFlush = LS.PrivateData = LS.PrivateFlush = NULL;
     LS.extern_couldntwrite = FALSE;
+    LS.WQMotionEnd = (uldat)0;
+    LS.PerfFired = (uldat)0;
+    LS.PerfBytesIn = LS.PerfBytesOut = (tany)0;
+    LS.PassedFd = NOFD;
     
     return Slot;
 }
@@ -224,6 +281,8 @@ void UnRegisterRemote(uldat Slot) {
 	    FreeMem(LS.WQueue);
 	if (LS.RQueue)
 	    FreeMem(LS.RQueue);
+	if (LS.PassedFd != NOFD)
+	    close(LS.PassedFd);
 	
 	i = LS.Fd;
 	LS.Fd = NOFD;
@@ -314,20 +373,81 @@ void RemotePidIsDead(pid_t pid) {
     }
 }
 
-void RemoteEvent(int FdCount, fd_set *FdSet) {
+/*
+ * at most this many ready terminal windows are serviced per main loop
+ * iteration: each one may parse up to TW_BIGBUFF bytes, so this bounds
+ * how long keyboard and mouse input can wait behind bulk pty output.
+ * Terminals left out are still readable and get their turn first
+ * on next iteration.
+ */
+#define REMOTE_MAXTTY 4
+
+/* is Slot a display input device, or a socket with an attached display? */
+static byte RemoteIsInput(uldat Slot) {
+    msgport MsgPort;
+    
+    if (LS.HandlerData)
+	return IS_DISPLAY_HW(LS.HandlerData);
+    if (!(MsgPort = LS.MsgPort) && LS.pairSlot != NOSLOT)
+	MsgPort = RemoteGetMsgPort(LS.pairSlot);
+    return MsgPort && MsgPort->AttachHW;
+}
+
+static void RemoteDispatch(int fd, uldat Slot) {
+    LS.PerfFired++;
+    if (LS.HandlerData)
+	LS.HandlerIO.D (fd, LS.HandlerData);
+    else
+	LS.HandlerIO.S (fd, Slot);
+}
+
+/*
+ * first pass of RemoteEvent(): handle only mouse and keyboard.
+ * dispatched fds are removed from FdSet, returns how many are left.
+ */
+int RemoteInputEvent(int FdCount, fd_set *FdSet) {
     uldat Slot;
     int fd;
     for (Slot=0; Slot<FdTop && FdCount; Slot++) {
-	if ((fd = LS.Fd) >= 0) {
-	    if (FD_ISSET(fd, FdSet)) {
-		FdCount--;
-		if (LS.HandlerData)
-		    LS.HandlerIO.D (fd, LS.HandlerData);
-		else
-		    LS.HandlerIO.S (fd, Slot);
+	if ((fd = LS.Fd) >= 0 && FD_ISSET(fd, FdSet) && RemoteIsInput(Slot)) {
+	    FD_CLR(fd, FdSet);
+	    FdCount--;
+	    RemoteDispatch(fd, Slot);
+	}
+    }
+    return FdCount;
+}
+
+/*
+ * second pass: everything else. Start from a rotating slot
+ * so that busy terminals take turns fairly.
+ */
+void RemoteEvent(int FdCount, fd_set *FdSet) {
+    static uldat FdRotate;
+    uldat Slot, n, Top = FdTop, nTty = 0, Next = NOSLOT;
+    int fd;
+    
+    if (FdRotate >= Top)
+	FdRotate = 0;
+    
+    for (n=0; n<Top && FdCount; n++) {
+	if ((Slot = FdRotate + n) >= Top)
+	    Slot -= Top;
+	if (Slot < FdTop && (fd = LS.Fd) >= 0 && FD_ISSET(fd, FdSet)) {
+	    FdCount--;
+	    if (LS.HandlerData && IS_WINDOW(LS.HandlerData)) {
+		if (nTty == REMOTE_MAXTTY) {
+		    /* no more terminals this time. restart from here next time */
+		    if (Next == NOSLOT)
+			Next = Slot;
+		    continue;
+		}
+		nTty++;
 	    }
+	    RemoteDispatch(fd, Slot);
 	}
     }
+    FdRotate = Next != NOSLOT ? Next : FdRotate + 1;
 }
 
 void RemoteParanoia(void) {
@@ -20,8 +20,12 @@ byte	RemoteFlush(uldat Slot);
 #define	RemoteWindowFlush(Window) RemoteFlush((Window)->RemoteData.FdSlot)
 
 msgport RemoteGetMsgPort(uldat Slot);
+uldat   RemoteGetWQlen(uldat Slot);
+tany    RemoteGetMemUsed(msgport MsgPort);
+void    RemotePauseRead(uldat Slot, byte pause);
 
 void RemoteFlushAll(void);
+int  RemoteInputEvent(int FdNum, fd_set *FdSet);
 void RemoteEvent(int FdNum, fd_set *FdSet);
 void RemoteParanoia(void);
 
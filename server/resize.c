@@ -121,84 +121,394 @@ byte CheckResizeWindowContents(window Window) {
     return TRUE;
 }
 
-byte ResizeWindowContents(window Window) {
-    hwattr *NewCont, *saveNewCont, *OldCont, *max, h;
-    ldat count, common, left;
-    ttydata *Data = Window->USE.C.TtyData;
-    dat x = Window->XWidth, y = Window->YWidth + Data->ScrollBack;
+#define NOEXTRA(attr) (HWATTR_COLMASK(attr) | HWATTR_FONTMASK(attr))
+
+/*
+ * terminal Contents are a ring of HLogic rows, WLogic cells each, starting at row HSplit.
+ * Resizing keeps the number of scrollback rows, so the ring always holds ScrollBack + SizeY rows.
+ * 
+ * The functions below read rows either from the current ring of a window,
+ * or from the old one kept after a width change until all its lines are rewrapped.
+ */
+static void CurrentRing(window Window, reflow *R) {
+    R->Contents = Window->USE.C.Contents;
+    R->Wrapped = Window->USE.C.Wrapped;
+    R->WLogic = Window->WLogic;
+    R->HLogic = Window->HLogic;
+    R->HSplit = Window->USE.C.HSplit;
+}
+
+/* Contents row holding the i-th row of the ring, counting from the oldest */
+static ldat RingRow(CONST reflow *R, ldat i) {
+    if ((i += R->HSplit) >= R->HLogic)
+	i -= R->HLogic;
+    return i;
+}
+
+/* move n Contents rows (and their USE.C.Wrapped flags) from row src to row dst */
+static void MoveRows(window Window, ldat src, ldat dst, ldat n) {
+    ldat w = Window->WLogic;
     
-    if (!(Window->Flags & WINDOWFL_BORDERLESS))
-	x -= 2, y -= 2;
+    if (n > 0 && src != dst) {
+	MoveMem(Window->USE.C.Contents + src * w, Window->USE.C.Contents + dst * w, n * w * sizeof(hwattr));
+	MoveMem(Window->USE.C.Wrapped + src, Window->USE.C.Wrapped + dst, n);
+    }
+}
 
-    h = HWATTR(Window->ColText, ' ') | extra_POS_INSIDE;
+static void BlankRows(window Window, ldat first, ldat n, hwattr h) {
+    hwattr *p = Window->USE.C.Contents + first * Window->WLogic;
+    ldat k;
+    
+    WriteMem(Window->USE.C.Wrapped + first, 0, n);
+    for (k = n * Window->WLogic; k; k--)
+	*p++ = h;
+}
 
-    /* safety check: */
-    if (x > 0 && y > 0) {
-	if (!(saveNewCont = NewCont = (hwattr *)AllocMem(x*y*sizeof(hwattr))))
-	    return FALSE;
+/*
+ * if the width does not change, the ring is resized in place, moving
+ * at most the rows on one side of HSplit.
+ * Shrinking drops the oldest rows if the cursor would go below the new bottom,
+ * else the rows below the new bottom; growing adds blank rows at the bottom.
+ */
+static byte RingContents(window Window, ldat v, ldat NewH, hwattr h) {
+    ttydata *Data = Window->USE.C.TtyData;
+    ldat w = Window->WLogic, H = Window->HLogic, d, k, q;
+    hwattr *NewCont;
+    byte *NewWrap;
+    reflow R;
     
-	/*
-	 * copy the Contents. Quite non-trivial for two reasons:
-	 * 1. always preserve the cursor line
-	 * 2. copy as much scrollback as possible
-	 */
-	if ((max = OldCont = Window->USE.C.Contents)) {
-	    max += Window->WLogic * Window->HLogic;
-	    common = Min2(Window->WLogic, x);
-	    count = Min2(Window->HLogic, y);
-	    OldCont += Window->USE.C.HSplit * Window->WLogic;
+    if (NewH > H) {
+	if (!(NewCont = (hwattr *)ReAllocMem(Window->USE.C.Contents, NewH * w * sizeof(hwattr))))
+	    return FALSE;
+	Window->USE.C.Contents = NewCont;
+	if (!(NewWrap = (byte *)ReAllocMem(Window->USE.C.Wrapped, NewH)))
+	    return FALSE;
+	Window->USE.C.Wrapped = NewWrap;
 	
-	    /* ok, now check for the cursor line */
-	    if (Window->CurY >= y) {
-		OldCont += (Window->CurY + 1 - y) * Window->WLogic;
-		if (OldCont > max)
-		    OldCont -= Window->WLogic * Window->HLogic;
-	    }
-	    
-	    while (count--) {
-		CopyMem(OldCont, NewCont, common*sizeof(hwattr));
-		
-		if ((OldCont += Window->WLogic) >= max) 
-		    OldCont = Window->USE.C.Contents;
-		NewCont += common;
-		for (left = x - common; left; left--)
-		    *NewCont++ = h;
-	    }
-	    FreeMem(Window->USE.C.Contents);
+	d = NewH - H;
+	q = Window->USE.C.HSplit;
+	if (q <= H - q) {
+	    /* the newest rows [0, q) are moved after the old end, then shifted down */
+	    k = Min2(q, d);
+	    MoveRows(Window, 0, H, k);
+	    MoveRows(Window, k, 0, q - k);
+	    BlankRows(Window, H + k, d - k, h);
+	    BlankRows(Window, q - k, k, h);
+	} else {
+	    /* the oldest rows [q, H) are shifted up */
+	    MoveRows(Window, q, q + d, H - q);
+	    BlankRows(Window, q, d, h);
+	    Window->USE.C.HSplit = q + d;
 	}
-	
-	left = (saveNewCont + x*y) - NewCont;
-	while (left--)
-	    *NewCont++ = h;
     } else {
-	x = y = 0;
-	if (Window->USE.C.Contents)
-	    FreeMem(Window->USE.C.Contents);
-	saveNewCont = NULL;
+	d = H - NewH;
+	/* rows pushed out of the ring to keep the cursor visible */
+	k = Min2(Max2(Window->CurY - Data->ScrollBack + 1 - v, 0), d);
+	Window->CurY -= k;
+	DropReflowRows(Window, k);
+	
+	/* the d dropped rows start after the k oldest ones, at Contents row q */
+	CurrentRing(Window, &R);
+	R.HSplit = Window->USE.C.HSplit = RingRow(&R, k);
+	q = RingRow(&R, NewH);
+	if (q + d <= H) {
+	    MoveRows(Window, q + d, q, H - q - d);
+	    if (Window->USE.C.HSplit > q)
+		Window->USE.C.HSplit -= d;
+	} else {
+	    MoveRows(Window, q + d - H, 0, NewH);
+	    Window->USE.C.HSplit -= q + d - H;
+	}
+	if ((NewCont = (hwattr *)ReAllocMem(Window->USE.C.Contents, NewH * w * sizeof(hwattr))))
+	    Window->USE.C.Contents = NewCont;
+	if ((NewWrap = (byte *)ReAllocMem(Window->USE.C.Wrapped, NewH)))
+	    Window->USE.C.Wrapped = NewWrap;
     }
+    ChargeMem(Window, NewH * (w * sizeof(hwattr) + 1), H * (w * sizeof(hwattr) + 1));
+    Window->HLogic = NewH;
+    return TRUE;
+}
+
+/* first ring row, not before lo, of the logical line (rows joined by Wrapped) containing ring row b */
+static ldat LineStart(CONST reflow *R, ldat lo, ldat b) {
+    ldat y = RingRow(R, b);
     
-    Window->XLogic = 0;
-    Window->YLogic = Data->ScrollBack;
-    Window->WLogic = x;	/* Contents width */
-    Window->HLogic = y;	/* Y visible + scrollback */
-    Window->USE.C.HSplit = 0;	/* splitline == 0 */
-    Window->USE.C.Contents = saveNewCont;
+    while (b > lo) {
+	if (--y < 0)
+	    y = R->HLogic - 1;
+	if (!R->Wrapped[y])
+	    break;
+	b--;
+    }
+    return b;
+}
+
+/* last ring row of the logical line starting at ring row a */
+static ldat LineEnd(CONST reflow *R, ldat a) {
+    while (a < R->HLogic - 1 && R->Wrapped[RingRow(R, a)])
+	a++;
+    return a;
+}
 
-    if (Window->CurY >= y)
-	Window->CurY = y - 1;
-    else if (Window->CurY < Window->YLogic)
-	Window->CurY = Window->YLogic;
+/* TRUE if the n cells at Row are all blanks `h' */
+static byte BlankCells(CONST hwattr *Row, ldat n, hwattr h) {
+    hwattr diff = 0;
+    
+    while (n--)
+	diff |= *Row++ ^ h;
+    return !NOEXTRA(diff);
+}
+
+/*
+ * return the length of the logical line on ring rows [a, b], rewrapped at width x.
+ * Trailing blanks are dropped only as long as they change its number of rows.
+ */
+static ldat LineLen(CONST reflow *R, ldat a, ldat b, ldat x, hwattr h) {
+    ldat w = R->WLogic, full = (b - a) * w, len = full + w, stop, lo;
+    CONST hwattr *Row = R->Contents + RingRow(R, b) * w;
+    
+    for (stop = x; stop < full; stop += x)
+	;
+    /* drop trailing blanks one row of width x at a time */
+    while (len > stop) {
+	for (lo = stop; lo + x < len; lo += x)
+	    ;
+	if (!BlankCells(Row + lo - full, len - lo, h))
+	    break;
+	len = lo;
+    }
+    return len;
+}
 
+/* as above, but the cursor is considered part of its line, even if after its end */
+static ldat CursorLineLen(window Window, CONST reflow *R, ldat a, ldat b, ldat x, hwattr h) {
+    ldat len = LineLen(R, a, b, x, h);
+    
+    if (Window->CurY >= a && Window->CurY <= b)
+	len = Max2(len, (Window->CurY - a) * R->WLogic + Window->CurX + 1);
+    return len;
+}
+
+/* number of rows of width x needed by len cells, avoiding a division for the usual short lines */
+static ldat RowCount(ldat len, ldat x) {
+    ldat n;
+    
+    for (n = 1; len > x; len -= x)
+	n++;
+    return n;
+}
+
+/*
+ * copy cells [s, e) of the logical line on ring rows [a, b] into dst, blank after row b.
+ * Whole old rows are copied, including their trailing blanks: the rows of a rewrapped
+ * line are contiguous in the new Contents, so copies have only a few distinct sizes.
+ */
+static void CopyLine(CONST reflow *R, ldat a, ldat b, ldat s, ldat e, hwattr *dst, hwattr h) {
+    ldat w = R->WLogic, y, n;
+    
+    for (; s >= w; s -= w, e -= w)
+	a++;
+    for (y = RingRow(R, a); a <= b && s < e; a++, s = 0, e -= w, dst += n) {
+	n = Min2(w, e) - s;
+	CopyMem(R->Contents + y * w + s, dst, n * sizeof(hwattr));
+	if (++y == R->HLogic)
+	    y = 0;
+    }
+    for (n = e - s; n > 0; n--)
+	*dst++ = h;
+}
+
+void FreeReflow(window Window) {
+    reflow *R = Window->USE.C.Reflow;
+    
+    if (R) {
+	Window->USE.C.Reflow = NULL;
+	ChargeMem(Window, (tany)0, R->HLogic * (R->WLogic * sizeof(hwattr) + 1));
+	FreeMem(R->Contents);
+	FreeMem(R->Wrapped);
+	FreeMem(R);
+    }
+}
+
+/* the n oldest ring rows have been dropped or recycled: nothing must be rewrapped into them */
+void DropReflowRows(window Window, ldat n) {
+    reflow *R = Window->USE.C.Reflow;
+    
+    if (R && n > 0 && (R->Rows -= n) <= 0)
+	FreeReflow(Window);
+}
+
+/*
+ * after a width change, make ring rows [y, HLogic) readable, rewrapping the old lines
+ * not rewrapped yet. They are taken backward, so ring rows are filled from the bottom.
+ */
+void ReflowRows(window Window, ldat y) {
+    reflow *R = Window->USE.C.Reflow, Cur;
+    hwattr h = HWATTR(Window->ColText, ' ') | extra_POS_INSIDE, *p;
+    ldat x = Window->WLogic, a, b, n, i, j;
+    
+    if (!R)
+	return;
+    CurrentRing(Window, &Cur);
+    while (R->Rows > y && R->Lines > 0) {
+	b = R->Lines - 1;
+	a = LineStart(R, 0, b);
+	n = RowCount(LineLen(R, a, b, x, h), x);
+	for (i = Max2(n - R->Rows, 0); i < n; i++) {
+	    j = RingRow(&Cur, R->Rows - n + i);
+	    Window->USE.C.Wrapped[j] = i < n - 1;
+	    CopyLine(R, a, b, i * x, (i + 1) * x, Window->USE.C.Contents + j * x, h);
+	}
+	R->Rows -= n;
+	R->Lines = a;
+    }
+    /* blank rows before the oldest line */
+    if (R->Lines <= 0) {
+	for (i = 0; i < R->Rows; i++) {
+	    j = RingRow(&Cur, i);
+	    Window->USE.C.Wrapped[j] = FALSE;
+	    for (p = Window->USE.C.Contents + j * x, n = x; n; n--)
+		*p++ = h;
+	}
+	R->Rows = 0;
+    }
+    if (R->Rows <= 0)
+	FreeReflow(Window);
+}
+
+/*
+ * if the width changes, lines are rewrapped into a new ring of NewH rows, filled from the bottom.
+ * Only the lines from the old visible top down are rewrapped now: the old Contents are kept,
+ * and ReflowRows() rewraps the older lines only when their rows are read.
+ * A previous width change still pending is completed first: rewrapping its old lines
+ * straight to the new width would keep lines, or blanks, the intermediate width dropped.
+ */
+static byte ReflowContents(window Window, ldat x, ldat v, ldat NewH, hwattr h) {
+    ttydata *Data = Window->USE.C.TtyData;
+    reflow Cur, *R;
+    hwattr *New, *p;
+    byte *NewWrap;
+    ldat H = Window->HLogic, w = Window->WLogic;
+    ldat top = 0, cur = 0, curX = 0, first, last, lo, a, b, len, n, off, r, i, j;
+    
+    ReflowRows(Window, 0);
+    
+    New = (hwattr *)AllocMem(NewH * x * sizeof(hwattr));
+    NewWrap = (byte *)AllocMem(NewH);
+    R = (reflow *)AllocMem(sizeof(reflow));
+    if (!New || !NewWrap || !R) {
+	if (New)
+	    FreeMem(New);
+	if (NewWrap)
+	    FreeMem(NewWrap);
+	if (R)
+	    FreeMem(R);
+	return FALSE;
+    }
+    CurrentRing(Window, &Cur);
+    lo = LineStart(&Cur, 0, Min2(Data->ScrollBack, Window->CurY));
+    
+    /* rows are numbered from the start of the first line rewrapped now */
+    for (r = 0, a = lo; a < H; a = b + 1) {
+	b = LineEnd(&Cur, a);
+	len = CursorLineLen(Window, &Cur, a, b, x, h);
+	if (Window->CurY >= a && Window->CurY <= b) {
+	    off = (Window->CurY - a) * w + Window->CurX;
+	    cur = r + off / x;
+	    curX = off % x;
+	}
+	if (Data->ScrollBack >= a && Data->ScrollBack <= b)
+	    top = r + (Data->ScrollBack - a) * w / x;
+	r += RowCount(len, x);
+    }
+    
+    /* keep the old visible top, unless the cursor would go below the new bottom */
+    if (cur >= top + v)
+	top = cur - v + 1;
+    last = top + v;
+    first = last - NewH;
+    
+    /* blank rows after the last line */
+    for (i = r; i < last; i++) {
+	NewWrap[i - first] = FALSE;
+	for (p = New + (i - first) * x, j = x; j; j--)
+	    *p++ = h;
+    }
+    /* copy lines backward until the new ring is full */
+    for (b = H - 1; b >= lo && r > first; b = a - 1) {
+	a = LineStart(&Cur, lo, b);
+	len = CursorLineLen(Window, &Cur, a, b, x, h);
+	n = RowCount(len, x);
+	r -= n;
+	i = Max2(first - r, 0);
+	j = Min2(n, last - r);
+	if (i < j)
+	    CopyLine(&Cur, a, b, i * x, j * x, New + (r + i - first) * x, h);
+	for (; i < j; i++)
+	    NewWrap[r + i - first] = i < n - 1;
+    }
+    /* the old Contents are the source of the lines before lo */
+    *R = Cur;
+    R->Lines = lo;
+    R->Rows = r - first;
+    Window->USE.C.Reflow = R;
+    ChargeMem(Window, NewH * (x * sizeof(hwattr) + 1), (tany)0);
+    
+    Window->USE.C.Contents = New;
+    Window->USE.C.Wrapped = NewWrap;
+    Window->USE.C.HSplit = 0;
+    Window->WLogic = x;
+    Window->HLogic = NewH;
+    Window->CurX = curX;
+    Window->CurY = cur - first;
+    
+    /* nothing left to rewrap, or no room for it */
+    if (R->Rows <= 0 || R->Lines <= 0)
+	ReflowRows(Window, 0);
+    
+    /* a pending autowrap survives only in the last column */
+    if ((Data->Flags & TTY_NEEDWRAP) && curX < x - 1) {
+	Data->Flags &= ~TTY_NEEDWRAP;
+	Window->CurX++;
+    }
+    return TRUE;
+}
+
+byte ResizeWindowContents(window Window) {
+    ttydata *Data = Window->USE.C.TtyData;
+    ldat x = Window->XWidth, v = Window->YWidth - 2, H;
+    hwattr h;
+    
+    if (!(Window->Flags & WINDOWFL_BORDERLESS))
+	x -= 2;
+
+    /* a window with no visible rows keeps its contents until it grows again */
+    if (x <= 0 || v <= 0 || !Window->USE.C.Contents)
+	return TRUE;
+    
+    h = HWATTR(Window->ColText, ' ') | extra_POS_INSIDE;
+    
+    H = Data->ScrollBack + v;
+    
+    if (x == Window->WLogic) {
+	if (H != Window->HLogic && !RingContents(Window, v, H, h))
+	    return FALSE;
+    } else if (!ReflowContents(Window, x, v, H, h))
+	return FALSE;
+    
+    Window->XLogic = 0;
+    Window->YLogic = Data->ScrollBack;
+    
     Data->SizeX = x;
-    Data->SizeY = Window->YWidth - 2;
+    Data->SizeY = v;
     Data->Top = 0;
     Data->Bottom = Data->SizeY;
     
-    Data->Start = Window->USE.C.Contents + x * Data->ScrollBack;
-    Data->Split = Window->USE.C.Contents + x * y;
+    Data->Start = Window->USE.C.Contents + (Data->ScrollBack + Window->USE.C.HSplit) % H * x;
+    Data->Split = Window->USE.C.Contents + x * H;
     Data->saveX = Data->X = Window->CurX;
     Data->saveY = Data->Y = Window->CurY - Data->ScrollBack;    
-    Data->Pos = Window->USE.C.Contents + Window->CurY * x + Window->CurX;
+    Data->Pos = Window->USE.C.Contents + (Window->CurY + Window->USE.C.HSplit) % H * x + Window->CurX;
     
     if (!(Window->Attrib & WINDOW_WANT_CHANGES)
 	&& Window->USE.C.TtyData && Window->RemoteData.FdSlot != NOSLOT)
@@ -246,6 +556,8 @@ byte EnsureLenRow(row Row, ldat Len, byte DefaultCol) {
 		    return FALSE;
 	    }
 	    Row->Text=tempText;
+	    if (Row->Window && IS_WINDOW(Row->Window) && W_USE(Row->Window, USEROWS))
+		ChargeMem(Row->Window, ROWMEM(NewLen), ROWMEM(Row->MaxLen));
 	    Row->MaxLen=NewLen;
 	} else
 	    return FALSE;
@@ -22,6 +22,9 @@ void FlushCursor(void);
 
 byte CheckResizeWindowContents(window Window);
 byte ResizeWindowContents(window Window);
+void ReflowRows(window Window, ldat y);
+void DropReflowRows(window Window, ldat n);
+void FreeReflow(window Window);
 
 /*
 void SetNewFont(void);
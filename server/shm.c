@@ -47,6 +47,8 @@ static byte *E;  /* 1 + the last available address */
 static byte *TSR_M; /* the _previous_ memory pool */
 static size_t TSR_L; /* its length */
 
+static byte *Starts; /* bitmap of the shm_malloc() block starts, see shm_reloc_map() */
+
 #define ALIGN 15
 
 /* look at WriteGlobals() to find the reason of this size */
@@ -84,6 +86,12 @@ static size_t full_read(int fd, byte *data, size_t len) {
     return len - left;
 }
 
+static void shm_starts_free(void) {
+    if (Starts)
+	FreeMem(Starts);
+    Starts = NULL;
+}
+
 #if !defined(CONF_WM_RC_SHMMAP) && defined(CONF_WM_RC_SHRINK)
 static void shm_shrink_error(void) {
     
@@ -174,6 +182,7 @@ byte shm_shrink(void) {
 void shm_abort(void) {
     munmap(M, L);
     M = NULL;
+    shm_starts_free();
 }
 
 void shm_TSR_abort(void) {
@@ -194,6 +203,7 @@ void shm_TSR(void) {
     TSR_M = M;
     TSR_L = L;
     M = NULL;
+    shm_starts_free();
 }
 
 void shm_quit(void) {
@@ -274,6 +284,7 @@ void shm_abort(void) {
     if (M)
 	FreeMem(M);
     M = NULL;
+    shm_starts_free();
 }
 
 void shm_TSR_abort(void) {
@@ -294,6 +305,7 @@ void shm_TSR(void) {
     TSR_M = M;
     TSR_L = L;
     M = NULL;
+    shm_starts_free();
 }
 
 void shm_TSR_quit(void) {
@@ -358,6 +370,7 @@ byte shm_receive(int fd) {
 
 void *shm_malloc(size_t len) {
     byte *ret, *retE;
+    size_t off;
     int delta;
 
     if (!len)
@@ -380,6 +393,13 @@ void *shm_malloc(size_t len) {
     retE = ret + len;
 
     if (retE <= E) {
+	/* start recording block starts at the first block */
+	if (!Starts && S == M + GL_SIZE && (Starts = AllocMem((L + 7) / 8)))
+	    WriteMem(Starts, '\0', (L + 7) / 8);
+	if (Starts) {
+	    off = ret - M;
+	    Starts[off / 8] |= 1 << (off & 7);
+	}
 	S = retE;
 #ifdef DEBUG_SHM
 	printk("%.8X  ", (size_t)ret);
@@ -409,6 +429,122 @@ byte *shm_strdup_or_die(CONST byte *s) {
     return d;
 }
 
+
+
+/*
+ * pool images, used to cache a parsed ~/.twinrc on disk.
+ *
+ * The pool contains absolute pointers into itself, and they always point
+ * to the start of a shm_malloc() block. While parsing, shm_malloc() marks
+ * where each block starts: after parsing, every aligned word that holds
+ * the address of a block start is a pointer, and the resulting bitmap lets
+ * shm_load_image() relocate the image wherever the new pool happens to be.
+ */
+typedef struct shm_image_hdr {
+    byte *base;
+    size_t len;
+} shm_image_hdr;
+
+#define RELOC_LEN(len) (((len) / sizeof(byte *) + 7) / 8)
+
+/*
+ * map len bytes of fd read-only, or read them if mmap() is not available.
+ * Used for the cache and the files it depends on.
+ */
+byte *shm_map_file(int fd, size_t len) {
+    byte *data;
+    
+#if defined(TW_HAVE_SYS_MMAN_H) && defined(MAP_FAILED)
+    data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    return data != MAP_FAILED ? data : NULL;
+#else
+    if ((data = AllocMem(len)) && full_read(fd, data, len) != len) {
+	FreeMem(data);
+	data = NULL;
+    }
+    return data;
+#endif
+}
+
+void shm_unmap_file(byte *data, size_t len) {
+#if defined(TW_HAVE_SYS_MMAN_H) && defined(MAP_FAILED)
+    munmap(data, len);
+#else
+    FreeMem(data);
+#endif
+}
+
+/*
+ * compute the relocation bitmap of the pool built so far,
+ * or return NULL if the block starts were not recorded.
+ */
+byte *shm_reloc_map(void) {
+    size_t len = S - M, i, off;
+    byte *reloc, *p;
+    
+    if (!Starts || !(reloc = AllocMem(RELOC_LEN(len))))
+	return NULL;
+    
+    WriteMem(reloc, '\0', RELOC_LEN(len));
+    for (i = 0; i + sizeof(byte *) <= len; i += sizeof(byte *)) {
+	CopyMem(M + i, &p, sizeof(byte *));
+	off = (size_t)p - (size_t)M;
+	if (off >= GL_SIZE && off < len && (Starts[off / 8] & (1 << (off & 7))))
+	    reloc[i / sizeof(byte *) / 8] |= 1 << (i / sizeof(byte *) & 7);
+    }
+    return reloc;
+}
+
+byte shm_write_image(int fd, CONST byte *reloc) {
+    shm_image_hdr h;
+    
+    h.base = M;
+    h.len = S - M;
+    return full_write(fd, (CONST byte *)&h, sizeof(h)) == sizeof(h) &&
+	full_write(fd, M, h.len) == h.len &&
+	full_write(fd, reloc, RELOC_LEN(h.len)) == RELOC_LEN(h.len);
+}
+
+/*
+ * create a new pool and fill it with the image written by shm_write_image(),
+ * which is exactly size bytes at data (usually a mapped cache file).
+ */
+byte shm_load_image(CONST byte *data, size_t size) {
+    shm_image_hdr h;
+    size_t i, n, off;
+    CONST byte *reloc;
+    byte *p;
+    
+    if (size < sizeof(h))
+	return FALSE;
+    CopyMem(data, &h, sizeof(h));
+    data += sizeof(h);
+    if (h.len < GL_SIZE || h.len > size ||
+	size - sizeof(h) != h.len + RELOC_LEN(h.len) || !shm_init(h.len))
+	return FALSE;
+    
+    CopyMem(data, M, h.len);
+    reloc = data + h.len;
+    n = h.len / sizeof(byte *);
+    
+    for (i = 0; i < n; i++) {
+	if (!(reloc[i / 8] & (1 << (i & 7))))
+	    continue;
+	CopyMem(M + i * sizeof(byte *), &p, sizeof(byte *));
+	if ((off = (size_t)p - (size_t)h.base) > h.len)
+	    break;
+	p = M + off;
+	CopyMem(&p, M + i * sizeof(byte *), sizeof(byte *));
+    }
+    if (i == n) {
+	S = M + h.len;
+	return TRUE;
+    }
+    shm_abort();
+    return FALSE;
+}
+
+
 void *shm_getbase(void) {
     return M + sizeof(size_t); /* skip space for placing shm length */
 }
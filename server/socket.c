@@ -47,6 +47,7 @@
 #include "util.h"
 #include "resize.h"
 #include "extreg.h"
+#include "upgrade.h"
 
 #include "fdlist.h"
 #include "remote.h"
@@ -77,6 +78,8 @@ static void alienPush(CONST byte *src, uldat len, byte **dst, uldat alien_len);
 
 static void alienSendMsg(msgport MsgPort, msg Msg);
 static void AlienIO(int fd, uldat slot);
+static byte sockCheckQuota(msgport MsgPort, byte inHandler);
+static uldat sockRead(byte *t, uldat len);
 
 #endif
 
@@ -407,6 +410,7 @@ static void sockSetOwnerSelection(tany Time, tany Frac);
 static void sockNotifySelection(obj Requestor, uldat ReqPrivate,
 				 uldat Magic, CONST byte MIME[MAX_MIMELEN], uldat Len, CONST byte *Data);
 static void sockRequestSelection(obj Owner, uldat ReqPrivate);
+static void sockAckSelection(uldat ReqPrivate);
 
 #define sockSetServerUid SetServerUid
 #define sockGetDisplayWidth GetDisplayWidth
@@ -1041,6 +1045,9 @@ static void sockAttachHW(uldat len, CONST byte *arg, byte flags) {
 	if (D_HW->NeedHW & NEEDPersistentSlot)
 	    buf[1]++;
     }
+    if (verbose)
+	/* messages must reach the client before the reply */
+	flushk();
     write(realFd, buf, 2);
 
     /* wait for twattach to confirm attach... */
@@ -1803,6 +1810,15 @@ static byte sockSendToMsgPort(msgport MsgPort, udat Len, CONST byte *Data) {
 	    
 	_Len = 0;
 	switch (tMsg->Type) {
+	  case TW_MSG_DISPLAY:
+	    /* EventDisplay.Data is cloned below, just check its length */
+	    if (Len >= tmsgEventOffset(EventDisplay.Data)) {
+		if (tMsg->Event.EventDisplay.Len + tmsgEventOffset(EventDisplay.Data) > Len)
+		    tMsg->Event.EventDisplay.Len = Len - tmsgEventOffset(EventDisplay.Data);
+	    } else
+		/* (tmsg) too short */
+		ok = FALSE;
+	    break;
 	  case TW_MSG_WIDGET_KEY:
 	    if (Len >= tmsgEventOffset(EventKeyboard.AsciiSeq)) {
 		if (tMsg->Event.EventKeyboard.SeqLen + tmsgEventOffset(EventKeyboard.AsciiSeq) > Len)
@@ -2023,6 +2039,11 @@ static void sockRequestSelection(obj Owner, uldat ReqPrivate) {
 	TwinSelectionRequest((obj)LS.MsgPort, ReqPrivate, Owner);
 }
 
+static void sockAckSelection(uldat ReqPrivate) {
+    if (LS.MsgPort)
+	TwinSelectionAck((obj)LS.MsgPort, ReqPrivate);
+}
+
 
 #ifdef CONF_SOCKET_GZ
 
@@ -2619,7 +2640,126 @@ static void sockKillSlot(uldat slot) {
 }
 
 
+/*
+ * read() from the client socket, also accepting a file descriptor
+ * sent by Tw_SendFd() with SCM_RIGHTS. It waits in LS.PassedFd
+ * until an extension claims it with sockTakeFd(); a newer one replaces it.
+ */
+static uldat sockRead(byte *t, uldat len) {
+#ifdef SCM_RIGHTS
+    union {
+	struct cmsghdr h;
+	byte buf[CMSG_SPACE(sizeof(int))];
+    } cbuf;
+    struct cmsghdr *c;
+    struct msghdr mh;
+    struct iovec iov;
+    ssize_t got;
+    int passed;
+    
+    iov.iov_base = t;
+    iov.iov_len = len;
+    WriteMem(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = cbuf.buf;
+    mh.msg_controllen = sizeof(cbuf.buf);
+    
+    if ((got = recvmsg(Fd, &mh, 0)) > 0) {
+	for (c = CMSG_FIRSTHDR(&mh); c; c = CMSG_NXTHDR(&mh, c)) {
+	    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS &&
+		c->cmsg_len >= CMSG_LEN(sizeof(int))) {
+		
+		CopyMem(CMSG_DATA(c), &passed, sizeof(int));
+		fcntl(passed, F_SETFD, FD_CLOEXEC);
+		if (LS.PassedFd != NOFD)
+		    close(LS.PassedFd);
+		LS.PassedFd = passed;
+	    }
+	}
+    }
+    return (uldat)got;
+#else
+    return read(Fd, t, len);
+#endif
+}
+
+#ifdef CONF_EXT
+/* give the fd passed by the client being served to an extension */
+static byte sockTakeFd(int *fd, msgport *Owner) {
+    uldat slot = Slot;
+    
+    if (slot >= FdTop || !(*Owner = RemoteGetMsgPort(slot)))
+	return FALSE;
+    /* compressed sockets receive on the other slot of the pair */
+    if (ls.PassedFd == NOFD && (slot = ls.pairSlot) >= FdTop)
+	return FALSE;
+    if ((*fd = ls.PassedFd) == NOFD)
+	return FALSE;
+    ls.PassedFd = NOFD;
+    return TRUE;
+}
+#endif
+
+/*
+ * enforce --memsoft and --memhard on the client of MsgPort, after it sent
+ * requests or we queued msgs for it: above the hard quota it is disconnected,
+ * above the soft one its input is read at most once every MEM_THROTTLE_MSEC.
+ * return FALSE if the client was disconnected.
+ */
+#define MEM_THROTTLE_MSEC 100
+
+static byte sockCheckQuota(msgport MsgPort, byte inHandler) {
+    uldat slot = MsgPort->RemoteData.FdSlot;
+    timevalue T;
+    tany used;
+    
+    if ((!flag_memsoft && !flag_memhard) || slot == NOSLOT)
+	return TRUE;
+    
+    used = RemoteGetMemUsed(MsgPort);
+    
+    if (flag_memhard && used > flag_memhard) {
+	printk("twin: client `%.*s' uses %lu kbytes, over --memhard: disconnecting it\n",
+	       (int)MsgPort->NameLen, MsgPort->Name, (unsigned long)(used >> 10));
+	PerfMemKills++;
+	Ext(Remote,KillSlot)(slot);
+	return FALSE;
+    }
+    if (flag_memsoft && used > flag_memsoft) {
+	if (!MsgPort->MemThrottled) {
+	    printk("twin: client `%.*s' uses %lu kbytes, over --memsoft: throttling it\n",
+		   (int)MsgPort->NameLen, MsgPort->Name, (unsigned long)(used >> 10));
+	    MsgPort->MemThrottled = TRUE;
+	    PerfMemThrottles++;
+	}
+	if (!inHandler) {
+	    /* just served its input: pause it, and wake up SocketH() to resume it */
+	    T.Seconds = 0;
+	    T.Fraction = MEM_THROTTLE_MSEC MilliSECs;
+	    SumTime(&MsgPort->MemThrottle, &All->Now, &T);
+	    CopyMem(&MsgPort->MemThrottle, &MsgPort->CallTime, sizeof(timevalue));
+	    MsgPort->WakeUp |= TIMER_ONCE;
+	    SortMsgPortByCallTime(MsgPort);
+	    RemotePauseRead(slot, TRUE);
+	}
+    } else if (MsgPort->MemThrottled) {
+	MsgPort->MemThrottled = FALSE;
+	RemotePauseRead(slot, FALSE);
+    }
+    if (inHandler && MsgPort->MemThrottled) {
+	if (CmpTime(&MsgPort->MemThrottle, &All->Now) > 0) {
+	    /* still paused: RunMsgPort() will call us again at MemThrottle */
+	    SubTime(&MsgPort->PauseDuration, &MsgPort->MemThrottle, &All->Now);
+	    MsgPort->WakeUp |= TIMER_ONCE;
+	} else
+	    RemotePauseRead(slot, FALSE);
+    }
+    return TRUE;
+}
+
 static void SocketIO(int fd, uldat slot) {
+    msgport MsgPort;
     uldat len, Funct;
     byte *t, *tend;
     int tot = 0;
@@ -2638,9 +2778,10 @@ static void SocketIO(int fd, uldat slot) {
     if (!(t = RemoteReadGrowQueue(Slot, tot)))
 	return;
     
-    if ((len = read(Fd, t, tot)) && len && len != (uldat)-1) {
+    if ((len = sockRead(t, tot)) && len && len != (uldat)-1) {
 	if (len < tot)
 	    RemoteReadShrinkQueue(Slot, tot - len);
+	LS.PerfBytesIn += len;
 	
 	/* ok, now process the data */
 
@@ -2698,6 +2839,9 @@ static void SocketIO(int fd, uldat slot) {
 	    Slot = gzSlot;
 #endif
 	
+	if ((MsgPort = RemoteGetMsgPort(Slot)))
+	    (void)sockCheckQuota(MsgPort, FALSE);
+	
     } else if (!len || (len == (uldat)-1 && errno != EINTR && errno != EWOULDBLOCK)) {
 	/* let's close this sucker */
 	Ext(Remote,KillSlot)(Slot);
@@ -2707,6 +2851,36 @@ static void SocketIO(int fd, uldat slot) {
 
 
 
+/*
+ * send a mouse motion msg. if the previous motion for the same widget and buttons
+ * is still at the tail of the write queue, the client did not read it yet:
+ * drop it, only the newest position is worth sending.
+ */
+static void sockSendMotion(msgport MsgPort, msg Msg) {
+    uldat slot = MsgPort->RemoteData.FdSlot, start;
+    widget W = Msg->Event.EventMouse.W;
+    
+    if (slot >= FdTop || ls.Fd == NOFD) {
+	sockSendMsg(MsgPort, Msg);
+	return;
+    }
+    if (ls.WQMotionEnd && ls.WQMotionEnd == ls.WQlen &&
+	ls.WQMotionW == W->Id && ls.WQMotionCode == Msg->Event.EventMouse.Code) {
+	
+	if (!(ls.WQlen = ls.WQMotion))
+	    FdWQueued--;
+    }
+    start = ls.WQlen;
+    sockSendMsg(MsgPort, Msg);
+    
+    if ((ls.WQMotionEnd = ls.WQlen) > start) {
+	ls.WQMotion = start;
+	ls.WQMotionW = W->Id;
+	ls.WQMotionCode = Msg->Event.EventMouse.Code;
+    } else
+	ls.WQMotionEnd = (uldat)0;
+}
+
 static void SocketH(msgport MsgPort) {
     msg Msg;
     byte buf[10], len;
@@ -2726,16 +2900,910 @@ static void SocketH(msgport MsgPort) {
 	     */
 	    if (len)
 		SyntheticKey(Msg->Event.EventMouse.W, TW_XTermMouse, 0, len, buf);
-	} else
+	} else if (Msg->Type==MSG_WIDGET_MOUSE && isMOVE(Msg->Event.EventMouse.Code) &&
+		   (W = Msg->Event.EventMouse.W) && !(W->Attrib & WIDGET_WANT_ALL_MOTION))
+	    sockSendMotion(MsgPort, Msg);
+	else
 	    sockSendMsg(MsgPort, Msg);
 	
 	Delete(Msg);
     }
+    (void)sockCheckQuota(MsgPort, TRUE);
 }
 
 
 static void (*save_unixSocketIO)(int fd, uldat slot);
 
+/*
+ * live upgrade support, see upgrade.c: each client is saved with its
+ * socket, its queues and its msgport, then its menus, widgets, rows and
+ * groups under the Ids the client knows them by. The new server creates
+ * them again and gives them back those Ids with MoveId().
+ * Objects of all clients are saved first, then the links between them,
+ * then where they are mapped, as each may refer to other clients' objects.
+ *
+ * Clients with a compressed socket, or using extensions, are not kept:
+ * part of their state lives in zlib or in the extension.
+ * They are disconnected as if the server quit.
+ */
+#define PUT(x) UpgradePutNum((tany)(x))
+#define GET(x) ((x) = UpgradeGetNum())
+
+/* the slots handed over to the new server. only set during Upgrade() */
+static byte *sockKeep;
+
+/* a client restored by sockRestore() */
+struct sockrestored {
+    uldat Slot, AttachLen, HelperId;
+    msgport MsgPort;
+    byte *Attach, AttachFlags;	/* how to attach its display again, if any */
+};
+
+static byte sockIsClient(uldat slot) {
+    return ls.Fd != NOFD && (ls.HandlerIO.S == SocketIO
+# ifdef CONF_SOCKET_ALIEN
+			     || ls.HandlerIO.S == AlienIO
+# endif
+			     );
+}
+
+static byte sockKeptPort(msgport M) {
+    uldat slot;
+    return M && sockKeep && (slot = M->RemoteData.FdSlot) < FdTop && sockKeep[slot] && ls.MsgPort == M;
+}
+
+/* the msgport an object belongs to */
+static msgport sockObjOwner(obj O) {
+    switch (O->Id >> magic_shift) {
+      case widget_magic_id:
+      case gadget_magic_id:
+      case window_magic_id:
+	return ((widget)O)->Owner;
+      case menuitem_magic_id:
+	return O->Parent ? sockObjOwner(O->Parent) : (msgport)0;
+      case menu_magic_id:
+	return ((menu)O)->MsgPort;
+      case group_magic_id:
+	return ((group)O)->MsgPort;
+      case msgport_magic_id:
+	return (msgport)O;
+      default:
+	break;
+    }
+    return (msgport)0;
+}
+
+/* the Id of O if the new server will have it too, else NOID */
+static uldat sockSaveId(obj O) {
+    return O && (IS_SCREEN(O) || sockKeptPort(sockObjOwner(O))) ? O->Id : NOID;
+}
+
+/* the restored object or screen with this Id, if any */
+static obj sockId2Obj(byte i, uldat Id) {
+    obj O = Id != NOID ? Id2Obj(i, Id) : (obj)0;
+    msgport M;
+
+    if (O && !IS_SCREEN(O) && (!(M = sockObjOwner(O)) || M->Handler != SocketH))
+	O = (obj)0;
+    return O;
+}
+
+static obj sockGetObj(byte i) {
+    uldat Id;
+    GET(Id);
+    return sockId2Obj(i, Id);
+}
+
+/* read an Id, FALSE at the NOID ending a list or if the state is bad */
+static byte sockGetId(uldat *Id) {
+    GET(*Id);
+    return UpgradeGetMem(NULL, 0) && *Id != NOID;
+}
+
+/* clients know functions by their number: the new server must have the same ones */
+static uldat sockFunctHash(void) {
+    uldat h = MaxFunct, i;
+    CONST byte *c;
+
+    for (i = 0; i < MaxFunct; i++) {
+	for (c = sockF[i].Name; *c; c++)
+	    h = h * 31 + *c;
+	for (c = sockF[i].Format; *c; c++)
+	    h = h * 31 + *c;
+    }
+    return h;
+}
+
+/*
+ * the AttachHW() argument giving the client's display back to it:
+ * display_InitHW() rewrote the name of twdisplay ones and dropped the options
+ */
+static uldat sockAttachArg(display_hw D, byte *buf) {
+    uldat len, n = Min2(D->NameLen, TW_SMALLBUFF);
+
+    if (n > 9 && !CmpMem(D->Name, "-display=", 9))
+	len = sprintf(buf, "-hw=display@(-hw=%.*s)", (int)(n - 9), D->Name + 9);
+    else if (n >= 11 && !CmpMem(D->Name, "-hw=display", 11))
+	len = sprintf(buf, "-hw=display");
+    else {
+	CopyMem(D->Name, buf, n);
+	return n;
+    }
+    return len + sprintf(buf + len, ",x=%d,y=%d%s%s%s", (int)D->X, (int)D->Y,
+			 D->CanResize ? ",resize" : "", D->CanDragArea ? ",drag" : "",
+			 D->FlagsHW & FlHWExpensiveFlushVideo ? ",slow" : "");
+}
+
+static byte sockIsTwDisplay(display_hw D) {
+    return D->NameLen >= 9 && (!CmpMem(D->Name, "-display=", 9) || !CmpMem(D->Name, "-hw=displ", 9));
+}
+
+/* the msgport display_InitHW() created for D, if any */
+static msgport sockDisplayHelper(display_hw D, msgport M) {
+    msgport H;
+    for (H = All->FirstMsgPort; H; H = H->Next)
+	if (H != M && H->AttachHW == D)
+	    break;
+    return H;
+}
+
+static void sockSaveSlot(uldat slot) {
+    msgport M = ls.MsgPort, H;
+    display_hw D;
+    byte buf[TW_BIGBUFF];
+    uldat len = 0;
+
+    UpgradePutFd(ls.Fd);
+    PUT(ls.HandlerIO.S == SocketIO);
+    UpgradePutMem(ls.AlienMagic, sizeof(ls.AlienMagic));
+    PUT(ls.RQlen);
+    UpgradePutMem(ls.RQueue + ls.RQstart, ls.RQlen);
+    PUT(ls.WQlen);
+    UpgradePutMem(ls.WQueue, ls.WQlen);
+
+    PUT(!!M);
+    if (M) {
+	PUT(M->NameLen);
+	UpgradePutMem(M->Name, M->NameLen);
+	PUT(M->Id);
+    }
+    if (M && (D = M->AttachHW) && D->AttachSlot == slot)
+	len = sockAttachArg(D, buf);
+    PUT(len);
+    if (len) {
+	UpgradePutMem(buf, len);
+	PUT(All->ExclusiveHW == D ? TW_ATTACH_HW_EXCLUSIVE : 0);
+	H = sockIsTwDisplay(D) ? sockDisplayHelper(D, M) : (msgport)0;
+	PUT(H ? H->Id : NOID);
+    }
+}
+
+static void sockSaveRowText(row R) {
+    ldat n = R->Text ? R->Len + R->LenGap : 0;
+    byte hascol = n && R->ColText && !(R->Flags & ROW_DEFCOL);
+
+    PUT(hascol); PUT(n); PUT(n ? R->Len : 0); PUT(n ? R->Gap : 0); PUT(n ? R->LenGap : 0);
+    UpgradePutMem(R->Text, n * sizeof(hwfont));
+    if (hascol)
+	UpgradePutMem(R->ColText, n * sizeof(hwcol));
+}
+
+static void sockSaveMenuItem(menuitem I) {
+    PUT(I->Id); PUT(sockSaveId((obj)I->Window));
+    PUT(I->Code); PUT(I->Flags); PUT(I->Left); PUT(I->ShortCut); PUT(I->WCurY);
+    sockSaveRowText((row)I);
+}
+
+static void sockSaveGadget(gadget G) {
+    uldat i, n = (uldat)G->XWidth * G->YWidth;
+
+    PUT(G->ColText); PUT(G->ColSelect); PUT(G->ColDisabled); PUT(G->ColSelectDisabled);
+    PUT(G->Code);
+    if (G_USE(G, USETEXT)) for (i = 0; i < 4; i++) {
+	PUT(!!G->USE.T.Text[i]);
+	if (G->USE.T.Text[i])
+	    UpgradePutMem(G->USE.T.Text[i], n * sizeof(hwfont));
+	PUT(!!G->USE.T.Color[i]);
+	if (G->USE.T.Color[i])
+	    UpgradePutMem(G->USE.T.Color[i], n * sizeof(hwcol));
+    }
+}
+
+static void sockSaveWindow(window W) {
+    PUT(W->NameLen);
+    UpgradePutMem(W->Name, W->NameLen);
+    PUT(!!W->ColName);
+    if (W->ColName)
+	UpgradePutMem(W->ColName, W->NameLen * sizeof(hwcol));
+    PUT(W->ColGadgets); PUT(W->ColArrows); PUT(W->ColBars); PUT(W->ColTabs); PUT(W->ColBorder);
+    PUT(W->ColText); PUT(W->ColSelect); PUT(W->ColDisabled); PUT(W->ColSelectDisabled);
+    PUT(W->CurX); PUT(W->CurY); PUT(W->CursorType);
+    PUT(W->XstSel); PUT(W->YstSel); PUT(W->XendSel); PUT(W->YendSel);
+    PUT(W->State & WINDOW_ANYSEL);
+    PUT(W->MinXWidth); PUT(W->MinYWidth); PUT(W->MaxXWidth); PUT(W->MaxYWidth);
+    PUT(W->WLogic); PUT(W->HLogic);
+    if (W_USE(W, USECONTENTS)) {
+	/* the saved Contents must be complete */
+	ReflowRows(W, 0);
+	UpgradePutContents(W);
+    }
+}
+
+static void sockSaveWidget(widget W) {
+    PUT(W->Id >> magic_shift); PUT(W->Id);
+    PUT(W->Left); PUT(W->Up); PUT(W->XWidth); PUT(W->YWidth); PUT(W->Attrib); PUT(W->Flags);
+    PUT(W->XLogic); PUT(W->YLogic); PUT(W->USE_Fill);
+    if (IS_GADGET(W))
+	sockSaveGadget((gadget)W);
+    else if (IS_WINDOW(W))
+	sockSaveWindow((window)W);
+}
+
+/* first pass: the objects of M, without links to other objects */
+static void sockSaveObjects(msgport M) {
+    menu Menu;
+    widget W;
+    group G;
+    uldat n;
+
+    for (n = 0, Menu = M->FirstMenu; Menu; Menu = Menu->Next)
+	n++;
+    PUT(n);
+    for (Menu = M->FirstMenu; Menu; Menu = Menu->Next) {
+	PUT(Menu->Id);
+	PUT(Menu->ColItem); PUT(Menu->ColSelect); PUT(Menu->ColDisabled);
+	PUT(Menu->ColSelectDisabled); PUT(Menu->ColShtCut); PUT(Menu->ColSelShtCut);
+	PUT(Menu->FlagDefColInfo);
+    }
+    for (n = 0, W = M->FirstW; W; W = W->O_Next)
+	n++;
+    PUT(n);
+    for (W = M->FirstW; W; W = W->O_Next)
+	sockSaveWidget(W);
+    for (n = 0, G = M->FirstGroup; G; G = G->Next)
+	n++;
+    PUT(n);
+    for (G = M->FirstGroup; G; G = G->Next)
+	PUT(G->Id);
+}
+
+/* second pass: rows, menu items and the links between objects */
+static void sockSaveLinks(msgport M) {
+    menu Menu;
+    menuitem I;
+    widget W;
+    row R;
+    group G;
+    gadget g;
+    uldat n;
+
+    for (Menu = M->FirstMenu; Menu; Menu = Menu->Next) {
+	PUT(Menu->Id);
+	PUT(!!Menu->Info);
+	if (Menu->Info) {
+	    PUT(Menu->Info->Flags);
+	    sockSaveRowText(Menu->Info);
+	}
+	for (n = 0, I = Menu->FirstI; I; I = I->Next)
+	    n++;
+	PUT(n);
+	for (I = Menu->FirstI; I; I = I->Next)
+	    sockSaveMenuItem(I);
+	PUT(sockSaveId((obj)Menu->SelectI));
+	PUT(Menu->CommonItems);
+    }
+    PUT(NOID);
+    for (W = M->FirstW; W; W = W->O_Next) {
+	if (!IS_WINDOW(W))
+	    continue;
+	PUT(W->Id);
+	PUT(!!((window)W)->Menu);
+	PUT(sockSaveId((obj)((window)W)->Menu));
+	if (W_USE((window)W, USEROWS)) {
+	    for (n = 0, R = ((window)W)->USE.R.FirstRow; R; R = R->Next)
+		n++;
+	    PUT(n);
+	    for (R = ((window)W)->USE.R.FirstRow; R; R = R->Next) {
+		PUT(IS_MENUITEM(R));
+		if (IS_MENUITEM(R))
+		    sockSaveMenuItem((menuitem)R);
+		else {
+		    PUT(R->Code); PUT(R->Flags);
+		    sockSaveRowText(R);
+		}
+	    }
+	}
+	/* menu items may have grown it */
+	PUT(W->XWidth); PUT(W->YWidth);
+    }
+    PUT(NOID);
+    for (G = M->FirstGroup; G; G = G->Next) {
+	PUT(G->Id);
+	for (g = G->LastG; g; g = g->G_Prev)
+	    if (sockSaveId((obj)g) != NOID)
+		PUT(g->Id);
+	PUT(NOID);
+	PUT(sockSaveId((obj)G->SelectG));
+    }
+    PUT(NOID);
+}
+
+/* third pass: where the kept children of P are mapped, bottom to top */
+static void sockSaveMapped(widget P) {
+    widget W;
+
+    for (W = P->LastW; W; W = W->Prev) {
+	/* menu windows are only mapped while their menu is open */
+	if (sockSaveId((obj)W) == NOID || IS_SCREEN(W) ||
+	    (IS_WINDOW(W) && (W->Flags & WINDOWFL_MENU)))
+	    continue;
+	PUT(W->Id); PUT(P->Id);
+	PUT(IS_SCREEN(P) ? W->Left - ((screen)P)->XLogic : W->Left);
+	PUT(IS_SCREEN(P) ? W->Up - ((screen)P)->YLogic : W->Up);
+	sockSaveMapped(W);
+    }
+}
+
+static byte sockSave(void) {
+    uldat slot, n = 0, lost = 0;
+    msgport M;
+    widget W;
+    screen S;
+
+    /* first send clients what we can, the rest stays queued */
+    for (slot = 0; slot < FdTop; slot++) {
+	if (sockIsClient(slot) && (M = ls.MsgPort)) {
+	    SocketH(M);
+	    if (ls.MsgPort == M)
+		RemoteFlush(slot);
+	}
+    }
+    if (sockKeep)
+	FreeMem(sockKeep);
+    sockKeep = AllocMem0(sizeof(byte), FdTop + 1);
+
+    for (slot = 0; slot < FdTop; slot++) {
+	if (!sockIsClient(slot))
+	    continue;
+	if (sockKeep && ls.Fd >= 0 && ls.pairSlot == NOSLOT && (!ls.MsgPort || !ls.MsgPort->CountE))
+	    sockKeep[slot] = TRUE, n++;
+	else
+	    lost++;
+    }
+    PUT(lost); PUT(n);
+    PUT(sockFunctHash());
+    for (S = All->FirstScreen, n = 0; S; S = S->Next)
+	n++;
+    PUT(n);
+    for (S = All->FirstScreen; S; S = S->Next)
+	PUT(S->Id);
+
+    for (slot = 0; slot < FdTop; slot++)
+	if (sockKeep && sockKeep[slot])
+	    sockSaveSlot(slot);
+    for (slot = 0; slot < FdTop; slot++)
+	if (sockKeep && sockKeep[slot] && ls.MsgPort)
+	    sockSaveObjects(ls.MsgPort);
+    for (slot = 0; slot < FdTop; slot++)
+	if (sockKeep && sockKeep[slot] && ls.MsgPort)
+	    sockSaveLinks(ls.MsgPort);
+
+    for (S = All->FirstScreen; S; S = S->Next)
+	sockSaveMapped((widget)S);
+    for (slot = 0; slot < FdTop; slot++) {
+	if (!sockKeep || !sockKeep[slot] || !(M = ls.MsgPort))
+	    continue;
+	for (W = M->FirstW; W; W = W->O_Next) {
+	    if (W->Parent)
+		continue;
+	    /* windows the WM did not map yet */
+	    if (W->MapQueueMsg) {
+		PUT(W->Id); PUT(W->MapQueueMsg->Event.EventMap.Screen->Id);
+		PUT(TW_MAXDAT); PUT(TW_MAXDAT);
+	    }
+	    sockSaveMapped(W);
+	}
+    }
+    PUT(NOID);
+    PUT(sockSaveId((obj)All->FirstScreen->FocusW));
+    PUT(sockSaveId((obj)All->Selection->Owner));
+    PUT(All->Selection->Time.Seconds);
+    PUT(All->Selection->Time.Fraction);
+    return TRUE;
+}
+
+static void sockDetachKept(msgport M) {
+    display_hw D = M->AttachHW;
+    msgport H;
+
+    M->AttachHW = (display_hw)0;
+    D->AttachSlot = NOSLOT;
+    if (sockIsTwDisplay(D)) {
+	/* as display_QuitHW(), without telling twdisplay to quit */
+	if ((H = sockDisplayHelper(D, M))) {
+	    H->AttachHW = (display_hw)0;
+	    Delete(H);
+	}
+	D->QuitHW = NoOp;
+    }
+    QuitDisplayHW(D);
+    Delete(D);
+}
+
+/*
+ * the saved clients now belong to the new server: forget them
+ * without closing their sockets or telling them anything
+ */
+static void sockHandOver(void) {
+    uldat slot;
+    msgport M;
+
+    if (!sockKeep)
+	return;
+    for (slot = 0; slot < FdTop; slot++) {
+	if (sockKeep[slot] && (M = ls.MsgPort) && M->AttachHW)
+	    sockDetachKept(M);
+    }
+    for (slot = 0; slot < FdTop; slot++) {
+	if (!sockKeep[slot])
+	    continue;
+	UpgradeOwnFd(ls.Fd);
+	if (ls.MsgPort)
+	    UnRegisterMsgPort(ls.MsgPort);
+	UnRegisterRemote(slot);
+    }
+    /* now deleting their msgports does not touch the sockets */
+    for (M = All->FirstMsgPort; M; ) {
+	msgport Next = M->Next;
+	if (M->Handler == SocketH && M->RemoteData.FdSlot == NOSLOT)
+	    Delete(M);
+	M = Next;
+    }
+    FreeMem(sockKeep);
+    sockKeep = NULL;
+}
+
+static byte sockRestoreSlot(struct sockrestored *C) {
+    msgport M;
+    byte *name, *t, native, hasport;
+    uldat slot, len, Id;
+    int fd;
+    void (*HandlerIO)(int, uldat) = SocketIO;
+
+    GET(fd);
+    GET(native);
+    if (!UpgradeGetMem(NULL, 0))
+	return FALSE;
+# ifdef CONF_SOCKET_ALIEN
+    if (!native)
+	HandlerIO = AlienIO;
+# endif
+    if ((C->Slot = slot = RegisterRemoteFd(fd, HandlerIO)) == NOSLOT) {
+	close(fd);
+	return FALSE;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    UpgradeGetMem(ls.AlienMagic, sizeof(ls.AlienMagic));
+
+    /* what the client sent and we did not read yet, and what we did not send yet */
+    GET(len);
+    if (len && (!(t = RemoteReadGrowQueue(slot, len)) || !UpgradeGetMem(t, len)))
+	return FALSE;
+    GET(len);
+    if (len && (!RemoteWriteQueue(slot, len, NULL) || !UpgradeGetMem(ls.WQueue, len)))
+	return FALSE;
+
+    GET(hasport);
+    if (hasport) {
+	GET(len);
+	if (!(name = AllocMem(len + 1)))
+	    return FALSE;
+	UpgradeGetMem(name, len);
+	GET(Id);
+	M = Do(Create,MsgPort)(FnMsgPort, len, name, 0, 0, 0, SocketH);
+	FreeMem(name);
+	if (!M)
+	    return FALSE;
+	RegisterMsgPort(M, slot);
+	M->ShutDownHook = sockShutDown;
+	C->MsgPort = M;
+	if (!MoveId((obj)M, Id))
+	    return FALSE;
+    }
+    GET(C->AttachLen);
+    if (C->AttachLen) {
+	if (!(C->Attach = AllocMem(C->AttachLen + 1)))
+	    return FALSE;
+	UpgradeGetMem(C->Attach, C->AttachLen);
+	C->Attach[C->AttachLen] = '\0';
+	GET(C->AttachFlags);
+	GET(C->HelperId);
+    }
+    return UpgradeGetMem(NULL, 0);
+}
+
+static byte sockRestoreRowText(row R) {
+    ldat n, Len, Gap, LenGap;
+    byte hascol;
+
+    GET(hascol); GET(n); GET(Len); GET(Gap); GET(LenGap);
+    if (!UpgradeGetMem(NULL, 0) || n < 0 || Len + LenGap != n || !EnsureLenRow(R, n, !hascol))
+	return FALSE;
+    if (hascol && !R->ColText && R->MaxLen && !(R->ColText = AllocMem(R->MaxLen * sizeof(hwcol))))
+	return FALSE;
+    if (!UpgradeGetMem(R->Text, n * sizeof(hwfont)) ||
+	(hascol && !UpgradeGetMem(R->ColText, n * sizeof(hwcol))))
+	return FALSE;
+    R->Len = Len;
+    R->Gap = Gap;
+    R->LenGap = LenGap;
+    return TRUE;
+}
+
+static byte sockRestoreMenuItem(obj Parent) {
+    menuitem I;
+    window Window;
+    uldat Id;
+    udat Code;
+    byte Flags;
+    dat Left, ShortCut;
+    ldat WCurY;
+
+    GET(Id);
+    Window = (window)sockGetObj(window_magic_id);
+    GET(Code); GET(Flags); GET(Left); GET(ShortCut); GET(WCurY);
+    if (!UpgradeGetMem(NULL, 0) ||
+	!(I = Do(Create,MenuItem)(FnMenuItem, Parent, Window, Code, Flags, Left, 0, ShortCut, "")) ||
+	!MoveId((obj)I, Id) || !sockRestoreRowText((row)I))
+	return FALSE;
+    I->WCurY = WCurY;
+    return TRUE;
+}
+
+static gadget sockRestoreGadget(msgport M, widget S) {
+    gadget G;
+    hwcol ColText, ColSelect, ColDisabled, ColSelectDisabled;
+    udat Code;
+    uldat i, n = (uldat)S->XWidth * S->YWidth;
+    byte has;
+
+    GET(ColText); GET(ColSelect); GET(ColDisabled); GET(ColSelectDisabled);
+    GET(Code);
+    if (!UpgradeGetMem(NULL, 0) ||
+	!(G = Do(Create,Gadget)(FnGadget, M, (widget)0, S->XWidth, S->YWidth, NULL, S->Attrib, S->Flags,
+				Code, ColText, ColSelect, ColDisabled, ColSelectDisabled, S->Left, S->Up)))
+	return (gadget)0;
+
+    if (G_USE(G, USETEXT)) for (i = 0; i < 4; i++) {
+	GET(has);
+	if (has && (!(G->USE.T.Text[i] = AllocMem(n * sizeof(hwfont) + 1)) ||
+		    !UpgradeGetMem(G->USE.T.Text[i], n * sizeof(hwfont))))
+	    return (gadget)0;
+	GET(has);
+	if (has && (!(G->USE.T.Color[i] = AllocMem(n * sizeof(hwcol) + 1)) ||
+		    !UpgradeGetMem(G->USE.T.Color[i], n * sizeof(hwcol))))
+	    return (gadget)0;
+    }
+    return G;
+}
+
+static window sockRestoreWindow(msgport M, widget S) {
+    struct s_window SWin, *SW = &SWin; /* saved fields, until the real window exists */
+    window W = (window)0;
+    byte *Name, hascol = FALSE;
+    hwcol *ColName;
+    dat NameLen;
+    ldat WLogic, HLogic;
+    uldat State;
+
+    GET(NameLen);
+    Name = AllocMem(NameLen + 1);
+    ColName = AllocMem(NameLen * sizeof(hwcol) + 1);
+    if (Name && ColName) {
+	UpgradeGetMem(Name, NameLen);
+	GET(hascol);
+	if (hascol)
+	    UpgradeGetMem(ColName, NameLen * sizeof(hwcol));
+    }
+    GET(SW->ColGadgets); GET(SW->ColArrows); GET(SW->ColBars); GET(SW->ColTabs); GET(SW->ColBorder);
+    GET(SW->ColText); GET(SW->ColSelect); GET(SW->ColDisabled); GET(SW->ColSelectDisabled);
+    GET(SW->CurX); GET(SW->CurY); GET(SW->CursorType);
+    GET(SW->XstSel); GET(SW->YstSel); GET(SW->XendSel); GET(SW->YendSel);
+    GET(State);
+    GET(SW->MinXWidth); GET(SW->MinYWidth); GET(SW->MaxXWidth); GET(SW->MaxYWidth);
+    GET(WLogic); GET(HLogic);
+
+    /* small: UpgradeGetContents() replaces its contents */
+    if (Name && ColName && UpgradeGetMem(NULL, 0))
+	W = Do(Create,Window)(FnWindow, M, NameLen, Name, hascol ? ColName : NULL, (menu)0,
+			      SW->ColText, SW->CursorType, S->Attrib, S->Flags, MIN_XWIN, MIN_YWIN, 0);
+    if (ColName)
+	FreeMem(ColName);
+    if (Name)
+	FreeMem(Name);
+    if (!W || (W_USE(W, USECONTENTS) && !UpgradeGetContents(W)))
+	return (window)0;
+
+    W->ColGadgets = SW->ColGadgets; W->ColArrows = SW->ColArrows; W->ColBars = SW->ColBars;
+    W->ColTabs = SW->ColTabs; W->ColBorder = SW->ColBorder; W->ColText = SW->ColText;
+    W->ColSelect = SW->ColSelect; W->ColDisabled = SW->ColDisabled;
+    W->ColSelectDisabled = SW->ColSelectDisabled;
+    W->CurX = SW->CurX; W->CurY = SW->CurY; W->CursorType = SW->CursorType;
+    W->XstSel = SW->XstSel; W->YstSel = SW->YstSel; W->XendSel = SW->XendSel; W->YendSel = SW->YendSel;
+    W->State = (W->State & ~WINDOW_ANYSEL) | (State & WINDOW_ANYSEL);
+    W->MinXWidth = SW->MinXWidth; W->MinYWidth = SW->MinYWidth;
+    W->MaxXWidth = SW->MaxXWidth; W->MaxYWidth = SW->MaxYWidth;
+    if (!W_USE(W, USECONTENTS)) {
+	W->WLogic = WLogic;
+	/* rows count themselves when inserted */
+	if (!W_USE(W, USEROWS))
+	    W->HLogic = HLogic;
+    }
+    return W;
+}
+
+static byte sockRestoreWidget(msgport M) {
+    struct s_widget SWidget, *S = &SWidget; /* saved fields, until the real widget exists */
+    widget W = (widget)0;
+    uldat type, Id;
+
+    GET(type); GET(Id);
+    GET(S->Left); GET(S->Up); GET(S->XWidth); GET(S->YWidth); GET(S->Attrib); GET(S->Flags);
+    GET(S->XLogic); GET(S->YLogic); GET(S->USE_Fill);
+    if (!UpgradeGetMem(NULL, 0))
+	return FALSE;
+
+    switch (type) {
+      case gadget_magic_id:
+	W = (widget)sockRestoreGadget(M, S);
+	break;
+      case window_magic_id:
+	W = (widget)sockRestoreWindow(M, S);
+	break;
+      case widget_magic_id:
+	W = Do(Create,Widget)(FnWidget, M, S->XWidth, S->YWidth, S->Attrib, S->Flags,
+			      S->Left, S->Up, S->USE_Fill);
+	break;
+      default:
+	break;
+    }
+    if (!W || !MoveId((obj)W, Id))
+	return FALSE;
+    W->Left = S->Left; W->Up = S->Up; W->XWidth = S->XWidth; W->YWidth = S->YWidth;
+    W->Attrib = S->Attrib; W->Flags = S->Flags;
+    W->XLogic = S->XLogic; W->YLogic = S->YLogic; W->USE_Fill = S->USE_Fill;
+    return TRUE;
+}
+
+static byte sockRestoreObjects(msgport M) {
+    menu Menu;
+    group G;
+    uldat n, Id;
+    hwcol ColItem, ColSelect, ColDisabled, ColSelectDisabled, ColShtCut, ColSelShtCut;
+    byte FlagDefColInfo;
+
+    for (GET(n); n && UpgradeGetMem(NULL, 0); n--) {
+	GET(Id);
+	GET(ColItem); GET(ColSelect); GET(ColDisabled);
+	GET(ColSelectDisabled); GET(ColShtCut); GET(ColSelShtCut);
+	GET(FlagDefColInfo);
+	if (!(Menu = Do(Create,Menu)(FnMenu, M, ColItem, ColSelect, ColDisabled, ColSelectDisabled,
+				     ColShtCut, ColSelShtCut, FlagDefColInfo)) ||
+	    !MoveId((obj)Menu, Id))
+	    return FALSE;
+    }
+    for (GET(n); n && UpgradeGetMem(NULL, 0); n--) {
+	if (!sockRestoreWidget(M))
+	    return FALSE;
+    }
+    for (GET(n); n && UpgradeGetMem(NULL, 0); n--) {
+	GET(Id);
+	if (!(G = Do(Create,Group)(FnGroup, M)) || !MoveId((obj)G, Id))
+	    return FALSE;
+    }
+    return UpgradeGetMem(NULL, 0);
+}
+
+static byte sockRestoreLinks(void) {
+    menu Menu;
+    menuitem I;
+    window W;
+    row R;
+    group G;
+    gadget g;
+    uldat n, Id;
+    udat Code;
+    byte Flags, has;
+
+    while (sockGetId(&Id)) {
+	if (!(Menu = (menu)sockId2Obj(menu_magic_id, Id)))
+	    return FALSE;
+	GET(has);
+	if (has) {
+	    GET(Flags);
+	    if (!(Menu->Info = Do(Create,Row)(FnRow, 0, Flags)) || !sockRestoreRowText(Menu->Info))
+		return FALSE;
+	}
+	for (GET(n); n && UpgradeGetMem(NULL, 0); n--) {
+	    if (!sockRestoreMenuItem((obj)Menu))
+		return FALSE;
+	}
+	if ((I = (menuitem)sockGetObj(menuitem_magic_id)) && (menu)I->Parent == Menu)
+	    Menu->SelectI = I;
+	GET(Menu->CommonItems);
+	SyncMenu(Menu);
+    }
+    while (sockGetId(&Id)) {
+	if (!(W = (window)sockId2Obj(window_magic_id, Id)))
+	    return FALSE;
+	GET(has);
+	Menu = (menu)sockGetObj(menu_magic_id);
+	/* a menu of a client that was not kept */
+	W->Menu = Menu ? Menu : has ? All->CommonMenu : (menu)0;
+	if (W_USE(W, USEROWS)) {
+	    for (GET(n); n && UpgradeGetMem(NULL, 0); n--) {
+		if (UpgradeGetNum()) {
+		    if (!sockRestoreMenuItem((obj)W))
+			return FALSE;
+		    continue;
+		}
+		GET(Code); GET(Flags);
+		if (!(R = Do(Create,Row)(FnRow, Code, Flags)))
+		    return FALSE;
+		Act(Insert,R)(R, W, W->USE.R.LastRow, (row)0);
+		if (!sockRestoreRowText(R))
+		    return FALSE;
+	    }
+	}
+	GET(W->XWidth); GET(W->YWidth);
+    }
+    while (sockGetId(&Id)) {
+	if (!(G = (group)sockId2Obj(group_magic_id, Id)))
+	    return FALSE;
+	while (sockGetId(&Id)) {
+	    if ((g = (gadget)sockId2Obj(gadget_magic_id, Id)))
+		Act(InsertGadget,G)(G, g);
+	}
+	if ((g = (gadget)sockGetObj(gadget_magic_id)) && g->Group == G)
+	    G->SelectG = g;
+    }
+    return UpgradeGetMem(NULL, 0);
+}
+
+static void sockRestoreMapped(void) {
+    widget W, P, OldFocus = All->FirstScreen->FocusW;
+    obj O;
+    uldat Id, PId;
+    dat Left, Up;
+
+    while (sockGetId(&Id)) {
+	GET(PId); GET(Left); GET(Up);
+	W = (widget)sockId2Obj(widget_magic_id, Id);
+	P = (widget)sockId2Obj(widget_magic_id, PId);
+	if (!W || !P || W->Parent || IS_SCREEN(W))
+	    continue;
+	if (!IS_SCREEN(P)) {
+	    W->Left = Left;
+	    W->Up = Up;
+	    Act(Map,W)(W, P);
+	} else if (Left == TW_MAXDAT && Up == TW_MAXDAT)
+	    /* the WM will place it, as it was about to */
+	    Act(Map,W)(W, P);
+	else {
+	    W->Left = Left;
+	    W->Up = Up;
+	    Act(MapTopReal,W)(W, (screen)P);
+	}
+    }
+    /* give the focus back to its window, or to the terminal that had it */
+    if ((W = (widget)sockGetObj(widget_magic_id)) && W->Parent)
+	OldFocus = W;
+    if (OldFocus && OldFocus != All->FirstScreen->FocusW)
+	Act(Focus,OldFocus)(OldFocus);
+
+    if ((O = sockGetObj(msgport_magic_id)) && IS_MSGPORT(O)) {
+	All->Selection->Owner = (msgport)O;
+	All->Selection->OwnerOnce = (display_hw)0;
+	GET(All->Selection->Time.Seconds);
+	GET(All->Selection->Time.Fraction);
+    } else {
+	UpgradeGetNum();
+	UpgradeGetNum();
+    }
+}
+
+/* attach the client's display again, as sockAttachHW() did */
+static byte sockRestoreAttach(struct sockrestored *C) {
+    display_hw D;
+    msgport H;
+    msg Msg;
+
+    if (!(D = AttachDisplayHW(C->AttachLen, C->Attach, C->Slot, C->AttachFlags)))
+	return FALSE;
+    if (D->NeedHW & NEEDPersistentSlot)
+	C->MsgPort->AttachHW = D;
+    else
+	D->AttachSlot = NOSLOT;
+
+    /*
+     * twdisplay keeps sending events to the helper it knew
+     * until it reads the new one: give the helper its old Id
+     */
+    if (C->HelperId != NOID && (H = sockDisplayHelper(D, C->MsgPort)) && MoveId((obj)H, C->HelperId) &&
+	(Msg = Do(Create,Msg)(FnMsg, MSG_DISPLAY, sizeof(event_display)))) {
+
+	Msg->Event.EventDisplay.Code = DPY_Helper;
+	Msg->Event.EventDisplay.Len = sizeof(H->Id);
+	Msg->Event.EventDisplay.Data = (byte *)&H->Id;
+	sockSendMsg(C->MsgPort, Msg);
+	Delete(Msg);
+    }
+    return TRUE;
+}
+
+/*
+ * restore the clients sockSave() saved. all or nothing: if one cannot be
+ * restored, the state after it cannot be parsed and objects may refer
+ * to each other, so all of them are disconnected and count as *Lost
+ */
+static uldat sockRestore(uldat *Lost) {
+    struct sockrestored *C = NULL;
+    screen S;
+    uldat i, n, Id, failed = 0;
+    byte ok;
+
+    GET(*Lost);
+    GET(n);
+    if (!(ok = UpgradeGetNum() == sockFunctHash()))
+	printk("twin: sockRestore(): libTw functions changed, clients must be restarted\n");
+    if (n && !(C = AllocMem0(sizeof(struct sockrestored), n))) {
+	*Lost += n;
+	return 0;
+    }
+    for (i = 0; i < n; i++) {
+	C[i].Slot = NOSLOT;
+	C[i].HelperId = NOID;
+    }
+    /* screens first: clients know them by Id too */
+    for (GET(i), S = All->FirstScreen; i && UpgradeGetMem(NULL, 0); i--) {
+	GET(Id);
+	if (S) {
+	    MoveId((obj)S, Id);
+	    S = S->Next;
+	}
+    }
+    for (i = 0; i < n && sockRestoreSlot(&C[i]); i++)
+	;
+    ok &= i == n;
+    for (i = 0; ok && i < n; i++)
+	if (C[i].MsgPort && !sockRestoreObjects(C[i].MsgPort))
+	    ok = FALSE;
+    for (i = 0; ok && i < n; i++)
+	if (C[i].MsgPort && !sockRestoreLinks())
+	    ok = FALSE;
+    if (ok) {
+	sockRestoreMapped();
+	ok = UpgradeGetMem(NULL, 0);
+    }
+    for (i = 0; i < n; i++) {
+	if (ok && C[i].Attach && !sockRestoreAttach(&C[i])) {
+	    printk("twin: sockRestore(): cannot attach \"%."STR(TW_SMALLBUFF)"s\" again\n", C[i].Attach);
+	    sockKillSlot(C[i].Slot);
+	    failed++;
+	} else if (!ok && C[i].Slot != NOSLOT)
+	    sockKillSlot(C[i].Slot);
+	if (C[i].Attach)
+	    FreeMem(C[i].Attach);
+    }
+    if (C)
+	FreeMem(C);
+    if (!ok)
+	failed = n;
+    *Lost += failed;
+    return n - failed;
+}
+
+
 byte InitModule(module Module)
 {
     uldat m;
@@ -2779,6 +3847,12 @@ byte InitModule(module Module)
 	RegisterExt(Socket,InitAuth,sockInitAuth);
 	RegisterExt(Socket,DecodeExtension,sockDecodeExtension);
 	RegisterExt(Socket,MultiplexS,sockMultiplexS);
+#ifdef CONF_EXT
+	RegisterExt(Socket,TakeFd,sockTakeFd);
+#endif
+	RegisterExt(Socket,Save,sockSave);
+	RegisterExt(Socket,HandOver,sockHandOver);
+	RegisterExt(Socket,Restore,sockRestore);
 
 	m = TWIN_MAGIC;
 	CopyMem(&m, TwinMagicData+TwinMagicData[0]-sizeof(uldat), sizeof(uldat));
@@ -2818,4 +3892,10 @@ void QuitModule(module Module) {
     UnRegisterExt(Socket,InitAuth,sockInitAuth);
     UnRegisterExt(Socket,DecodeExtension,sockDecodeExtension);
     UnRegisterExt(Socket,MultiplexS,sockMultiplexS);
+#ifdef CONF_EXT
+    UnRegisterExt(Socket,TakeFd,sockTakeFd);
+#endif
+    UnRegisterExt(Socket,Save,sockSave);
+    UnRegisterExt(Socket,HandOver,sockHandOver);
+    UnRegisterExt(Socket,Restore,sockRestore);
 }
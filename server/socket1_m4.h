@@ -497,6 +497,11 @@ case order_NotifySelection:
 	sockNotifySelection((obj)a[1]_obj, (uldat)a[2]_any, (uldat)a[3]_any, (CONST byte *)a[4]_vec, (uldat)a[5]_any, (CONST byte *)a[6]_vec);
     break;
 
+case order_AckSelection:
+    if (N >= 1)
+	sockAckSelection((uldat)a[1]_any);
+    break;
+
 
 case order_SetServerUid:
     if (N >= 2)
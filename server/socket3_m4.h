@@ -284,6 +284,7 @@
 
 
 
+
   case order_OpenExtension:
     switch (n) {
       case 2: L = a[1]_any; break;
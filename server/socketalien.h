@@ -145,79 +145,100 @@ static void alienPush(CONST byte *src, uldat len, byte **dst, uldat alien_len) {
 }
 
 
+#define FLIP_CHUNK	64
+
 /*
- * translate from alien data, copying len bytes from srcsize chunks to dstsize chunks, optionally flipping byte order.
- * assume dst is large enough to hold translated data.
+ * copy len bytes from src to dst, flipping byte order of each (size) bytes element.
+ * src and dst may be the same buffer.
+ * elements of 2, 4 and 8 bytes are swapped FLIP_CHUNK bytes at time
+ * working on whole uldat words, which compilers turn into vector shuffles.
  */
-INLINE void alienReadVec(CONST byte *src, byte *dst, uldat len, uldat srcsize, uldat dstsize, byte flag) {
-    /* round to srcsize multiple */
-    len = (len / srcsize) * srcsize;
-    
-    /* optimize common cases */
+static void FlipCopyVec(CONST byte *src, byte *dst, uldat len, uldat size) {
+    uldat w[FLIP_CHUNK / sizeof(uldat)], x, i, k;
+    byte c;
     
-#if TW_IS_LITTLE_ENDIAN
-    if (srcsize == 1) {
-	while (len--) {
-	    WriteMem(dst+1, '\0', dstsize-1);
-	    *dst = *src++;
-	    dst += dstsize;
-	}
-    } else if (dstsize == 1) {
-	if (flag) {
-	    while (len--) {
-		*dst++ = src[srcsize-1];
-		src += srcsize;
-	    }
-	} else {
-	    while (len--) {
-		*dst++ = *src;
-		src += srcsize;
+    if (size < 2)
+	return;
+    if (sizeof(uldat) == 4 && (size == 2 || size == 4 || size == 8)) {
+	for (; len >= FLIP_CHUNK; src += FLIP_CHUNK, dst += FLIP_CHUNK, len -= FLIP_CHUNK) {
+	    CopyMem(src, w, FLIP_CHUNK);
+	    if (size == 2) {
+		for (i = 0; i < FLIP_CHUNK / 4; i++) {
+		    x = w[i];
+		    w[i] = ((x & 0x00FF00FF) << 8) | ((x >> 8) & 0x00FF00FF);
+		}
+	    } else {
+		for (i = 0; i < FLIP_CHUNK / 4; i++) {
+		    x = w[i];
+		    w[i] = (x << 24) | ((x & 0xFF00) << 8) | ((x >> 8) & 0xFF00) | (x >> 24);
+		}
+		if (size == 8) {
+		    for (i = 0; i < FLIP_CHUNK / 4; i += 2) {
+			x = w[i];
+			w[i] = w[i+1];
+			w[i+1] = x;
+		    }
+		}
 	    }
+	    CopyMem(w, dst, FLIP_CHUNK);
 	}
     }
-#else /* TW_IS_BIG_ENDIAN */
-    if (srcsize == 1) {
-	while (len--) {
-	    WriteMem(dst, '\0', dstsize-1);
-	    dst[dstsize-1] = *src++;
-	    dst += dstsize;
-	}
-    } else if (dstsize == 1) {
-	if (flag) {
-	    while (len--) {
-		*dst++ = *src;
-		src += srcsize;
+    for (; len >= size; src += size, dst += size, len -= size) {
+	if (src == dst) {
+	    for (i = 0, k = size - 1; i < k; i++, k--) {
+		c = dst[i];
+		dst[i] = dst[k];
+		dst[k] = c;
 	    }
-	} else {
-	    while (len--) {
-		*dst++ = src[srcsize-1];
-		src += srcsize;
-	    }
-	}
+	} else
+	    FlipCopyMem(src, dst, size);
     }
-#endif /* TW_IS_LITTLE_ENDIAN */
+}
+
+/*
+ * copy len bytes of srcsize wide numbers to dstsize wide numbers,
+ * keeping the least significant bits and zeroing the others.
+ * src_big and dst_big tell the byte order of src and dst.
+ */
+static void ResizeVec(CONST byte *src, byte *dst, uldat len, uldat srcsize, uldat dstsize, byte src_big, byte dst_big) {
+    tany v;
+    uldat k;
+    
+    for (; len >= srcsize; src += srcsize, dst += dstsize, len -= srcsize) {
+	v = 0;
+	if (src_big)
+	    for (k = 0; k < srcsize; k++)
+		v = v << 8 | src[k];
+	else
+	    for (k = srcsize; k; k--)
+		v = v << 8 | src[k-1];
 	
-    else if (srcsize == dstsize) {
-	if (flag) {
-	    while (len) {
-		FlipCopyMem(src, dst, srcsize);
-		src += srcsize;
-		dst += dstsize;
-		len -= srcsize;
-	    }
-	} else
-	    CopyMem(src, dst, srcsize);
-    } else {
-	/* fallback. all other cases */
-	while (len) {
-	    alienRead(src, srcsize, dst, dstsize, flag);
-	    src += srcsize;
-	    dst += dstsize;
-	    len -= srcsize;
-	}
+	if (dst_big)
+	    for (k = dstsize; k; k--, v >>= 8)
+		dst[k-1] = (byte)v;
+	else
+	    for (k = 0; k < dstsize; k++, v >>= 8)
+		dst[k] = (byte)v;
     }
 }
 
+/*
+ * translate from alien data, copying len bytes from srcsize chunks to dstsize chunks, optionally flipping byte order.
+ * assume dst is large enough to hold translated data.
+ */
+INLINE void alienReadVec(CONST byte *src, byte *dst, uldat len, uldat srcsize, uldat dstsize, byte flag) {
+    /* round to srcsize multiple */
+    len = (len / srcsize) * srcsize;
+    
+    if (srcsize == dstsize) {
+	if (flag && srcsize > 1)
+	    FlipCopyVec(src, dst, len, srcsize);
+	else
+	    CopyMem(src, dst, len);
+    } else
+	ResizeVec(src, dst, len, srcsize, dstsize, !TW_IS_LITTLE_ENDIAN ^ !!flag, !TW_IS_LITTLE_ENDIAN);
+}
+
 
 /*
  * translate from alien data, copying len bytes from srcsize chunks to dstsize chunks, optionally flipping byte order.
@@ -241,26 +262,13 @@ static void alienWriteVec(CONST byte *src, byte *dst, uldat len, uldat srcsize,
     /* round to srcsize multiple */
     len = (len / srcsize) * srcsize;
 
-    /* no optimization for srcsize == 1 or dstsize == 1 here */
     if (srcsize == dstsize) {
-	if (flag) {
-	    while (len) {
-		FlipCopyMem(src, dst, srcsize);
-		src += srcsize;
-		dst += dstsize;
-		len -= srcsize;
-	    }
-	} else
-	    CopyMem(src, dst, srcsize);
-    } else {
-	/* fallback. all other cases */
-	while (len) {
-	    alienWrite(src, srcsize, dst, dstsize, flag);
-	    src += srcsize;
-	    dst += dstsize;
-	    len -= srcsize;
-	}
-    }
+	if (flag && srcsize > 1)
+	    FlipCopyVec(src, dst, len, srcsize);
+	else
+	    CopyMem(src, dst, len);
+    } else
+	ResizeVec(src, dst, len, srcsize, dstsize, !TW_IS_LITTLE_ENDIAN, !TW_IS_LITTLE_ENDIAN ^ !!flag);
 }
 
 static void alienReply(uldat code, uldat alien_len, uldat len, CONST void *data) {
@@ -364,7 +372,7 @@ TW_INLINE ldat alienDecodeArg(uldat id, CONST byte * Format, uldat n, tsfield a,
 			 AlienXendian(Slot) == MagicAlienXendian);
 		    if (a[n]_vec) {
 			if (c == TWS_hwattr && SIZEOF(hwattr) == 2)
-			    alienTranslateHWAttrV_CP437_to_UTF_16((hwattr *)a[n]_vec, nlen);
+			    alienTranslateHWAttrV_CP437_to_UTF_16((hwattr *)a[n]_vec, nlen / 2);
 			*mask |= 1 << n;
 		    } else
 			fail = -fail;
@@ -397,7 +405,7 @@ TW_INLINE ldat alienDecodeArg(uldat id, CONST byte * Format, uldat n, tsfield a,
 			    
 			if (a[n]_vec) {
 			    if (c == TWS_hwattr && SIZEOF(hwattr) == 2)
-				alienTranslateHWAttrV_CP437_to_UTF_16((hwattr *)a[n]_vec, nlen);
+				alienTranslateHWAttrV_CP437_to_UTF_16((hwattr *)a[n]_vec, nlen / 2);
 			    *mask |= 1 << n;
 			} else
 			    fail = -fail;
@@ -622,6 +630,7 @@ static void alienMultiplexB(uldat id) {
 
 
 static void AlienIO(int fd, uldat slot) {
+    msgport MsgPort;
     uldat len, Funct;
     byte *t, *tend;
     int tot = 0;
@@ -641,7 +650,7 @@ static void AlienIO(int fd, uldat slot) {
     if (!(t = RemoteReadGrowQueue(Slot, tot)))
 	return;
     
-    if ((len = read(Fd, t, tot)) && len && len != (uldat)-1) {
+    if ((len = sockRead(t, tot)) && len && len != (uldat)-1) {
 	if (len < tot)
 	    RemoteReadShrinkQueue(Slot, tot - len);
 	
@@ -703,6 +712,9 @@ static void AlienIO(int fd, uldat slot) {
 	    Slot = gzSlot;
 #endif
 	
+	if ((MsgPort = RemoteGetMsgPort(Slot)))
+	    (void)sockCheckQuota(MsgPort, FALSE);
+	
     } else if (!len || (len == (uldat)-1 && errno != EINTR && errno != EWOULDBLOCK)) {
 	/* let's close this sucker */
 	Ext(Remote,KillSlot)(Slot);
@@ -712,51 +724,7 @@ static void AlienIO(int fd, uldat slot) {
 
 /*move chunk bytes to chunk bytes at time, flipping byte order*/
 static void FlipMoveMem(byte *mem, uldat len, uldat chunk) {
-    uldat i, j;
-    byte c;
-#if TW_IS_LITTLE_ENDIAN
-    uint32_t t;
-    
-    switch (chunk) {
-      case 1:
-	return;
-      case 2:
-	while (len >= 2) {
-	    *(uint16_t *)mem = htons(*(CONST uint16_t *)mem);
-	    mem += 2;
-	    len -= 2;
-	}
-	return;
-      case 4:
-	while (len >= 4) {
-	    *(uint32_t *)mem = htonl(*(CONST uint32_t *)mem);
-	    mem += 4;
-	    len -= 4;
-	}
-	return;
-      case 8:
-	while (len >= 8) {
-	    t = htonl(((CONST uint32_t *)mem)[0]);
-	    ((uint32_t *)mem)[0] = htonl(((CONST uint32_t *)mem)[1]);
-	    ((uint32_t *)mem)[1] = t;
-	    mem += 8;
-	    len -= 8;
-	}
-	return;
-      default:
-	break;
-    }
-#endif
-    while (len >= chunk) {
-	for (i = 0; i < chunk / 2; i++) {
-	    j = chunk - i - 1;
-	    c = mem[i];
-	    mem[i] = mem[j];
-	    mem[j] = c;
-	}
-	mem += chunk;
-	len -= chunk;
-    }
+    FlipCopyVec(mem, mem, len, chunk);
 }
 
 /*
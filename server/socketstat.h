@@ -261,8 +261,24 @@ static byte sockStatWindow(window x, tsfield TSF) {
         TWScase(window,MaxYWidth,dat);
         TWScase(window,WLogic,ldat);
         TWScase(window,HLogic,ldat);
+	
+      case TWS_window_ReadCalls:
+	TSF->TWS_field_uldat = x->RemoteData.ReadCalls;
+	TSF->type = TWS_uldat;
+	break;
+      case TWS_window_ReadBytes:
+	TSF->TWS_field_uldat = x->RemoteData.ReadBytes;
+	TSF->type = TWS_uldat;
+	break;
+      case TWS_window_ReadRate:
+	/* rate is updated only while reading: an idle window reads 0 */
+	TSF->TWS_field_uldat = x->RemoteData.RateTime + 1 >= (tany)All->Now.Seconds
+	    ? x->RemoteData.ReadRate : 0;
+	TSF->type = TWS_uldat;
+	break;
       default:
 	if (W_USE((window)x, USECONTENTS)) {
+	    ReflowRows((window)x, 0);
 	    switch (TSF->hash) {
 		TWScasevecUSE(window,C,Contents,hwattr,x->WLogic * x->HLogic);
 		TWScaseUSE(window,C,HSplit,ldat);
@@ -0,0 +1,224 @@
+/*
+ *  test_bind_index.c  --  check that the key and mouse bind indexes in
+ *                         rcrun.c find the same bind as a linear scan,
+ *                         and measure how lookups scale with the binds
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *
+ * Built and run by `make check' in the server directory. It includes
+ * rcrun.c, to reach the static RCFindKeyBind() and RCFindMouseBind(), and
+ * only runs them and RCIndexBinds(), so the rest of the server can stay
+ * unresolved. To build it by hand, from the build directory:
+ *
+ *   cc -DHAVE_CONFIG_H -I include -I $srcdir/include -I $srcdir/server \
+ *      -o test_bind_index $srcdir/server/test_bind_index.c \
+ *      -no-pie -Wl,--unresolved-symbols=ignore-all
+ *   ./test_bind_index [-n rounds] [-s seed] [-b]
+ *
+ * Key lookups are compared with rcrun.c's own linear scan, used when
+ * building the index fails: AllocMem0() below fails on demand to get it.
+ * Mouse lookups with one button and one context use the index, and are
+ * compared with a copy of the scan the index replaced.
+ *
+ * With -b it reports the cost of a lookup against the number of binds.
+ */
+
+#include "rcrun.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static byte FailAlloc;
+
+void *AllocMem(size_t Size) {
+    return malloc(Size);
+}
+
+void *AllocMem0(size_t ElementSize, size_t Count) {
+    return FailAlloc ? NULL : calloc(Count, ElementSize);
+}
+
+/* the scan RCFindMouseBind() does without the index */
+static node LinearMouseBind(ldat code, ldat ctx) {
+    ldat hc = code & (PRESS_|RELEASE_);
+    node l;
+
+    code &= HOLD_ANY;
+    for (l = MouseList; l; l = l->next) {
+	if ((l->id & code) && (l->id & hc) && (l->x.ctx & ctx))
+	    return l;
+    }
+    return NULL;
+}
+
+#define MAX_BINDS 1000
+
+static struct node Keys[MAX_BINDS], Mice[MAX_BINDS], Bodies[MAX_BINDS];
+
+/* a few bits, most often exactly one, of the n lowest */
+static ldat SomeBits(ldat n) {
+    ldat mask = (ldat)1 << rand() % n;
+
+    while (rand() % 4 == 0)
+	mask |= (ldat)1 << rand() % n;
+    return mask;
+}
+
+static ldat RandomShift(void) {
+    static CONST ldat Shift[] = { 0, KBD_SHIFT_FL, KBD_CTRL_FL, KBD_ALT_FL, KBD_CTRL_FL|KBD_ALT_FL };
+    return Shift[rand() % (sizeof(Shift) / sizeof(Shift[0]))];
+}
+
+static ldat RandomLock(void) {
+    return (rand() % 4 ? 0 : KBD_CAPS_LOCK) | (rand() % 4 ? 0 : KBD_NUM_LOCK);
+}
+
+/* n key binds with labels in [0, labels): duplicates are likely when labels is small */
+static void MakeKeys(ldat n, ldat labels) {
+    ldat i;
+
+    for (i = 0; i < n; i++) {
+	Keys[i].id = rand() % labels;
+	Keys[i].x.ctx = RandomShift();
+	Keys[i].body = &Bodies[i];
+	Keys[i].next = i + 1 < n ? &Keys[i + 1] : NULL;
+    }
+    KeyList = n ? &Keys[0] : NULL;
+}
+
+static void MakeMice(ldat n) {
+    ldat i;
+
+    for (i = 0; i < n; i++) {
+	Mice[i].id = SomeBits(BUTTON_N_MAX) * HOLD_ | (rand() % 3 + 1) * PRESS_;
+	Mice[i].x.ctx = SomeBits(CTX_BITS - 1);
+	Mice[i].body = &Bodies[i];
+	Mice[i].next = i + 1 < n ? &Mice[i + 1] : NULL;
+    }
+    MouseList = n ? &Mice[0] : NULL;
+}
+
+static void Index(byte linear) {
+    FailAlloc = linear;
+    RCIndexBinds();
+    FailAlloc = FALSE;
+}
+
+static uldat Check(ldat n) {
+    node linear, indexed;
+    ldat i, label, shift, code, ctx;
+    uldat fail = 0;
+
+    MakeKeys(n, 1 + rand() % 64);
+    MakeMice(n);
+    for (i = 0; i < 64; i++) {
+	label = rand() % 64;
+	shift = RandomShift() | RandomLock();
+	Index(TRUE);
+	linear = RCFindKeyBind(label, shift);
+	Index(FALSE);
+	indexed = RCFindKeyBind(label, shift);
+	if (linear != indexed) {
+	    fail++;
+	    printf("MISMATCH key %d shift 0x%x, %d binds: linear %d, indexed %d\n",
+		   (int)label, (int)shift, (int)n,
+		   linear ? (int)(linear - Bodies) : -1, indexed ? (int)(indexed - Bodies) : -1);
+	}
+	code = SomeBits(BUTTON_N_MAX) * HOLD_ | (rand() % 3 + 1) * PRESS_;
+	ctx = SomeBits(CTX_BITS - 1);
+	linear = LinearMouseBind(code, ctx);
+	indexed = RCFindMouseBind(code, ctx);
+	if (linear != indexed) {
+	    fail++;
+	    printf("MISMATCH mouse code 0x%x ctx 0x%x, %d binds: linear %d, indexed %d\n",
+		   (int)code, (int)ctx, (int)n,
+		   linear ? (int)(linear - Mice) : -1, indexed ? (int)(indexed - Mice) : -1);
+	}
+    }
+    return fail;
+}
+
+/* ---- benchmark ---- */
+
+static double Now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+#define LOOKUPS 2000000
+
+/* ns per lookup of the keys and buttons of n binds, half of them bound */
+static void Bench(void) {
+    static CONST ldat Sizes[] = { 10, 100, 300, 1000 };
+    static ldat Label[1024], Shift[1024], Code[1024], Ctx[1024];
+    double t, ns[2][2];
+    ldat s, n, i, linear;
+    node volatile sink;
+
+    printf("binds   key: linear  indexed    mouse: linear  indexed   (ns per lookup)\n");
+    for (s = 0; s < (ldat)(sizeof(Sizes) / sizeof(Sizes[0])); s++) {
+	n = Sizes[s];
+	/* distinct keys, as a generated .twinrc would have */
+	for (i = 0; i < n; i++) {
+	    Keys[i].id = 0x100 + i;
+	    Keys[i].x.ctx = RandomShift();
+	    Keys[i].body = &Bodies[i];
+	    Keys[i].next = i + 1 < n ? &Keys[i + 1] : NULL;
+	}
+	KeyList = &Keys[0];
+	MakeMice(n);
+	for (i = 0; i < 1024; i++) {
+	    Label[i] = 0x100 + rand() % (2 * n);
+	    Shift[i] = Keys[rand() % n].x.ctx;
+	    Code[i] = HOLD_CODE(rand() % BUTTON_N_MAX) | (rand() % 2 + 1) * PRESS_;
+	    Ctx[i] = (ldat)1 << rand() % (CTX_BITS - 1);
+	}
+	for (linear = 1; linear >= 0; linear--) {
+	    Index((byte)linear);
+	    t = Now();
+	    for (i = 0; i < LOOKUPS; i++)
+		sink = RCFindKeyBind(Label[i & 1023], Shift[i & 1023]);
+	    ns[0][!linear] = (Now() - t) * 1e9 / LOOKUPS;
+	    t = Now();
+	    for (i = 0; i < LOOKUPS; i++)
+		sink = linear ? LinearMouseBind(Code[i & 1023], Ctx[i & 1023]) : RCFindMouseBind(Code[i & 1023], Ctx[i & 1023]);
+	    ns[1][!linear] = (Now() - t) * 1e9 / LOOKUPS;
+	}
+	printf("%5d   %11.1f %8.1f    %13.1f %8.1f\n", (int)n, ns[0][0], ns[0][1], ns[1][0], ns[1][1]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uldat rounds = 10000, r, fail = 0;
+    unsigned seed = 1;
+    byte bench = FALSE;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:b")) != -1) {
+	switch (c) {
+	  case 'n': rounds = strtoul(optarg, NULL, 0); break;
+	  case 's': seed = strtoul(optarg, NULL, 0); break;
+	  case 'b': bench = TRUE; break;
+	  default:
+	    fprintf(stderr, "usage: %s [-n rounds] [-s seed] [-b]\n", argv[0]);
+	    return 1;
+	}
+    }
+    srand(seed);
+    if (bench) {
+	Bench();
+	return 0;
+    }
+    for (r = 0; r < rounds && fail < 10; r++)
+	fail += Check(r % 64);
+    printf("%lu rounds, %lu failed\n", (unsigned long)r, (unsigned long)fail);
+    return fail != 0;
+}
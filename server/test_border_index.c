@@ -0,0 +1,158 @@
+/*
+ *  test_border_index.c  --  check that the BorderList first-character index
+ *                           in rcrun.c finds the same pattern as a linear scan
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *
+ * Built and run by `make check' in the server directory. It links against
+ * its own copy of rcrun.c and only runs RCIndexBinds() and
+ * RCFindBorderPattern(), so the rest of the server can stay unresolved.
+ * To build it by hand, from the build directory:
+ *
+ *   cc -DHAVE_CONFIG_H -I include -I $srcdir/include -I $srcdir/server \
+ *      -o test_border_index $srcdir/server/test_border_index.c \
+ *      server/rcrun.o -no-pie -Wl,--unresolved-symbols=ignore-all
+ *   ./test_border_index [rounds] [seed]
+ *
+ * The linear scan is rcrun.c's own fallback, used when building the index
+ * fails: AllocMem() below fails on demand to get it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "twin.h"
+#include "wm.h"
+#include "rctypes.h"
+#include "rcparse_tab.h"
+#include "rcrun.h"
+
+static byte FailAlloc;
+
+void *AllocMem(size_t Size) {
+    return FailAlloc ? NULL : malloc(Size);
+}
+
+void *AllocMem0(size_t ElementSize, size_t Count) {
+    return calloc(Count, ElementSize);
+}
+
+#define MAX_PATS   24
+#define MAX_TITLES 64
+
+/* pattern pieces: literals (some of them 8-bit), wildcards, classes, escapes */
+static CONST char *Pieces[] = {
+    "a", "b", "x", "T", "\xE8", "\xFF", "*", "*", "?", "[ab]", "[!a]", "[a-c]", "\\*", "\\a", "[",
+};
+#define N_PIECES (sizeof(Pieces) / sizeof(Pieces[0]))
+
+/* titles are made of the same literals */
+static CONST char Letters[] = "abxT\xE8\xFF*[";
+#define N_LETTERS (sizeof(Letters) - 1)
+
+/* patterns a real .twinrc would use */
+static CONST char *Fixed[] = {
+    "", "*", "x*", "Twin*", "[Tt]erm*", "*Menu*", "?",
+};
+#define N_FIXED (sizeof(Fixed) / sizeof(Fixed[0]))
+
+static struct node Nodes[MAX_PATS];
+static char Names[MAX_PATS][64];
+static char Titles[MAX_TITLES][16];
+
+static void RandomPattern(char *s) {
+    int n = rand() % 5;
+
+    *s = '\0';
+    while (n--)
+	strcat(s, Pieces[rand() % N_PIECES]);
+}
+
+static void RandomTitle(char *s) {
+    int n = rand() % 6;
+
+    while (n--)
+	*s++ = Letters[rand() % N_LETTERS];
+    *s = '\0';
+}
+
+static void MakeList(int n) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+	if (rand() % 4 == 0)
+	    strcpy(Names[i], Fixed[rand() % N_FIXED]);
+	else
+	    RandomPattern(Names[i]);
+	Nodes[i].name = (str)Names[i];
+	Nodes[i].data = (str)&Nodes[i];
+	Nodes[i].x.f.flag = rand() % 2 ? FL_INACTIVE : FL_ACTIVE;
+	Nodes[i].next = i + 1 < n ? &Nodes[i + 1] : NULL;
+    }
+    BorderList = n ? &Nodes[0] : NULL;
+}
+
+static hwfont *Find(window W, str Title, byte Border) {
+    W->Name = Title;
+    W->NameLen = Title ? strlen((char *)Title) : 0;
+    return RCFindBorderPattern(W, Border);
+}
+
+static int Check(window W, int n) {
+    hwfont *linear, *indexed;
+    str t;
+    int i, j, fail = 0;
+    byte Border;
+
+    for (i = 0; i < MAX_TITLES; i++)
+	RandomTitle(Titles[i]);
+
+    for (i = -1; i < MAX_TITLES; i++) {
+	t = i < 0 ? (str)NULL : (str)Titles[i];
+	for (Border = 0; Border < 2; Border++) {
+	    FailAlloc = TRUE;
+	    RCIndexBinds();
+	    linear = Find(W, t, Border);
+	    FailAlloc = FALSE;
+	    RCIndexBinds();
+	    indexed = Find(W, t, Border);
+
+	    if (linear != indexed) {
+		fail = 1;
+		printf("MISMATCH title %s%s%s border %d: linear %d, indexed %d\n",
+		       t ? "\"" : "", t ? (char *)t : "(null)", t ? "\"" : "", (int)Border,
+		       linear ? (int)((node)linear - Nodes) : -1,
+		       indexed ? (int)((node)indexed - Nodes) : -1);
+		for (j = 0; j < n; j++)
+		    printf("  %2d %s \"%s\"\n", j,
+			   Nodes[j].x.f.flag == FL_INACTIVE ? "inactive" : "active  ", Names[j]);
+	    }
+	}
+    }
+    return fail;
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 10000;
+    unsigned seed = argc > 2 ? (unsigned)atoi(argv[2]) : 1;
+    int r, fails = 0;
+    window W;
+
+    srand(seed);
+
+    if (!(W = calloc(1, sizeof(struct s_window))))
+	return 2;
+
+    for (r = 0; r < rounds && fails < 10; r++) {
+	int n = r % (MAX_PATS + 1);
+	MakeList(n);
+	fails += Check(W, n);
+    }
+    printf("%d rounds, %d failed\n", r, fails);
+    return fails != 0;
+}
@@ -0,0 +1,224 @@
+/*
+ *  test_charset_bulk.c  --  check that the libTutf bulk translations give
+ *                           the same chars as the one-char ones, and
+ *                           measure both on typical screens
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *
+ * Built and run by `make check' in the server directory, next to the
+ * display drivers that use Tutf_UTF_16_to_charset_function_n().
+ * To build it by hand, from the build directory:
+ *
+ *   cc -DHAVE_CONFIG_H -I include -I $srcdir/include \
+ *      -o test_charset_bulk $srcdir/server/test_charset_bulk.c \
+ *      libs/libTutf/.libs/libTutf.a
+ *   ./test_charset_bulk [-s seed] [-b]
+ *
+ * For every charset, every UTF-16 char (and some beyond, if hwfont is
+ * wider) is translated one at a time and in random runs, in both orders:
+ * the bulk functions fill per-block maps that the one-char functions then
+ * read, so either may run first.
+ *
+ * With -b it measures ns per cell on 80x25 screens instead, see Bench().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "twin.h"
+
+#include <Tutf/Tutf.h>
+
+#define NCHARS 0x20000
+
+static hwfont Src[NCHARS], One[NCHARS], Bulk[NCHARS];
+
+static uldat NChars(void) {
+    return sizeof(hwfont) > 2 ? NCHARS : 0x10000;
+}
+
+static void TranslateOne(Tutf_function f, uldat n) {
+    uldat i;
+    for (i = 0; i < n; i++)
+	One[i] = f(Src[i]);
+}
+
+/* in random runs, as the drivers do */
+static void TranslateBulk(Tutf_function_n f_n, uldat n) {
+    uldat i, len;
+    for (i = 0; i < n; i += len) {
+	len = Min2(n - i, (uldat)(rand() % 300 + 1));
+	f_n(Src + i, Bulk + i, len);
+    }
+}
+
+/* the first char of Src[0, n) translated differently, if any */
+static uldat Compare(uldat id, uldat n) {
+    uldat i;
+
+    for (i = 0; i < n && One[i] == Bulk[i]; i++)
+	;
+    if (i == n)
+	return 0;
+    printf("MISMATCH charset %s: U+%04lX gives 0x%lX one at a time, 0x%lX in bulk\n",
+	   Tutf_charset_name(id), (unsigned long)Src[i], (unsigned long)One[i], (unsigned long)Bulk[i]);
+    return 1;
+}
+
+static uldat Check(void) {
+    Tutf_function f;
+    Tutf_function_n f_n;
+    uldat id, i, n = NChars(), fail = 0, ncharsets = 0;
+
+    for (id = 1; (f = Tutf_UTF_16_to_charset_function(id)); id++) {
+	ncharsets++;
+	if (!(f_n = Tutf_UTF_16_to_charset_function_n(f))) {
+	    printf("charset %s: no bulk function\n", Tutf_charset_name(id));
+	    fail++;
+	    continue;
+	}
+	/* all chars in order */
+	for (i = 0; i < n; i++)
+	    Src[i] = (hwfont)i;
+	if (id & 1) {
+	    TranslateOne(f, n);
+	    TranslateBulk(f_n, n);
+	} else {
+	    TranslateBulk(f_n, n);
+	    TranslateOne(f, n);
+	}
+	if (Compare(id, n)) {
+	    fail++;
+	    continue;
+	}
+	/* mostly the blocks real text uses */
+	for (i = 0; i < n; i++)
+	    Src[i] = (hwfont)(rand() % 4 ? rand() % 0x3000 : rand() % n);
+	TranslateOne(f, n);
+	TranslateBulk(f_n, n);
+	fail += Compare(id, n);
+    }
+    printf("%lu charsets, %lu chars each, %lu failed\n",
+	   (unsigned long)ncharsets, (unsigned long)n, (unsigned long)fail);
+    return fail;
+}
+
+/* ---- benchmark ---- */
+
+static double Now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+#define CELLS  (80 * 25)
+#define SCREENS 5000
+
+/* a char of [lo, hi] */
+static hwfont Range(hwfont lo, hwfont hi) {
+    return lo + rand() % (hi - lo + 1);
+}
+
+/* text with spaces between words: `other' is the share of non-ASCII letters, in percent */
+static void Text(hwfont *s, uldat n, int other, hwfont lo, hwfont hi) {
+    uldat i;
+    for (i = 0; i < n; i++)
+	s[i] = rand() % 6 == 0 ? ' ' : rand() % 100 < other ? Range(lo, hi) : Range('a', 'z');
+}
+
+/* a window frame of box-drawing chars around text, as twin draws it */
+static void Frame(hwfont *s) {
+    uldat x, y;
+    for (y = 0; y < 25; y++)
+	for (x = 0; x < 80; x++) {
+	    if (y == 0 || y == 24)
+		s[y * 80 + x] = x == 0 || x == 79 ? 0x2554 : 0x2550;
+	    else if (x == 0 || x == 79)
+		s[y * 80 + x] = 0x2551;
+	    else if (x == 78)
+		s[y * 80 + x] = y == 1 ? 0x2592 : 0x2591;
+	}
+}
+
+static double NsPerCell(Tutf_function f, Tutf_function_n f_n, hwfont *s) {
+    static hwfont d[CELLS];
+    double t = Now();
+    uldat i, k;
+
+    for (k = 0; k < SCREENS; k++) {
+	if (f_n)
+	    f_n(s, d, CELLS);
+	else for (i = 0; i < CELLS; i++)
+	    d[i] = f(s[i]);
+    }
+    return (Now() - t) * 1e9 / SCREENS / CELLS;
+}
+
+/*
+ * typical screens: ASCII in a box-drawing frame for CP437, latin text
+ * for ISO-8859-1 and -2, Cyrillic for KOI8-R, then Greek and Cyrillic,
+ * and CJK, on CP437, where most of them fall back to approximations.
+ */
+static void Bench(void) {
+    static CONST struct {
+	CONST char *name, *charset;
+	int other;
+	hwfont lo, hi;
+	byte frame;
+    } Screens[] = {
+	{ "ascii + frame",    "CP437",      0,  'a',    'z',    TRUE },
+	{ "latin-1 text",     "ISO-8859-1", 10, 0xC0,   0xFF,   FALSE },
+	{ "latin-2 text",     "ISO-8859-2", 10, 0x100,  0x17F,  FALSE },
+	{ "cyrillic + frame", "KOI8-R",     80, 0x410,  0x44F,  TRUE },
+	{ "greek + cyrillic", "CP437",      50, 0x370,  0x4FF,  TRUE },
+	{ "cjk",              "CP437",      90, 0x4E00, 0x9FFF, FALSE },
+    };
+    static hwfont s[CELLS];
+    Tutf_function f;
+    Tutf_function_n f_n;
+    double one, bulk;
+    uldat i;
+
+    printf("screen             charset       one at a time    bulk   (ns per cell)\n");
+    for (i = 0; i < sizeof(Screens) / sizeof(Screens[0]); i++) {
+	Text(s, CELLS, Screens[i].other, Screens[i].lo, Screens[i].hi);
+	if (Screens[i].frame)
+	    Frame(s);
+	f = Tutf_UTF_16_to_charset_function(Tutf_charset_id((CONST byte *)Screens[i].charset));
+	f_n = Tutf_UTF_16_to_charset_function_n(f);
+	/* warm up the caches and block maps */
+	NsPerCell(f, f_n, s);
+	one = NsPerCell(f, NULL, s);
+	bulk = NsPerCell(f, f_n, s);
+	printf("%-18s %-12s %10.2f %10.2f   %.1fx\n", Screens[i].name, Screens[i].charset, one, bulk, one / bulk);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    unsigned seed = 1;
+    byte bench = FALSE;
+    int c;
+
+    while ((c = getopt(argc, argv, "s:b")) != -1) {
+	switch (c) {
+	  case 's': seed = strtoul(optarg, NULL, 0); break;
+	  case 'b': bench = TRUE; break;
+	  default:
+	    fprintf(stderr, "usage: %s [-s seed] [-b]\n", argv[0]);
+	    return 1;
+	}
+    }
+    srand(seed);
+    if (bench) {
+	Bench();
+	return 0;
+    }
+    return Check() != 0;
+}
@@ -0,0 +1,503 @@
+/*
+ *  test_reflow.c  --  check that terminal resizes in resize.c, which rewrap
+ *                     the history lazily, give the same contents as an
+ *                     eager rewrap of the whole ring
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *
+ * Built and run by `make check' in the server directory. It links against
+ * its own copy of resize.c and only runs ResizeWindowContents(),
+ * ReflowRows() and DropReflowRows() on a window without parent, so the
+ * rest of the server can stay unresolved.
+ * To build it by hand, from the build directory:
+ *
+ *   cc -DHAVE_CONFIG_H -I include -I $srcdir/include -I $srcdir/server \
+ *      -o test_reflow $srcdir/server/test_reflow.c $srcdir/server/resize.c \
+ *      -no-pie -Wl,--unresolved-symbols=ignore-all
+ *   ./test_reflow [-n rounds] [-s seed] [-b]
+ *
+ * Each round runs a random sequence of width and height changes,
+ * full-screen scrolls (which recycle the oldest rows, as tty.c does),
+ * writes, cursor moves and partial reads of the history (as draw.c does)
+ * on a window and on a model of it. The model is a plain array of rows,
+ * oldest first, and rewraps every line at once on each width change.
+ * After every step the window rows not rewrapped yet must be none of the
+ * visible ones, and a copy of the window with all its rows rewrapped by
+ * ReflowRows() must match the model, wrap flags and cursor included.
+ *
+ * With -b it measures how long resizes take instead, see Bench().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "twin.h"
+#include "resize.h"
+
+/* ---- the parts of the server resize.c talks to ---- */
+
+hwattr extra_POS_INSIDE;
+
+void *AllocMem(size_t Size) {
+    return malloc(Size);
+}
+
+void *ReAllocMem(void *Mem, size_t Size) {
+    return realloc(Mem, Size);
+}
+
+void ChargeMem(window W, tany Alloc, tany Freed) { }
+
+/* ---- the model ---- */
+
+#define MAXW  24
+#define MAXV  12
+#define MAXSB 40
+
+typedef struct {
+    ldat W, H, SB, CurX, CurY;
+    byte NeedWrap;
+    hwattr *Cells;	/* H rows of W cells, oldest first */
+    byte *Wrap;
+} model;
+
+static hwattr Blank;	/* what resize.c fills new cells with */
+
+static model M;
+static struct s_window Win;
+static struct s_ttydata Data;
+
+static ldat RoundUp(ldat n, ldat x) {
+    return (n + x - 1) / x * x;
+}
+
+static byte IsBlank(hwattr a) {
+    return !((a ^ Blank) & 0xFFFFFF);
+}
+
+/*
+ * the length a line of rows [a, b] keeps at width x: its cells up to the last
+ * non-blank one, rounded up to whole rows of width x, but never less than
+ * what reaches its last old row, nor more than all its old cells.
+ * The cursor is part of its line.
+ */
+static ldat ModelLineLen(ldat a, ldat b, ldat x) {
+    ldat w = M.W, cells = (b - a + 1) * w, e, len;
+
+    for (e = cells; e > 0 && IsBlank(M.Cells[a * w + e - 1]); e--)
+	;
+    len = Max2(RoundUp(e, x), Max2(RoundUp((b - a) * w, x), x));
+    len = Min2(len, cells);
+    if (M.CurY >= a && M.CurY <= b)
+	len = Max2(len, (M.CurY - a) * w + M.CurX + 1);
+    return len;
+}
+
+static void ModelReflow(ldat x, ldat v) {
+    ldat w = M.W, NewH = M.SB + v, a, b, i, k, n, r, top = 0, cur = 0, curX = 0, first, off;
+    hwattr *New = (hwattr *)malloc(NewH * x * sizeof(hwattr)), *line;
+    byte *NewWrap = (byte *)malloc(NewH);
+    ldat *start = (ldat *)malloc((M.H + 1) * sizeof(ldat)), *rows = (ldat *)malloc((M.H + 1) * sizeof(ldat));
+    ldat nlines = 0;
+
+    /* lay out all lines, rows numbered from the oldest one */
+    for (r = 0, a = 0; a < M.H; a = b + 1) {
+	for (b = a; b < M.H - 1 && M.Wrap[b]; b++)
+	    ;
+	n = (ModelLineLen(a, b, x) + x - 1) / x;
+	if (M.CurY >= a && M.CurY <= b) {
+	    off = (M.CurY - a) * w + M.CurX;
+	    cur = r + off / x;
+	    curX = off % x;
+	}
+	if (M.SB >= a && M.SB <= b)
+	    top = r + (M.SB - a) * w / x;
+	start[nlines] = a;
+	rows[nlines++] = r;
+	r += n;
+    }
+    start[nlines] = M.H;
+    rows[nlines] = r;
+
+    if (cur >= top + v)
+	top = cur - v + 1;
+    first = top + v - NewH;
+
+    for (i = 0; i < NewH; i++) {
+	NewWrap[i] = FALSE;
+	for (k = 0; k < x; k++)
+	    New[i * x + k] = Blank;
+    }
+    for (n = 0; n < nlines; n++) {
+	a = start[n];
+	line = M.Cells + a * w;
+	for (r = rows[n]; r < rows[n + 1]; r++) {
+	    if (r < first || r >= first + NewH)
+		continue;
+	    NewWrap[r - first] = r < rows[n + 1] - 1;
+	    for (k = 0; k < x; k++) {
+		off = (r - rows[n]) * x + k;
+		if (off < (start[n + 1] - a) * w)
+		    New[(r - first) * x + k] = line[off];
+	    }
+	}
+    }
+    free(M.Cells);
+    free(M.Wrap);
+    free(start);
+    free(rows);
+    M.Cells = New;
+    M.Wrap = NewWrap;
+    M.W = x;
+    M.H = NewH;
+    M.CurX = curX;
+    M.CurY = cur - first;
+    if (M.NeedWrap && curX < x - 1) {
+	M.NeedWrap = FALSE;
+	M.CurX++;
+    }
+}
+
+/* same width: blank rows are added at the bottom, or rows dropped at the top to keep the cursor visible, then at the bottom */
+static void ModelRing(ldat v) {
+    ldat w = M.W, NewH = M.SB + v, k = 0, i;
+
+    if (NewH < M.H) {
+	k = Min2(Max2(M.CurY - M.SB + 1 - v, 0), M.H - NewH);
+	memmove(M.Cells, M.Cells + k * w, NewH * w * sizeof(hwattr));
+	memmove(M.Wrap, M.Wrap + k, NewH);
+	M.CurY -= k;
+    }
+    M.Cells = (hwattr *)realloc(M.Cells, NewH * w * sizeof(hwattr));
+    M.Wrap = (byte *)realloc(M.Wrap, NewH);
+    for (i = M.H; i < NewH; i++) {
+	M.Wrap[i] = FALSE;
+	for (k = 0; k < w; k++)
+	    M.Cells[i * w + k] = Blank;
+    }
+    M.H = NewH;
+}
+
+/* ---- the window ---- */
+
+static hwattr *Row(window W, ldat i) {
+    return W->USE.C.Contents + (i + W->USE.C.HSplit) % W->HLogic * W->WLogic;
+}
+
+static byte *WrapOf(window W, ldat i) {
+    return W->USE.C.Wrapped + (i + W->USE.C.HSplit) % W->HLogic;
+}
+
+static void Init(ldat w, ldat v, ldat sb) {
+    ldat i;
+
+    FreeReflow(&Win);
+    free(Win.USE.C.Contents);
+    free(Win.USE.C.Wrapped);
+    free(M.Cells);
+    free(M.Wrap);
+
+    memset(&Data, 0, sizeof(Data));
+    memset(&Win, 0, sizeof(Win));
+    Data.ScrollBack = sb;
+    Data.SizeX = w;
+    Data.SizeY = v;
+    Win.Flags = WINDOWFL_USECONTENTS | WINDOWFL_BORDERLESS;
+    Win.Attrib = WINDOW_WANT_CHANGES;
+    Win.RemoteData.FdSlot = NOSLOT;
+    Win.ColText = 0x07;
+    Win.XWidth = w;
+    Win.YWidth = v + 2;
+    Win.WLogic = w;
+    Win.HLogic = sb + v;
+    Win.USE.C.TtyData = &Data;
+    Win.USE.C.Contents = (hwattr *)malloc(Win.HLogic * w * sizeof(hwattr));
+    Win.USE.C.Wrapped = (byte *)calloc(Win.HLogic, 1);
+    Win.USE.C.HSplit = rand() % Win.HLogic;
+    Win.CurY = sb;
+    for (i = 0; i < Win.HLogic * w; i++)
+	Win.USE.C.Contents[i] = Blank;
+
+    M.W = w;
+    M.H = sb + v;
+    M.SB = sb;
+    M.CurX = 0;
+    M.CurY = sb;
+    M.NeedWrap = FALSE;
+    M.Cells = (hwattr *)malloc(M.H * w * sizeof(hwattr));
+    M.Wrap = (byte *)calloc(M.H, 1);
+    for (i = 0; i < M.H * w; i++)
+	M.Cells[i] = Blank;
+}
+
+/* blanks, blanks with other extra bits, and a few letters */
+static hwattr RandomCell(void) {
+    switch (rand() % 4) {
+      case 0:
+	return Blank;
+      case 1:
+	return HWATTR(0x07, ' ');
+      default:
+	return HWATTR(rand() % 3 ? 0x07 : 0x1F, 'a' + rand() % 26) | extra_POS_INSIDE;
+    }
+}
+
+/* ---- steps, applied to both ---- */
+
+static void Resize(ldat x, ldat v) {
+    ldat oldW = Win.WLogic;
+
+    Win.XWidth = x;
+    Win.YWidth = v + 2;
+    if (!ResizeWindowContents(&Win)) {
+	fprintf(stderr, "test_reflow: ResizeWindowContents() failed\n");
+	exit(1);
+    }
+    if (x != oldW)
+	ModelReflow(x, v);
+    else
+	ModelRing(v);
+}
+
+/* full-screen scroll of n rows, as scrollup() in tty.c */
+static void Scroll(ldat n) {
+    ldat H = Win.HLogic, w = Win.WLogic, i, k;
+
+    Win.USE.C.HSplit = (Win.USE.C.HSplit + n) % H;
+    DropReflowRows(&Win, n);
+    for (i = H - n; i < H; i++) {
+	*WrapOf(&Win, i) = FALSE;
+	for (k = 0; k < w; k++)
+	    Row(&Win, i)[k] = Blank;
+    }
+    memmove(M.Cells, M.Cells + n * w, (H - n) * w * sizeof(hwattr));
+    memmove(M.Wrap, M.Wrap + n, H - n);
+    for (i = H - n; i < H; i++) {
+	M.Wrap[i] = FALSE;
+	for (k = 0; k < w; k++)
+	    M.Cells[i * w + k] = Blank;
+    }
+}
+
+/* overwrite a few visible rows, then move the cursor */
+static void Write(void) {
+    ldat w = Win.WLogic, n = 1 + rand() % 3, i, k;
+    hwattr c;
+
+    while (n--) {
+	i = M.SB + rand() % (M.H - M.SB);
+	M.Wrap[i] = *WrapOf(&Win, i) = rand() % 2;
+	for (k = rand() % w; k < w; k++) {
+	    c = rand() % 4 ? RandomCell() : Blank;
+	    M.Cells[i * w + k] = Row(&Win, i)[k] = c;
+	}
+    }
+    M.CurY = Win.CurY = M.SB + rand() % (M.H - M.SB);
+    M.CurX = Win.CurX = rand() % 3 ? rand() % w : w - 1;
+    M.NeedWrap = M.CurX == w - 1 && rand() % 2;
+    if (M.NeedWrap)
+	Data.Flags |= TTY_NEEDWRAP;
+    else
+	Data.Flags &= ~TTY_NEEDWRAP;
+}
+
+/* ---- comparison ---- */
+
+static byte Check(CONST char *step) {
+    struct s_window C = Win;
+    reflow *R = Win.USE.C.Reflow;
+    ldat w = M.W, H = M.H, i, visible_from = R ? R->Rows : 0;
+    byte ok = TRUE;
+
+    if (Win.WLogic != M.W || Win.HLogic != M.H || Win.CurX != M.CurX || Win.CurY != M.CurY ||
+	!!(Data.Flags & TTY_NEEDWRAP) != M.NeedWrap) {
+	fprintf(stderr, "after %s: window %dx%d cursor %d,%d%s, model %dx%d cursor %d,%d%s\n", step,
+		(int)Win.WLogic, (int)Win.HLogic, (int)Win.CurX, (int)Win.CurY,
+		Data.Flags & TTY_NEEDWRAP ? " (wrap)" : "",
+		(int)M.W, (int)M.H, (int)M.CurX, (int)M.CurY, M.NeedWrap ? " (wrap)" : "");
+	return FALSE;
+    }
+    if (visible_from > M.SB) {
+	fprintf(stderr, "after %s: rows up to %d not rewrapped, but rows from %d are visible\n",
+		step, (int)visible_from, (int)M.SB);
+	return FALSE;
+    }
+    /* rewrap everything on a copy, so the window keeps its pending rows */
+    C.USE.C.Contents = (hwattr *)malloc(H * w * sizeof(hwattr));
+    C.USE.C.Wrapped = (byte *)malloc(H);
+    memcpy(C.USE.C.Contents, Win.USE.C.Contents, H * w * sizeof(hwattr));
+    memcpy(C.USE.C.Wrapped, Win.USE.C.Wrapped, H);
+    if (R) {
+	C.USE.C.Reflow = (reflow *)malloc(sizeof(reflow));
+	*C.USE.C.Reflow = *R;
+	C.USE.C.Reflow->Contents = (hwattr *)malloc(R->HLogic * R->WLogic * sizeof(hwattr));
+	C.USE.C.Reflow->Wrapped = (byte *)malloc(R->HLogic);
+	memcpy(C.USE.C.Reflow->Contents, R->Contents, R->HLogic * R->WLogic * sizeof(hwattr));
+	memcpy(C.USE.C.Reflow->Wrapped, R->Wrapped, R->HLogic);
+    }
+    ReflowRows(&C, 0);
+
+    for (i = 0; i < H && ok; i++) {
+	if (*WrapOf(&C, i) != M.Wrap[i] || memcmp(Row(&C, i), M.Cells + i * w, w * sizeof(hwattr))) {
+	    fprintf(stderr, "after %s: row %d of %dx%d (scrollback %d, %d rows pending) differs\n",
+		    step, (int)i, (int)w, (int)H, (int)M.SB, (int)visible_from);
+	    ok = FALSE;
+	}
+    }
+    if (C.USE.C.Reflow) {
+	fprintf(stderr, "after %s: ReflowRows(0) left rows pending\n", step);
+	ok = FALSE;
+    }
+    free(C.USE.C.Contents);
+    free(C.USE.C.Wrapped);
+    return ok;
+}
+
+static byte Round(void) {
+    ldat steps = 1 + rand() % 30, x, v;
+    CONST char *step = "init";
+
+    x = 1 + rand() % MAXW;
+    v = 1 + rand() % MAXV;
+    Init(x, v, rand() % MAXSB);
+    for (; steps; steps--) {
+	switch (rand() % 8) {
+	  case 0: case 1:
+	    x = 1 + rand() % MAXW;
+	    v = rand() % 2 ? 1 + rand() % MAXV : M.H - M.SB;
+	    Resize(x, v);
+	    step = "width change";
+	    break;
+	  case 2:
+	    Resize(M.W, 1 + rand() % MAXV);
+	    step = "height change";
+	    break;
+	  case 3:
+	    Scroll(1 + rand() % (M.H - M.SB));
+	    step = "scroll";
+	    break;
+	  case 4:
+	    ReflowRows(&Win, rand() % M.H);
+	    step = "history read";
+	    break;
+	  default:
+	    Write();
+	    step = "write";
+	    break;
+	}
+	if (!Check(step))
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+/* ---- benchmark ---- */
+
+static double Now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+/* fill the ring with lines of 0 to 200 letters, wrapped at the window width */
+static void Fill(void) {
+    ldat w = Win.WLogic, i = 0, k, len;
+
+    while (i < Win.HLogic) {
+	len = rand() % 201;
+	for (k = 0; k < len && i < Win.HLogic; k++) {
+	    Row(&Win, i)[k % w] = HWATTR(0x07, 'a' + k % 26) | extra_POS_INSIDE;
+	    if (k % w == w - 1 && k < len - 1)
+		*WrapOf(&Win, i++) = TRUE;
+	}
+	i++;
+    }
+}
+
+/*
+ * ms per resize of an 80x24 terminal with 1k, 10k and 32k lines of history.
+ * ScrollBack is a dat, so a terminal cannot hold 100k lines: 32k is the most.
+ * A width change rewraps only the visible rows, so the history read column
+ * is what scrolling back through all of it costs later. Back to back width
+ * changes, as while dragging a corner, each complete the previous one.
+ */
+static void Bench(void) {
+    static CONST ldat Sizes[] = { 1000, 10000, 32000 };
+    double t, height, width, read, drag;
+    ldat s, i, n = 10;
+
+    printf("history   80x24<->80x40   80<->100 cols   then history read   back to back\n");
+    for (s = 0; s < (ldat)(sizeof(Sizes) / sizeof(Sizes[0])); s++) {
+	Init(80, 24, Sizes[s]);
+	Fill();
+	t = Now();
+	for (i = 0; i < n; i++) {
+	    Win.YWidth = (i & 1 ? 24 : 40) + 2;
+	    ResizeWindowContents(&Win);
+	}
+	height = (Now() - t) / n;
+	Win.YWidth = 24 + 2;
+	ResizeWindowContents(&Win);
+
+	width = read = 0;
+	for (i = 0; i < n; i++) {
+	    Win.XWidth = i & 1 ? 80 : 100;
+	    t = Now();
+	    ResizeWindowContents(&Win);
+	    width += Now() - t;
+	    t = Now();
+	    ReflowRows(&Win, 0);
+	    read += Now() - t;
+	}
+	t = Now();
+	for (i = 0; i < n; i++) {
+	    Win.XWidth = i & 1 ? 80 : 100;
+	    ResizeWindowContents(&Win);
+	}
+	drag = (Now() - t) / n;
+	printf("%-9d %12.3f ms %12.3f ms %14.3f ms %14.3f ms\n", (int)Sizes[s],
+	       height * 1e3, width / n * 1e3, read / n * 1e3, drag * 1e3);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uldat rounds = 20000, i, failed = 0;
+    unsigned seed = 1;
+    byte bench = FALSE;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:b")) != -1) {
+	switch (c) {
+	  case 'n': rounds = strtoul(optarg, NULL, 0); break;
+	  case 's': seed = strtoul(optarg, NULL, 0); break;
+	  case 'b': bench = TRUE; break;
+	  default:
+	    fprintf(stderr, "usage: %s [-n rounds] [-s seed] [-b]\n", argv[0]);
+	    return 1;
+	}
+    }
+    extra_POS_INSIDE = HWATTR_EXTRA32(0, 0x40);
+    Blank = HWATTR(0x07, ' ') | extra_POS_INSIDE;
+    srand(seed);
+
+    if (bench) {
+	Bench();
+	return 0;
+    }
+    for (i = 0; i < rounds; i++) {
+	if (!Round()) {
+	    fprintf(stderr, "round %lu failed (seed %u)\n", (unsigned long)i, seed);
+	    failed++;
+	    break;
+	}
+    }
+    printf("%lu rounds, %lu failed\n", (unsigned long)rounds, (unsigned long)failed);
+    return failed != 0;
+}
@@ -0,0 +1,308 @@
+/*
+ *  test_tt_cache.c  --  check that the libTT listener and ttdata lookup
+ *                       caches find the same objects as the AVL trees
+ *                       they sit in front of, and measure both
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *
+ * Built and run by `make check' in the server directory, next to the
+ * other lookup drivers, since libTT itself is not built. It includes
+ * libTT.c, to reach the static FindListener4Event() and FindByKey_ttdata(),
+ * and only runs them and the functions that add and remove listeners and
+ * ttdata, so the rest of libTT can stay unresolved. Objects are plain
+ * structs with the real class magic, no TTOpen() needed.
+ * To build it by hand, from the build directory:
+ *
+ *   cc -DHAVE_CONFIG_H -I include -I $srcdir/include -I $srcdir/libs/libTT \
+ *      -o test_tt_cache $srcdir/server/test_tt_cache.c $srcdir/libs/libTw/avl.c \
+ *      -no-pie -Wl,--unresolved-symbols=ignore-all
+ *   ./test_tt_cache [-n rounds] [-s seed] [-b]
+ *
+ * Random adds, removes and bulk deletes of listeners and ttdata are mixed
+ * with lookups, each compared with a plain AVLFind(), as libTT did before
+ * the caches, so stale cache entries would show up as mismatches.
+ *
+ * With -b it reports the cost of a lookup with and without the caches.
+ */
+
+#include "libTT.c"
+
+#include <unistd.h>
+
+#define NCOMPONENTS	4
+#define NLISTENERS	1024
+#define NDATAS		1024
+#define NPOOL		64	/* listeners and ttdata the random steps use: few, so they are reused often */
+#define NKEYS		16
+
+static s_ttclass_ttcomponent ComponentClass;
+static s_ttclass_ttlistener ListenerClass;
+static s_ttclass_ttdata DataClass;
+
+static s_ttcomponent Components[NCOMPONENTS];
+static s_ttlistener Listeners[NLISTENERS];
+static s_ttevent Events[NLISTENERS];
+static s_ttdata Datas[NDATAS];
+static ttbyte Keys[NKEYS][12];
+
+/* called by DelAll_ttlistener() and DelAll_ttdata(): the objects only go back to the pool */
+static void DelListener(ttlistener o) {
+    o->events_inprogress = 0;
+    o->refcount = ttobject_refcount_alive;
+}
+
+static void DelData(ttdata o) {
+    o->AVL = empty_AVL;
+    o->component = (ttcomponent)0;
+    o->events_inprogress = 0;
+    o->refcount = ttobject_refcount_alive;
+}
+
+static void Init(void) {
+    ttuint i;
+
+    ComponentClass.magic = magic_ttcomponent;
+    ListenerClass.magic = magic_ttlistener;
+    ListenerClass.Del = DelListener;
+    DataClass.magic = magic_ttdata;
+    DataClass.Del = DelData;
+
+    for (i = 0; i < NCOMPONENTS; i++) {
+	Components[i].Class = &ComponentClass;
+	Components[i].id = i + 1;
+    }
+    for (i = 0; i < NLISTENERS; i++) {
+	Listeners[i].Class = &ListenerClass;
+	Listeners[i].refcount = ttobject_refcount_alive;
+	Listeners[i].event = &Events[i];
+    }
+    for (i = 0; i < NDATAS; i++) {
+	Datas[i].Class = &DataClass;
+	Datas[i].refcount = ttobject_refcount_alive;
+    }
+    for (i = 0; i < NKEYS; i++)
+	sprintf((char *)Keys[i], "key%u", i * 37);
+}
+
+/* the lookups as they were before the caches */
+static ttlistener OldFindListener4Event(ttlistener base, ttevent ev) {
+    s_ttlistener evc;
+    ttavl key;
+
+    evc.AVL.AVLkey = AVLEventKey(ev);
+    evc.event = ev;
+    key = AVLFind(&evc.AVL, ttlistener2ttavl(base), CompareListenerAVLs);
+    return key ? ttavl2ttlistener(key) : (ttlistener)0;
+}
+
+static ttdata OldFindByKey_ttdata(ttdata base, TT_CONST ttbyte *key, ttopaque len) {
+    s_ttdata d;
+
+    d.AVL.AVLkey = AVLStringKey(key, len);
+    d.key = (ttbyte *)key;
+    d.key_len = len;
+    return Find_ttdata(&d, base);
+}
+
+static void RandomEvent(ttevent ev, ttcomponent o) {
+    static TT_CONST ttuint Types[] = {
+	ttevent_evtype_key, ttevent_evtype_mouse, ttevent_evtype_activate, ttevent_evtype_change
+    };
+    ev->component = o;
+    ev->evtype = Types[rand() % (sizeof(Types) / sizeof(Types[0]))];
+    ev->evcode = rand() % 4;
+    ev->evflags = rand() % 2;
+}
+
+static void AddListener(void) {
+    ttlistener c = &Listeners[rand() % NPOOL];
+    ttcomponent o = &Components[rand() % NCOMPONENTS];
+
+    if (c->component)
+	return;
+    RandomEvent(c->event, o);
+    c->lflags = rand() % 2 ? ttlistener_lflags_before : 0;
+    AddTo_ttlistener(c, o);
+}
+
+static void RemoveListener(void) {
+    ttlistener c = &Listeners[rand() % NPOOL];
+
+    if (c->component) {
+	Remove_ttlistener(c);
+	/* back to the pool, as deleting it would */
+	c->component = (ttcomponent)0;
+	c->AVL = empty_AVL;
+	c->prev = c->next = (ttlistener)0;
+    }
+}
+
+static void AddData(void) {
+    ttdata d = &Datas[rand() % NPOOL];
+    ttcomponent o = &Components[rand() % NCOMPONENTS];
+
+    if (d->component)
+	return;
+    d->key = Keys[rand() % NKEYS];
+    d->key_len = strlen((char *)d->key);
+    /* keep keys unique per component: a replaced ttdata would be deleted */
+    if (!OldFindByKey_ttdata(o->datas, d->key, d->key_len))
+	AddTo_ttdata(d, o, TT_FALSE);
+}
+
+static void RemoveData(void) {
+    ttdata d = &Datas[rand() % NPOOL];
+
+    if (d->component) {
+	Remove_ttdata(d);
+	d->AVL = empty_AVL;
+    }
+}
+
+static uldat Lookup(void) {
+    s_ttevent ev;
+    ttcomponent o = &Components[rand() % NCOMPONENTS];
+    ttlistener l_old, l_new;
+    ttdata d_old, d_new;
+    TT_CONST ttbyte *key;
+    uldat fail = 0;
+
+    RandomEvent(&ev, o);
+    l_old = OldFindListener4Event(o->listeners, &ev);
+    l_new = FindListener4Event(o->listeners, &ev);
+    if (l_old != l_new) {
+	fail++;
+	printf("MISMATCH listener component %u evtype %u evcode %u evflags %u: tree %d, cached %d\n",
+	       (unsigned)o->id, (unsigned)ev.evtype, (unsigned)ev.evcode, (unsigned)ev.evflags,
+	       l_old ? (int)(l_old - Listeners) : -1, l_new ? (int)(l_new - Listeners) : -1);
+    }
+    key = Keys[rand() % NKEYS];
+    d_old = OldFindByKey_ttdata(o->datas, key, strlen((TT_CONST char *)key));
+    d_new = FindByKey_ttdata(o->datas, key, strlen((TT_CONST char *)key));
+    if (d_old != d_new) {
+	fail++;
+	printf("MISMATCH ttdata component %u key \"%s\": tree %d, cached %d\n",
+	       (unsigned)o->id, (TT_CONST char *)key,
+	       d_old ? (int)(d_old - Datas) : -1, d_new ? (int)(d_new - Datas) : -1);
+    }
+    return fail;
+}
+
+static uldat Step(void) {
+    int op = rand() % 100;
+
+    if (op < 20)
+	AddListener();
+    else if (op < 35)
+	RemoveListener();
+    else if (op < 55)
+	AddData();
+    else if (op < 70)
+	RemoveData();
+    else if (op < 73)
+	DelAllListeners_ttcomponent(&Components[rand() % NCOMPONENTS]);
+    else if (op < 76)
+	DelAllDatas_ttcomponent(&Components[rand() % NCOMPONENTS]);
+    else
+	return Lookup() + Lookup();
+    return Lookup();
+}
+
+/* ---- benchmark ---- */
+
+static double Now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+#define LOOKUPS 2000000
+
+/*
+ * ns per lookup on one component with n listeners and n ttdata, all distinct,
+ * for lookups spread over all of them and for a hot set of 16, as a GUI firing
+ * many small events at a few widgets does.
+ */
+static void Bench(void) {
+    static TT_CONST ttuint Sizes[] = { 10, 100, 1000 };
+    static s_ttevent Ev[1024];
+    static TT_CONST ttbyte *Key[1024];
+    static ttopaque Len[1024];
+    static ttbyte Names[NDATAS][16];
+    ttcomponent o = &Components[0];
+    double t, ns[2][2][2];
+    ttuint s, n, i, hot, cached;
+    volatile ttopaque sink;
+
+    printf("size  lookups   listener: tree  cached    ttdata: tree  cached   (ns per lookup)\n");
+    for (s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); s++) {
+	n = Sizes[s];
+	DelAllListeners_ttcomponent(o);
+	DelAllDatas_ttcomponent(o);
+	for (i = 0; i < n; i++) {
+	    /* distinct events: one listener per code */
+	    Events[i].component = o;
+	    Events[i].evtype = ttevent_evtype_activate;
+	    Events[i].evcode = i;
+	    AddTo_ttlistener(&Listeners[i], o);
+
+	    sprintf((char *)Names[i], "widget_data%u", i);
+	    Datas[i].key = Names[i];
+	    Datas[i].key_len = strlen((char *)Names[i]);
+	    AddTo_ttdata(&Datas[i], o, TT_FALSE);
+	}
+	for (hot = 0; hot < (n > 16 ? 2 : 1); hot++) {
+	    for (i = 0; i < 1024; i++) {
+		Ev[i] = Events[rand() % (hot && n > 16 ? 16 : n)];
+		Key[i] = Datas[rand() % (hot && n > 16 ? 16 : n)].key;
+		Len[i] = strlen((TT_CONST char *)Key[i]);
+	    }
+	    for (cached = 0; cached < 2; cached++) {
+		t = Now();
+		for (i = 0; i < LOOKUPS; i++)
+		    sink = (ttopaque)(cached ? FindListener4Event(o->listeners, &Ev[i & 1023])
+				      : OldFindListener4Event(o->listeners, &Ev[i & 1023]));
+		ns[hot][0][cached] = (Now() - t) * 1e9 / LOOKUPS;
+		t = Now();
+		for (i = 0; i < LOOKUPS; i++)
+		    sink = (ttopaque)(cached ? FindByKey_ttdata(o->datas, Key[i & 1023], Len[i & 1023])
+				      : OldFindByKey_ttdata(o->datas, Key[i & 1023], Len[i & 1023]));
+		ns[hot][1][cached] = (Now() - t) * 1e9 / LOOKUPS;
+	    }
+	    printf("%4u  %-7s   %14.1f %7.1f    %12.1f %7.1f\n", (unsigned)n, hot ? "hot 16" : "spread",
+		   ns[hot][0][0], ns[hot][0][1], ns[hot][1][0], ns[hot][1][1]);
+	}
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uldat rounds = 200000, r, fail = 0;
+    unsigned seed = 1;
+    byte bench = FALSE;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:b")) != -1) {
+	switch (c) {
+	  case 'n': rounds = strtoul(optarg, NULL, 0); break;
+	  case 's': seed = strtoul(optarg, NULL, 0); break;
+	  case 'b': bench = TRUE; break;
+	  default:
+	    fprintf(stderr, "usage: %s [-n rounds] [-s seed] [-b]\n", argv[0]);
+	    return 1;
+	}
+    }
+    srand(seed);
+    Init();
+    if (bench) {
+	Bench();
+	return 0;
+    }
+    for (r = 0; r < rounds && fail < 10; r++)
+	fail += Step();
+    printf("%lu rounds, %lu failed\n", (unsigned long)r, (unsigned long)fail);
+    return fail != 0;
+}
@@ -0,0 +1,848 @@
+/*
+ *  test_tty_fastpath.c  --  check that the TtyWriteAscii() fast paths
+ *                           (write_run() and bulk CSI parameters) give
+ *                           the same result as the per-byte parser
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *
+ * Built and run by `make check' in the server directory. tty.c is linked
+ * twice: the server's own tty.o, and a copy compiled with TTY_NO_FASTPATH
+ * and renamed entry points (this file with TTY_REF_PASS).
+ * To build it by hand, from the build directory:
+ *
+ *   CC="cc -DHAVE_CONFIG_H -I include -I $srcdir/include -I $srcdir/server"
+ *   $CC -DTTY_REF_PASS -c -o tty_ref.o $srcdir/server/test_tty_fastpath.c
+ *   $CC -no-pie -o test_tty_fastpath $srcdir/server/test_tty_fastpath.c tty_ref.o \
+ *       server/tty.o libs/libTutf/.libs/libTutf.a
+ *   ./test_tty_fastpath [-n rounds] [-s seed] [recorded_output ...]
+ *
+ * Each stream is written in random sized chunks to two windows, one per
+ * tty.c copy. After every chunk the contents, the wrap flags, the ttydata
+ * state and the side effects (replies, title, mode changes) must match,
+ * and every changed cell must have been redrawn. Streams are random
+ * escape-sequence soup, a few built-in recordings, and the files given
+ * on the command line (e.g. a `script' typescript).
+ *
+ * With -b it measures throughput instead: cat-a-log, vim, htop and vttest
+ * shaped traces, and the files given on the command line, are written
+ * to an 80x24 window in 4KB chunks through each tty.c copy, reporting MB/s
+ * (-m sets how many megabytes per trace, default 64).
+ *
+ * LLVMFuzzerTestOneInput() runs the same comparison on fuzzer input.
+ * With clang, build it as a libFuzzer target by compiling this file
+ * with -DTTY_FUZZ -fsanitize=fuzzer (tty.c too, for coverage).
+ * Without clang, -F replays saved inputs through it.
+ */
+
+#ifdef TTY_REF_PASS
+
+# define TTY_NO_FASTPATH
+# define TtyWriteAscii		RefTtyWriteAscii
+# define TtyWriteString		RefTtyWriteString
+# define TtyWriteHWFont		RefTtyWriteHWFont
+# define TtyWriteHWAttr		RefTtyWriteHWAttr
+# define TtyKbdFocus		RefTtyKbdFocus
+# define ForceKbdFocus		RefForceKbdFocus
+# include "tty.c"
+
+#else /* !TTY_REF_PASS */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "twin.h"
+#include "data.h"
+#include "draw.h"
+#include "resize.h"
+#include "remote.h"
+#include "common.h"
+#include "methods.h"
+#include "tty.h"
+
+#include <Tw/Tw.h>
+#include <Tw/Twstat.h>
+#include <Tw/Twstat_defs.h>
+#include <Tutf/Tutf.h>
+
+void RefTtyWriteAscii(window Window, ldat Len, CONST byte *AsciiSeq);
+
+/* window 0 runs the server's tty.c, window 1 the per-byte one */
+#define FAST 0
+#define REF  1
+
+typedef struct side {
+    struct s_window W;
+    byte Title[256];
+    byte Reply[4096];
+    uldat TitleLen, ReplyLen, Beeps, HWCalls;
+    byte *Dirty;	/* visible cells redrawn by the last write */
+} side;
+
+static side S[2];
+static int Cur;	/* side being written to */
+
+/* ---- the parts of the server tty.c talks to ---- */
+
+hwattr extra_POS_INSIDE;
+byte NeedUpdateCursor;
+fn Fn; /* replies go to RemoteWriteQueue(), so messages are never created */
+
+static struct s_all TheAll;
+static struct s_screen TheScreen;
+static struct s_setup TheSetUp;
+static hwfont UserMap[0x100];
+all CONST All = &TheAll;
+
+void *ReAllocMem(void *Mem, size_t Size) {
+    return realloc(Mem, Size);
+}
+
+void DrawLogicWidget(widget W, ldat X1, ldat Y1, ldat X2, ldat Y2) {
+    side *s = &S[(window)W == &S[REF].W];
+    ttydata *D = ((window)W)->USE.C.TtyData;
+    ldat x, y;
+
+    Y1 -= D->ScrollBack;
+    Y2 -= D->ScrollBack;
+    for (y = Max2(Y1, 0); y <= Y2 && y < D->SizeY; y++)
+	for (x = Max2(X1, 0); x <= X2 && x < D->SizeX; x++)
+	    s->Dirty[x + y * D->SizeX] = TRUE;
+}
+
+void DrawBorderWindow(window Window, byte Flags) { }
+void ClearHilight(window Window) { }
+byte ContainsCursor(widget W) { return FALSE; }
+void ScrollFirstWindow(ldat DeltaX, ldat DeltaY, byte byXYLogic) { }
+void ScrollFirstWindowArea(dat X1, dat Y1, dat X2, dat Y2, ldat DeltaX, ldat DeltaY) { }
+void DropReflowRows(window Window, ldat n) { }
+
+uldat RemoteWriteQueue(uldat Slot, uldat len, CONST void *data) {
+    side *s = &S[Slot];
+
+    len = Min2(len, sizeof(s->Reply) - s->ReplyLen);
+    CopyMem(data, s->Reply + s->ReplyLen, len);
+    s->ReplyLen += len;
+    return len;
+}
+
+void BeepHW(void) { S[Cur].Beeps++; }
+void ConfigureHW(udat resource, byte todefault, udat value) {
+    S[Cur].HWCalls = S[Cur].HWCalls * 31 + resource * 7 + todefault * 3 + value;
+}
+void SetPaletteHW(udat N, udat R, udat G, udat B) {
+    S[Cur].HWCalls = S[Cur].HWCalls * 31 + N + (R << 8) + (G << 16) + (B << 24);
+}
+void ResetPaletteHW(void) { S[Cur].HWCalls = S[Cur].HWCalls * 31 + 1; }
+
+static void ChangeField(window W, udat field, uldat CLEARMask, uldat XORMask) {
+    if (field == TWS_window_Attrib)
+	W->Attrib = (W->Attrib & ~CLEARMask) ^ XORMask;
+    else if (field == TWS_window_Flags)
+	W->Flags = (W->Flags & ~CLEARMask) ^ XORMask;
+}
+
+static void SetTitle(window W, dat titlelen, byte *title) {
+    side *s = &S[W == &S[REF].W];
+
+    s->TitleLen = Min2((uldat)titlelen, sizeof(s->Title));
+    CopyMem(title, s->Title, s->TitleLen);
+    free(title);
+}
+
+static widget KbdFocus(window W) { return NULL; }
+
+static struct s_fn_window TheFnWindow;
+
+/* ---- windows ---- */
+
+/* same as InitTtyData() in methods.c */
+static void InitSide(side *s, dat Width, dat Height, dat ScrollBackLines) {
+    window W = &s->W;
+    ttydata *D;
+    ldat count;
+    hwattr *p;
+
+    if (W->USE.C.TtyData) {
+	free(W->USE.C.TtyData->newName);
+	free(W->USE.C.TtyData);
+	free(W->USE.C.Contents);
+	free(W->USE.C.Wrapped);
+	free(s->Dirty);
+    }
+    memset(s, 0, sizeof(*s));
+
+    W->Fn = &TheFnWindow;
+    W->Flags = WINDOWFL_USECONTENTS;
+    W->RemoteData.FdSlot = s == &S[REF];
+    W->Charset = Tutf_CP437_to_UTF_16;
+    W->WLogic = Width;
+    W->HLogic = ScrollBackLines + Height;
+    count = W->WLogic * W->HLogic;
+
+    W->USE.C.TtyData = D = calloc(1, sizeof(ttydata));
+    W->USE.C.Contents = p = malloc(count * sizeof(hwattr));
+    W->USE.C.Wrapped = calloc(1, W->HLogic);
+    s->Dirty = calloc(1, Width * Height);
+    if (!D || !p || !W->USE.C.Wrapped || !s->Dirty) {
+	fprintf(stderr, "out of memory\n");
+	exit(2);
+    }
+    while (count--)
+	*p++ = HWATTR(COL(WHITE,BLACK), ' ') | extra_POS_INSIDE;
+
+    D->State = ESnormal;
+    D->Flags = TTY_AUTOWRAP;
+    W->YLogic = W->CurY = D->ScrollBack = ScrollBackLines;
+    D->SizeX = W->WLogic;
+    D->SizeY = W->HLogic - ScrollBackLines;
+    D->Bottom = D->SizeY;
+    D->Pos = D->Start = W->USE.C.Contents + D->ScrollBack * W->WLogic;
+    D->Split = W->USE.C.Contents + W->WLogic * W->HLogic;
+    W->CursorType = LINECURSOR;
+    W->ColText = D->Color = D->DefColor = D->saveColor = COL(WHITE,BLACK);
+    D->Underline = COL(HIGH|WHITE,BLACK);
+    D->HalfInten = COL(HIGH|BLACK,BLACK);
+    D->TabStop[0] = 0x01010100;
+    D->TabStop[1] = D->TabStop[2] = D->TabStop[3] = D->TabStop[4] = 0x01010101;
+    D->currG = D->G0 = D->saveG0 = LATIN1_MAP;
+    D->G1 = D->saveG1 = VT100GR_MAP;
+    D->InvCharset = Tutf_UTF_16_to_ISO_8859_1;
+}
+
+static hwattr *Cell(window W, ldat x, ldat y) {
+    ttydata *D = W->USE.C.TtyData;
+    hwattr *p = D->Start + x + y * D->SizeX;
+
+    if (p >= D->Split)
+	p -= D->Split - W->USE.C.Contents;
+    return p;
+}
+
+/* ---- comparison ---- */
+
+static CONST byte *Chunk;
+static ldat ChunkLen, ChunkAt;
+static CONST char *StreamName;
+
+static void PrintChunk(void) {
+    ldat i;
+
+    printf("  stream %s, chunk at byte %ld:\n  \"", StreamName, (long)ChunkAt);
+    for (i = 0; i < ChunkLen && i < 200; i++) {
+	if (Chunk[i] >= 32 && Chunk[i] < 127 && Chunk[i] != '\\' && Chunk[i] != '"')
+	    putchar(Chunk[i]);
+	else
+	    printf("\\x%02X", (unsigned)Chunk[i]);
+    }
+    printf(i < ChunkLen ? "\"...\n" : "\"\n");
+}
+
+static int Fail(CONST char *what) {
+    ttydata *F = S[FAST].W.USE.C.TtyData;
+
+    printf("MISMATCH: %s (window %dx%d, scrollback %d)\n", what,
+	   (int)F->SizeX, (int)F->SizeY, (int)F->ScrollBack);
+    PrintChunk();
+    return 1;
+}
+
+#define SAME(field) (f->field == r->field)
+
+static int Compare(void) {
+    window fw = &S[FAST].W, rw = &S[REF].W;
+    ttydata *f = fw->USE.C.TtyData, *r = rw->USE.C.TtyData;
+    ldat n = fw->WLogic * fw->HLogic;
+
+    if (memcmp(fw->USE.C.Contents, rw->USE.C.Contents, n * sizeof(hwattr)))
+	return Fail("Contents");
+    if (memcmp(fw->USE.C.Wrapped, rw->USE.C.Wrapped, fw->HLogic))
+	return Fail("Wrapped");
+    if (fw->USE.C.HSplit != rw->USE.C.HSplit || fw->CurX != rw->CurX || fw->CurY != rw->CurY ||
+	fw->YLogic != rw->YLogic || fw->Attrib != rw->Attrib || fw->Flags != rw->Flags ||
+	fw->ColText != rw->ColText || fw->CursorType != rw->CursorType || fw->Charset != rw->Charset)
+	return Fail("window fields");
+    if (f->Pos - fw->USE.C.Contents != r->Pos - rw->USE.C.Contents ||
+	f->Start - fw->USE.C.Contents != r->Start - rw->USE.C.Contents)
+	return Fail("cursor or screen start");
+    if (!SAME(State) || !SAME(Flags) || !SAME(Effects) || !SAME(X) || !SAME(Y) ||
+	!SAME(saveX) || !SAME(saveY) || !SAME(Top) || !SAME(Bottom))
+	return Fail("ttydata position/state");
+    if (!SAME(Color) || !SAME(DefColor) || !SAME(saveColor) || !SAME(Underline) || !SAME(HalfInten) ||
+	memcmp(f->TabStop, r->TabStop, sizeof(f->TabStop)))
+	return Fail("ttydata colors/tabs");
+    if (!SAME(nPar) || memcmp(f->Par, r->Par, (f->nPar + 1) * sizeof(f->Par[0])))
+	return Fail("CSI parameters");
+    if (!SAME(currG) || !SAME(G) || !SAME(G0) || !SAME(G1) || !SAME(saveG) ||
+	!SAME(saveG0) || !SAME(saveG1) || !SAME(InvCharset))
+	return Fail("charsets");
+    if (!SAME(utf8) || !SAME(utf8_count) || (f->utf8_count && !SAME(utf8_char)))
+	return Fail("utf8 state");
+    if (!SAME(newLen) || (f->newLen && memcmp(f->newName, r->newName, f->newLen)))
+	return Fail("pending title");
+    if (S[FAST].TitleLen != S[REF].TitleLen || memcmp(S[FAST].Title, S[REF].Title, S[FAST].TitleLen))
+	return Fail("title");
+    if (S[FAST].ReplyLen != S[REF].ReplyLen || memcmp(S[FAST].Reply, S[REF].Reply, S[FAST].ReplyLen))
+	return Fail("replies");
+    if (S[FAST].Beeps != S[REF].Beeps || S[FAST].HWCalls != S[REF].HWCalls)
+	return Fail("bell/palette/hw config");
+    return 0;
+}
+
+/* cells that changed during the last write must have been redrawn */
+static int CheckRedraw(int i, CONST hwattr *before) {
+    window W = &S[i].W;
+    ttydata *D = W->USE.C.TtyData;
+    ldat x, y;
+    static char what[80];
+
+    for (y = 0; y < D->SizeY; y++)
+	for (x = 0; x < D->SizeX; x++)
+	    if (*Cell(W, x, y) != before[x + y * D->SizeX] && !S[i].Dirty[x + y * D->SizeX]) {
+		sprintf(what, "%s: cell %ld,%ld changed but was not redrawn",
+			i == FAST ? "fast" : "per-byte", (long)x, (long)y);
+		return Fail(what);
+	    }
+    return 0;
+}
+
+static int Write(int i, hwattr *before) {
+    window W = &S[i].W;
+    ttydata *D = W->USE.C.TtyData;
+    ldat x, y;
+
+    for (y = 0; y < D->SizeY; y++)
+	for (x = 0; x < D->SizeX; x++)
+	    before[x + y * D->SizeX] = *Cell(W, x, y);
+    memset(S[i].Dirty, 0, D->SizeX * D->SizeY);
+
+    Cur = i;
+    if (i == FAST)
+	TtyWriteAscii(W, ChunkLen, Chunk);
+    else
+	RefTtyWriteAscii(W, ChunkLen, Chunk);
+    return CheckRedraw(i, before);
+}
+
+/* write Data[0...Len-1] to both windows in random chunks. return 1 on mismatch */
+static int Run(CONST char *Name, CONST byte *Data, ldat Len, dat Width, dat Height, dat ScrollBackLines) {
+    hwattr *before;
+    int fail = 0;
+
+    InitSide(&S[FAST], Width, Height, ScrollBackLines);
+    InitSide(&S[REF], Width, Height, ScrollBackLines);
+    if (!(before = malloc(Width * Height * sizeof(hwattr))))
+	return 1;
+    StreamName = Name;
+
+    for (ChunkAt = 0; ChunkAt < Len && !fail; ChunkAt += ChunkLen) {
+	switch (rand() % 4) {
+	  case 0: ChunkLen = 1 + rand() % 8; break;
+	  case 1: ChunkLen = 1 + rand() % 64; break;
+	  default: ChunkLen = 1 + rand() % 1024; break;
+	}
+	ChunkLen = Min2(ChunkLen, Len - ChunkAt);
+	Chunk = Data + ChunkAt;
+
+	fail = Write(FAST, before) || Write(REF, before) || Compare();
+    }
+    free(before);
+    return fail;
+}
+
+/* ---- setup ---- */
+
+static void Setup(void) {
+    static byte done;
+    int i;
+
+    if (done)
+	return;
+    done = TRUE;
+    All->FirstScreen = &TheScreen;
+    All->SetUp = &TheSetUp;
+    All->SetUp->MinAllocSize = 8;
+    for (i = 0; i < 0x100; i++)
+	UserMap[i] = i;
+    All->Gtranslations[USER_MAP] = UserMap;
+    TheFnWindow.ChangeField = ChangeField;
+    TheFnWindow.SetTitle = SetTitle;
+    TheFnWindow.KbdFocus = KbdFocus;
+}
+
+/* ---- fuzzing ---- */
+
+/*
+ * libFuzzer entry point: the first bytes choose the window size, the
+ * scrollback and how the rest is split in chunks; the rest is written
+ * to both windows and any difference aborts.
+ */
+int LLVMFuzzerTestOneInput(CONST byte *Data, size_t Size) {
+    dat Width, Height, SB;
+
+    if (Size < 4)
+	return 0;
+    Setup();
+    Width = 1 + Data[0] % 100;
+    Height = 1 + Data[1] % 40;
+    SB = Data[2] % 50;
+    srand(Data[3]);
+    if (Run("fuzz input", Data + 4, (ldat)Size - 4, Width, Height, SB))
+	abort();
+    return 0;
+}
+
+#ifndef TTY_FUZZ
+
+/* ---- streams ---- */
+
+static byte *Buf;
+static ldat BufLen, BufMax;
+
+static void Put(CONST void *s, ldat n) {
+    if (BufLen + n > BufMax) {
+	BufMax = (BufLen + n) * 2;
+	if (!(Buf = realloc(Buf, BufMax))) {
+	    fprintf(stderr, "out of memory\n");
+	    exit(2);
+	}
+    }
+    CopyMem(s, Buf + BufLen, n);
+    BufLen += n;
+}
+
+static void PutS(CONST char *s) {
+    Put(s, strlen(s));
+}
+
+static void PutPrintable(int n) {
+    static CONST char chars[] = "abcdefghijklmnopqrstuvwxyz ABCXYZ0123456789;[]{}()<>=+-_*&^%$#@!~|/?.,:'\"`\\";
+    byte c;
+
+    while (n--) {
+	c = chars[rand() % (sizeof(chars) - 1)];
+	Put(&c, 1);
+    }
+}
+
+static void PutCSI(void) {
+    static CONST char finals[] = "ABCDEFGHJKLMPX@`adefghlmnqrsuc";
+    static CONST int modes[] = { 1, 3, 4, 5, 6, 7, 9, 10, 20, 25, 999, 1000 };
+    char s[32];
+    int n, i;
+
+    PutS("\033[");
+    if (rand() % 4 == 0)
+	PutS("?");
+    n = rand() % 4 ? rand() % 4 : rand() % 20;
+    for (i = 0; i < n; i++) {
+	if (i)
+	    PutS(";");
+	switch (rand() % 6) {
+	  case 0: break;				/* empty parameter */
+	  case 1: sprintf(s, "%d", modes[rand() % 12]); PutS(s); break;
+	  case 2: sprintf(s, "%d", rand() % 100000); PutS(s); break;
+	  default: sprintf(s, "%d", rand() % 50); PutS(s); break;
+	}
+    }
+    s[0] = finals[rand() % (sizeof(finals) - 1)];
+    Put(s, 1);
+}
+
+static void PutUtf8(void) {
+    unsigned c = rand() % 3 ? 0x80 + rand() % 0x780 : 0x800 + rand() % 0xF000;
+    byte s[3];
+
+    if (rand() % 8 == 0) {
+	/* stray continuation or lead byte */
+	s[0] = 0x80 + rand() % 0x80;
+	Put(s, 1);
+    } else if (c < 0x800) {
+	s[0] = 0xC0 | (c >> 6);
+	s[1] = 0x80 | (c & 0x3F);
+	Put(s, 2);
+    } else {
+	s[0] = 0xE0 | (c >> 12);
+	s[1] = 0x80 | ((c >> 6) & 0x3F);
+	s[2] = 0x80 | (c & 0x3F);
+	Put(s, 3);
+    }
+}
+
+static void RandomStream(ldat Len, dat Width) {
+    static CONST char *escs[] = {
+	"\0337", "\0338", "\033c", "\033D", "\033E", "\033M", "\033H", "\033Z",
+	"\033(0", "\033(B", "\033(U", "\033(K", "\033)0", "\033)B", "\033%G", "\033%@",
+	"\033=", "\033>", "\033]R", "\033]P1a0b0c0", "\033]0;title\007", "\033]2;a;b\007",
+	"\033]1;x", "\033[[A", "\033[?", "\033", "\030", "\032",
+    };
+    static CONST char ctrls[] = "\r\n\b\t\007\016\017\177\013\014\000\033";
+    byte c;
+
+    BufLen = 0;
+    while (BufLen < Len) {
+	switch (rand() % 12) {
+	  case 0: case 1: case 2:
+	    PutPrintable(rand() % 3 ? 1 + rand() % 8 : 1 + rand() % (3 * Width));
+	    break;
+	  case 3: case 4:
+	    PutCSI();
+	    break;
+	  case 5:
+	    PutS(escs[rand() % (sizeof(escs) / sizeof(escs[0]))]);
+	    break;
+	  case 6: case 7:
+	    c = ctrls[rand() % (sizeof(ctrls) - 1)];
+	    Put(&c, 1);
+	    break;
+	  case 8:
+	    PutUtf8();
+	    break;
+	  case 9:
+	    c = 0x80 + rand() % 0x80;
+	    Put(&c, 1);
+	    break;
+	  case 10:
+	    /* printable run that stops exactly at the right margin */
+	    PutS("\r");
+	    PutPrintable(Width);
+	    break;
+	  default:
+	    PutS("\033[4h");
+	    PutPrintable(1 + rand() % 4);
+	    PutS("\033[4l");
+	    break;
+	}
+    }
+}
+
+/* output of some common programs */
+static CONST char *Recorded[] = {
+    /* ls --color */
+    "\033[0m\033[01;34mbin\033[0m  \033[01;34mdocs\033[0m  \033[01;32mconfigure\033[0m  Makefile.am  "
+    "\033[01;36mlib -> usr/lib\033[0m  README\r\n\033[01;31mtwin-0.7.tar.gz\033[0m\r\n",
+    /* shell prompt with title and a long wrapping command line */
+    "\033]0;user@host: ~/src/twin\007\033[01;32muser@host\033[00m:\033[01;34m~/src/twin\033[00m$ "
+    "make -C server CFLAGS='-O2 -g -Wall -Wshadow -Wno-uninitialized' LDFLAGS='-L/usr/local/lib -Wl,-rpath,/usr/local/lib' all install\r\n",
+    /* full screen editor redraw with scroll region */
+    "\033[?1049h\033[22;0;0t\033[1;24r\033[?12h\033[?12l\033[27m\033[23m\033[29m\033[m\033[H\033[2J"
+    "\033[?25l\033[24;1H\"tty.c\" 1862L, 47213C\033[2;1H\033[1m\033[34m~                                   \033[3;1H~   "
+    "\033[m\033[1;1H/* this is the main entry point */\033[K\033[2;1H\033[1;23r\033[23;1H\r\n\033[1;24r\033[23;1H"
+    "void TtyWriteAscii(window Window, ldat Len, CONST byte *AsciiSeq) {\033[24;1H\033[K\033[1;1H\033[?25h",
+    /* progress bar redrawn with \r */
+    "  0% [                                        ]\r 25% [##########                              ]\r"
+    " 50% [####################                    ]\r100% [########################################]\r\n",
+    /* top-style screen: cursor addressing, erase, reverse video */
+    "\033[H\033[2Jtop - 12:00:01 up 3 days,  1 user,  load average: 0.00, 0.01, 0.05\033[K\r\n"
+    "\033[7m  PID USER      PR  NI    VIRT    RES  %CPU %MEM     TIME+ COMMAND      \033[m\033[K\r\n"
+    "\033[1m    1 root      20   0  167640  11520   0.0  0.1   0:02.31 systemd\033[m\033[K\033[3;1H\033[J",
+    /* line drawing charset and utf8 */
+    "\033(0lqqqqk\r\nx  x\r\nmqqqqj\033(B\r\n\033%G\xe2\x94\x8c\xe2\x94\x80\xe2\x94\x90 caf\xc3\xa9\033%@\r\n",
+};
+
+static int ReadFile(CONST char *name) {
+    FILE *f = fopen(name, "rb");
+    byte tmp[4096];
+    size_t n;
+
+    if (!f) {
+	perror(name);
+	return 0;
+    }
+    BufLen = 0;
+    while ((n = fread(tmp, 1, sizeof(tmp), f)) > 0)
+	Put(tmp, n);
+    fclose(f);
+    return 1;
+}
+
+/* ---- throughput ---- */
+
+/*
+ * synthetic traces shaped like the output of common programs.
+ * Real recordings (e.g. `script -q /dev/null vttest' typescripts)
+ * can be given on the command line instead.
+ */
+static void TraceLog(ldat Len) {
+    static CONST char *level[] = { "INFO ", "DEBUG", "WARN ", "ERROR" };
+    char s[160];
+    long n = 0;
+
+    BufLen = 0;
+    while (BufLen < Len) {
+	sprintf(s, "2026-10-19 12:%02ld:%02ld.%03ld %s [worker-%d] request %ld served in %dms, %d bytes\r\n",
+		n / 3600 % 60, n / 60 % 60, n % 1000, level[rand() % 4], rand() % 16, n, rand() % 500, rand() % 100000);
+	PutS(s);
+	if (rand() % 4 == 0) {
+	    PutS("    at ");
+	    PutPrintable(20 + rand() % 100);
+	    PutS("\r\n");
+	}
+	n++;
+    }
+}
+
+static void TraceVim(ldat Len) {
+    static CONST char *syn[] = { "\033[m", "\033[1m\033[34m", "\033[33m", "\033[32m", "\033[35m", "\033[1m\033[36m" };
+    char s[64];
+    int y, k;
+
+    BufLen = 0;
+    PutS("\033[?1049h\033[1;24r\033[m\033[H\033[2J");
+    while (BufLen < Len) {
+	switch (rand() % 3) {
+	  case 0:
+	    /* page down: redraw every line with syntax highlighting */
+	    PutS("\033[?25l");
+	    for (y = 1; y < 24; y++) {
+		sprintf(s, "\033[%d;1H", y);
+		PutS(s);
+		for (k = rand() % 8; k; k--) {
+		    PutS(syn[rand() % 6]);
+		    PutPrintable(1 + rand() % 12);
+		}
+		PutS("\033[m\033[K");
+	    }
+	    PutS("\033[24;1H\033[K\"tty.c\" 1926L, 52110C\033[1;1H\033[?25h");
+	    break;
+	  case 1:
+	    /* scroll one line inside the scroll region */
+	    PutS("\033[1;23r\033[23;1H\r\n\033[1;24r\033[23;1H");
+	    PutS(syn[rand() % 6]);
+	    PutPrintable(rand() % 79);
+	    PutS("\033[m\033[K");
+	    break;
+	  default:
+	    /* typing in insert mode */
+	    sprintf(s, "\033[%d;%dH", 1 + rand() % 23, 1 + rand() % 60);
+	    PutS(s);
+	    for (k = 1 + rand() % 10; k; k--) {
+		PutS("\033[4h");
+		PutPrintable(1);
+		PutS("\033[4l");
+	    }
+	    break;
+	}
+    }
+}
+
+static void TraceHtop(ldat Len) {
+    char s[64];
+    int y;
+
+    BufLen = 0;
+    PutS("\033[?1049h\033[H\033[2J");
+    while (BufLen < Len) {
+	/* meters */
+	PutS("\033[1;3H\033[1m\033[36m1\033[m\033[1m[\033[32m||||\033[31m||\033[m          ");
+	sprintf(s, "\033[1m%4.1f%%\033[m]\033[2;3H\033[1m\033[36mMem\033[m\033[1m[\033[32m|||||", (rand() % 1000) / 10.0);
+	PutS(s);
+	/* process list: one field at a time, colors change every few cells */
+	for (y = 5; y < 24; y++) {
+	    sprintf(s, "\033[%d;1H\033[30m\033[46m%5d\033[m \033[36m%-8s\033[m ", y, rand() % 32768, "root");
+	    PutS(s);
+	    sprintf(s, "\033[1m%3d\033[m \033[32m%6dM\033[m \033[1m%5.1f\033[m ", rand() % 40, rand() % 4096, (rand() % 1000) / 10.0);
+	    PutS(s);
+	    sprintf(s, "\033[%dm%2d:%02d.%02d\033[m ", rand() % 2 ? 1 : 0, rand() % 60, rand() % 60, rand() % 100);
+	    PutS(s);
+	    PutPrintable(10 + rand() % 30);
+	    PutS("\033[K");
+	}
+    }
+}
+
+static void TraceVttest(ldat Len) {
+    char s[64];
+    int i;
+
+    BufLen = 0;
+    while (BufLen < Len) {
+	switch (rand() % 5) {
+	  case 0:
+	    /* screen alignment and a box in the line drawing charset */
+	    PutS("\033#8\033[9;10H\033(0lqqqqqqqqqqqqqqqqqqqqk");
+	    for (i = 10; i < 16; i++) {
+		sprintf(s, "\033[%d;10Hx\033[%d;31Hx", i, i);
+		PutS(s);
+	    }
+	    PutS("\033[16;10Hmqqqqqqqqqqqqqqqqqqqqj\033(B");
+	    break;
+	  case 1:
+	    /* cursor movements */
+	    for (i = 0; i < 20; i++) {
+		sprintf(s, "\033[%d%c*", 1 + rand() % 10, "ABCDEFGd"[rand() % 8]);
+		PutS(s);
+	    }
+	    break;
+	  case 2:
+	    /* insert/delete lines and characters */
+	    sprintf(s, "\033[%d;1H\033[%dL\033[%dM\033[%d@\033[%dP\033[%dX", 1 + rand() % 24,
+		    1 + rand() % 5, 1 + rand() % 5, 1 + rand() % 5, 1 + rand() % 5, 1 + rand() % 5);
+	    PutS(s);
+	    PutPrintable(40);
+	    break;
+	  case 3:
+	    /* tab stops */
+	    PutS("\033[3g\033[1;1H");
+	    for (i = 0; i < 10; i++)
+		PutS("\033[3C\033H");
+	    PutS("\r");
+	    for (i = 0; i < 10; i++)
+		PutS("*\t");
+	    PutS("\r\n");
+	    break;
+	  default:
+	    /* wrap-around and origin tests */
+	    PutS("\033[?7h\033[24;1H");
+	    PutPrintable(200);
+	    PutS("\033[?7l\033[1;1H");
+	    PutPrintable(200);
+	    PutS("\033[?7h\033[2J\033[H");
+	    break;
+	}
+    }
+}
+
+static double Now(void) {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+/* write Buf to window i in read()-sized chunks until at least Total bytes went through. return MB/s */
+static double Throughput(int i, ldat Total) {
+    window W = &S[i].W;
+    double t;
+    ldat done, at, n;
+
+    InitSide(&S[i], 80, 24, 100);
+    Cur = i;
+    t = Now();
+    for (done = 0; done < Total; done += BufLen) {
+	for (at = 0; at < BufLen; at += n) {
+	    n = Min2(BufLen - at, 4096);
+	    if (i == FAST)
+		TtyWriteAscii(W, n, Buf + at);
+	    else
+		RefTtyWriteAscii(W, n, Buf + at);
+	}
+	/* keep the reply buffer from filling up */
+	S[i].ReplyLen = 0;
+    }
+    t = Now() - t;
+    return done / (t > 0.0 ? t : 1e-9) / 1e6;
+}
+
+static void Bench(CONST char *Name, ldat Total) {
+    double fast = Throughput(FAST, Total), ref = Throughput(REF, Total);
+
+    printf("%-20s %8.1f MB/s  per-byte %8.1f MB/s  (x%.2f)\n", Name, fast, ref, fast / ref);
+}
+
+static void BenchAll(int nfiles, char *files[], ldat Total) {
+    static struct {
+	CONST char *name;
+	void (*trace)(ldat Len);
+    } traces[] = {
+	{ "cat big.log", TraceLog },
+	{ "vim", TraceVim },
+	{ "htop", TraceHtop },
+	{ "vttest", TraceVttest },
+    };
+    int i;
+
+    for (i = 0; i < (int)(sizeof(traces) / sizeof(traces[0])); i++) {
+	traces[i].trace(1 << 20);
+	Bench(traces[i].name, Total);
+    }
+    for (i = 0; i < nfiles; i++)
+	if (ReadFile(files[i]) && BufLen)
+	    Bench(files[i], Total);
+}
+
+
+static void Usage(void) {
+    fprintf(stderr, "usage: test_tty_fastpath [-n rounds] [-s seed] [recorded_output ...]\n"
+	    "       test_tty_fastpath -b [-m megabytes] [recorded_output ...]\n"
+	    "       test_tty_fastpath -F fuzz_input ...\n");
+    exit(2);
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = 2000, i, r, fails = 0, files = 0;
+    unsigned seed = 1;
+    dat Width, Height, SB;
+    char name[32];
+    byte bench = FALSE, fuzz = FALSE;
+    ldat megs = 64;
+    int nfiles = 0;
+
+    /* options first, file names are moved to argv[0...nfiles-1] */
+    for (i = 1; i < argc; i++) {
+	if (!strcmp(argv[i], "-n") && i + 1 < argc)
+	    rounds = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+	    seed = (unsigned)atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+	    megs = atoi(argv[++i]);
+	else if (!strcmp(argv[i], "-b"))
+	    bench = TRUE;
+	else if (!strcmp(argv[i], "-F"))
+	    fuzz = TRUE;
+	else if (argv[i][0] == '-')
+	    Usage();
+	else
+	    argv[nfiles++] = argv[i];
+    }
+    srand(seed);
+    Setup();
+
+    if (bench) {
+	BenchAll(nfiles, argv, megs << 20);
+	return 0;
+    }
+    if (fuzz) {
+	/* replay inputs saved by libFuzzer, without libFuzzer */
+	for (i = 0; i < nfiles; i++)
+	    if (ReadFile(argv[i]))
+		LLVMFuzzerTestOneInput(Buf, BufLen);
+	printf("%d fuzz inputs: no mismatch\n", nfiles);
+	return 0;
+    }
+
+    /* recorded streams, on a few usual sizes */
+    for (i = 0; i < (int)(sizeof(Recorded) / sizeof(Recorded[0])); i++) {
+	for (r = 0; r < 3; r++) {
+	    sprintf(name, "recorded #%d", i);
+	    fails += Run(name, (CONST byte *)Recorded[i], strlen(Recorded[i]),
+			 r == 0 ? 80 : r == 1 ? 20 : 132, r == 0 ? 24 : r == 1 ? 5 : 50, r * 10);
+	}
+    }
+    for (i = 0; i < nfiles; i++) {
+	if (ReadFile(argv[i])) {
+	    files++;
+	    fails += Run(argv[i], Buf, BufLen, 80, 24, 100);
+	}
+    }
+    /* random streams, including degenerate window sizes */
+    for (r = 0; r < rounds && fails < 10; r++) {
+	Width = rand() % 8 ? 1 + rand() % 100 : 1 + rand() % 3;
+	Height = rand() % 8 ? 1 + rand() % 40 : 1 + rand() % 3;
+	SB = rand() % 2 ? 0 : rand() % 50;
+	RandomStream(1 + rand() % 8192, Width);
+	sprintf(name, "random #%d (seed %u)", r, seed);
+	fails += Run(name, Buf, BufLen, Width, Height, SB);
+    }
+    printf("%d recorded, %d files, %d random streams: %d failed\n",
+	   (int)(sizeof(Recorded) / sizeof(Recorded[0])), files, r, fails);
+    return fails != 0;
+}
+
+#endif /* TTY_FUZZ */
+
+#endif /* TTY_REF_PASS */
@@ -10,6 +10,8 @@
  *
  */
 
+#include <sys/uio.h>
+
 #include "twin.h"
 #include "data.h"
 #include "methods.h"
@@ -19,6 +21,10 @@
 #include "pty.h"
 #include "util.h"
 #include "common.h"
+#include "hw_multi.h"
+#include "main.h"
+#include "upgrade.h"
+#include "resize.h"
 
 #define COD_QUIT      (udat)1
 #define COD_SPAWN     (udat)3
@@ -44,15 +50,15 @@ static void termShutDown(widget W) {
     }
 }
 
-static window newTermWindow(byte *title) {
+static window newTermWindow(CONST byte *title, dat titlelen, dat XWidth, dat YWidth, dat ScrollBack) {
     window Window;
 
     Window = Do(Create,Window)
-	(FnWindow, Term_MsgPort, LenStr(title), title, NULL,
+	(FnWindow, Term_MsgPort, titlelen, title, NULL,
 	 Term_Menu, COL(WHITE,BLACK), LINECURSOR,
 	 WINDOW_WANT_KEYS|WINDOW_DRAG|WINDOW_RESIZE|WINDOW_Y_BAR|WINDOW_CLOSE,
 	 WINDOWFL_CURSOR_ON|WINDOWFL_USECONTENTS,
-	 80, 25, 200);
+	 XWidth, YWidth, ScrollBack);
     
     if (Window) {
 	Act(SetColors,Window)
@@ -82,7 +88,7 @@ static window OpenTerm(CONST byte *arg0, byte * CONST *argv) {
 	title = default_title;
     }
     
-    if ((Window = newTermWindow(title))) {
+    if ((Window = newTermWindow(title, LenStr(title), 80, 25, 200))) {
         if (SpawnInWindow(Window, arg0, argv)) {
 	    if (RegisterWindowFdIO(Window, TwinTermIO)) {
 		Window->ShutDownHook = termShutDown;
@@ -145,6 +151,8 @@ static void TwinTermH(msgport MsgPort) {
 		    (void)RemoteWindowWriteQueue(Win, Event->EventSelectionNotify.Len,
 						 Event->EventSelectionNotify.Data);
 	    }
+	    if (Event->EventSelectionNotify.Code & SEL_NOTIFY_MORE)
+		TwinSelectionAck((obj)Term_MsgPort, Event->EventSelectionNotify.ReqPrivate);
 	} else if (Msg->Type==MSG_WIDGET_MOUSE) {
 	    if (Win) {
 		byte buf[10];
@@ -183,21 +191,81 @@ static void TwinTermH(msgport MsgPort) {
     }
 }
 
+/*
+ * each terminal reads into its own buffer, which starts at TW_BIGBUFF bytes.
+ * If a readv() fills it and spills into the shared buffer too,
+ * the buffer doubles (up to TTY_MAXBUFF); after TTY_SHRINKREADS reads
+ * using less than a quarter of it, it halves again.
+ */
+#define TTY_MAXBUFF	(TW_BIGBUFF * 16)
+#define TTY_SHRINKREADS	64
+
+static byte TermResizeBuf(remotedata *RData, uldat size) {
+    byte *RBuf;
+    
+    if ((RBuf = ReAllocMem(RData->RBuf, size))) {
+	RData->RBuf = RBuf;
+	RData->RBufSize = size;
+	RData->RBufIdle = 0;
+	return TRUE;
+    }
+    return FALSE;
+}
+
 static void TwinTermIO(int Fd, window Window) {
-    static byte buf[TW_BIGBUFF];
-    uldat got = 0, chunk = 0;
+    static byte spill[TW_BIGBUFF];
+    remotedata *RData = &Window->RemoteData;
+    struct iovec iov[2];
+    uldat got, max = flag_ttyquantum ? flag_ttyquantum : TW_MAXULDAT;
+    int n = 0;
+    ssize_t chunk;
     
-    do {
-	/*
-	 * TW_BIGBUFF - 1 to avoid silly windows...
-	 * linux ttys buffer up to 4095 bytes.
-	 */
-	chunk = read(Fd, buf + got, TW_BIGBUFF - 1 - got);
-    } while (chunk && chunk != (uldat)-1 && (got += chunk) < TW_BIGBUFF - 1);
+    if (RData->RBuf || TermResizeBuf(RData, TW_BIGBUFF)) {
+	iov[n].iov_base = RData->RBuf;
+	iov[n++].iov_len = Min2(RData->RBufSize, max);
+	max -= iov[0].iov_len;
+    }
+    if (max) {
+	iov[n].iov_base = spill;
+	iov[n++].iov_len = Min2(sizeof(spill), max);
+    }
+
+    /*
+     * a single readv() drains the pty: whatever is left
+     * stays in the kernel until next turn.
+     */
+    chunk = readv(Fd, iov, n);
     
-    if (got)
-	Act(TtyWriteAscii,Window)(Window, got, buf);
-    else if (chunk == (uldat)-1 && errno != EINTR && errno != EWOULDBLOCK)
+    if (chunk > 0) {
+	got = (uldat)chunk;
+	RData->ReadCalls++;
+	RData->ReadBytes += got;
+	if (RData->RateTime != (tany)All->Now.Seconds) {
+	    RData->ReadRate = RData->RateBytes / Max2(All->Now.Seconds - RData->RateTime, 1);
+	    RData->RateTime = All->Now.Seconds;
+	    RData->RateBytes = 0;
+	}
+	RData->RateBytes += got;
+	
+	/* parse in place: no copies */
+	if (n == 2 && got > iov[0].iov_len) {
+	    Act(TtyWriteAscii,Window)(Window, iov[0].iov_len, iov[0].iov_base);
+	    Act(TtyWriteAscii,Window)(Window, got - iov[0].iov_len, spill);
+	} else
+	    Act(TtyWriteAscii,Window)(Window, got, iov[0].iov_base);
+	
+	if (!RData->RBuf)
+	    ;
+	else if (got > RData->RBufSize) {
+	    if (RData->RBufSize < TTY_MAXBUFF)
+		TermResizeBuf(RData, RData->RBufSize * 2);
+	} else if (got < RData->RBufSize / 4 && RData->RBufSize > TW_BIGBUFF) {
+	    if (++RData->RBufIdle >= TTY_SHRINKREADS)
+		TermResizeBuf(RData, RData->RBufSize / 2);
+	} else
+	    RData->RBufIdle = 0;
+	
+    } else if (chunk == -1 && errno != EINTR && errno != EWOULDBLOCK)
 	/* something bad happened to our child :( */
 	Delete(Window);
 }
@@ -226,6 +294,139 @@ static void OverrideMethods(byte enter) {
 }
 
 
+/*
+ * live upgrade support, see upgrade.c: each terminal is saved with
+ * its geometry, contents, emulator state and pty master, which stays
+ * open across exec(). Screens are saved bottom to top, so that Restore()
+ * maps the windows back in the same stacking order.
+ */
+#define PUT(x) UpgradePutNum((tany)(x))
+#define GET(x) ((x) = UpgradeGetNum())
+
+static void termSaveWindow(window W, tany nscreen, screen Screen) {
+    /* the saved Contents must be complete */
+    ReflowRows(W, 0);
+    
+    PUT(W->NameLen);
+    UpgradePutMem(W->Name, W->NameLen);
+    PUT(nscreen);
+    PUT(Screen ? W->Left - Screen->XLogic : W->Left);
+    PUT(Screen ? W->Up - Screen->YLogic : W->Up);
+    PUT(W->XWidth); PUT(W->YWidth); PUT(W->Attrib); PUT(W->Flags);
+    PUT(W->XLogic); PUT(W->YLogic); PUT(W->CurX); PUT(W->CurY); PUT(W->CursorType);
+    PUT(W->ColGadgets); PUT(W->ColArrows); PUT(W->ColBars); PUT(W->ColTabs); PUT(W->ColBorder);
+    PUT(W->ColText); PUT(W->ColSelect); PUT(W->ColDisabled); PUT(W->ColSelectDisabled);
+    UpgradePutContents(W);
+
+    /* the new server inherits the pty */
+    UpgradePutFd(W->RemoteData.Fd);
+    PUT(W->RemoteData.ChildPid);
+}
+
+static byte termSaveable(widget W) {
+    return W->Owner == Term_MsgPort && IS_WINDOW(W) &&
+	W_USE((window)W, USECONTENTS) && ((window)W)->RemoteData.Fd != NOFD;
+}
+
+static byte termSave(void) {
+    screen Screen;
+    widget W;
+    tany n = 0, s;
+    
+    for (W = Term_MsgPort->FirstW; W; W = W->O_Next)
+	if (termSaveable(W))
+	    n++;
+    PUT(n);
+    
+    /* unmapped windows first */
+    for (W = Term_MsgPort->FirstW; W; W = W->O_Next)
+	if (!W->Parent && termSaveable(W))
+	    termSaveWindow((window)W, (tany)-1, (screen)0);
+    
+    for (Screen = All->FirstScreen, s = 0; Screen; Screen = Screen->Next, s++) {
+	for (W = Screen->LastW; W; W = W->Prev)
+	    if (termSaveable(W))
+		termSaveWindow((window)W, s, Screen);
+    }
+    return TRUE;
+}
+
+static window termRestoreWindow(void) {
+    window W;
+    screen Screen;
+    byte *name;
+    tany namelen, nscreen;
+    struct s_window SWin, *S = &SWin; /* saved fields, until the real window exists */
+    
+    GET(namelen);
+    if (!(name = AllocMem(namelen + 1)))
+	return NULL;
+    UpgradeGetMem(name, namelen);
+
+    GET(nscreen);
+    GET(S->Left); GET(S->Up); GET(S->XWidth); GET(S->YWidth); GET(S->Attrib); GET(S->Flags);
+    GET(S->XLogic); GET(S->YLogic); GET(S->CurX); GET(S->CurY); GET(S->CursorType);
+    GET(S->ColGadgets); GET(S->ColArrows); GET(S->ColBars); GET(S->ColTabs); GET(S->ColBorder);
+    GET(S->ColText); GET(S->ColSelect); GET(S->ColDisabled); GET(S->ColSelectDisabled);
+
+    /* small: UpgradeGetContents() replaces its contents */
+    W = newTermWindow(name, namelen, MIN_XWIN, MIN_YWIN, 0);
+    FreeMem(name);
+    if (!W)
+	return NULL;
+    if (!UpgradeGetContents(W)) {
+	Delete(W);
+	return NULL;
+    }
+    GET(S->RemoteData.Fd);
+    GET(S->RemoteData.ChildPid);
+    if (!UpgradeGetMem(NULL, 0)) {
+	Delete(W);
+	return NULL;
+    }
+    
+    W->Left = S->Left; W->Up = S->Up; W->XWidth = S->XWidth; W->YWidth = S->YWidth;
+    W->Attrib = S->Attrib; W->Flags = S->Flags;
+    W->XLogic = S->XLogic; W->YLogic = S->YLogic;
+    W->CurX = S->CurX; W->CurY = S->CurY; W->CursorType = S->CursorType;
+    W->ColGadgets = S->ColGadgets; W->ColArrows = S->ColArrows; W->ColBars = S->ColBars;
+    W->ColTabs = S->ColTabs; W->ColBorder = S->ColBorder; W->ColText = S->ColText;
+    W->ColSelect = S->ColSelect; W->ColDisabled = S->ColDisabled;
+    W->ColSelectDisabled = S->ColSelectDisabled;
+    
+    W->RemoteData.Fd = S->RemoteData.Fd;
+    W->RemoteData.ChildPid = S->RemoteData.ChildPid;
+    fcntl(W->RemoteData.Fd, F_SETFD, FD_CLOEXEC);
+    
+    if (!RegisterWindowFdIO(W, TwinTermIO)) {
+	close(W->RemoteData.Fd);
+	Delete(W);
+	return NULL;
+    }
+    W->ShutDownHook = termShutDown;
+    
+    if (nscreen != (tany)-1) {
+	for (Screen = All->FirstScreen; Screen && nscreen; Screen = Screen->Next)
+	    nscreen--;
+	Act(MapTopReal,W)(W, Screen ? Screen : All->FirstScreen);
+    }
+    return W;
+}
+
+static uldat termRestore(void) {
+    tany n;
+    uldat ok = 0;
+    
+    /* stop at the first failure: the rest of the state may be out of sync */
+    for (GET(n); n && UpgradeGetMem(NULL, 0) && termRestoreWindow(); n--)
+	ok++;
+    return ok;
+}
+
+#undef PUT
+#undef GET
+
+
 byte InitModule(module Module)
 {
     window Window;
@@ -252,6 +453,8 @@ byte InitModule(module Module)
 	Item4MenuCommon(Term_Menu)) {
 
 	RegisterExt(Term,Open,OpenTerm);
+	RegisterExt(Term,Save,termSave);
+	RegisterExt(Term,Restore,termRestore);
 	OverrideMethods(TRUE);
 
 	if (default_args[1][0] == '/')
@@ -267,6 +470,8 @@ byte InitModule(module Module)
 
 void QuitModule(module Module) {
     UnRegisterExt(Term,Open,OpenTerm);
+    UnRegisterExt(Term,Save,termSave);
+    UnRegisterExt(Term,Restore,termRestore);
     OverrideMethods(FALSE);
     if (Term_MsgPort)
 	Delete(Term_MsgPort);
@@ -327,8 +327,23 @@ static void fill(hwattr *s, hwattr c, ldat len) {
     }
 }
 
+/* wrap flag of visible row y, see USE.C.Wrapped */
+static byte *wrap_row(dat y) {
+    ldat r = (Start - Base) / SizeX + y;
+    
+    if (r >= Win->HLogic)
+	r -= Win->HLogic;
+    return Win->USE.C.Wrapped + r;
+}
+
+static void clear_wrap(dat y, dat nr) {
+    while (nr-- > 0)
+	*wrap_row(y++) = FALSE;
+}
+
 static void scrollup(dat t, dat b, dat nr) {
     hwattr *d, *s;
+    dat y;
     byte accel = FALSE;
     
     if (t + nr >= b)
@@ -349,6 +364,8 @@ static void scrollup(dat t, dat b, dat nr) {
 	Win->USE.C.HSplit += nr;
 	if (Win->USE.C.HSplit >= Win->HLogic)
 	    Win->USE.C.HSplit -= Win->HLogic;
+	/* the oldest rows are recycled */
+	DropReflowRows(Win, nr);
 	
 	Start += nr * SizeX;
 	if (Start >= Split) Start -= Split - Base;
@@ -363,10 +380,13 @@ static void scrollup(dat t, dat b, dat nr) {
 	s = Start + SizeX * (t+nr);
 	d = Start + SizeX * t;
 	fwd_copy(s, d, (b-t-nr) * SizeX);
+	for (y = t; y < b-nr; y++)
+	    *wrap_row(y) = *wrap_row(y+nr);
     }
     
     /* clear the last nr lines */
     fill(d + (b-t-nr) * SizeX, HWATTR(ColText, ' ') | extra_POS_INSIDE, nr * SizeX);
+    clear_wrap(b-nr, nr);
     
     if (accel)
 	ScrollFirstWindowArea(0, t, SizeX-1, b-1, 0, -nr);
@@ -375,6 +395,7 @@ static void scrollup(dat t, dat b, dat nr) {
 static void scrolldown(dat t, dat b, dat nr) {
     hwattr *s;
     ldat step;
+    dat y;
     byte accel = FALSE;
     
     if (t+nr >= b)
@@ -394,6 +415,9 @@ static void scrolldown(dat t, dat b, dat nr) {
 
     rev_copy(s, s + step, (b-t-nr)*SizeX);
     fill(s, HWATTR(ColText, ' ') | extra_POS_INSIDE, step);
+    for (y = b-1; y >= t+nr; y--)
+	*wrap_row(y) = *wrap_row(y-nr);
+    clear_wrap(t, nr);
 
     if (accel)
 	ScrollFirstWindowArea(0, t, SizeX-1, b-1, 0, nr);
@@ -447,6 +471,13 @@ INLINE void del(void) {
     /* ignored */
 }
 
+/* autowrap: remember the row continues on the next one, to reflow it on resize */
+INLINE void wrap(void) {
+    *wrap_row(Y) = TRUE;
+    cr();
+    lf();
+}
+
 static void csi_J(int vpar) {
     ldat count;
     hwattr *start;
@@ -454,18 +485,21 @@ static void csi_J(int vpar) {
     switch (vpar) {
       case 0:	/* erase from cursor to end of display */
 	dirty_tty(0, Y, SizeX-1, SizeY-1);
-	count = (SizeY - Y) * (ldat)SizeX + SizeX - X;
+	count = (SizeY - Y) * (ldat)SizeX - X;
 	start = Pos;
+	clear_wrap(Y, SizeY - Y);
 	break;
       case 1:	/* erase from start to cursor */
 	dirty_tty(0, 0, SizeX-1, Y);
 	count = Y * (ldat)SizeX + X;
 	start = Start;
+	clear_wrap(0, Y);
 	break;
       case 2: /* erase whole display */
 	dirty_tty(0, 0, SizeX-1, SizeY-1);
 	count = (ldat)SizeX * SizeY;
 	start = Start;
+	clear_wrap(0, SizeY);
 	break;
       default:
 	return;
@@ -484,6 +518,7 @@ static void csi_K(int vpar) {
 	dirty_tty(X, Y, SizeX-1, Y);
 	count = SizeX - X;
 	start = Pos;
+	clear_wrap(Y, 1);
 	break;
       case 1:	/* erase from start of line to cursor */
 	dirty_tty(0, Y, X, Y);
@@ -494,6 +529,7 @@ static void csi_K(int vpar) {
 	dirty_tty(0, Y, SizeX-1, Y);
 	count = SizeX;
 	start = Pos - X;
+	clear_wrap(Y, 1);
 	break;
       default:
 	return;
@@ -1461,9 +1497,82 @@ static byte combine_utf8(hwfont *pc) {
     return FALSE;
 }
 
+#ifndef TTY_NO_FASTPATH
+/*
+ * byte classes used by TtyWriteAscii() to consume whole runs of bytes
+ * without going through the per-byte state machine:
+ * TC_PRINT bytes are displayed as-is in ESnormal state regardless of
+ * utf8 and TTY_DISPCTRL, TC_PARAM bytes are CSI parameters in ESgetpars state.
+ */
+#define TC_PRINT	1
+#define TC_PARAM	2
+
+#define P_ TC_PRINT
+#define D_ (TC_PRINT|TC_PARAM)
+static CONST byte tty_class[0x100] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,			/* 0x00 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,			/* 0x10 */
+    P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,			/* 0x20 */
+    D_,D_,D_,D_,D_,D_,D_,D_,D_,D_,P_,D_,P_,P_,P_,P_,			/* 0x30 */
+    P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,			/* 0x40 */
+    P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,			/* 0x50 */
+    P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,			/* 0x60 */
+    P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_,P_, 0,			/* 0x70 */
+    /* 0x80 ... 0xFF: all zero, utf8 and meta need the per-byte path */
+};
+#undef D_
+#undef P_
+
+/*
+ * write a run of TC_PRINT bytes at cursor position, with a single dirty_tty()
+ * per row. same result as writing them one at a time from TtyWriteAscii(),
+ * but TTY_INSERT is not supported: caller must check it.
+ */
+static void write_run(CONST byte *s, ldat n, byte translate) {
+    hwattr *p;
+    hwfont c;
+    byte meta = *Flags & TTY_SETMETA ? 0x80 : 0;
+    ldat i, chunk;
+    
+    while (n) {
+	if (*Flags & TTY_NEEDWRAP)
+	    wrap();
+	chunk = Min2(n, (ldat)SizeX - X);
+	
+	dirty_tty(X, Y, X + chunk - 1, Y);
+	for (p = Pos, i = 0; i < chunk; i++) {
+	    c = translate ? applyG((byte)(s[i] | meta)) : s[i];
+	    *p++ = HWATTR(Color, c) | extra_POS_INSIDE;
+	}
+	s += chunk;
+	n -= chunk;
+	
+	if (X + chunk < SizeX) {
+	    X += chunk;
+	    Pos = p;
+	    continue;
+	}
+	/* wrote the last column: cursor stays there */
+	Pos = p - 1;
+	X = SizeX - 1;
+	if (*Flags & TTY_AUTOWRAP)
+	    *Flags |= TTY_NEEDWRAP;
+	else if (n) {
+	    /* without autowrap, the remaining bytes all overwrite the last column */
+	    c = translate ? applyG((byte)(s[n-1] | meta)) : s[n-1];
+	    *Pos = HWATTR(Color, c) | extra_POS_INSIDE;
+	    n = 0;
+	}
+    }
+}
+#endif /* TTY_NO_FASTPATH */
+
 /* this is the main entry point */
 void TtyWriteAscii(window Window, ldat Len, CONST byte *AsciiSeq) {
     hwfont c;
+#ifndef TTY_NO_FASTPATH
+    ldat n;
+#endif
     byte printable, utf8_in_use, disp_ctrl, state_normal;
     
     if (!Window || !Len || !AsciiSeq || !W_USE(Window, USECONTENTS) || !Window->USE.C.TtyData)
@@ -1472,6 +1581,39 @@ void TtyWriteAscii(window Window, ldat Len, CONST byte *AsciiSeq) {
     common(Window);
     
     while (!(*Flags & TTY_STOPPED) && Len) {
+	
+#ifndef TTY_NO_FASTPATH
+	/* TTY_NO_FASTPATH leaves only the per-byte parser, see test_tty_fastpath.c */
+	if (DState == ESnormal) {
+	    /* consume the whole run of plain printable bytes at once */
+	    for (n = 0; n < Len && (tty_class[AsciiSeq[n]] & TC_PRINT); n++)
+		;
+	    if (n > 1 && !(*Flags & TTY_INSERT)) {
+		utf8_in_use = utf8 && !(*Flags & TTY_DISPCTRL);
+		if (utf8_in_use)
+		    utf8_count = 0;
+		write_run(AsciiSeq, n, !utf8_in_use);
+		AsciiSeq += n;
+		Len -= n;
+		continue;
+	    }
+	} else if ((DState & ESany) == ESgetpars) {
+	    /* consume CSI parameters at once */
+	    while (Len && (tty_class[c = *AsciiSeq] & TC_PARAM)) {
+		if (c == ';') {
+		    if (nPar >= NPAR-1)
+			break;
+		    Par[++nPar] = 0;
+		} else
+		    Par[nPar] = Par[nPar] * 10 + (c - '0');
+		AsciiSeq++;
+		Len--;
+	    }
+	    if (!Len)
+		break;
+	}
+#endif
+	
 	c = *AsciiSeq++;
 	Len--;
 	
@@ -1510,10 +1652,8 @@ void TtyWriteAscii(window Window, ldat Len, CONST byte *AsciiSeq) {
 
 	if (printable && state_normal) {
 	    /* Now try to find out how to display it */
-	    if (*Flags & TTY_NEEDWRAP) {
-		cr();
-		lf();
-	    }
+	    if (*Flags & TTY_NEEDWRAP)
+		wrap();
 	    if (*Flags & TTY_INSERT)
 		insert_char(1);
 	    
@@ -1563,10 +1703,8 @@ void TtyWriteHWFont(window Window, ldat Len, CONST hwfont *HWFont) {
 	if (DState == ESnormal && ok) {
 
 	    /* Now try to find out how to display it */
-	    if (*Flags & TTY_NEEDWRAP) {
-		cr();
-		lf();
-	    }
+	    if (*Flags & TTY_NEEDWRAP)
+		wrap();
 	    if (*Flags & TTY_INSERT)
 		insert_char(1);
 	    
@@ -1604,10 +1742,8 @@ void TtyWriteString(window Window, ldat Len, CONST byte *String) {
 	Len--;
 
 	/* Now try to find out how to display it */
-	if (*Flags & TTY_NEEDWRAP) {
-	    cr();
-	    lf();
-	}
+	if (*Flags & TTY_NEEDWRAP)
+	    wrap();
 	    
 	dirty_tty(X, Y, X, Y);
 	*Pos = HWATTR(Color, c) | extra_POS_INSIDE;
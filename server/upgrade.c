@@ -0,0 +1,591 @@
+/*
+ *  upgrade.c  --  re-exec twin in place, keeping its terminals and clients alive
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ */
+
+/*
+ * Upgrade() serializes what can survive an exec() into an unlinked file:
+ * the TWDISPLAY listening socket (see util.c), the builtin terminals
+ * with their pty masters, contents and emulator state (see tterm.c),
+ * and the libTw clients with their sockets, queues, msgports and objects,
+ * under the same Ids, plus the displays they attached (see socket.c).
+ * The file descriptor is passed to the new server in $TWIN_UPGRADE,
+ * together with every fd the state refers to.
+ *
+ * It runs from the builtin File/Upgrade menu row or on SIGUSR2.
+ *
+ * Clients the new server could not rebuild are disconnected as if the
+ * server quit, and the new server reports how many: gzip-compressed ones,
+ * and ones using server extensions, whose state lives in the extension.
+ * Displays given with -hw= are reopened by the new server from the same
+ * command line.
+ */
+
+#include "twin.h"
+
+#include <Tutf/Tutf.h>
+
+#ifdef TW_HAVE_SIGNAL_H
+# include <signal.h>
+#endif
+
+#include "main.h"
+#include "data.h"
+#include "dl.h"
+#include "extreg.h"
+#include "hw.h"
+#include "hw_multi.h"
+#include "remote.h"
+#include "printk.h"
+#include "util.h"
+#include "upgrade.h"
+
+#define UPGRADE_ENV	"TWIN_UPGRADE"
+#define UPGRADE_MAGIC	"TwinUpg"
+#define UPGRADE_VERSION	((tany)4)	/* bump on any change of the state layout */
+
+tany PerfUpgrade;
+VOLATILE byte GotSignalUpgrade;
+
+static byte *UpgradeArgv0;
+
+static int StateFd = NOFD;
+static byte StateOk, StateResuming, StartupSkip;
+static byte StateBuf[TW_BIGBUFF * 16];
+static uldat StateLen, StatePos;
+
+/* fds the state refers to: they must survive exec() */
+static int *StateFds;
+static uldat StateFdN, StateFdMax;
+
+/* fds only the state refers to: closed if exec() fails */
+static int *OwnFds;
+static uldat OwnFdN, OwnFdMax;
+
+/* timestamps of the upgrade phases, the first two taken by the old server */
+static timevalue UpgradeStart, UpgradeExec, UpgradeResumed, UpgradeRestored;
+
+static byte statefile[]="/tmp/.Twin_upgrade\0\0\0\0\0";
+
+
+static void StateFlush(void) {
+    CONST byte *data = StateBuf;
+    int r;
+
+    while (StateOk && StateLen) {
+	r = write(StateFd, data, StateLen);
+	if (r > 0) {
+	    data += r;
+	    StateLen -= r;
+	} else if (r == 0 || errno != EINTR)
+	    StateOk = FALSE;
+    }
+    StateLen = 0;
+}
+
+void UpgradePutMem(CONST void *mem, uldat len) {
+    CONST byte *data = (CONST byte *)mem;
+    uldat chunk;
+
+    while (StateOk && len) {
+	if (StateLen == sizeof(StateBuf))
+	    StateFlush();
+	chunk = Min2(len, sizeof(StateBuf) - StateLen);
+	CopyMem(data, StateBuf + StateLen, chunk);
+	StateLen += chunk;
+	data += chunk;
+	len -= chunk;
+    }
+}
+
+void UpgradePutNum(tany n) {
+    UpgradePutMem(&n, sizeof(n));
+}
+
+/* return FALSE if the state is truncated or was already found bad */
+byte UpgradeGetMem(void *mem, uldat len) {
+    byte *data = (byte *)mem;
+    uldat chunk;
+    int r;
+
+    while (StateOk && len) {
+	if (StatePos == StateLen) {
+	    StatePos = StateLen = 0;
+	    do {
+		r = read(StateFd, StateBuf, sizeof(StateBuf));
+	    } while (r < 0 && errno == EINTR);
+	    if (r <= 0) {
+		StateOk = FALSE;
+		break;
+	    }
+	    StateLen = r;
+	}
+	chunk = Min2(len, StateLen - StatePos);
+	CopyMem(StateBuf + StatePos, data, chunk);
+	StatePos += chunk;
+	data += chunk;
+	len -= chunk;
+    }
+    return StateOk;
+}
+
+tany UpgradeGetNum(void) {
+    tany n = 0;
+    UpgradeGetMem(&n, sizeof(n));
+    return n;
+}
+
+static byte AddFd(int **fds, uldat *n, uldat *max, int fd) {
+    int *newfds;
+
+    if (*n == *max) {
+	if (!(newfds = ReAllocMem(*fds, (*max ? *max * 2 : 64) * sizeof(int))))
+	    return FALSE;
+	*fds = newfds;
+	*max = *max ? *max * 2 : 64;
+    }
+    (*fds)[(*n)++] = fd;
+    return TRUE;
+}
+
+/* save a fd the new server will inherit. it is read back with UpgradeGetNum() */
+void UpgradePutFd(int fd) {
+    if (!AddFd(&StateFds, &StateFdN, &StateFdMax, fd))
+	StateOk = FALSE;
+    UpgradePutNum((tany)fd);
+}
+
+/*
+ * the caller no longer uses fd, already saved with UpgradePutFd():
+ * it is closed if exec() fails, as nobody would serve it
+ */
+void UpgradeOwnFd(int fd) {
+    if (!AddFd(&OwnFds, &OwnFdN, &OwnFdMax, fd))
+	close(fd);
+}
+
+static void SetStateFdsCloseOnExec(int flag) {
+    uldat i;
+    for (i = 0; i < StateFdN; i++)
+	fcntl(StateFds[i], F_SETFD, flag);
+}
+
+/* the byte <-> hwfont translations setCharset() in tty.c picks, by charset */
+static void GetCharsets(CONST hwfont **Charsets, void **InvCharsets) {
+    Charsets[VT100GR_MAP] = Tutf_VT100GR_to_UTF_16;
+    InvCharsets[VT100GR_MAP] = (void *)Tutf_UTF_16_to_VT100GR;
+    Charsets[LATIN1_MAP] = Tutf_ISO8859_1_to_UTF_16;
+    InvCharsets[LATIN1_MAP] = (void *)Tutf_UTF_16_to_ISO8859_1;
+    Charsets[IBMPC_MAP] = Tutf_CP437_to_UTF_16;
+    InvCharsets[IBMPC_MAP] = (void *)Tutf_UTF_16_to_CP437;
+    Charsets[USER_MAP] = All->Gtranslations[USER_MAP];
+    InvCharsets[USER_MAP] = (void *)Tutf_UTF_16_to_ISO8859_1;
+}
+
+#define PUT(x) UpgradePutNum((tany)(x))
+#define GET(x) ((x) = UpgradeGetNum())
+
+/*
+ * save the contents and emulator state of a USECONTENTS window,
+ * for tterm.c and socket.c. ReflowRows() it first:
+ * the saved Contents must be complete
+ */
+void UpgradePutContents(window W) {
+    ttydata *Data = W->USE.C.TtyData;
+    CONST hwfont *Charsets[USER_MAP+1];
+    void *InvCharsets[USER_MAP+1];
+    uldat i, c, ic;
+
+    PUT(W->WLogic); PUT(W->HLogic); PUT(W->USE.C.HSplit);
+
+    PUT(Data->State); PUT(Data->Flags); PUT(Data->Effects); PUT(Data->ScrollBack);
+    PUT(Data->SizeX); PUT(Data->SizeY); PUT(Data->Top); PUT(Data->Bottom);
+    PUT(Data->X); PUT(Data->Y); PUT(Data->saveX); PUT(Data->saveY);
+    PUT(Data->Start - W->USE.C.Contents);
+    PUT(Data->Split - W->USE.C.Contents);
+    PUT(Data->Pos - W->USE.C.Contents);
+    PUT(Data->Color); PUT(Data->DefColor); PUT(Data->saveColor);
+    PUT(Data->Underline); PUT(Data->HalfInten);
+    for (i = 0; i < 5; i++)
+	PUT(Data->TabStop[i]);
+    PUT(Data->nPar);
+    for (i = 0; i < NPAR; i++)
+	PUT(Data->Par[i]);
+    PUT(Data->currG); PUT(Data->G); PUT(Data->G0); PUT(Data->G1);
+    PUT(Data->saveG); PUT(Data->saveG0); PUT(Data->saveG1);
+    PUT(Data->utf8); PUT(Data->utf8_count); PUT(Data->utf8_char);
+
+    /* the translations are pointers into this server: save which ones they are */
+    GetCharsets(Charsets, InvCharsets);
+    for (c = 0; c <= USER_MAP && Charsets[c] != W->Charset; c++)
+	;
+    for (ic = 0; ic <= USER_MAP && InvCharsets[ic] != Data->InvCharset; ic++)
+	;
+    PUT(c); PUT(ic);
+
+    UpgradePutMem(W->USE.C.Contents, W->WLogic * W->HLogic * sizeof(hwattr));
+    UpgradePutMem(W->USE.C.Wrapped, W->HLogic);
+}
+
+/*
+ * restore into W, a new USECONTENTS window, what UpgradePutContents() saved.
+ * the caller restores the other fields of W
+ */
+byte UpgradeGetContents(window W) {
+    ttydata *Data, SData;
+    CONST hwfont *Charsets[USER_MAP+1];
+    void *InvCharsets[USER_MAP+1];
+    hwattr *Contents;
+    byte *Wrapped;
+    ldat WLogic, HLogic, Start, Split, Pos;
+    dat HSplit;
+    uldat i, c, ic;
+
+    GET(WLogic); GET(HLogic); GET(HSplit);
+
+    Data = &SData;
+    GET(Data->State); GET(Data->Flags); GET(Data->Effects); GET(Data->ScrollBack);
+    GET(Data->SizeX); GET(Data->SizeY); GET(Data->Top); GET(Data->Bottom);
+    GET(Data->X); GET(Data->Y); GET(Data->saveX); GET(Data->saveY);
+    GET(Start); GET(Split); GET(Pos);
+    GET(Data->Color); GET(Data->DefColor); GET(Data->saveColor);
+    GET(Data->Underline); GET(Data->HalfInten);
+    for (i = 0; i < 5; i++)
+	GET(Data->TabStop[i]);
+    GET(Data->nPar);
+    for (i = 0; i < NPAR; i++)
+	GET(Data->Par[i]);
+    GET(Data->currG); GET(Data->G); GET(Data->G0); GET(Data->G1);
+    GET(Data->saveG); GET(Data->saveG0); GET(Data->saveG1);
+    GET(Data->utf8); GET(Data->utf8_count); GET(Data->utf8_char);
+    GET(c); GET(ic);
+
+    if (!StateOk || WLogic <= 0 || HLogic <= 0 ||
+	Start > WLogic * HLogic || Split > WLogic * HLogic || Pos > WLogic * HLogic)
+	return FALSE;
+
+    if (!(Contents = AllocMem(WLogic * HLogic * sizeof(hwattr))))
+	return FALSE;
+    if (!(Wrapped = AllocMem(HLogic))) {
+	FreeMem(Contents);
+	return FALSE;
+    }
+    if (!UpgradeGetMem(Contents, WLogic * HLogic * sizeof(hwattr)) ||
+	!UpgradeGetMem(Wrapped, HLogic)) {
+	FreeMem(Wrapped);
+	FreeMem(Contents);
+	return FALSE;
+    }
+
+    FreeMem(W->USE.C.Contents);
+    FreeMem(W->USE.C.Wrapped);
+    ChargeMem(W, HLogic * (WLogic * sizeof(hwattr) + 1), W->HLogic * (W->WLogic * sizeof(hwattr) + 1));
+    W->USE.C.Contents = Contents;
+    W->USE.C.Wrapped = Wrapped;
+    W->USE.C.HSplit = HSplit;
+    W->WLogic = WLogic;
+    W->HLogic = HLogic;
+
+    /* a pending xterm title escape is lost with its buffer */
+    if ((Data->State & ESany) == ESxterm_title_ || (Data->State & ESany) == ESxterm_title)
+	Data->State = ESnormal;
+    Data->Start = Contents + Start;
+    Data->Split = Contents + Split;
+    Data->Pos = Contents + Pos;
+    Data->newLen = Data->newMax = 0;
+    Data->newName = NULL;
+    /* keep the defaults InitTtyData() chose for translations we did not know */
+    Data->InvCharset = W->USE.C.TtyData->InvCharset;
+    CopyMem(Data, W->USE.C.TtyData, sizeof(ttydata));
+
+    GetCharsets(Charsets, InvCharsets);
+    if (c <= USER_MAP)
+	W->Charset = Charsets[c];
+    if (ic <= USER_MAP)
+	W->USE.C.TtyData->InvCharset = InvCharsets[ic];
+    return TRUE;
+}
+
+#undef GET
+#undef PUT
+
+static void UpgradeSetEnv(CONST byte *name, CONST byte *value) {
+#if defined(TW_HAVE_SETENV)
+    if (value)
+	setenv(name, value, 1);
+    else
+	unsetenv(name);
+#elif defined(TW_HAVE_PUTENV)
+    byte *s;
+    /* putenv() keeps the string: leak it, we are about to exec() anyway */
+    if (!value)
+	value = "";
+    if ((s = AllocMem(LenStr(name) + LenStr(value) + 2))) {
+	sprintf(s, "%s=%s", name, value);
+	putenv(s);
+    }
+#endif
+}
+
+static void PutTime(timevalue *T) {
+    UpgradePutNum(T->Seconds);
+    UpgradePutNum(T->Fraction);
+}
+
+static void GetTime(timevalue *T) {
+    T->Seconds = UpgradeGetNum();
+    T->Fraction = UpgradeGetNum();
+}
+
+/*
+ * the path we were started from, for exec(): prefer the one the kernel
+ * knows, as argv[0] may have been searched in a $PATH we no longer have
+ */
+static byte *UpgradeFindSelf(void) {
+    byte buf[TW_BIGBUFF];
+    int len;
+
+    len = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+    if (len > 0 && buf[0] == '/') {
+	buf[len] = '\0';
+	return CloneStr(buf);
+    }
+    return CloneStr(main_argv[0]);
+}
+
+/* SIGUSR2 asks for an upgrade: main loop calls Upgrade() */
+static TW_RETSIGTYPE SignalUpgrade(int n) {
+    GotSignals = GotSignalUpgrade = TRUE;
+    signal(SIGUSR2, SignalUpgrade);
+    TW_RETFROMSIGNAL(0);
+}
+
+/*
+ * called by Init() before InitTWDisplay(), which overwrites argv[0]:
+ * remember how we were started, and see if we are resuming from Upgrade()
+ */
+byte InitUpgrade(void) {
+    byte *env, magic[sizeof(UPGRADE_MAGIC)];
+
+    if (!(UpgradeArgv0 = UpgradeFindSelf())) {
+	printk("twin: InitUpgrade(): Out of memory!\n");
+	return FALSE;
+    }
+    signal(SIGUSR2, SignalUpgrade);
+    
+    if (!(env = getenv(UPGRADE_ENV)) || !*env)
+	return TRUE;
+
+    StateFd = atoi(env);
+    UpgradeSetEnv(UPGRADE_ENV, NULL);
+    StateOk = TRUE;
+
+    if (UpgradeGetMem(magic, sizeof(magic)) &&
+	!CmpMem(magic, UPGRADE_MAGIC, sizeof(magic)) &&
+	UpgradeGetNum() == UPGRADE_VERSION &&
+	UpgradeGetNum() == (tany)sizeof(hwattr)) {
+
+	GetTime(&UpgradeStart);
+	StateResuming = StateOk;
+    }
+    if (!StateResuming) {
+	printk("twin: InitUpgrade(): bad or incompatible upgrade state, starting from scratch\n");
+	close(StateFd);
+	StateFd = NOFD;
+    }
+    return TRUE;
+}
+
+/* TRUE if InitXXX() functions should restore their state instead of creating it */
+byte UpgradeResuming(void) {
+    return StateResuming && StateOk;
+}
+
+/* called after Init(): restore what was not restored by InitXXX() */
+void UpgradeResume(void) {
+    byte hassocket, hasterm;
+    uldat n = 0, nc = 0, lost = 0;
+
+    if (!StateResuming)
+	return;
+    InstantNow(&UpgradeResumed);
+
+    hassocket = StateOk && UpgradeGetNum();
+    hasterm = StateOk && UpgradeGetNum();
+    if (StateOk && hasterm) {
+	if (DlLoad(TermSo))
+	    n = Ext(Term,Restore)();
+	else {
+	    /* the rest of the state cannot be parsed without it */
+	    printk("twin: UpgradeResume(): failed to load the terminal module, terminals are lost\n");
+	    StateOk = FALSE;
+	}
+    }
+    /* restore clients, then they can reconnect too */
+    if (hassocket) {
+	if (DlLoad(SocketSo)) {
+	    if (StateOk)
+		nc = Ext(Socket,Restore)(&lost);
+	} else
+	    printk("twin: UpgradeResume(): failed to load the socket module, libTw clients are lost\n");
+    }
+    GetTime(&UpgradeExec);
+    if (!StateOk)
+	printk("twin: UpgradeResume(): upgrade state is truncated, some windows may be lost\n");
+    else
+	printk("twin: upgrade restored %lu terminals and %lu libTw clients\n",
+	       (unsigned long)n, (unsigned long)nc);
+    if (lost)
+	printk("twin: upgrade disconnected %lu libTw clients, they must be restarted\n", (unsigned long)lost);
+
+    close(StateFd);
+    StateFd = NOFD;
+    StateResuming = FALSE;
+    StartupSkip = TRUE;
+    InstantNow(&UpgradeRestored);
+}
+
+/*
+ * TRUE only the first time it is called after UpgradeResume():
+ * the startup commands of the rc file must not run again
+ */
+byte UpgradeSkipStartup(void) {
+    byte skip = StartupSkip;
+    StartupSkip = FALSE;
+    return skip;
+}
+
+/* called once the first frame is on screen: the pause is over */
+void UpgradeReport(void) {
+    timevalue T;
+
+    if (!UpgradeStart.Seconds)
+	return;
+    InstantNow(&T);
+    PerfUpgrade = PerfUsec(&UpgradeStart, &T);
+
+    printk("twin: upgrade pause (usec): total %lu, save %lu, exec and init %lu, restore %lu, first frame %lu\n",
+	   (unsigned long)PerfUpgrade,
+	   (unsigned long)PerfUsec(&UpgradeStart, &UpgradeExec),
+	   (unsigned long)PerfUsec(&UpgradeExec, &UpgradeResumed),
+	   (unsigned long)PerfUsec(&UpgradeResumed, &UpgradeRestored),
+	   (unsigned long)PerfUsec(&UpgradeRestored, &T));
+    UpgradeStart.Seconds = 0;
+}
+
+static byte OpenState(void) {
+    CopyMem(TWDisplay, statefile + 18, lenTWDisplay);
+
+    unlink(statefile);
+    if ((StateFd = open(statefile, O_RDWR|O_CREAT|O_TRUNC|O_EXCL, 0600)) < 0) {
+	StateFd = NOFD;
+	Error(SYSCALLERROR);
+	return FALSE;
+    }
+    unlink(statefile);
+    StateOk = TRUE;
+    StateLen = StateFdN = OwnFdN = 0;
+    return TRUE;
+}
+
+static void CloseState(void) {
+    if (StateFd != NOFD)
+	close(StateFd);
+    StateFd = NOFD;
+    StateOk = FALSE;
+    StateFdN = OwnFdN = 0;
+}
+
+/* exec() a fresh copy of twin, handing over our terminals and clients. return only on failure */
+void Upgrade(void) {
+    byte **argv, fdbuf[12], hassocket;
+    uldat n, i;
+    timevalue T;
+
+    InstantNow(&T);
+    if (!OpenState()) {
+	printk("twin: Upgrade(): cannot create %."STR(TW_SMALLBUFF)"s: %."STR(TW_SMALLBUFF)"s\n",
+	       statefile, ErrStr);
+	return;
+    }
+    for (n = 0; orig_argv[n]; n++)
+	;
+    if (!(argv = AllocMem((n + 2) * sizeof(byte *)))) {
+	CloseState();
+	printk("twin: Upgrade(): Out of memory!\n");
+	return;
+    }
+    argv[0] = UpgradeArgv0;
+    CopyMem(orig_argv, argv + 1, (n + 1) * sizeof(byte *));
+
+    UpgradePutMem(UPGRADE_MAGIC, sizeof(UPGRADE_MAGIC));
+    UpgradePutNum(UPGRADE_VERSION);
+    UpgradePutNum((tany)sizeof(hwattr));
+    PutTime(&T);
+
+    /* from here on, keep the order in sync with InitTWDisplay() and UpgradeResume() */
+    SaveTWDisplay();
+    UpgradePutNum((tany)(hassocket = !!DlIsLoaded(SocketSo)));
+    UpgradePutNum((tany)!!DlIsLoaded(TermSo));
+    if (DlIsLoaded(TermSo))
+	Ext(Term,Save)();
+    if (hassocket)
+	Ext(Socket,Save)();
+
+    InstantNow(&T);
+    PutTime(&T);
+    StateFlush();
+    if (!StateOk || lseek(StateFd, 0, SEEK_SET) < 0) {
+	Error(SYSCALLERROR);
+	printk("twin: Upgrade(): cannot write upgrade state: %."STR(TW_SMALLBUFF)"s\n", ErrStr);
+	CloseState();
+	FreeMem(argv);
+	return;
+    }
+    sprintf(fdbuf, "%d", StateFd);
+
+    /*
+     * the saved clients now belong to the new server: forget them
+     * without a word, then say goodbye to the others and to displays,
+     * as Quit() does
+     */
+    Ext(Socket,HandOver)();
+    DlUnLoad(SocketSo);
+    RemoteFlushAll();
+    SuspendHW(FALSE);
+    flushk();
+
+    /* let the new server see the environment we were started with */
+    UpgradeSetEnv("TWDISPLAY", origTWDisplay);
+    UpgradeSetEnv("TERM", origTERM);
+    UpgradeSetEnv(UPGRADE_ENV, fdbuf);
+    SetStateFdsCloseOnExec(0);
+
+    execvp(argv[0], (char **)argv);
+
+    /* failed: undo what we can */
+    Error(SYSCALLERROR);
+    SetStateFdsCloseOnExec(FD_CLOEXEC);
+    UpgradeSetEnv(UPGRADE_ENV, NULL);
+    UpgradeSetEnv("TWDISPLAY", TWDisplay);
+    UpgradeSetEnv("TERM", "linux");
+    /* the handed over clients were forgotten: they must reconnect */
+    for (i = 0; i < OwnFdN; i++)
+	close(OwnFds[i]);
+    n = OwnFdN;
+    CloseState();
+    FreeMem(argv);
+
+    RestartHW(TRUE);
+    if (hassocket)
+	DlLoad(SocketSo);
+    printk("twin: Upgrade(): exec(\"%."STR(TW_SMALLBUFF)"s\") failed: %."STR(TW_SMALLBUFF)"s\n",
+	   UpgradeArgv0, ErrStr);
+    if (n)
+	printk("twin: Upgrade(): disconnected %lu libTw clients, they must be restarted\n", (unsigned long)n);
+}
@@ -0,0 +1,32 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ */
+#ifndef _TWIN_UPGRADE_H
+#define _TWIN_UPGRADE_H
+
+/* pause of the last live upgrade, in usec. 0 if this server did not start from one */
+extern tany PerfUpgrade;
+extern VOLATILE byte GotSignalUpgrade;
+
+byte InitUpgrade(void);
+byte UpgradeResuming(void);
+void UpgradeResume(void);
+void UpgradeReport(void);
+byte UpgradeSkipStartup(void);
+void Upgrade(void);
+
+/* used by Save/Restore code to (de)serialize state across exec() */
+void UpgradePutNum(tany n);
+void UpgradePutMem(CONST void *mem, uldat len);
+void UpgradePutFd(int fd);
+void UpgradeOwnFd(int fd);
+void UpgradePutContents(window W);
+tany UpgradeGetNum(void);
+byte UpgradeGetMem(void *mem, uldat len);
+byte UpgradeGetContents(window W);
+
+#endif /* _TWIN_UPGRADE_H */
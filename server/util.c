@@ -45,6 +45,7 @@
 #include "util.h"
 
 #include "hw.h"
+#include "upgrade.h"
 
 #include <Tw/Twkeys.h>
 #include <Tutf/Tutf.h>
@@ -158,6 +159,36 @@ timevalue *SubTime(timevalue *Result, timevalue *Time, timevalue *Decr) {
     return DecrTime(Result, Decr);
 }
 
+uldat PerfMsgPortRuns, PerfMsgs;
+uldat PerfMemThrottles, PerfMemKills;
+perf_hist PerfDraw, PerfFlush;
+byte PerfDrawTiming;
+tany PerfStartup[PERF_STARTUP_N];
+
+/* return the length of interval [Start, End] in microseconds */
+tany PerfUsec(timevalue *Start, timevalue *End) {
+    timevalue Delta;
+    
+    if (CmpTime(End, Start) > 0) {
+	SubTime(&Delta, End, Start);
+	return Delta.Seconds * 1000000 + Delta.Fraction / (1 MicroSECs);
+    }
+    return 0;
+}
+
+/* account the interval [Start, End] in H, return its length in microseconds */
+tany PerfHistAdd(perf_hist *H, timevalue *Start, timevalue *End) {
+    tany Usec = PerfUsec(Start, End);
+    udat i;
+    
+    for (i = 0; i < TWP_HIST_N - 1 && (Usec >> (i + 1)); i++)
+	;
+    H->Calls++;
+    H->Usec += Usec;
+    H->Hist[i]++;
+    return Usec;
+}
+
 dat CmpTime(timevalue *T1, timevalue *T2) {
     NormalizeTime(T1);
     NormalizeTime(T2);
@@ -354,10 +385,17 @@ byte SelectionStore(uldat Magic, CONST byte MIME[MAX_MIMELEN], uldat Len, CONST
 	newLen++;
     
     if (Sel->Max < newLen) {
-	if (!(newData = ReAllocMem(Sel->Data, newLen)))
+	/*
+	 * SetSelectionFromWindow() appends one row at time:
+	 * grow geometrically to avoid copying the whole selection each time.
+	 */
+	uldat newMax = newLen;
+	if (Magic == SEL_APPEND)
+	    newMax = Max2(newLen, Sel->Max + (Sel->Max >> 1));
+	if (!(newData = ReAllocMem(Sel->Data, newMax)))
 	    return FALSE;
 	Sel->Data = newData;
-	Sel->Max = newLen;
+	Sel->Max = newMax;
     }
     if (Magic != SEL_APPEND) {
 	Sel->Owner = NULL;
@@ -446,6 +484,7 @@ byte SetSelectionFromWindow(window Window) {
 	    return FALSE;
 	
 	
+	ReflowRows(Window, Window->YstSel);
 	hw = Window->USE.C.Contents + (Window->YstSel + Window->USE.C.HSplit) * slen;
 	while (hw >= Window->USE.C.TtyData->Split)
 	    hw -= Window->USE.C.TtyData->Split - Window->USE.C.Contents;
@@ -854,14 +893,67 @@ static void TWDisplayIO(int fd, uldat slot) {
 static byte fullTWD[]="/tmp/.Twin:\0\0\0";
 static byte envTWD[]="TWDISPLAY=\0\0\0\0";
 
+/* start accepting connections on unixFd, bound to fullTWD, and set TWDISPLAY */
+static byte ListenTWDisplay(void) {
+    byte *arg0;
+    
+    if (fcntl(unixFd, F_SETFD, FD_CLOEXEC) < 0) {
+	Error(SYSCALLERROR);
+	return FALSE;
+    }
+    if ((unixSlot = RegisterRemoteFd(unixFd, TWDisplayIO)) == NOSLOT)
+	return FALSE;
+    
+    TWDisplay = fullTWD+10;
+    lenTWDisplay = LenStr(TWDisplay);
+    CopyMem(TWDisplay, envTWD+10, lenTWDisplay);
+#if defined(TW_HAVE_SETENV)
+    setenv("TWDISPLAY",TWDisplay,1);
+    setenv("TERM","linux",1);
+#elif defined(TW_HAVE_PUTENV)
+    putenv(envTWD);
+    putenv("TERM=linux");
+#endif
+    if ((arg0 = AllocMem(LenStr(TWDisplay) + 6))) {
+	sprintf(arg0, "twin %s", TWDisplay);
+	SetArgv0(main_argv, main_argv_usable_len, arg0);
+	FreeMem(arg0);
+    }
+    return TRUE;
+}
+
+/* hand unixFd and /tmp/.Twin:<x> over to the server Upgrade() is about to exec() */
+void SaveTWDisplay(void) {
+    byte len = LenStr(fullTWD+11);
+    
+    UpgradePutFd(unixFd);
+    UpgradePutNum((tany)len);
+    UpgradePutMem(fullTWD+11, len);
+}
+
+/* take over the socket saved by SaveTWDisplay() */
+static byte ResumeTWDisplay(void) {
+    tany len;
+    
+    unixFd = (int)UpgradeGetNum();
+    len = UpgradeGetNum();
+    if (len && len <= 3 && UpgradeGetMem(fullTWD+11, len) && ListenTWDisplay())
+	return TRUE;
+    
+    printk("twin: failed to take over the /tmp/.Twin* socket of the upgraded server. Aborting.\n");
+    return FALSE;
+}
+
 /* set TWDISPLAY and create /tmp/.Twin:<x> */
 byte InitTWDisplay(void) {
     struct sockaddr_un addr;
     int i, fd = NOFD;
-    byte *arg0, ok;
+    byte ok;
     
     HOME = getenv("HOME");
 
+    if (UpgradeResuming())
+	return ResumeTWDisplay();
     
     if ((unixFd = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0) {
 	
@@ -905,28 +997,11 @@ byte InitTWDisplay(void) {
 	    }
 	    if (ok) {
 		if (chmod(fullTWD, 0700) >= 0 &&
-		    listen(unixFd, 3) >= 0 &&
-		    fcntl(unixFd, F_SETFD, FD_CLOEXEC) >= 0) {
+		    listen(unixFd, 3) >= 0) {
 		    
-		    if ((unixSlot = RegisterRemoteFd(unixFd, TWDisplayIO)) != NOSLOT) {
-			
+		    if (ListenTWDisplay()) {
 			if (fd != NOFD)
 			    close(fd);
-			TWDisplay = fullTWD+10;
-			lenTWDisplay = LenStr(TWDisplay);
-			CopyMem(TWDisplay, envTWD+10, lenTWDisplay);
-#if defined(TW_HAVE_SETENV)
-			setenv("TWDISPLAY",TWDisplay,1);
-			setenv("TERM","linux",1);
-#elif defined(TW_HAVE_PUTENV)
-			putenv(envTWD);
-			putenv("TERM=linux");
-#endif
-			if ((arg0 = AllocMem(LenStr(TWDisplay) + 6))) {
-			    sprintf(arg0, "twin %s", TWDisplay);
-			    SetArgv0(main_argv, main_argv_usable_len, arg0);
-			    FreeMem(arg0);
-			}
 			return TRUE;
 		    }
 		} else
@@ -1430,6 +1505,49 @@ byte AssignId_all(all Obj) {
     return FALSE;
 }
 
+/*
+ * give Obj the Id it had in the server we were upgraded from (see upgrade.c).
+ * if another object has it, the two swap their Ids
+ */
+byte MoveId(obj Obj, uldat Id) {
+    byte i = Id >> magic_shift;
+    uldat from, to = Id & MAXID, j;
+    obj Other;
+    
+    if (!Obj || Id == NOID || i >= magic_n || i == obj_magic_id || i == all_magic_id ||
+	i != (Obj->Id >> magic_shift))
+	return FALSE;
+    
+    from = Obj->Id & MAXID;
+    if (from >= IdTop[i] || IdList[i][from] != Obj /* paranoia */)
+	return FALSE;
+    while (to >= IdSize[i])
+	if (IdListGrow(i) == NOSLOT)
+	    return FALSE;
+    
+    if ((Other = IdList[i][to]))
+	Other->Id = Obj->Id;
+    IdList[i][from] = Other;
+    IdList[i][to] = Obj;
+    Obj->Id = Id;
+    
+    if (IdTop[i] <= to)
+	IdTop[i] = to + 1;
+    if (!Other) {
+	if (IdBottom[i] > from)
+	    IdBottom[i] = from;
+	for (j = IdTop[i]; j > 0 && !IdList[i][j - 1]; j--)
+	    ;
+	IdTop[i] = j;
+    }
+    if (IdBottom[i] == to) {
+	for (j = to + 1; j < IdTop[i] && IdList[i][j]; j++)
+	    ;
+	IdBottom[i] = j;
+    }
+    return TRUE;
+}
+
 obj Id2Obj(byte i, uldat Id) {
     byte I = Id >> magic_shift;
     
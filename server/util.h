@@ -13,6 +13,8 @@
 # include "twautoconf.h" /* for TW_HAVE_ALARM */
 #endif
 
+#include <Tw/Twperf.h> /* for TWP_HIST_N */
+
 extern udat ErrNo;
 extern byte CONST * ErrStr;
 extern uldat unixSlot;
@@ -42,6 +44,30 @@ timevalue *SumTime(timevalue *Result, timevalue *Time, timevalue *Incr);
 timevalue *SubTime(timevalue *Result, timevalue *Time, timevalue *Decr);
 timevalue *IncrTime(timevalue *Time, timevalue *Incr);
 timevalue *DecrTime(timevalue *Time, timevalue *Decr);
+
+/* server-wide performance counters, exported by extensions/ext_perf.c */
+typedef struct perf_hist {
+    uldat Calls;
+    tany Usec;
+    uldat Hist[TWP_HIST_N];
+} perf_hist;
+
+extern uldat PerfMsgPortRuns, PerfMsgs;
+extern uldat PerfMemThrottles, PerfMemKills;
+extern perf_hist PerfDraw, PerfFlush;
+extern byte PerfDrawTiming;	/* TRUE while the perf extension is loaded: only then draws are timed */
+tany PerfUsec(timevalue *Start, timevalue *End);
+tany PerfHistAdd(perf_hist *H, timevalue *Start, timevalue *End);
+
+/* startup phases, in the order main.c runs them */
+#define PERF_STARTUP_CORE	0 /* data, signals, builtin msgport... */
+#define PERF_STARTUP_HW		1 /* first display */
+#define PERF_STARTUP_WM		2 /* drawing and window manager */
+#define PERF_STARTUP_FRAME	3 /* main loop, until first frame is flushed */
+#define PERF_STARTUP_MOREHW	4 /* displays after the first one */
+#define PERF_STARTUP_N		5
+extern tany PerfStartup[PERF_STARTUP_N];
+
 void SortMsgPortByCallTime(msgport Port);
 void SortAllMsgPortsByCallTime(void);
 byte SendControlMsg(msgport MsgPort, udat Code, udat Len, CONST byte *Data);
@@ -69,6 +95,7 @@ void FreeStringVec(byte **argv);
 
 byte InitTWDisplay(void);
 void QuitTWDisplay(void);
+void SaveTWDisplay(void);
 
 extern uid_t Uid, EUid;
 byte CheckPrivileges(void);
@@ -83,6 +110,7 @@ hwattr EncodeToHWAttrExtra(byte pos, byte detail, byte active, byte pressed);
 byte AssignId(CONST fn_obj Fn_Obj, obj Obj);
 byte AssignId_all(all Obj);
 void DropId(obj Obj);
+byte MoveId(obj Obj, uldat Id);
 obj  Id2Obj(byte i, uldat Id);
 #define Obj2Id(o) ((o) ? (o)->Id : NOID)
 
@@ -495,6 +495,7 @@ static byte CheckForwardMsg(wm_ctx *C, msg Msg, byte WasUsed) {
     static udat LastKeys = 0;
     widget LastW, W, P;
     event_any *Event;
+    msg Last;
     udat Code;
     dat X, Y;
     byte Inside, inUse = FALSE;
@@ -619,18 +620,26 @@ static byte CheckForwardMsg(wm_ctx *C, msg Msg, byte WasUsed) {
 	    if (Code == MOVE_MOUSE && !Inside)
 		X = Y = TW_MINDAT;
 	    
-	    Msg->Type=MSG_WIDGET_MOUSE;
-	    Event->EventMouse.W = (widget)W;
-	    Event->EventMouse.X = X;
-	    Event->EventMouse.Y = Y;
-	    SendMsg(W->Owner, Msg);
+	    if (isMOVE(Code) && !(W->Attrib & WIDGET_WANT_ALL_MOTION) &&
+		(Last = W->Owner->LastMsg) && Last->Type == MSG_WIDGET_MOUSE &&
+		Last->Event.EventMouse.W == (widget)W && Last->Event.EventMouse.Code == Code &&
+		Last->Event.EventMouse.ShiftFlags == Event->EventMouse.ShiftFlags) {
+		/* owner did not read the previous motion yet: just move it */
+		Last->Event.EventMouse.X = X;
+		Last->Event.EventMouse.Y = Y;
+	    } else {
+		Msg->Type=MSG_WIDGET_MOUSE;
+		Event->EventMouse.W = (widget)W;
+		Event->EventMouse.X = X;
+		Event->EventMouse.Y = Y;
+		SendMsg(W->Owner, Msg);
+		inUse = TRUE;
+	    }
 	    
 	    LastInside = (W->Attrib & WIDGET_WANT_MOUSE_MOTION) ? Inside : 0;
 	    LastKeys = (W->Attrib & WIDGET_WANT_MOUSE) ? Code & HOLD_ANY : 0;
 	    if (isPRESS(Code))
 		LastKeys |= HOLD_CODE(PRESS_N(Code));
-	    
-	    inUse = TRUE;
 	}
     }
     
@@ -1785,24 +1794,125 @@ static void WManagerH(msgport MsgPort) {
 
 static dat XWidth, YWidth;
 
-static byte doSmartPlace(widget W, dat *X, udat *Y) {
+/*
+ * doSmartPlace() explores the free space with a depth-first search that splits
+ * the candidate area around each overlapping widget. With many widgets the same
+ * (widget, area) pairs are reached again and again through different paths and
+ * the search becomes exponential, so once it gets big we remember the pairs
+ * that failed. Entries are valid only if their Gen equals PlaceGen,
+ * so the table is emptied by incrementing PlaceGen.
+ */
+#define PLACE_MEMO_NODES 1024 /* start remembering failures after this many nodes */
+
+typedef struct place_fail {
+    widget W;
+    uldat Gen;
+    dat X[2], Y[2];
+} place_fail;
+
+static place_fail *PlaceFail;
+static uldat PlaceFailN, PlaceFailMax; /* PlaceFailMax is zero or a power of two */
+static uldat PlaceGen = 1, PlaceNodes;
+
+INLINE uldat HashPlace(widget W, dat *X, dat *Y) {
+    uldat h = (uldat)(topaque)W;
+    h = h * 31 + (udat)X[0];
+    h = h * 31 + (udat)X[1];
+    h = h * 31 + (udat)Y[0];
+    h = h * 31 + (udat)Y[1];
+    return h ^ (h >> 15);
+}
+
+static place_fail *FindPlaceFail(widget W, dat *X, dat *Y) {
+    place_fail *F;
+    uldat i, mask = PlaceFailMax - 1;
+    
+    for (i = HashPlace(W, X, Y) & mask; (F = &PlaceFail[i])->Gen == PlaceGen; i = (i + 1) & mask) {
+	if (F->W == W && F->X[0] == X[0] && F->X[1] == X[1] && F->Y[0] == Y[0] && F->Y[1] == Y[1])
+	    break;
+    }
+    return F;
+}
+
+static byte GrowPlaceFail(void) {
+    place_fail *Old = PlaceFail, *F;
+    uldat i, OldMax = PlaceFailMax;
+    
+    if (!(PlaceFail = (place_fail *)AllocMem0(sizeof(place_fail), OldMax ? OldMax * 2 : 256))) {
+	PlaceFail = Old;
+	return FALSE;
+    }
+    PlaceFailMax = OldMax ? OldMax * 2 : 256;
+    
+    for (i = 0; i < OldMax; i++) {
+	if (Old[i].Gen == PlaceGen) {
+	    F = FindPlaceFail(Old[i].W, Old[i].X, Old[i].Y);
+	    *F = Old[i];
+	}
+    }
+    if (Old)
+	FreeMem(Old);
+    return TRUE;
+}
+
+static byte IsPlaceFail(widget W, dat *X, dat *Y) {
+    return PlaceFailN && FindPlaceFail(W, X, Y)->Gen == PlaceGen;
+}
+
+static void AddPlaceFail(widget W, dat *X, dat *Y) {
+    place_fail *F;
+    
+    if (PlaceFailN * 2 >= PlaceFailMax && !GrowPlaceFail())
+	return;
+    
+    F = FindPlaceFail(W, X, Y);
+    if (F->Gen != PlaceGen) {
+	F->W = W;
+	F->Gen = PlaceGen;
+	F->X[0] = X[0]; F->X[1] = X[1];
+	F->Y[0] = Y[0]; F->Y[1] = Y[1];
+	PlaceFailN++;
+    }
+}
+
+static void ClearPlaceFail(void) {
+    PlaceNodes = PlaceFailN = 0;
+    if (!++PlaceGen) {
+	/* wrapped around: really clear the table */
+	if (PlaceFail)
+	    WriteMem(PlaceFail, 0, PlaceFailMax * sizeof(place_fail));
+	PlaceGen = 1;
+    }
+}
+
+static byte doSmartPlace(widget W, dat *X, dat *Y) {
     dat WLeft, WRgt, TryX[2];
     dat WUp, WDwn, TryY[2];
+    widget W0;
     byte OK = FALSE;
 
     if (XWidth > X[1] - X[0] + 1 || YWidth > Y[1] - Y[0] + 1)
 	return FALSE;
     
-    if (!W)
-	return TRUE;
+    /* skip widgets not overlapping the area */
+    for (;;) {
+	if (!W)
+	    return TRUE;
 	
-    WRgt = (WLeft = W->Left) + W->XWidth;
-    WDwn = (WUp = W->Up) + (IS_WINDOW(W) && (((window)W)->Attrib & WINDOW_ROLLED_UP)
-			    ? 1 : W->YWidth);
+	WRgt = (WLeft = W->Left) + W->XWidth;
+	WDwn = (WUp = W->Up) + (IS_WINDOW(W) && (((window)W)->Attrib & WINDOW_ROLLED_UP)
+				? 1 : W->YWidth);
+	if (X[0] >= WRgt || X[1] < WLeft || Y[0] >= WDwn || Y[1] < WUp)
+	    W = W->Next;
+	else
+	    break;
+    }
+    
+    if (++PlaceNodes > PLACE_MEMO_NODES && IsPlaceFail(W, X, Y))
+	return FALSE;
+    
+    W0 = W;
     W = W->Next;
-	
-    if (X[0] >= WRgt || X[1] < WLeft || Y[0] >= WDwn || Y[1] < WUp)
-	return W ? doSmartPlace(W, X, Y) : TRUE;
     
     if (Y[0] < WUp) {
 	TryX[0] = X[0]; TryX[1] = X[1];
@@ -1827,7 +1937,9 @@ static byte doSmartPlace(widget W, dat *X, udat *Y) {
     if (OK) {
 	X[0] = TryX[0]; X[1] = TryX[1];
 	Y[0] = TryY[0]; Y[1] = TryY[1];
-    }
+    } else if (PlaceNodes > PLACE_MEMO_NODES)
+	AddPlaceFail(W0, X, Y);
+    
     return OK;
 }
 
@@ -1836,6 +1948,7 @@ static byte doSmartPlace(widget W, dat *X, udat *Y) {
 static void SmartPlace(widget W, screen Screen) {
     dat X[2];
     dat Y[2];
+    byte OK;
     
     if (!W || W->Parent)
 	return;
@@ -1847,7 +1960,10 @@ static void SmartPlace(widget W, screen Screen) {
 	XWidth = W->XWidth;
 	YWidth = IS_WINDOW(W) && W->Attrib & WINDOW_ROLLED_UP ? 1 : W->YWidth;
     
-	if (!doSmartPlace(Screen->FirstW, X, Y)) {
+	OK = doSmartPlace(Screen->FirstW, X, Y);
+	ClearPlaceFail();
+	
+	if (!OK) {
 	    /* can't be smart... be random */
 	    if (XWidth <= X[1] - X[0])
 		X[0] += lrand48() / (MAXLRAND48 / (X[1] - X[0] + 2 - XWidth));
@@ -1913,6 +2029,11 @@ byte InitModule(module Module)
 }
 
 void QuitModule(module Module) {
+    if (PlaceFail) {
+	FreeMem(PlaceFail);
+	PlaceFail = NULL;
+	PlaceFailMax = PlaceFailN = 0;
+    }
     QuitRC();
     OverrideMethods(FALSE);
     UnRegisterExt(WM,MsgPort,WM_MsgPort);